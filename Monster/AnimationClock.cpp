@@ -0,0 +1,104 @@
+#include "AnimationClock.h"
+#include <algorithm>
+#include <cmath>
+
+AnimationClock::AnimationClock() : last_tick(Clock::now()) {}
+
+void AnimationClock::Reset(double time) {
+    this->time = ToNanoseconds(time);
+    step_time = this->time;
+    frame_delta = 0;
+    real_delta = 0;
+    pending = 0;
+    frame_step_pending = false;
+    scale_remainder = 0.0;
+    frame_index = 0;
+    last_tick = Clock::now();
+}
+
+void AnimationClock::SetRealTime() {
+    frame_duration = 0;
+    last_tick = Clock::now();
+}
+
+void AnimationClock::SetDeterministic(double frame_duration) {
+    this->frame_duration = std::max<std::int64_t>(ToNanoseconds(frame_duration), 1);
+}
+
+void AnimationClock::SetPaused(bool paused) {
+    this->paused = paused;
+}
+
+void AnimationClock::SetTimeScale(double scale) {
+    time_scale = std::max(scale, 0.0);
+}
+
+void AnimationClock::SetFixedStep(double step) {
+    this->step = std::max<std::int64_t>(ToNanoseconds(step), 0);
+    pending = 0;
+    step_time = time;
+}
+
+void AnimationClock::Tick() {
+    auto now = Clock::now();
+    auto real_delta = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_tick).count();
+    last_tick = now;
+
+    Advance(IsDeterministic() ? frame_duration : real_delta);
+}
+
+void AnimationClock::Tick(double real_delta) {
+    last_tick = Clock::now();
+    Advance(ToNanoseconds(real_delta));
+}
+
+void AnimationClock::Advance(std::int64_t real_delta) {
+    this->real_delta = real_delta;
+    real_delta = std::clamp<std::int64_t>(real_delta, 0, ToNanoseconds(MAX_FRAME_DELTA));
+
+    frame_delta = 0;
+    if (!paused) {
+        auto scaled = real_delta * time_scale + scale_remainder;
+        frame_delta = (std::int64_t)scaled;
+        scale_remainder = scaled - (double)frame_delta;
+    }
+
+    time += frame_delta;
+    frame_index++;
+
+    if (step > 0) {
+        pending += frame_delta;
+    }
+    else {
+        frame_step_pending = true;
+    }
+}
+
+bool AnimationClock::Step() {
+    if (step > 0) {
+        if (pending < step) {
+            return false;
+        }
+        pending -= step;
+        step_time += step;
+        return true;
+    }
+
+    if (!frame_step_pending) {
+        return false;
+    }
+    frame_step_pending = false;
+    step_time = time;
+    return true;
+}
+
+double AnimationClock::Alpha() const {
+    if (step <= 0) {
+        return 1.0;
+    }
+    return (double)pending / (double)step;
+}
+
+std::int64_t AnimationClock::ToNanoseconds(double seconds) {
+    return (std::int64_t)std::llround(seconds * 1e9);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Animation time, accumulated frame by frame instead of read off the wall clock, so
+// it can be paused, scaled and replayed.
+//
+// Each frame calls Tick once, then Step until it returns false, advancing the
+// simulation to StepTime on every step, and finally renders with Alpha of the way
+// from the previous step to the last one. With a fixed step, the simulation runs at
+// a constant rate no matter the frame rate; without one, Step returns true once per
+// frame and Alpha is 1.
+//
+// In real-time mode frames last as long as they took on steady_clock (QPC on
+// Windows). In deterministic mode every frame lasts exactly the same, so the same
+// number of frames always produces the same times.
+//
+// Times are kept in integer nanoseconds, so they don't lose precision as the clock
+// runs and deterministic runs repeat bit for bit.
+class AnimationClock {
+public:
+    // Longest real frame that is let through, so a breakpoint or a dragged window
+    // doesn't fast-forward the animation.
+    static constexpr double MAX_FRAME_DELTA = 0.25;
+
+    AnimationClock();
+
+    // Restarts at time with no steps pending.
+    void Reset(double time = 0.0);
+
+    void SetRealTime();
+    void SetDeterministic(double frame_duration);
+    bool IsDeterministic() const { return frame_duration > 0; }
+
+    void SetPaused(bool paused);
+    bool IsPaused() const { return paused; }
+
+    // Animation seconds per real second. Negative scales are clamped to 0.
+    void SetTimeScale(double scale);
+    double TimeScale() const { return time_scale; }
+
+    // Length of a simulation step in animation seconds, or 0 to step once per frame.
+    void SetFixedStep(double step);
+    double FixedStep() const { return ToSeconds(step); }
+
+    // Starts a frame, advancing by its real duration scaled by the time scale.
+    void Tick();
+    // Same with an injected real duration, whatever the mode. Used for replays.
+    void Tick(double real_delta);
+
+    // Takes the next pending simulation step, if any.
+    bool Step();
+
+    // Animation time at the current frame.
+    double Time() const { return ToSeconds(time); }
+    // Animation time the frame advanced by.
+    double FrameDelta() const { return ToSeconds(frame_delta); }
+    // Real time the frame lasted, before clamping and scaling. Passing it back to
+    // Tick(real_delta) repeats the frame exactly.
+    double RealDelta() const { return ToSeconds(real_delta); }
+    // Animation time of the last step taken.
+    double StepTime() const { return ToSeconds(step_time); }
+    // How far the frame is from the last step towards the next one, in [0, 1).
+    double Alpha() const;
+
+    std::uint64_t FrameIndex() const { return frame_index; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point last_tick;
+    std::int64_t frame_duration = 0;
+
+    bool paused = false;
+    double time_scale = 1.0;
+    // Sub-nanosecond part of scaled frame durations, carried to the next frame.
+    double scale_remainder = 0.0;
+
+    std::int64_t time = 0;
+    std::int64_t frame_delta = 0;
+    std::int64_t real_delta = 0;
+    std::int64_t step = 0;
+    std::int64_t step_time = 0;
+    // Animation time not yet taken by Step. Without a fixed step, the whole frame is
+    // one step.
+    std::int64_t pending = 0;
+    bool frame_step_pending = false;
+
+    std::uint64_t frame_index = 0;
+
+    void Advance(std::int64_t real_delta);
+
+    static std::int64_t ToNanoseconds(double seconds);
+    static double ToSeconds(std::int64_t nanoseconds) { return nanoseconds * 1e-9; }
+};
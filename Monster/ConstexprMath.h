@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cmath>
+#include <numbers>
+#include <type_traits>
+
+// The few math functions geometry needs, usable in constant expressions so shapes can
+// be baked at compile time.
+//
+// At runtime they are the standard library functions, so nothing computed there
+// changes. In constant expressions they are evaluated in double and rounded to float,
+// which lands on the same value or one unit in the last place away.
+namespace gfx::math {
+
+namespace detail {
+
+constexpr double Sqrt(double x) {
+    if (!(x > 0.0)) {
+        return 0.0;
+    }
+    // Newton's method from above converges monotonically; stop once it stalls.
+    auto y = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 1100; i++) {
+        auto next = 0.5 * (y + x / y);
+        if (next >= y) {
+            break;
+        }
+        y = next;
+    }
+    return y;
+}
+
+// Taylor series around 0 after reducing x to [-pi, pi].
+constexpr double Sin(double x) {
+    constexpr auto two_pi = 2.0 * std::numbers::pi;
+    auto turns = x / two_pi;
+    auto whole = (double)(long long)(turns + (turns >= 0.0 ? 0.5 : -0.5));
+    x -= whole * two_pi;
+
+    double term = x, sum = x;
+    for (int n = 1; n < 20; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double Cos(double x) {
+    return Sin(x + std::numbers::pi / 2.0);
+}
+
+// Halves the argument twice with atan(z) = 2 atan(z / (1 + sqrt(1 + z^2))), so the
+// series converges quickly even at |z| = 1.
+constexpr double Atan(double z) {
+    auto negative = z < 0.0;
+    z = negative ? -z : z;
+    auto invert = z > 1.0;
+    z = invert ? 1.0 / z : z;
+
+    for (int i = 0; i < 2; i++) {
+        z = z / (1.0 + Sqrt(1.0 + z * z));
+    }
+    double term = z, sum = z;
+    for (int n = 1; n < 30; n++) {
+        term *= -z * z;
+        sum += term / (2.0 * n + 1.0);
+    }
+    sum *= 4.0;
+
+    sum = invert ? std::numbers::pi / 2.0 - sum : sum;
+    return negative ? -sum : sum;
+}
+
+constexpr double Exp2(double x) {
+    auto whole = (long long)x;
+    if ((double)whole > x) {
+        whole--;
+    }
+    auto fraction = (x - (double)whole) * std::numbers::ln2;
+
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 25; n++) {
+        term *= fraction / n;
+        sum += term;
+    }
+    for (; whole > 0; whole--) {
+        sum *= 2.0;
+    }
+    for (; whole < 0; whole++) {
+        sum *= 0.5;
+    }
+    return sum;
+}
+
+}
+
+constexpr float Abs(float x) {
+    return x < 0.0f ? -x : x;
+}
+
+constexpr float Ceil(float x) {
+    if (!std::is_constant_evaluated()) {
+        return std::ceil(x);
+    }
+    auto whole = (float)(long long)x;
+    return whole < x ? whole + 1.0f : whole;
+}
+
+constexpr float Sqrt(float x) {
+    if (!std::is_constant_evaluated()) {
+        return std::sqrt(x);
+    }
+    return (float)detail::Sqrt(x);
+}
+
+constexpr float Sin(float x) {
+    if (!std::is_constant_evaluated()) {
+        return std::sin(x);
+    }
+    return (float)detail::Sin(x);
+}
+
+constexpr float Cos(float x) {
+    if (!std::is_constant_evaluated()) {
+        return std::cos(x);
+    }
+    return (float)detail::Cos(x);
+}
+
+constexpr float Tan(float x) {
+    if (!std::is_constant_evaluated()) {
+        return std::tan(x);
+    }
+    return (float)(detail::Sin(x) / detail::Cos(x));
+}
+
+constexpr float Atan2(float y, float x) {
+    if (!std::is_constant_evaluated()) {
+        return std::atan2(y, x);
+    }
+    if (x > 0.0f) {
+        return (float)detail::Atan((double)y / x);
+    }
+    if (x < 0.0f) {
+        auto angle = detail::Atan((double)y / x);
+        return (float)(y >= 0.0f ? angle + std::numbers::pi : angle - std::numbers::pi);
+    }
+    if (y == 0.0f) {
+        return 0.0f;
+    }
+    return (float)(y > 0.0f ? std::numbers::pi / 2.0 : -std::numbers::pi / 2.0);
+}
+
+constexpr float Exp2(float x) {
+    if (!std::is_constant_evaluated()) {
+        return std::exp2(x);
+    }
+    return (float)detail::Exp2(x);
+}
+
+}
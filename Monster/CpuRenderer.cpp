@@ -0,0 +1,493 @@
+#include "CpuRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using gfx::FlatteningCache;
+
+// Levels flattened at compile time: the one MonsterScene::SCALE falls into, where the
+// monster is drawn at its default size, and the two above it, up to twice that.
+constexpr int FIRST_BAKED_LEVEL = 4;
+static_assert(FlatteningCache::LevelScale(FIRST_BAKED_LEVEL - 1) < MonsterScene::SCALE &&
+    MonsterScene::SCALE <= FlatteningCache::LevelScale(FIRST_BAKED_LEVEL));
+
+// Flattened as FlatteningCache would flatten the level at runtime: the same points,
+// some of them a unit in the last place away where ConstexprMath rounds differently.
+template <const auto& shape, int level>
+constexpr auto baked_level = gfx::BakeFlattened<shape, FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(level)>();
+
+template <const auto& shape>
+void AddBakedLevels(FlatteningCache& cache, const gfx::Path& path) {
+    cache.AddBaked(path, FIRST_BAKED_LEVEL, baked_level<shape, FIRST_BAKED_LEVEL>.View());
+    cache.AddBaked(path, FIRST_BAKED_LEVEL + 1, baked_level<shape, FIRST_BAKED_LEVEL + 1>.View());
+    cache.AddBaked(path, FIRST_BAKED_LEVEL + 2, baked_level<shape, FIRST_BAKED_LEVEL + 2>.View());
+}
+
+}
+
+CpuRenderer::CpuRenderer()
+    : body_gradient(MonsterScene::rad_stops_data), eye_gradient(MonsterScene::eye_stops_data) {
+    MonsterScene::monster_shape.CopyTo(monster_path);
+    MonsterScene::nose_shape.CopyTo(nose_path);
+    MonsterScene::smile_shape.CopyTo(smile_path);
+    MonsterScene::sad_shape.CopyTo(sad_path);
+    AddBakedGeometry();
+    left_eye_path.AddEllipse(MonsterScene::left_eye);
+    right_eye_path.AddEllipse(MonsterScene::right_eye);
+    unit_circle_path.AddEllipse({ { 0.0f, 0.0f }, 1.0f, 1.0f });
+
+    const gfx::Path* mouths[] = { &sad_path, &smile_path };
+    mouth_morph.Build(mouths);
+}
+
+bool CpuRenderer::LoadGeometry(const std::filesystem::path& filename) {
+    auto loaded = flattening_cache.Load(filename, CachedPaths());
+    AddBakedGeometry();
+    return loaded;
+}
+
+void CpuRenderer::AddBakedGeometry() {
+    AddBakedLevels<MonsterScene::monster_shape>(flattening_cache, monster_path);
+    AddBakedLevels<MonsterScene::nose_shape>(flattening_cache, nose_path);
+    AddBakedLevels<MonsterScene::smile_shape>(flattening_cache, smile_path);
+    AddBakedLevels<MonsterScene::sad_shape>(flattening_cache, sad_path);
+}
+
+bool CpuRenderer::BakeGeometry(const std::filesystem::path& filename) {
+    for (const auto* path : CachedPaths()) {
+        flattening_cache.Bake(*path, BAKE_MIN_SCALE, BAKE_MAX_SCALE);
+    }
+    return flattening_cache.Save(filename);
+}
+
+std::array<const gfx::Path*, 7> CpuRenderer::CachedPaths() const {
+    return { &monster_path, &nose_path, &smile_path, &sad_path, &left_eye_path, &right_eye_path, &unit_circle_path };
+}
+
+void CpuRenderer::SetTarget(const gfx::Surface& surface) {
+    // Surfaces taking turns differ every frame, which the damage tracker's buffer age
+    // accounts for.
+    auto taking_turns = target_count > 1 && target_count <= gfx::DamageTracker::MAX_BUFFER_AGE;
+    if ((surface.pixels != target.pixels && !taking_turns) || surface.width != target.width ||
+        surface.height != target.height || surface.stride != target.stride) {
+        damage.Invalidate();
+    }
+    target = surface;
+}
+
+void CpuRenderer::SetTargetCount(int count) {
+    target_count = std::max(count, 1);
+    damage = gfx::DamageTracker(target_count);
+}
+
+void CpuRenderer::InvalidateTarget() {
+    damage.Invalidate();
+}
+
+void CpuRenderer::SetThreadPool(ThreadPool* new_pool) {
+    pool = new_pool;
+}
+
+void CpuRenderer::SetBlendSpace(gfx::BlendSpace space) {
+    if (space == blend_space) {
+        return;
+    }
+    blend_space = space;
+
+    // The layer and atlas were blended in the old space.
+    layer_surface = {};
+    atlas_pixels.clear();
+    damage.Invalidate();
+}
+
+void CpuRenderer::Render(const SceneState& scene) {
+    using gfx::Paint;
+
+    if (!target.pixels) {
+        return;
+    }
+
+    auto transformation = scene.transformation;
+    auto mouth_transformation = scene.MouthTransformation();
+    if (!IsLayerValid(transformation)) {
+        RenderLayer(transformation);
+    }
+
+    auto black = Paint::Solid(MonsterScene::brush_color);
+
+    edges.clear();
+    commands.clear();
+
+    FillEllipse(scene.left_ball, transformation, black);
+    FillEllipse(scene.right_ball, transformation, black);
+
+    FillGeometry(nose_path, mouth_transformation, Paint::Solid(MonsterScene::nose_color));
+    DrawGeometry(nose_path, mouth_transformation, black);
+    DrawMouth(scene.smile, mouth_transformation, black);
+
+    auto dynamic_bounds = MonsterScene::DynamicBounds(scene);
+    damage.Update(dynamic_bounds, transformation, TargetBounds());
+
+    backdrop = &layer_surface;
+    RenderCommands();
+    backdrop = nullptr;
+    frame_arena.Reset();
+}
+
+bool CpuRenderer::IsLayerValid(const gfx::Matrix3x2& transformation) const {
+    return layer_surface.pixels && layer_surface.width == target.width && layer_surface.height == target.height &&
+        layer_transformation == transformation;
+}
+
+void CpuRenderer::RenderLayer(const gfx::Matrix3x2& transformation) {
+    using gfx::Paint;
+
+    auto screen = target;
+
+    auto key = TargetKey::ForSize(screen.width, screen.height);
+    if (layer_pixels.empty() || key != layer_key) {
+        if (!layer_pixels.empty()) {
+            layer_pool.Release(layer_key, std::move(layer_pixels));
+        }
+        layer_pixels = layer_pool.Acquire(key, [](const TargetKey& key) {
+            return std::vector<std::uint8_t>((std::size_t)key.width * key.height * 4);
+        });
+        layer_key = key;
+    }
+    layer_surface = { layer_pixels.data(), screen.width, screen.height, (int)key.width * 4 };
+    layer_transformation = transformation;
+    target = layer_surface;
+
+    auto black = Paint::Solid(MonsterScene::brush_color);
+    auto body = Paint::RadialGradient({ 0.0f, 0.0f }, MonsterScene::BODY_GRADIENT_RADIUS,
+        MonsterScene::BODY_GRADIENT_RADIUS, body_gradient, transformation);
+    auto left_eye = Paint::RadialGradient(MonsterScene::left_eye.center, MonsterScene::EYE_RADIUS,
+        MonsterScene::EYE_RADIUS, eye_gradient, transformation);
+    auto right_eye = Paint::RadialGradient(MonsterScene::right_eye.center, MonsterScene::EYE_RADIUS,
+        MonsterScene::EYE_RADIUS, eye_gradient, transformation);
+
+    edges.clear();
+    commands.clear();
+
+    FillGeometry(monster_path, transformation, body);
+    DrawGeometry(monster_path, transformation, black);
+
+    FillGeometry(left_eye_path, transformation, left_eye);
+    FillGeometry(right_eye_path, transformation, right_eye);
+
+    background = MonsterScene::background_color;
+    damage.Full(TargetBounds());
+    RenderCommands();
+
+    // A new layer means a new transformation or size, which redraws the screen anyway.
+    target = screen;
+}
+
+void CpuRenderer::RenderCrowd(const Crowd& crowd) {
+    if (!target.pixels) {
+        return;
+    }
+    if (atlas_pixels.empty()) {
+        RenderAtlas();
+    }
+
+    crowd.BuildSprites(atlas, sprites);
+    BinSprites();
+    damage.Full(TargetBounds());
+
+    background = MonsterScene::background_color;
+    ForEachTile([&](std::size_t index, unsigned) {
+        RenderCrowdTile((int)(index % tile_columns), (int)(index / tile_columns));
+    });
+    frame_arena.Reset();
+}
+
+void CpuRenderer::FillGeometry(const gfx::Path& path, const gfx::Matrix3x2& transformation, const gfx::Paint& paint) {
+    gfx::TransformPath(transformation, flattening_cache.Get(path, transformation), flattened);
+
+    auto first_edge = edges.size();
+    gfx::AppendPolygons(edges, flattened);
+    AddCommand(first_edge, paint);
+}
+
+void CpuRenderer::FillEllipse(const gfx::Ellipse& ellipse, const gfx::Matrix3x2& transformation, const gfx::Paint& paint) {
+    using gfx::Matrix3x2;
+
+    FillGeometry(unit_circle_path, Matrix3x2::Scale(ellipse.radius_x, ellipse.radius_y) *
+        Matrix3x2::Translation(ellipse.center.x, ellipse.center.y) * transformation, paint);
+}
+
+void CpuRenderer::DrawGeometry(const gfx::Path& path, const gfx::Matrix3x2& transformation, const gfx::Paint& paint,
+    const gfx::StrokeStyle& style) {
+    if (style.hairline) {
+        DrawPolylines(flattening_cache.Get(path, transformation), transformation, paint, style,
+            gfx::FlatteningCache::TOLERANCE);
+        return;
+    }
+
+    // Outlines are cached in local space, so the width scales with the transformation as
+    // in Direct2D, and a rotated stroke only needs its outline transformed.
+    gfx::TransformPath(transformation, stroke_cache.Get(path, transformation, style, flattening_cache), stroked);
+    AddPolygons(stroked, paint);
+}
+
+void CpuRenderer::DrawPolylines(gfx::FlatPathView path, const gfx::Matrix3x2& transformation, const gfx::Paint& paint,
+    const gfx::StrokeStyle& style, float tolerance) {
+    stroked.Clear();
+    if (style.hairline) {
+        // Stroked after transforming, so the width stays in pixels.
+        gfx::TransformPath(transformation, path, flattened);
+        gfx::StrokePath(flattened, style, gfx::FlatteningCache::TOLERANCE, stroked, &frame_arena);
+    }
+    else {
+        gfx::StrokePath(path, style, tolerance, stroked, &frame_arena);
+        gfx::TransformPoints(transformation, stroked);
+    }
+    AddPolygons(stroked, paint);
+}
+
+void CpuRenderer::AddPolygons(const gfx::FlattenedPath& polygons, const gfx::Paint& paint) {
+    auto first_edge = edges.size();
+    gfx::AppendPolygons(edges, polygons);
+    AddCommand(first_edge, paint);
+}
+
+void CpuRenderer::DrawMouth(float smile, const gfx::Matrix3x2& transformation, const gfx::Paint& paint) {
+    gfx::StrokeStyle style = { .width = MonsterScene::MOUTH_STROKE_WIDTH };
+
+    // The two expressions themselves come from the caches.
+    if (smile <= 0.0f || smile >= 1.0f) {
+        DrawGeometry(smile > 0.0f ? smile_path : sad_path, transformation, paint, style);
+        return;
+    }
+
+    mouth_morph.Evaluate({ &smile, 1 }, mouth_path);
+    mouth_flattened.Clear();
+    auto tolerance = gfx::FlatteningCache::TOLERANCE / transformation.MaxScale();
+    gfx::FlattenPathAdaptive(mouth_path, gfx::Matrix3x2::Identity(), tolerance, mouth_flattened);
+    DrawPolylines(mouth_flattened, transformation, paint, style, tolerance);
+}
+
+void CpuRenderer::AddCommand(std::size_t first_edge, const gfx::Paint& paint) {
+    DrawCommand command;
+    command.first_edge = first_edge;
+    command.edge_count = edges.size() - first_edge;
+    command.bounds = gfx::Intersect(gfx::EdgeBounds({ edges.data() + first_edge, command.edge_count }),
+        { 0, 0, target.width, target.height });
+    command.paint = paint;
+    command.paint.space = blend_space;
+
+    if (command.bounds.IsEmpty()) {
+        edges.resize(first_edge);
+        return;
+    }
+    commands.push_back(command);
+}
+
+void CpuRenderer::RenderCommands() {
+    BinCommands();
+
+    auto thread_count = pool ? pool->ThreadCount() : 1u;
+    if (rasterizers.size() < thread_count) {
+        rasterizers.resize(thread_count);
+    }
+
+    ForEachTile([&](std::size_t index, unsigned thread) {
+        RenderTile((int)(index % tile_columns), (int)(index / tile_columns), rasterizers[thread]);
+    });
+}
+
+template <class Entry, class ForEach>
+CpuRenderer::TileBins<Entry> CpuRenderer::BinTiles(ForEach&& for_each) {
+    // Entries are counted first, so every row knows where it starts.
+    TileBins<Entry> result;
+    result.starts = frame_arena.AllocateArray<std::uint32_t>((std::size_t)tile_rows + 1);
+    for_each([&](int row, const Entry&) {
+        result.starts[row + 1]++;
+    });
+    for (int row = 0; row < tile_rows; row++) {
+        result.starts[row + 1] += result.starts[row];
+    }
+
+    result.entries = frame_arena.AllocateArray<Entry>(result.starts[tile_rows]);
+    auto ends = frame_arena.AllocateArray<std::uint32_t>(tile_rows);
+    std::copy(result.starts.begin(), result.starts.end() - 1, ends.begin());
+    for_each([&](int row, const Entry& entry) {
+        result.entries[ends[row]++] = entry;
+    });
+    return result;
+}
+
+void CpuRenderer::BinCommands() {
+    UpdateTileGrid();
+
+    // Commands are binned in order, so each row lists its entries grouped by command.
+    bins = BinTiles<BinEntry>([&](auto&& add) {
+        for (std::uint32_t c = 0; c < commands.size(); c++) {
+            const auto& command = commands[c];
+            for (auto e = command.first_edge; e < command.first_edge + command.edge_count; e++) {
+                const auto& edge = edges[e];
+                auto top = std::max(edge.y0 >> gfx::SUBPIXEL_SHIFT, command.bounds.top);
+                auto bottom = std::min((edge.y1 - 1) >> gfx::SUBPIXEL_SHIFT, command.bounds.bottom - 1);
+                if (top > bottom) {
+                    continue;
+                }
+
+                auto left = std::max(std::min(edge.x0, edge.x1) >> gfx::SUBPIXEL_SHIFT, 0);
+                BinEntry entry = { c, (std::uint32_t)e, left / TILE_SIZE };
+                for (auto row = top / TILE_SIZE; row <= bottom / TILE_SIZE; row++) {
+                    add(row, entry);
+                }
+            }
+        }
+    });
+}
+
+void CpuRenderer::RenderTile(int column, int row, gfx::Rasterizer& rasterizer) {
+    auto tile = TileBounds(column, row);
+    for (const auto& rect : damage.Region().Rects()) {
+        auto area = gfx::Intersect(tile, rect);
+        if (!area.IsEmpty()) {
+            RenderArea(area, column, row, rasterizer);
+        }
+    }
+}
+
+void CpuRenderer::RenderArea(const gfx::IntRect& area, int column, int row, gfx::Rasterizer& rasterizer) {
+    if (backdrop) {
+        gfx::CopyRect(target, *backdrop, area);
+    }
+    else {
+        gfx::FillRect(target, area, background, blend_space);
+    }
+
+    auto bin = bins.Row(row);
+    std::size_t i = 0;
+    while (i < bin.size()) {
+        auto command_index = bin[i].command;
+        const auto& command = commands[command_index];
+        auto clip = gfx::Intersect(area, command.bounds);
+
+        if (clip.IsEmpty()) {
+            while (i < bin.size() && bin[i].command == command_index) {
+                i++;
+            }
+            continue;
+        }
+
+        // Edges left of the area still matter: they land in the rasterizer's backdrop.
+        rasterizer.Reset(clip);
+        for (; i < bin.size() && bin[i].command == command_index; i++) {
+            if (bin[i].first_column <= column) {
+                rasterizer.AddEdge(edges[bin[i].edge]);
+            }
+        }
+
+        rasterizer.Sweep([&](int y, int x, int length, const std::uint8_t* coverage) {
+            gfx::ShadeSpan(target, command.paint, x, y, length, coverage);
+        });
+    }
+}
+
+void CpuRenderer::RenderAtlas() {
+    auto screen = target;
+
+    atlas_pixels.assign((std::size_t)atlas.Width() * atlas.Height() * 4, 0);
+    atlas_surface = { atlas_pixels.data(), atlas.Width(), atlas.Height(), atlas.Width() * 4 };
+    target = atlas_surface;
+
+    edges.clear();
+    commands.clear();
+
+    auto black = gfx::Paint::Solid(MonsterScene::brush_color);
+    const auto& cells = atlas.Cells();
+
+    auto body_transformation = CrowdAtlas::CellTransformation(cells[CrowdAtlas::BODY_CELL]);
+    FillGeometry(monster_path, body_transformation, gfx::Paint::RadialGradient({ 0.0f, 0.0f },
+        MonsterScene::BODY_GRADIENT_RADIUS, MonsterScene::BODY_GRADIENT_RADIUS, body_gradient, body_transformation));
+    DrawGeometry(monster_path, body_transformation, black);
+    FillGeometry(left_eye_path, body_transformation, gfx::Paint::RadialGradient(MonsterScene::left_eye.center,
+        MonsterScene::EYE_RADIUS, MonsterScene::EYE_RADIUS, eye_gradient, body_transformation));
+    FillGeometry(right_eye_path, body_transformation, gfx::Paint::RadialGradient(MonsterScene::right_eye.center,
+        MonsterScene::EYE_RADIUS, MonsterScene::EYE_RADIUS, eye_gradient, body_transformation));
+
+    FillEllipse({ { 0.0f, 0.0f }, MonsterScene::EYE_BALL_RADIUS, MonsterScene::EYE_BALL_RADIUS },
+        CrowdAtlas::CellTransformation(cells[CrowdAtlas::BALL_CELL]), black);
+
+    for (auto expression : { Expression::Sad, Expression::Smile }) {
+        for (int frame = 0; frame < CrowdAtlas::ANGLE_FRAMES; frame++) {
+            auto angle = CrowdAtlas::FrameAngle(frame);
+            const auto& cell = cells[CrowdAtlas::MouthCell(angle, expression)];
+            auto transformation = gfx::Matrix3x2::Rotation(angle) * CrowdAtlas::CellTransformation(cell);
+
+            FillGeometry(nose_path, transformation, gfx::Paint::Solid(MonsterScene::nose_color));
+            DrawGeometry(nose_path, transformation, black);
+            DrawGeometry(expression == Expression::Smile ? smile_path : sad_path, transformation, black,
+                { .width = MonsterScene::MOUTH_STROKE_WIDTH });
+        }
+    }
+
+    background = { 0.0f, 0.0f, 0.0f, 0.0f };
+    damage.Full(TargetBounds());
+    RenderCommands();
+
+    // The screen target is untouched, but the atlas pass replaced its damage history.
+    target = screen;
+    damage.Invalidate();
+}
+
+void CpuRenderer::BinSprites() {
+    UpdateTileGrid();
+
+    sprite_bins = BinTiles<std::uint32_t>([&](auto&& add) {
+        for (std::uint32_t i = 0; i < sprites.size(); i++) {
+            auto bounds = gfx::Intersect(gfx::RoundOut(sprites[i].destination), { 0, 0, target.width, target.height });
+            if (bounds.IsEmpty()) {
+                continue;
+            }
+            for (auto row = bounds.top / TILE_SIZE; row <= (bounds.bottom - 1) / TILE_SIZE; row++) {
+                add(row, i);
+            }
+        }
+    });
+}
+
+void CpuRenderer::RenderCrowdTile(int column, int row) {
+    auto tile = TileBounds(column, row);
+
+    gfx::FillRect(target, tile, background, blend_space);
+
+    const auto& cells = atlas.Cells();
+    for (auto index : sprite_bins.Row(row)) {
+        const auto& sprite = sprites[index];
+        if (sprite.destination.right <= tile.left || sprite.destination.left >= tile.right) {
+            continue;
+        }
+        gfx::DrawBitmap(target, tile, atlas_surface, cells[sprite.cell].pixels, sprite.destination, blend_space);
+    }
+}
+
+gfx::IntRect CpuRenderer::TileBounds(int column, int row) const {
+    return {
+        column * TILE_SIZE, row * TILE_SIZE,
+        std::min((column + 1) * TILE_SIZE, target.width), std::min((row + 1) * TILE_SIZE, target.height)
+    };
+}
+
+void CpuRenderer::UpdateTileGrid() {
+    tile_columns = (target.width + TILE_SIZE - 1) / TILE_SIZE;
+    tile_rows = (target.height + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+void CpuRenderer::ForEachTile(const ThreadPool::Task& task) {
+    auto tile_count = (std::size_t)tile_columns * tile_rows;
+    if (pool) {
+        pool->ParallelFor(tile_count, task);
+    }
+    else {
+        for (std::size_t index = 0; index < tile_count; index++) {
+            task(index, 0);
+        }
+    }
+}
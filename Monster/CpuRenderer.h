@@ -0,0 +1,205 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "Damage.h"
+#include "FlatteningCache.h"
+#include "FrameArena.h"
+#include "Morph.h"
+#include "Rasterizer.h"
+#include "RenderTargetPool.h"
+#include "Stroke.h"
+#include "ThreadPool.h"
+#include <array>
+#include <filesystem>
+#include <vector>
+
+// Portable renderer that draws the same scene as the Direct2D backend into a
+// caller-owned BGRA8 buffer. Does not depend on Windows, so it can run headless.
+//
+// A frame is recorded as a list of fill commands whose edges are binned into rows of
+// TILE_SIZE x TILE_SIZE tiles. Every tile then replays the commands that touch it on
+// its own, so tiles can be rendered in any order or in parallel and still produce
+// exactly the same pixels.
+//
+// The body and eye sockets only change with the transformation, so they are rendered
+// once into a layer the size of the target, and frames copy from it instead of
+// clearing to the background. Only the eyeballs, nose and mouth are rasterized each
+// frame.
+//
+// Consecutive frames of the scene only redraw the pixels its moving parts cover now or
+// covered in the previous frame, which relies on the target keeping what was drawn
+// last. Crowds and the first frame on a new target are drawn in full.
+//
+// Nothing a frame needs outlives it, so once the buffers it keeps between frames have
+// grown to fit, a frame of the same scene makes no calls into the heap. The tile bins
+// and stroking scratch come from a FrameArena reset at the end of every frame; edges,
+// commands and each thread's Rasterizer keep their capacity instead. Tiles allocate
+// nothing, so the pool's threads have no arenas of their own: the cells and coverage of
+// their Rasterizers, sized for one tile, are all the scratch they use.
+class CpuRenderer : public RenderBackend {
+public:
+    static constexpr int TILE_SIZE = 64;
+
+    static constexpr float BAKE_MIN_SCALE = 0.25f;
+    static constexpr float BAKE_MAX_SCALE = 16.0f;
+
+    CpuRenderer();
+
+    // The surface must stay valid until the next call to SetTarget. Setting a different
+    // surface redraws it in full on the next frame.
+    void SetTarget(const gfx::Surface& surface);
+
+    // For count surfaces that take turns as the target, like the slots of a FrameSink.
+    // SetTarget then gets them in the same order every frame, and a frame only redraws
+    // what changed since its surface was last drawn. With more surfaces than
+    // DamageTracker::MAX_BUFFER_AGE, every frame is drawn in full. The default is 1.
+    void SetTargetCount(int count);
+
+    // Redraws everything on the next frame, for targets that were written to elsewhere.
+    void InvalidateTarget();
+
+    // Pixels the last frame wrote.
+    const gfx::DamageRegion& Damage() const { return damage.Region(); }
+
+    // Memory of the frame being drawn, for its counters.
+    const gfx::FrameArena& Arena() const { return frame_arena; }
+
+    // Layer buffers allocated so far. Layers are pooled by size class, so resizing the
+    // target only allocates when it moves to a class it hasn't used recently.
+    std::uint64_t LayerAllocations() const { return layer_pool.Allocations(); }
+
+    // Renders tiles on the pool; nullptr renders them on the calling thread.
+    void SetThreadPool(ThreadPool* pool);
+
+    // Blends in linear light instead of the stored space Direct2D blends 8-bit targets
+    // in. Changing it redraws everything, cached layers included.
+    void SetBlendSpace(gfx::BlendSpace space);
+
+    void Render(const SceneState& scene) override;
+
+    // Offline step: flattens every path for scales between BAKE_MIN_SCALE and
+    // BAKE_MAX_SCALE and writes them to filename.
+    bool BakeGeometry(const std::filesystem::path& filename);
+
+    // Maps a file written by BakeGeometry and flattens from it. Returns false if the file
+    // is missing, stale or corrupt; paths are then flattened at runtime as before.
+    bool LoadGeometry(const std::filesystem::path& filename);
+
+    // Copies pre-rendered parts from a sprite atlas instead of rasterizing every
+    // monster. The atlas is rendered on first use.
+    void RenderCrowd(const Crowd& crowd) override;
+
+private:
+    struct DrawCommand {
+        std::size_t first_edge = 0, edge_count = 0;
+        gfx::IntRect bounds;
+        gfx::Paint paint;
+    };
+
+    // An edge of a command that crosses a tile row. first_column is the leftmost tile
+    // column the edge reaches; tiles left of it never see the edge.
+    struct BinEntry {
+        std::uint32_t command;
+        std::uint32_t edge;
+        std::int32_t first_column;
+    };
+
+    gfx::Surface target;
+    int target_count = 1;
+    // What every tile starts from: the backdrop surface if there is one, otherwise the
+    // background color.
+    gfx::Color background;
+    const gfx::Surface* backdrop = nullptr;
+    gfx::DamageTracker damage;
+    ThreadPool* pool = nullptr;
+    gfx::BlendSpace blend_space = gfx::BlendSpace::Stored;
+
+    gfx::Path monster_path;
+    gfx::Path nose_path;
+    gfx::Path smile_path, sad_path;
+    gfx::Path left_eye_path, right_eye_path;
+    // Eyeballs are this, scaled and moved, so every path stays the same and can be cached.
+    gfx::Path unit_circle_path;
+
+    // From the sad mouth to the smile. Blends are flattened every frame instead of cached.
+    gfx::PathMorph mouth_morph;
+    gfx::Path mouth_path;
+    gfx::FlattenedPath mouth_flattened;
+
+    gfx::GradientLut body_gradient, eye_gradient;
+
+    gfx::FlatteningCache flattening_cache;
+    gfx::StrokeCache stroke_cache;
+    gfx::FlattenedPath flattened, stroked;
+    std::vector<gfx::Edge> edges;
+    std::vector<DrawCommand> commands;
+
+    // Entries of every row of tiles, packed row after row into one array.
+    template <class Entry>
+    struct TileBins {
+        std::span<std::uint32_t> starts;
+        std::span<Entry> entries;
+
+        std::span<const Entry> Row(int row) const {
+            return entries.subspan(starts[row], starts[row + 1] - starts[row]);
+        }
+    };
+
+    // Reset at the end of every frame.
+    gfx::FrameArena frame_arena;
+
+    int tile_columns = 0, tile_rows = 0;
+    TileBins<BinEntry> bins;
+    // One per thread of the pool, indexed by the thread a tile runs on. They stand in
+    // for per-thread arenas.
+    std::vector<gfx::Rasterizer> rasterizers;
+
+    // Background, body and eye sockets, for layer_transformation and the target's size.
+    // The buffer is as large as the size class of the target and layer_key.
+    std::vector<std::uint8_t> layer_pixels;
+    TargetKey layer_key;
+    RenderTargetPool<std::vector<std::uint8_t>> layer_pool;
+    gfx::Surface layer_surface;
+    gfx::Matrix3x2 layer_transformation;
+
+    CrowdAtlas atlas;
+    std::vector<std::uint8_t> atlas_pixels;
+    gfx::Surface atlas_surface;
+    std::vector<CrowdSprite> sprites;
+    TileBins<std::uint32_t> sprite_bins;
+
+    void FillGeometry(const gfx::Path& path, const gfx::Matrix3x2& transformation, const gfx::Paint& paint);
+    void FillEllipse(const gfx::Ellipse& ellipse, const gfx::Matrix3x2& transformation, const gfx::Paint& paint);
+    void DrawGeometry(const gfx::Path& path, const gfx::Matrix3x2& transformation, const gfx::Paint& paint,
+        const gfx::StrokeStyle& style = {});
+    // Strokes a path already flattened in its local space, within tolerance there.
+    void DrawPolylines(gfx::FlatPathView path, const gfx::Matrix3x2& transformation, const gfx::Paint& paint,
+        const gfx::StrokeStyle& style, float tolerance);
+    void AddPolygons(const gfx::FlattenedPath& polygons, const gfx::Paint& paint);
+    void DrawMouth(float smile, const gfx::Matrix3x2& transformation, const gfx::Paint& paint);
+    void AddCommand(std::size_t first_edge, const gfx::Paint& paint);
+
+    void RenderCommands();
+    // for_each(add) calls add(row, entry) for every entry in every row, in order.
+    template <class Entry, class ForEach>
+    TileBins<Entry> BinTiles(ForEach&& for_each);
+    void BinCommands();
+    void RenderTile(int column, int row, gfx::Rasterizer& rasterizer);
+    void RenderArea(const gfx::IntRect& area, int column, int row, gfx::Rasterizer& rasterizer);
+
+    bool IsLayerValid(const gfx::Matrix3x2& transformation) const;
+    void RenderLayer(const gfx::Matrix3x2& transformation);
+
+    void RenderAtlas();
+    void BinSprites();
+    void RenderCrowdTile(int column, int row);
+
+    std::array<const gfx::Path*, 7> CachedPaths() const;
+    // Hands the levels of the monster's shapes flattened at compile time to the cache.
+    void AddBakedGeometry();
+
+    gfx::IntRect TargetBounds() const { return { 0, 0, target.width, target.height }; }
+    gfx::IntRect TileBounds(int column, int row) const;
+    void UpdateTileGrid();
+    void ForEachTile(const ThreadPool::Task& task);
+};
@@ -0,0 +1,158 @@
+#include "Crowd.h"
+#include "EyeTracking.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Room for the outline and the anti-aliased edge around every cell.
+constexpr float CELL_PADDING = 2.0f;
+
+gfx::Rect Union(const gfx::Rect& a, const gfx::Rect& b) {
+    return {
+        std::min(a.left, b.left), std::min(a.top, b.top),
+        std::max(a.right, b.right), std::max(a.bottom, b.bottom)
+    };
+}
+
+gfx::Rect Inflate(const gfx::Rect& rect, float amount) {
+    return { rect.left - amount, rect.top - amount, rect.right + amount, rect.bottom + amount };
+}
+
+}
+
+CrowdAtlas::CrowdAtlas() {
+    using gfx::Matrix3x2;
+
+    auto body = Inflate(MonsterScene::monster_shape.control_bounds, CELL_PADDING);
+    auto ball_extent = MonsterScene::EYE_BALL_RADIUS + CELL_PADDING;
+    gfx::Rect ball = { -ball_extent, -ball_extent, ball_extent, ball_extent };
+    auto mouth = Union(MonsterScene::nose_shape.control_bounds,
+        Union(MonsterScene::smile_shape.control_bounds, MonsterScene::sad_shape.control_bounds));
+    mouth = Inflate(mouth, MonsterScene::MOUTH_STROKE_WIDTH + CELL_PADDING);
+
+    std::vector<gfx::Rect> bounds = { body, ball };
+    for (int expression = 0; expression < 2; expression++) {
+        for (int frame = 0; frame < ANGLE_FRAMES; frame++) {
+            bounds.push_back(gfx::TransformBounds(mouth, Matrix3x2::Rotation(FrameAngle(frame))));
+        }
+    }
+
+    // Shelf packing, row by row.
+    int x = 0, y = 0, shelf_height = 0;
+    for (const auto& rect : bounds) {
+        auto cell_width = (int)std::ceil((rect.right - rect.left) * SCALE);
+        auto cell_height = (int)std::ceil((rect.bottom - rect.top) * SCALE);
+        if (x + cell_width > MAX_WIDTH) {
+            x = 0;
+            y += shelf_height;
+            shelf_height = 0;
+        }
+
+        cells.push_back({ rect, { x, y, x + cell_width, y + cell_height } });
+        x += cell_width;
+        shelf_height = std::max(shelf_height, cell_height);
+        width = std::max(width, x);
+    }
+    height = y + shelf_height;
+}
+
+std::size_t CrowdAtlas::MouthCell(float angle, Expression expression) {
+    auto position = (angle + MAX_ANGLE) / (2.0f * MAX_ANGLE) * (ANGLE_FRAMES - 1);
+    auto frame = std::clamp((int)std::lround(position), 0, ANGLE_FRAMES - 1);
+    return 2 + (std::size_t)expression * ANGLE_FRAMES + frame;
+}
+
+float CrowdAtlas::FrameAngle(int frame) {
+    return -MAX_ANGLE + 2.0f * MAX_ANGLE * frame / (ANGLE_FRAMES - 1);
+}
+
+gfx::Matrix3x2 CrowdAtlas::CellTransformation(const AtlasCell& cell) {
+    using gfx::Matrix3x2;
+
+    return Matrix3x2::Scale(SCALE, SCALE) * Matrix3x2::Translation(
+        cell.pixels.left - cell.bounds.left * SCALE, cell.pixels.top - cell.bounds.top * SCALE);
+}
+
+void Crowd::CopyAnimation(const Crowd& other) {
+    expression = other.expression;
+    angle = other.angle;
+    left_ball_x = other.left_ball_x;
+    left_ball_y = other.left_ball_y;
+    right_ball_x = other.right_ball_x;
+    right_ball_y = other.right_ball_y;
+}
+
+void Crowd::Clear() {
+    position_x.clear();
+    position_y.clear();
+    scale.clear();
+    phase.clear();
+    expression.clear();
+    angle.clear();
+    left_ball_x.clear();
+    left_ball_y.clear();
+    right_ball_x.clear();
+    right_ball_y.clear();
+}
+
+void Crowd::Add(gfx::Point position, float instance_scale, float instance_phase, Expression instance_expression) {
+    position_x.push_back(position.x);
+    position_y.push_back(position.y);
+    scale.push_back(instance_scale);
+    phase.push_back(instance_phase);
+    expression.push_back(instance_expression);
+
+    angle.push_back(0.0f);
+    left_ball_x.push_back(-MonsterScene::EYE_X_OFFSET);
+    left_ball_y.push_back(MonsterScene::EYE_Y_OFFSET);
+    right_ball_x.push_back(MonsterScene::EYE_X_OFFSET);
+    right_ball_y.push_back(MonsterScene::EYE_Y_OFFSET);
+}
+
+void Crowd::Update(double time, gfx::Point target) {
+    constexpr float ORBIT = MonsterScene::EYE_RADIUS - MonsterScene::EYE_BALL_RADIUS;
+
+    auto count = Size();
+
+    for (std::size_t i = 0; i < count; i++) {
+        angle[i] = MonsterScene::SwayAngle(time + phase[i]);
+    }
+
+    // The inverse of a scale and translation, written out.
+    local_target_x.resize(count);
+    local_target_y.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        auto inverse_scale = 1.0f / (MonsterScene::SCALE * scale[i]);
+        local_target_x[i] = (target.x - position_x[i]) * inverse_scale;
+        local_target_y[i] = (target.y - position_y[i]) * inverse_scale;
+    }
+
+    gfx::TrackEyes(MonsterScene::left_eye.center, ORBIT, local_target_x, local_target_y, left_ball_x, left_ball_y);
+    gfx::TrackEyes(MonsterScene::right_eye.center, ORBIT, local_target_x, local_target_y, right_ball_x, right_ball_y);
+}
+
+void Crowd::BuildSprites(const CrowdAtlas& atlas, std::vector<CrowdSprite>& sprites) const {
+    const auto& cells = atlas.Cells();
+    const auto& body = cells[CrowdAtlas::BODY_CELL].bounds;
+    const auto& ball = cells[CrowdAtlas::BALL_CELL].bounds;
+
+    sprites.resize(Size() * 4);
+    for (std::size_t i = 0; i < Size(); i++) {
+        auto s = MonsterScene::SCALE * scale[i];
+        auto x = position_x[i], y = position_y[i];
+        auto place = [&](const gfx::Rect& rect, float offset_x, float offset_y) {
+            return gfx::Rect{
+                x + (rect.left + offset_x) * s, y + (rect.top + offset_y) * s,
+                x + (rect.right + offset_x) * s, y + (rect.bottom + offset_y) * s
+            };
+        };
+
+        auto mouth = (std::uint32_t)CrowdAtlas::MouthCell(angle[i], expression[i]);
+        auto* sprite = &sprites[i * 4];
+        sprite[0] = { place(body, 0.0f, 0.0f), (std::uint32_t)CrowdAtlas::BODY_CELL };
+        sprite[1] = { place(ball, left_ball_x[i], left_ball_y[i]), (std::uint32_t)CrowdAtlas::BALL_CELL };
+        sprite[2] = { place(ball, right_ball_x[i], right_ball_y[i]), (std::uint32_t)CrowdAtlas::BALL_CELL };
+        sprite[3] = { place(cells[mouth].bounds, 0.0f, 0.0f), mouth };
+    }
+}
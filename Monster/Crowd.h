@@ -0,0 +1,85 @@
+#pragma once
+
+#include "MonsterScene.h"
+#include <cstdint>
+#include <vector>
+
+enum class Expression : std::uint8_t { Sad, Smile };
+
+// A pre-rendered part of the monster. bounds is the area it covers in the monster's
+// local space, pixels is where it lives in the atlas.
+struct AtlasCell {
+    gfx::Rect bounds;
+    gfx::IntRect pixels;
+};
+
+// Layout of the sprite atlas crowds are drawn from: the static body with its eye
+// sockets, one eyeball, and the nose and mouth pre-rotated to ANGLE_FRAMES angles for
+// each expression. Backends render the cells once and then only copy them.
+class CrowdAtlas {
+public:
+    // Atlas pixels per unit of the monster's local space.
+    static constexpr float SCALE = 2.0f;
+    static constexpr int ANGLE_FRAMES = 21;
+    static constexpr float MAX_ANGLE = 10.0f;
+    static constexpr int MAX_WIDTH = 2048;
+
+    static constexpr std::size_t BODY_CELL = 0;
+    static constexpr std::size_t BALL_CELL = 1;
+
+    CrowdAtlas();
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    const std::vector<AtlasCell>& Cells() const { return cells; }
+
+    static std::size_t MouthCell(float angle, Expression expression);
+    static float FrameAngle(int frame);
+
+    // Maps the cell's local bounds onto its atlas pixels.
+    static gfx::Matrix3x2 CellTransformation(const AtlasCell& cell);
+
+private:
+    int width = 0, height = 0;
+    std::vector<AtlasCell> cells;
+};
+
+struct CrowdSprite {
+    gfx::Rect destination;
+    std::uint32_t cell;
+};
+
+// Per-instance state of many independently animated monsters, stored as a structure
+// of arrays so updates stream through memory. Every monster shares the geometry and
+// style of MonsterScene; only its placement and animation state differ.
+struct Crowd {
+    // Positions are in target pixels; a scale of 1 is the size of the single monster.
+    std::vector<float> position_x, position_y;
+    std::vector<float> scale;
+    std::vector<float> phase;
+    std::vector<Expression> expression;
+
+    // Written by Update. Eyeballs are in each monster's local space.
+    std::vector<float> angle;
+    std::vector<float> left_ball_x, left_ball_y;
+    std::vector<float> right_ball_x, right_ball_y;
+
+    // Scratch space for Update: the target in each monster's local space.
+    std::vector<float> local_target_x, local_target_y;
+
+    std::size_t Size() const { return position_x.size(); }
+
+    void Clear();
+    void Add(gfx::Point position, float scale, float phase, Expression expression);
+
+    // Copies what changes from frame to frame, the expressions and what Update writes,
+    // into a copy of other that already has its monsters in the same places.
+    void CopyAnimation(const Crowd& other);
+
+    // time is animation time in seconds, as for MonsterScene::SwayAngle. Every monster
+    // looks at target.
+    void Update(double time, gfx::Point target);
+
+    // Four sprites per monster, in drawing order: body, eyeballs, nose and mouth.
+    void BuildSprites(const CrowdAtlas& atlas, std::vector<CrowdSprite>& sprites) const;
+};
@@ -0,0 +1,398 @@
+#include "D2DRenderer.h"
+#include <vector>
+
+namespace {
+
+D2D1_POINT_2F ToD2D(gfx::Point point) {
+    return D2D1::Point2F(point.x, point.y);
+}
+
+D2D1_COLOR_F ToD2D(const gfx::Color& color) {
+    return D2D1::ColorF(color.r, color.g, color.b, color.a);
+}
+
+D2D1_ELLIPSE ToD2D(const gfx::Ellipse& ellipse) {
+    return D2D1::Ellipse(ToD2D(ellipse.center), ellipse.radius_x, ellipse.radius_y);
+}
+
+D2D1::Matrix3x2F ToD2D(const gfx::Matrix3x2& matrix) {
+    return D2D1::Matrix3x2F(matrix.m11, matrix.m12, matrix.m21, matrix.m22, matrix.dx, matrix.dy);
+}
+
+// Forwards gfx::PathSink calls to a Direct2D geometry sink.
+class D2DPathSink : public gfx::PathSink {
+public:
+    explicit D2DPathSink(ID2D1GeometrySink* sink) : sink(sink) {}
+
+    void BeginFigure(gfx::Point start, gfx::FigureBegin begin) override {
+        sink->BeginFigure(ToD2D(start),
+            begin == gfx::FigureBegin::Filled ? D2D1_FIGURE_BEGIN_FILLED : D2D1_FIGURE_BEGIN_HOLLOW);
+    }
+
+    void AddLine(gfx::Point point) override {
+        sink->AddLine(ToD2D(point));
+    }
+
+    void AddBezier(gfx::Point control1, gfx::Point control2, gfx::Point end) override {
+        sink->AddBezier(D2D1::BezierSegment(ToD2D(control1), ToD2D(control2), ToD2D(end)));
+    }
+
+    void AddQuadraticBezier(gfx::Point control, gfx::Point end) override {
+        sink->AddQuadraticBezier(D2D1::QuadraticBezierSegment(ToD2D(control), ToD2D(end)));
+    }
+
+    void AddArc(const gfx::ArcSegment& arc) override {
+        sink->AddArc(D2D1::ArcSegment(ToD2D(arc.point), D2D1::SizeF(arc.radius_x, arc.radius_y), arc.rotation_angle,
+            arc.sweep_direction == gfx::SweepDirection::Clockwise ? D2D1_SWEEP_DIRECTION_CLOCKWISE : D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE,
+            arc.arc_size == gfx::ArcSize::Large ? D2D1_ARC_SIZE_LARGE : D2D1_ARC_SIZE_SMALL));
+    }
+
+    void EndFigure(gfx::FigureEnd end) override {
+        sink->EndFigure(end == gfx::FigureEnd::Closed ? D2D1_FIGURE_END_CLOSED : D2D1_FIGURE_END_OPEN);
+    }
+
+private:
+    ID2D1GeometrySink* sink;
+};
+
+winrt::com_ptr<ID2D1GradientStopCollection> CreateStops(ID2D1DeviceContext6* context, std::span<const gfx::GradientStop> stops) {
+    std::vector<D2D1_GRADIENT_STOP> d2d_stops;
+    for (const auto& stop : stops) {
+        d2d_stops.push_back({ .position = stop.position, .color = ToD2D(stop.color) });
+    }
+
+    winrt::com_ptr<ID2D1GradientStopCollection> collection;
+    winrt::check_hresult(context->CreateGradientStopCollection(d2d_stops.data(), (UINT32)d2d_stops.size(), collection.put()));
+    return collection;
+}
+
+}
+
+void D2DRenderer::CreateDeviceIndependentResources(ID2D1Factory7* factory) {
+    monster_path = CreatePath(factory, MonsterScene::CreateMonster);
+    nose_path = CreatePath(factory, MonsterScene::CreateNose);
+    smile_path = CreatePath(factory, MonsterScene::CreateSmile);
+    sad_path = CreatePath(factory, MonsterScene::CreateSad);
+
+    d2d_factory.copy_from(factory);
+    gfx::Path sad, smile;
+    MonsterScene::sad_shape.CopyTo(sad);
+    MonsterScene::smile_shape.CopyTo(smile);
+    const gfx::Path* mouths[] = { &sad, &smile };
+    mouth_morph.Build(mouths);
+    mouth_path = nullptr;
+}
+
+void D2DRenderer::CreateDeviceDependentResources(ID2D1DeviceContext6* context) {
+    using D2D1::RadialGradientBrushProperties;
+    using D2D1::Point2F;
+
+    d2d_context.copy_from(context);
+
+    main_brush = nullptr;
+    winrt::check_hresult(d2d_context->CreateSolidColorBrush(ToD2D(MonsterScene::brush_color), main_brush.put()));
+
+    auto rad_stops = CreateStops(context, MonsterScene::rad_stops_data);
+    main_rad_brush = nullptr;
+    winrt::check_hresult(d2d_context->CreateRadialGradientBrush(
+        RadialGradientBrushProperties(Point2F(0, 0), Point2F(0, 0),
+            MonsterScene::BODY_GRADIENT_RADIUS, MonsterScene::BODY_GRADIENT_RADIUS),
+        rad_stops.get(), main_rad_brush.put()));
+
+    auto eye_stops = CreateStops(context, MonsterScene::eye_stops_data);
+    left_eye_brush = nullptr;
+    winrt::check_hresult(d2d_context->CreateRadialGradientBrush(
+        RadialGradientBrushProperties(ToD2D(MonsterScene::left_eye.center), Point2F(0, 0),
+            MonsterScene::EYE_RADIUS, MonsterScene::EYE_RADIUS),
+        eye_stops.get(), left_eye_brush.put()));
+    right_eye_brush = nullptr;
+    winrt::check_hresult(d2d_context->CreateRadialGradientBrush(
+        RadialGradientBrushProperties(ToD2D(MonsterScene::right_eye.center), Point2F(0, 0),
+            MonsterScene::EYE_RADIUS, MonsterScene::EYE_RADIUS),
+        eye_stops.get(), right_eye_brush.put()));
+
+    // The atlas is rendered again on first use with the new device.
+    atlas_bitmap = nullptr;
+    sprite_batch = nullptr;
+    winrt::check_hresult(d2d_context->CreateSpriteBatch(sprite_batch.put()));
+
+    layer_bitmap = nullptr;
+    layer_pool.Clear();
+    nose_stroke = smile_stroke = sad_stroke = nullptr;
+    damage.Invalidate();
+}
+
+void D2DRenderer::SetProfiler(FrameProfiler* profiler) {
+    this->profiler = profiler;
+}
+
+void D2DRenderer::InvalidateTarget() {
+    damage.Invalidate();
+}
+
+void D2DRenderer::SetTargetSize(UINT width, UINT height) {
+    if (width != target_size.width || height != target_size.height) {
+        target_size = D2D1::SizeU(width, height);
+        damage.Invalidate();
+    }
+}
+
+void D2DRenderer::Render(const SceneState& scene) {
+    // Damage is tracked in pixels, while the scene is in DIPs.
+    FLOAT dpi_x, dpi_y;
+    d2d_context->GetDpi(&dpi_x, &dpi_y);
+    auto scale = dpi_x / 96.0f;
+    if (target_size.width == 0 || target_size.height == 0) {
+        return;
+    }
+    auto dynamic_bounds = MonsterScene::DynamicBounds(scene);
+    damage.Update(dynamic_bounds, scene.transformation, { 0, 0, (int)target_size.width, (int)target_size.height },
+        scale);
+
+    if (!IsLayerValid(scene.transformation)) {
+        CreateLayer(scene.transformation);
+    }
+    UpdateStrokes(ToD2D(scene.MouthTransformation()));
+
+    FrameProfiler::Zone draw_zone(profiler, FramePhase::DrawSubmission);
+    d2d_context->BeginDraw();
+    if (damage.IsFull()) {
+        DrawScene(scene);
+    }
+    else {
+        // Aliased clips on whole pixels, so nothing outside the damage is touched.
+        for (const auto& rect : damage.Region().Rects()) {
+            d2d_context->SetTransform(D2D1::Matrix3x2F::Identity());
+            d2d_context->PushAxisAlignedClip(D2D1::RectF(rect.left / scale, rect.top / scale,
+                rect.right / scale, rect.bottom / scale), D2D1_ANTIALIAS_MODE_ALIASED);
+            DrawScene(scene);
+            d2d_context->PopAxisAlignedClip();
+        }
+    }
+
+    FrameProfiler::Zone wait_zone(profiler, FramePhase::Wait);
+    winrt::check_hresult(d2d_context->EndDraw());
+}
+
+void D2DRenderer::DrawScene(const SceneState& scene) {
+    auto transformation = ToD2D(scene.transformation);
+    auto mouth_transformation = ToD2D(scene.MouthTransformation());
+
+    // The layer has the target's DPI, so it lands pixel for pixel. Source copy replaces
+    // what was there, like a clear.
+    d2d_context->SetTransform(D2D1::Matrix3x2F::Identity());
+    d2d_context->DrawImage(layer_bitmap.get(), nullptr, &layer_rect, D2D1_INTERPOLATION_MODE_NEAREST_NEIGHBOR,
+        D2D1_COMPOSITE_MODE_SOURCE_COPY);
+
+    d2d_context->SetTransform(transformation);
+    d2d_context->FillEllipse(ToD2D(scene.left_ball), main_brush.get());
+    d2d_context->FillEllipse(ToD2D(scene.right_ball), main_brush.get());
+
+    d2d_context->SetTransform(mouth_transformation);
+    main_brush->SetColor(ToD2D(MonsterScene::nose_color));
+    d2d_context->FillGeometry(nose_path.get(), main_brush.get());
+    main_brush->SetColor(ToD2D(MonsterScene::brush_color));
+    d2d_context->DrawGeometryRealization(nose_stroke.get(), main_brush.get());
+    DrawMouth(scene.smile);
+}
+
+void D2DRenderer::UpdateStrokes(const D2D1_MATRIX_3X2_F& transformation) {
+    FLOAT dpi_x, dpi_y;
+    d2d_context->GetDpi(&dpi_x, &dpi_y);
+    auto tolerance = D2D1::ComputeFlatteningTolerance(transformation, dpi_x, dpi_y);
+    if (nose_stroke && tolerance == stroke_tolerance) {
+        return;
+    }
+
+    auto realize = [&](ID2D1PathGeometry* path, FLOAT width, winrt::com_ptr<ID2D1GeometryRealization>& stroke) {
+        stroke = nullptr;
+        winrt::check_hresult(d2d_context->CreateStrokedGeometryRealization(path, tolerance, width, nullptr, stroke.put()));
+    };
+    realize(nose_path.get(), 1.0f, nose_stroke);
+    realize(smile_path.get(), MonsterScene::MOUTH_STROKE_WIDTH, smile_stroke);
+    realize(sad_path.get(), MonsterScene::MOUTH_STROKE_WIDTH, sad_stroke);
+    stroke_tolerance = tolerance;
+}
+
+void D2DRenderer::DrawMouth(float smile) {
+    if (smile <= 0.0f || smile >= 1.0f) {
+        d2d_context->DrawGeometryRealization(smile > 0.0f ? smile_stroke.get() : sad_stroke.get(), main_brush.get());
+        return;
+    }
+
+    if (!mouth_path || smile != mouth_smile) {
+        mouth_morph.Evaluate({ &smile, 1 }, mouth_points);
+        mouth_path = CreatePath(d2d_factory.get(), mouth_points);
+        mouth_smile = smile;
+    }
+    d2d_context->DrawGeometry(mouth_path.get(), main_brush.get(), MonsterScene::MOUTH_STROKE_WIDTH);
+}
+
+bool D2DRenderer::IsLayerValid(const gfx::Matrix3x2& transformation) const {
+    if (!layer_bitmap || layer_transformation != transformation) {
+        return false;
+    }
+
+    FLOAT target_dpi_x, target_dpi_y, layer_dpi_x, layer_dpi_y;
+    d2d_context->GetDpi(&target_dpi_x, &target_dpi_y);
+    layer_bitmap->GetDpi(&layer_dpi_x, &layer_dpi_y);
+    return target_size.width == layer_size.width && target_size.height == layer_size.height &&
+        target_dpi_x == layer_dpi_x && target_dpi_y == layer_dpi_y;
+}
+
+void D2DRenderer::CreateLayer(const gfx::Matrix3x2& transformation) {
+    FLOAT dpi_x, dpi_y;
+    d2d_context->GetDpi(&dpi_x, &dpi_y);
+
+    // Bitmaps of another DPI can't be drawn pixel for pixel, so the DPI is part of the key.
+    auto key = TargetKey::ForSize(target_size.width, target_size.height, (std::uint32_t)dpi_x);
+    if (!layer_bitmap || key != layer_key) {
+        if (layer_bitmap) {
+            layer_pool.Release(layer_key, std::move(layer_bitmap));
+        }
+        layer_bitmap = layer_pool.Acquire(key, [&](const TargetKey& key) {
+            D2D1_BITMAP_PROPERTIES1 properties = D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_TARGET,
+                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED), dpi_x, dpi_y);
+            winrt::com_ptr<ID2D1Bitmap1> bitmap;
+            winrt::check_hresult(d2d_context->CreateBitmap(D2D1::SizeU(key.width, key.height), nullptr, 0,
+                &properties, bitmap.put()));
+            return bitmap;
+        });
+        layer_key = key;
+    }
+    layer_transformation = transformation;
+    layer_size = target_size;
+    layer_rect = D2D1::RectF(0.0f, 0.0f, target_size.width * 96.0f / dpi_x, target_size.height * 96.0f / dpi_y);
+
+    winrt::com_ptr<ID2D1Image> previous_target;
+    d2d_context->GetTarget(previous_target.put());
+    d2d_context->SetTarget(layer_bitmap.get());
+
+    d2d_context->BeginDraw();
+    d2d_context->Clear(ToD2D(MonsterScene::background_color));
+
+    d2d_context->SetTransform(ToD2D(transformation));
+    d2d_context->FillGeometry(monster_path.get(), main_rad_brush.get());
+    d2d_context->DrawGeometry(monster_path.get(), main_brush.get());
+
+    d2d_context->FillEllipse(ToD2D(MonsterScene::left_eye), left_eye_brush.get());
+    d2d_context->FillEllipse(ToD2D(MonsterScene::right_eye), right_eye_brush.get());
+
+    winrt::check_hresult(d2d_context->EndDraw());
+    d2d_context->SetTarget(previous_target.get());
+}
+
+void D2DRenderer::RenderCrowd(const Crowd& crowd) {
+    if (!atlas_bitmap) {
+        CreateAtlas();
+    }
+
+    {
+        FrameProfiler::Zone zone(profiler, FramePhase::Geometry);
+        crowd.BuildSprites(atlas, sprites);
+
+        const auto& cells = atlas.Cells();
+        sprite_destinations.resize(sprites.size());
+        sprite_sources.resize(sprites.size());
+        for (std::size_t i = 0; i < sprites.size(); i++) {
+            const auto& destination = sprites[i].destination;
+            const auto& source = cells[sprites[i].cell].pixels;
+            sprite_destinations[i] = D2D1::RectF(destination.left, destination.top, destination.right, destination.bottom);
+            sprite_sources[i] = D2D1::RectU(source.left, source.top, source.right, source.bottom);
+        }
+
+        sprite_batch->Clear();
+        if (!sprites.empty()) {
+            winrt::check_hresult(sprite_batch->AddSprites((UINT32)sprites.size(),
+                sprite_destinations.data(), sprite_sources.data()));
+        }
+    }
+
+    damage.Full({ 0, 0, (int)target_size.width, (int)target_size.height });
+
+    FrameProfiler::Zone draw_zone(profiler, FramePhase::DrawSubmission);
+    d2d_context->BeginDraw();
+    d2d_context->Clear(ToD2D(MonsterScene::background_color));
+
+    // Sprite batches can only be drawn with aliased primitives; the edges of every
+    // sprite are transparent padding anyway.
+    d2d_context->SetTransform(D2D1::Matrix3x2F::Identity());
+    d2d_context->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+    d2d_context->DrawSpriteBatch(sprite_batch.get(), atlas_bitmap.get(), D2D1_BITMAP_INTERPOLATION_MODE_LINEAR);
+    d2d_context->SetAntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+
+    FrameProfiler::Zone wait_zone(profiler, FramePhase::Wait);
+    winrt::check_hresult(d2d_context->EndDraw());
+}
+
+void D2DRenderer::CreateAtlas() {
+    using D2D1::Matrix3x2F;
+
+    D2D1_BITMAP_PROPERTIES1 properties = D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_TARGET,
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED), 96.0f, 96.0f);
+    winrt::check_hresult(d2d_context->CreateBitmap(D2D1::SizeU(atlas.Width(), atlas.Height()),
+        nullptr, 0, &properties, atlas_bitmap.put()));
+
+    winrt::com_ptr<ID2D1Image> previous_target;
+    d2d_context->GetTarget(previous_target.put());
+    d2d_context->SetTarget(atlas_bitmap.get());
+
+    const auto& cells = atlas.Cells();
+
+    d2d_context->BeginDraw();
+    d2d_context->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+
+    d2d_context->SetTransform(ToD2D(CrowdAtlas::CellTransformation(cells[CrowdAtlas::BODY_CELL])));
+    d2d_context->FillGeometry(monster_path.get(), main_rad_brush.get());
+    d2d_context->DrawGeometry(monster_path.get(), main_brush.get());
+    d2d_context->FillEllipse(ToD2D(MonsterScene::left_eye), left_eye_brush.get());
+    d2d_context->FillEllipse(ToD2D(MonsterScene::right_eye), right_eye_brush.get());
+
+    d2d_context->SetTransform(ToD2D(CrowdAtlas::CellTransformation(cells[CrowdAtlas::BALL_CELL])));
+    d2d_context->FillEllipse(D2D1::Ellipse(D2D1::Point2F(0.0f, 0.0f), MonsterScene::EYE_BALL_RADIUS,
+        MonsterScene::EYE_BALL_RADIUS), main_brush.get());
+
+    for (auto expression : { Expression::Sad, Expression::Smile }) {
+        for (int frame = 0; frame < CrowdAtlas::ANGLE_FRAMES; frame++) {
+            auto angle = CrowdAtlas::FrameAngle(frame);
+            const auto& cell = cells[CrowdAtlas::MouthCell(angle, expression)];
+            d2d_context->SetTransform(Matrix3x2F::Rotation(angle) * ToD2D(CrowdAtlas::CellTransformation(cell)));
+
+            main_brush->SetColor(ToD2D(MonsterScene::nose_color));
+            d2d_context->FillGeometry(nose_path.get(), main_brush.get());
+            main_brush->SetColor(ToD2D(MonsterScene::brush_color));
+            d2d_context->DrawGeometry(nose_path.get(), main_brush.get());
+            d2d_context->DrawGeometry(expression == Expression::Smile ? smile_path.get() : sad_path.get(),
+                main_brush.get(), MonsterScene::MOUTH_STROKE_WIDTH);
+        }
+    }
+
+    winrt::check_hresult(d2d_context->EndDraw());
+    d2d_context->SetTarget(previous_target.get());
+}
+
+winrt::com_ptr<ID2D1PathGeometry> D2DRenderer::CreatePath(ID2D1Factory7* factory, void (*create)(gfx::PathSink&)) {
+    winrt::com_ptr<ID2D1PathGeometry> path;
+    winrt::com_ptr<ID2D1GeometrySink> path_sink;
+    winrt::check_hresult(factory->CreatePathGeometry(path.put()));
+    winrt::check_hresult(path->Open(path_sink.put()));
+
+    D2DPathSink sink(path_sink.get());
+    create(sink);
+    winrt::check_hresult(path_sink->Close());
+
+    return path;
+}
+
+winrt::com_ptr<ID2D1PathGeometry> D2DRenderer::CreatePath(ID2D1Factory7* factory, const gfx::Path& source) {
+    winrt::com_ptr<ID2D1PathGeometry> path;
+    winrt::com_ptr<ID2D1GeometrySink> path_sink;
+    winrt::check_hresult(factory->CreatePathGeometry(path.put()));
+    winrt::check_hresult(path->Open(path_sink.put()));
+
+    D2DPathSink sink(path_sink.get());
+    source.Replay(sink);
+    winrt::check_hresult(path_sink->Close());
+
+    return path;
+}
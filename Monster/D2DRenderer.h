@@ -0,0 +1,102 @@
+#pragma once
+
+#include "framework.h"
+#include "Profiler.h"
+#include "RenderBackend.h"
+#include "Damage.h"
+#include "Morph.h"
+#include "RenderTargetPool.h"
+#include <d2d1_3.h>
+#include <winrt/base.h>
+#include <vector>
+
+// Draws the scene with Direct2D into the current target of a device context.
+// Presenting is left to the owner of the swap chain.
+//
+// The background, body and eye sockets are drawn once into a layer bitmap and copied
+// in each frame; the layer is drawn again when the transformation, target size or DPI
+// changes, or the device is recreated. Layer bitmaps are pooled by size class, so
+// resizing only allocates one when the size moves to a class not used recently.
+//
+// Scene frames only redraw the damaged part of the target, assuming it is the back
+// buffer of a two-buffer swap chain that keeps its contents, so each buffer last saw
+// the frame before the previous one.
+class D2DRenderer : public RenderBackend {
+public:
+    void CreateDeviceIndependentResources(ID2D1Factory7* factory);
+    void CreateDeviceDependentResources(ID2D1DeviceContext6* context);
+
+    // Times geometry, draw submission and EndDraw into the profiler's current frame.
+    void SetProfiler(FrameProfiler* profiler);
+
+    // Redraws everything on the next frame, after the target's buffers were recreated.
+    void InvalidateTarget();
+
+    // Pixels of the target that are shown, from its top left corner. The target can be
+    // larger, to leave room for resizing. Changing it redraws everything.
+    void SetTargetSize(UINT width, UINT height);
+
+    // Layer bitmaps created so far.
+    std::uint64_t LayerAllocations() const { return layer_pool.Allocations(); }
+
+    // Pixels the last frame drew, to pass on as dirty rectangles when presenting.
+    const gfx::DamageRegion& Damage() const { return damage.Region(); }
+    bool IsFullDamage() const { return damage.IsFull(); }
+
+    void Render(const SceneState& scene) override;
+
+    // Draws every monster with a single sprite batch over a pre-rendered atlas.
+    void RenderCrowd(const Crowd& crowd) override;
+
+private:
+    winrt::com_ptr<ID2D1DeviceContext6> d2d_context;
+    FrameProfiler* profiler = nullptr;
+    gfx::DamageTracker damage{ 2 };
+    D2D1_SIZE_U target_size = {};
+
+    winrt::com_ptr<ID2D1SolidColorBrush> main_brush;
+    winrt::com_ptr<ID2D1RadialGradientBrush> main_rad_brush;
+    winrt::com_ptr<ID2D1RadialGradientBrush> left_eye_brush;
+    winrt::com_ptr<ID2D1RadialGradientBrush> right_eye_brush;
+    winrt::com_ptr<ID2D1PathGeometry> monster_path;
+    winrt::com_ptr<ID2D1PathGeometry> nose_path;
+    winrt::com_ptr<ID2D1PathGeometry> smile_path, sad_path;
+
+    // The nose outline and both mouths are drawn every frame, so they are outlined once
+    // for the current flattening tolerance and drawn at any rotation from then on.
+    winrt::com_ptr<ID2D1GeometryRealization> nose_stroke, smile_stroke, sad_stroke;
+    FLOAT stroke_tolerance = 0.0f;
+
+    // Blends between the sad mouth and the smile get a geometry of their own, built again
+    // only when the blend changes.
+    winrt::com_ptr<ID2D1Factory7> d2d_factory;
+    gfx::PathMorph mouth_morph;
+    gfx::Path mouth_points;
+    winrt::com_ptr<ID2D1PathGeometry> mouth_path;
+    float mouth_smile = -1.0f;
+
+    // Drawn for layer_transformation and layer_size, in its top left layer_rect.
+    winrt::com_ptr<ID2D1Bitmap1> layer_bitmap;
+    TargetKey layer_key;
+    RenderTargetPool<winrt::com_ptr<ID2D1Bitmap1>> layer_pool;
+    gfx::Matrix3x2 layer_transformation;
+    D2D1_SIZE_U layer_size = {};
+    D2D1_RECT_F layer_rect = {};
+
+    CrowdAtlas atlas;
+    winrt::com_ptr<ID2D1Bitmap1> atlas_bitmap;
+    winrt::com_ptr<ID2D1SpriteBatch> sprite_batch;
+    std::vector<CrowdSprite> sprites;
+    std::vector<D2D1_RECT_F> sprite_destinations;
+    std::vector<D2D1_RECT_U> sprite_sources;
+
+    void DrawScene(const SceneState& scene);
+    void UpdateStrokes(const D2D1_MATRIX_3X2_F& transformation);
+    void DrawMouth(float smile);
+    bool IsLayerValid(const gfx::Matrix3x2& transformation) const;
+    void CreateLayer(const gfx::Matrix3x2& transformation);
+    void CreateAtlas();
+
+    static winrt::com_ptr<ID2D1PathGeometry> CreatePath(ID2D1Factory7* factory, void (*create)(gfx::PathSink&));
+    static winrt::com_ptr<ID2D1PathGeometry> CreatePath(ID2D1Factory7* factory, const gfx::Path& source);
+};
@@ -0,0 +1,145 @@
+#include "Damage.h"
+#include <algorithm>
+#include <limits>
+
+namespace gfx {
+
+namespace {
+
+IntRect Union(const IntRect& a, const IntRect& b) {
+    return {
+        std::min(a.left, b.left), std::min(a.top, b.top),
+        std::max(a.right, b.right), std::max(a.bottom, b.bottom)
+    };
+}
+
+std::int64_t Area(const IntRect& rect) {
+    return (std::int64_t)rect.Width() * rect.Height();
+}
+
+// Touching counts, so neighbors become one rectangle instead of two.
+bool Touches(const IntRect& a, const IntRect& b) {
+    return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+}
+
+void DamageRegion::Add(IntRect rect) {
+    if (rect.IsEmpty()) {
+        return;
+    }
+
+    // Merging can make the rectangle reach others, so look again after every merge.
+    for (std::size_t i = 0; i < count;) {
+        if (Touches(rects[i], rect)) {
+            rect = Union(rects[i], rect);
+            Remove(i);
+            i = 0;
+        }
+        else {
+            i++;
+        }
+    }
+    rects[count++] = rect;
+
+    if (count > MAX_RECTS) {
+        std::size_t best_a = 0, best_b = 1;
+        auto best_waste = std::numeric_limits<std::int64_t>::max();
+        for (std::size_t a = 0; a < count; a++) {
+            for (std::size_t b = a + 1; b < count; b++) {
+                auto waste = gfx::Area(Union(rects[a], rects[b])) - gfx::Area(rects[a]) - gfx::Area(rects[b]);
+                if (waste < best_waste) {
+                    best_waste = waste;
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
+
+        auto merged = Union(rects[best_a], rects[best_b]);
+        Remove(best_b);
+        Remove(best_a);
+        Add(merged);
+    }
+}
+
+void DamageRegion::Add(const DamageRegion& other) {
+    for (const auto& rect : other.Rects()) {
+        Add(rect);
+    }
+}
+
+std::int64_t DamageRegion::Area() const {
+    std::int64_t area = 0;
+    for (const auto& rect : Rects()) {
+        area += gfx::Area(rect);
+    }
+    return area;
+}
+
+bool DamageRegion::Intersects(const IntRect& rect) const {
+    for (const auto& damage : Rects()) {
+        if (!Intersect(damage, rect).IsEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DamageRegion::Remove(std::size_t index) {
+    rects[index] = rects[--count];
+}
+
+DamageTracker::DamageTracker(int buffer_age) : buffer_age(std::clamp(buffer_age, 1, MAX_BUFFER_AGE)) {}
+
+void DamageTracker::Invalidate() {
+    history_count = 0;
+}
+
+const DamageRegion& DamageTracker::Full(IntRect target) {
+    history_count = 0;
+    full = true;
+    region.Clear();
+    region.Add(target);
+    return region;
+}
+
+const DamageRegion& DamageTracker::Update(std::span<const Rect> dynamic_bounds, const Matrix3x2& transformation,
+    IntRect target, float scale) {
+    auto same_target = target.left == this->target.left && target.top == this->target.top &&
+        target.right == this->target.right && target.bottom == this->target.bottom;
+    if (!same_target || transformation != this->transformation || scale != this->scale) {
+        history_count = 0;
+    }
+    this->target = target;
+    this->transformation = transformation;
+    this->scale = scale;
+
+    std::rotate(history.rbegin(), history.rbegin() + 1, history.rend());
+    auto& current = history[0];
+    current.Clear();
+    for (const auto& bounds : dynamic_bounds) {
+        // A pixel of slack for antialiasing that reaches past the geometry.
+        auto pixels = RoundOut({ bounds.left * scale - 1.0f, bounds.top * scale - 1.0f,
+            bounds.right * scale + 1.0f, bounds.bottom * scale + 1.0f });
+        current.Add(Intersect(pixels, target));
+    }
+
+    // Until the back buffer has seen buffer_age frames with this transformation, parts
+    // of it are from before and everything has to be drawn.
+    full = history_count < buffer_age;
+    history_count = std::min(history_count + 1, MAX_BUFFER_AGE);
+
+    region.Clear();
+    if (full) {
+        region.Add(target);
+    }
+    else {
+        for (int i = 0; i <= buffer_age; i++) {
+            region.Add(history[i]);
+        }
+    }
+    return region;
+}
+
+}
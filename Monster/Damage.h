@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Geometry.h"
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace gfx {
+
+// Pixels that need redrawing, as a handful of rectangles. Overlapping rectangles are
+// merged as they come in, and past MAX_RECTS the two that waste the least area when
+// merged are, so the region stays cheap to clip to.
+class DamageRegion {
+public:
+    static constexpr std::size_t MAX_RECTS = 4;
+
+    void Clear() { count = 0; }
+    void Add(IntRect rect);
+    void Add(const DamageRegion& other);
+
+    bool IsEmpty() const { return count == 0; }
+    std::span<const IntRect> Rects() const { return { rects.data(), count }; }
+    std::int64_t Area() const;
+    bool Intersects(const IntRect& rect) const;
+
+private:
+    std::array<IntRect, MAX_RECTS + 1> rects;
+    std::size_t count = 0;
+
+    void Remove(std::size_t index);
+};
+
+// Works out what to redraw each frame for a scene whose only moving parts are a few
+// shapes over a static background.
+//
+// The region covers where the moving parts are now and where they were in every frame
+// the back buffer hasn't seen yet: buffer_age is 1 for a buffer that keeps the last
+// frame, 2 for a swap chain that alternates between two buffers, and so on. The whole
+// target is redrawn after Invalidate, and whenever the target or the scene's
+// transformation change.
+class DamageTracker {
+public:
+    static constexpr int MAX_BUFFER_AGE = 3;
+
+    explicit DamageTracker(int buffer_age = 1);
+
+    void Invalidate();
+
+    // For frames drawn some other way: the whole target, and the next Update starts over.
+    const DamageRegion& Full(IntRect target);
+
+    // dynamic_bounds are in the scene's target units; scale turns them into pixels.
+    const DamageRegion& Update(std::span<const Rect> dynamic_bounds, const Matrix3x2& transformation,
+        IntRect target, float scale = 1.0f);
+
+    const DamageRegion& Region() const { return region; }
+    // Whether the last Update asked for the whole target.
+    bool IsFull() const { return full; }
+
+private:
+    int buffer_age;
+    // Moving parts of this frame and the ones before, newest first. Only the first
+    // history_count are from frames with the current target and transformation.
+    std::array<DamageRegion, MAX_BUFFER_AGE + 1> history;
+    int history_count = 0;
+
+    IntRect target;
+    Matrix3x2 transformation;
+    float scale = 1.0f;
+
+    DamageRegion region;
+    bool full = true;
+};
+
+}
@@ -0,0 +1,107 @@
+#include "EyeTracking.h"
+#include <cassert>
+
+namespace gfx {
+
+namespace {
+
+void TrackEyesScalar(Point eye, float orbit, const float* target_x, const float* target_y,
+    float* ball_x, float* ball_y, std::size_t begin, std::size_t end) {
+    for (auto i = begin; i < end; i++) {
+        auto ball = TrackEye(eye, orbit, { target_x[i], target_y[i] });
+        ball_x[i] = ball.x;
+        ball_y[i] = ball.y;
+    }
+}
+
+#if GFX_SIMD_X86
+
+void TrackEyesSse2(Point eye, float orbit, const float* target_x, const float* target_y,
+    float* ball_x, float* ball_y, std::size_t count) {
+    auto eye_x = _mm_set1_ps(eye.x), eye_y = _mm_set1_ps(eye.y);
+    auto orbit4 = _mm_set1_ps(orbit), orbit_squared = _mm_set1_ps(orbit * orbit);
+    auto half = _mm_set1_ps(0.5f), three_halves = _mm_set1_ps(1.5f);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto tx = _mm_loadu_ps(target_x + i), ty = _mm_loadu_ps(target_y + i);
+        auto dx = _mm_sub_ps(tx, eye_x), dy = _mm_sub_ps(ty, eye_y);
+        auto dist_squared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+        // r = r * (1.5 - 0.5 * d * r * r) brings the 12 bit estimate to about 23 bits.
+        auto r = _mm_rsqrt_ps(dist_squared);
+        auto half_r = _mm_mul_ps(_mm_mul_ps(half, dist_squared), r);
+        r = _mm_mul_ps(r, _mm_sub_ps(three_halves, _mm_mul_ps(half_r, r)));
+        auto fac = _mm_mul_ps(orbit4, r);
+
+        // Lanes inside the orbit take the target as is, which also discards the
+        // infinities a zero distance produces.
+        auto inside = _mm_cmple_ps(dist_squared, orbit_squared);
+        auto bx = _mm_add_ps(eye_x, _mm_mul_ps(dx, fac));
+        auto by = _mm_add_ps(eye_y, _mm_mul_ps(dy, fac));
+        _mm_storeu_ps(ball_x + i, _mm_or_ps(_mm_and_ps(inside, tx), _mm_andnot_ps(inside, bx)));
+        _mm_storeu_ps(ball_y + i, _mm_or_ps(_mm_and_ps(inside, ty), _mm_andnot_ps(inside, by)));
+    }
+
+    TrackEyesScalar(eye, orbit, target_x, target_y, ball_x, ball_y, i, count);
+}
+
+GFX_TARGET_AVX2
+void TrackEyesAvx2(Point eye, float orbit, const float* target_x, const float* target_y,
+    float* ball_x, float* ball_y, std::size_t count) {
+    auto eye_x = _mm256_set1_ps(eye.x), eye_y = _mm256_set1_ps(eye.y);
+    auto orbit8 = _mm256_set1_ps(orbit), orbit_squared = _mm256_set1_ps(orbit * orbit);
+    auto half = _mm256_set1_ps(0.5f), three_halves = _mm256_set1_ps(1.5f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        auto tx = _mm256_loadu_ps(target_x + i), ty = _mm256_loadu_ps(target_y + i);
+        auto dx = _mm256_sub_ps(tx, eye_x), dy = _mm256_sub_ps(ty, eye_y);
+        auto dist_squared = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+
+        auto r = _mm256_rsqrt_ps(dist_squared);
+        auto half_r = _mm256_mul_ps(_mm256_mul_ps(half, dist_squared), r);
+        r = _mm256_mul_ps(r, _mm256_fnmadd_ps(half_r, r, three_halves));
+        auto fac = _mm256_mul_ps(orbit8, r);
+
+        auto inside = _mm256_cmp_ps(dist_squared, orbit_squared, _CMP_LE_OQ);
+        auto bx = _mm256_fmadd_ps(dx, fac, eye_x);
+        auto by = _mm256_fmadd_ps(dy, fac, eye_y);
+        _mm256_storeu_ps(ball_x + i, _mm256_blendv_ps(bx, tx, inside));
+        _mm256_storeu_ps(ball_y + i, _mm256_blendv_ps(by, ty, inside));
+    }
+
+    TrackEyesScalar(eye, orbit, target_x, target_y, ball_x, ball_y, i, count);
+}
+
+#endif
+
+}
+
+void TrackEyes(Point eye, float orbit, std::span<const float> target_x, std::span<const float> target_y,
+    std::span<float> ball_x, std::span<float> ball_y) {
+    TrackEyes(eye, orbit, target_x, target_y, ball_x, ball_y, DetectSimdLevel());
+}
+
+void TrackEyes(Point eye, float orbit, std::span<const float> target_x, std::span<const float> target_y,
+    std::span<float> ball_x, std::span<float> ball_y, SimdLevel level) {
+    assert(target_y.size() == target_x.size());
+    assert(ball_x.size() == target_x.size() && ball_y.size() == target_x.size());
+
+    auto count = target_x.size();
+
+#if GFX_SIMD_X86
+    if (level == SimdLevel::Avx2) {
+        TrackEyesAvx2(eye, orbit, target_x.data(), target_y.data(), ball_x.data(), ball_y.data(), count);
+        return;
+    }
+    if (level == SimdLevel::Sse2) {
+        TrackEyesSse2(eye, orbit, target_x.data(), target_y.data(), ball_x.data(), ball_y.data(), count);
+        return;
+    }
+#endif
+
+    TrackEyesScalar(eye, orbit, target_x.data(), target_y.data(), ball_x.data(), ball_y.data(), 0, count);
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Geometry.h"
+#include "Simd.h"
+#include <cmath>
+#include <span>
+
+namespace gfx {
+
+// Where an eyeball centered within orbit of eye ends up when it looks at target: the
+// target itself while it is close enough, otherwise the point on the orbit towards it.
+inline Point TrackEye(Point eye, float orbit, Point target) {
+    auto dist_x = target.x - eye.x, dist_y = target.y - eye.y;
+    auto dist_squared = dist_x * dist_x + dist_y * dist_y;
+    if (dist_squared <= orbit * orbit) {
+        return target;
+    }
+
+    auto fac = orbit / std::sqrt(dist_squared);
+    return { eye.x + dist_x * fac, eye.y + dist_y * fac };
+}
+
+// TrackEye for a whole array of targets, for example one per monster or one per
+// pointer. All spans must have the same length; the ball spans may be the target spans.
+//
+// The SIMD paths use a reciprocal square root estimate refined with one Newton-Raphson
+// step, so they can differ from TrackEye by a few units in the last place.
+void TrackEyes(Point eye, float orbit, std::span<const float> target_x, std::span<const float> target_y,
+    std::span<float> ball_x, std::span<float> ball_y);
+void TrackEyes(Point eye, float orbit, std::span<const float> target_x, std::span<const float> target_y,
+    std::span<float> ball_x, std::span<float> ball_y, SimdLevel level);
+
+}
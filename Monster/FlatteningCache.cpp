@@ -0,0 +1,109 @@
+#include "FlatteningCache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+FlatPathView FlatteningCache::Get(const Path& path, const Matrix3x2& transformation) {
+    return Get(path, LevelOfDetail(transformation.MaxScale()));
+}
+
+FlatPathView FlatteningCache::Get(const Path& path, int level) {
+    use_counter++;
+
+    auto [first, last] = mapped_entries.equal_range(&path);
+    for (auto it = first; it != last; ++it) {
+        if (it->second.level == level) {
+            return it->second.flattened;
+        }
+    }
+    for (auto& entry : entries) {
+        if (entry.path == &path && entry.level == level) {
+            entry.last_use = use_counter;
+            return entry.flattened;
+        }
+    }
+
+    // Reuse the least recently used entry once the cache is full.
+    Entry* entry;
+    if (entries.size() < MAX_ENTRIES) {
+        entry = &entries.emplace_back();
+    }
+    else {
+        entry = &*std::min_element(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.last_use < b.last_use;
+        });
+    }
+
+    entry->path = &path;
+    entry->level = level;
+    entry->last_use = use_counter;
+    entry->source_hash = HashPath(path);
+    entry->flattened.Clear();
+    FlattenPathAdaptive(path, Matrix3x2::Identity(), TOLERANCE / LevelScale(level), entry->flattened);
+    return entry->flattened;
+}
+
+void FlatteningCache::Bake(const Path& path, float min_scale, float max_scale) {
+    for (auto level = LevelOfDetail(min_scale); level <= LevelOfDetail(max_scale); level++) {
+        Get(path, level);
+    }
+}
+
+bool FlatteningCache::Save(const std::filesystem::path& filename) const {
+    std::vector<BakedPath> baked;
+    for (const auto& [path, entry] : mapped_entries) {
+        baked.push_back(entry);
+    }
+    for (const auto& entry : entries) {
+        baked.push_back({ entry.source_hash, entry.level, entry.flattened });
+    }
+    return GeometryFile::Write(filename, TOLERANCE, baked);
+}
+
+bool FlatteningCache::Load(const std::filesystem::path& filename, std::span<const Path* const> paths) {
+    mapped_entries.clear();
+    if (!file.Open(filename)) {
+        return false;
+    }
+    if (file.Tolerance() != TOLERANCE) {
+        file = GeometryFile();
+        return false;
+    }
+
+    std::unordered_multimap<std::uint64_t, const Path*> by_hash;
+    for (const auto* path : paths) {
+        by_hash.emplace(HashPath(*path), path);
+    }
+
+    for (const auto& baked : file.Paths()) {
+        auto [first, last] = by_hash.equal_range(baked.source_hash);
+        for (auto it = first; it != last; ++it) {
+            mapped_entries.emplace(it->second, baked);
+        }
+    }
+    return true;
+}
+
+void FlatteningCache::AddBaked(const Path& path, int level, FlatPathView flattened) {
+    mapped_entries.emplace(&path, BakedPath{ HashPath(path), level, flattened });
+}
+
+void FlatteningCache::Invalidate(const Path& path) {
+    std::erase_if(entries, [&](const Entry& entry) { return entry.path == &path; });
+    mapped_entries.erase(&path);
+}
+
+void FlatteningCache::Clear() {
+    entries.clear();
+    mapped_entries.clear();
+    file = GeometryFile();
+}
+
+int FlatteningCache::LevelOfDetail(float scale) {
+    // Below 1/1024 there is nothing left to see; clamping also keeps log2 finite.
+    scale = std::max(scale, 1.0f / 1024.0f);
+    return (int)std::ceil(std::log2(scale) * 2.0f);
+}
+
+}
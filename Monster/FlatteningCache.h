@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Geometry.h"
+#include "GeometryFile.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace gfx {
+
+// Flattened copies of paths in their own local space, one per level of detail, so a
+// path drawn at a new size or zoom only needs its points transformed again.
+//
+// Levels are half octaves of the transformation's scale. A level is flattened for
+// the largest scale it covers, so the polyline stays within TOLERANCE target pixels of
+// the curve for every transformation that falls into it.
+//
+// Entries are keyed by the address of the path; call Invalidate after changing a path
+// in place. Levels can also be baked into a GeometryFile and loaded from it later.
+class FlatteningCache {
+public:
+    static constexpr float TOLERANCE = 0.2f;
+    // Room for every level CpuRenderer::BakeGeometry flattens at once: 7 paths at the
+    // 13 levels from 0.25x to 16x. Fewer would evict levels before they are saved.
+    static constexpr std::size_t MAX_ENTRIES = 256;
+
+    // The view stays valid until the next call to Get, Bake, Load, Invalidate or Clear.
+    FlatPathView Get(const Path& path, const Matrix3x2& transformation);
+
+    // Flattens every level between the two scales ahead of time.
+    void Bake(const Path& path, float min_scale, float max_scale);
+
+    // Writes every cached level. The file must not be the one currently loaded.
+    bool Save(const std::filesystem::path& filename) const;
+
+    // Uses the levels in filename that were baked from one of paths, straight from the
+    // mapped file. Returns false if the file is missing, stale or corrupt, in which case
+    // paths are flattened on demand as usual.
+    bool Load(const std::filesystem::path& filename, std::span<const Path* const> paths);
+
+    // Uses flattened as path's level instead of flattening it, such as a StaticFlatPath
+    // baked at compile time. flattened has to outlive the cache; Load and Clear forget it.
+    void AddBaked(const Path& path, int level, FlatPathView flattened);
+
+    void Invalidate(const Path& path);
+    void Clear();
+
+    std::size_t Size() const { return entries.size() + mapped_entries.size(); }
+
+    static int LevelOfDetail(float scale);
+    static constexpr float LevelScale(int level) { return math::Exp2(level * 0.5f); }
+
+private:
+    struct Entry {
+        const Path* path = nullptr;
+        int level = 0;
+        std::uint64_t last_use = 0;
+        std::uint64_t source_hash = 0;
+        FlattenedPath flattened;
+    };
+
+
+    std::vector<Entry> entries;
+    std::uint64_t use_counter = 0;
+
+    GeometryFile file;
+    std::unordered_multimap<const Path*, BakedPath> mapped_entries;
+
+    FlatPathView Get(const Path& path, int level);
+};
+
+}
@@ -0,0 +1,49 @@
+#include "FrameArena.h"
+#include <algorithm>
+
+namespace gfx {
+
+void* FrameArena::Allocate(std::size_t size, std::size_t alignment) {
+    if (!blocks.empty()) {
+        auto& block = blocks.back();
+        auto address = reinterpret_cast<std::uintptr_t>(block.data.get()) + offset;
+        auto padding = (alignment - address % alignment) % alignment;
+        if (padding + size <= block.size - offset) {
+            auto* pointer = block.data.get() + offset + padding;
+            offset += padding + size;
+            used += padding + size;
+            return pointer;
+        }
+    }
+
+    // At least double the last block, so a frame that keeps growing takes few of them.
+    AddBlock(std::max({ MIN_BLOCK_SIZE, blocks.empty() ? 0 : 2 * blocks.back().size, size + alignment }));
+    return Allocate(size, alignment);
+}
+
+void FrameArena::Reset() {
+    peak = std::max(peak, used);
+    if (blocks.size() > 1) {
+        std::size_t total = 0;
+        for (const auto& block : blocks) {
+            total += block.size;
+        }
+        blocks.clear();
+        AddBlock(total);
+    }
+    offset = 0;
+    used = 0;
+}
+
+void FrameArena::AddBlock(std::size_t size) {
+    // The list of blocks grows on the heap too. Reset keeps its capacity, so once it
+    // has held the most blocks a frame needs it never grows again.
+    if (blocks.size() == blocks.capacity()) {
+        heap_allocations++;
+    }
+    blocks.push_back({ std::make_unique_for_overwrite<std::byte[]>(size), size });
+    offset = 0;
+    heap_allocations++;
+}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace gfx {
+
+// Bump allocator for memory that lives until the end of a frame. Allocating moves an
+// offset through the current block, and Reset gives everything back at once by moving
+// it to the start again. Nothing is freed on its own, and nothing is destroyed.
+//
+// A frame that outgrows its block goes on in a new one from the heap. The next Reset
+// replaces them with a single block big enough for the whole frame, so frames like it
+// never touch the heap again.
+class FrameArena {
+public:
+    static constexpr std::size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* Allocate(std::size_t size, std::size_t alignment);
+
+    // count zeroed Ts, for types that need no destructor.
+    template <class T>
+    std::span<T> AllocateArray(std::size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>);
+        auto* data = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        std::uninitialized_value_construct_n(data, count);
+        return { data, count };
+    }
+
+    // Everything allocated so far is free to be handed out again.
+    void Reset();
+
+    // Blocks taken from the heap so far, and times the list of them grew.
+    std::uint64_t HeapAllocations() const { return heap_allocations; }
+    // Bytes handed out since the last Reset, and the most handed out between two.
+    std::size_t Used() const { return used; }
+    std::size_t Peak() const { return std::max(peak, used); }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size = 0;
+    };
+
+    // Allocations come from the last one.
+    std::vector<Block> blocks;
+    std::size_t offset = 0;
+    std::size_t used = 0, peak = 0;
+    std::uint64_t heap_allocations = 0;
+
+    void AddBlock(std::size_t size);
+};
+
+// Lets standard containers allocate from a FrameArena, or from the heap when it is
+// null. Deallocating arena memory does nothing, so containers that grow leave their old
+// storage behind until the arena is reset.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(FrameArena* arena = nullptr) : arena(arena) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.Arena()) {}
+
+    T* allocate(std::size_t count) {
+        if (arena) {
+            return static_cast<T*>(arena->Allocate(sizeof(T) * count, alignof(T)));
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* pointer, std::size_t count) {
+        if (!arena) {
+            std::allocator<T>().deallocate(pointer, count);
+        }
+    }
+
+    FrameArena* Arena() const { return arena; }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.Arena(); }
+
+private:
+    FrameArena* arena;
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}
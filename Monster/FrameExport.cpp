@@ -0,0 +1,337 @@
+#include "FrameExport.h"
+#include "AnimationClock.h"
+#include "BoundedQueue.h"
+#include "CpuRenderer.h"
+#include "FrameSink.h"
+#include "ImageEncode.h"
+#include "MonsterScene.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <numbers>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Frames waiting between two stages.
+constexpr std::size_t QUEUE_DEPTH = 4;
+
+// The cursor the eyes follow goes around the monster once every LOOK_PERIOD seconds,
+// LOOK_RADIUS DIPs from its center. It smiles for the second half of every SMILE_PERIOD.
+constexpr double LOOK_PERIOD = 4.0;
+constexpr float LOOK_RADIUS = 150.0f;
+constexpr double SMILE_PERIOD = 2.0;
+
+using Clock = std::chrono::steady_clock;
+
+struct ExportFrame {
+    int index = 0;
+    // What the renderer drew, what the converter made of it and what the encoder made
+    // of that. Kept with the frame so buffers are reused instead of reallocated.
+    std::vector<std::uint8_t> pixels;
+    std::vector<std::uint8_t> converted;
+    std::vector<std::uint8_t> encoded;
+};
+
+using FramePointer = std::unique_ptr<ExportFrame>;
+
+double Seconds(Clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+gfx::Surface FrameSurface(ExportFrame& frame, const ExportSettings& settings) {
+    return { frame.pixels.data(), settings.width, settings.height, settings.width * 4 };
+}
+
+std::string Y4mHeader(const ExportSettings& settings) {
+    // Whole rates as they are, and NTSC-style rates like 29.97 over 1001.
+    long long numerator = std::llround(settings.fps), denominator = 1;
+    if (std::abs(settings.fps - (double)numerator) > 1e-6) {
+        numerator = std::llround(settings.fps * 1001.0);
+        denominator = 1001;
+    }
+
+    char header[128];
+    std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%lld:%lld Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n",
+        settings.width, settings.height, numerator, denominator);
+    return header;
+}
+
+// The scene of every frame in turn. The cursor the eyes follow circles the monster and
+// it smiles every other second.
+class ExportAnimation {
+public:
+    explicit ExportAnimation(const ExportSettings& settings)
+        : transformation(MonsterScene::DefaultTransformation((float)settings.width, (float)settings.height)),
+        center(transformation.TransformPoint({})) {
+        clock.SetDeterministic(1.0 / settings.fps);
+        clock.Reset();
+    }
+
+    SceneState Next() {
+        if (started) {
+            clock.Tick();
+        }
+        started = true;
+
+        auto time = clock.Time();
+        auto look = (float)(2.0 * std::numbers::pi * time / LOOK_PERIOD);
+        gfx::Point mouse = { center.x + LOOK_RADIUS * std::cos(look), center.y + LOOK_RADIUS * std::sin(look) };
+        auto smiling = std::fmod(time, SMILE_PERIOD) >= SMILE_PERIOD / 2.0;
+        smile = MonsterScene::StepExpression(smile, smiling, clock.FrameDelta());
+
+        auto scene = MonsterScene::CreateScene(transformation, MonsterScene::SwayAngle(time), mouse, false);
+        scene.smile = smile;
+        return scene;
+    }
+
+private:
+    AnimationClock clock;
+    gfx::Matrix3x2 transformation;
+    gfx::Point center;
+    float smile = 0.0f;
+    bool started = false;
+};
+
+// Frames for shared memory skip the pipeline: the renderer draws straight into the
+// ring's slots, and readers convert or encode them as they like.
+ExportResult SinkFrames(const ExportSettings& settings) {
+    ExportResult result;
+
+    FrameSink sink;
+    if (!sink.Create(settings.output.string(), settings.width, settings.height, settings.slots)) {
+        return result;
+    }
+
+    ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u));
+    CpuRenderer renderer;
+    renderer.SetThreadPool(&pool);
+    renderer.SetBlendSpace(settings.linear_light ? gfx::BlendSpace::Linear : gfx::BlendSpace::Stored);
+    renderer.SetTargetCount(sink.SlotCount());
+    result.baked_geometry = !settings.geometry.empty() && renderer.LoadGeometry(settings.geometry);
+
+    ExportAnimation animation(settings);
+    auto start = Clock::now();
+    for (int i = 0; i < settings.frame_count; i++) {
+        auto scene = animation.Next();
+        if (settings.paced) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(i / settings.fps)));
+        }
+
+        auto begin = Clock::now();
+        renderer.SetTarget(sink.BeginFrame());
+        renderer.Render(scene);
+        sink.EndFrame(SteadyNanoseconds());
+        result.render_seconds += Seconds(Clock::now() - begin);
+        result.frames++;
+    }
+
+    result.seconds = Seconds(Clock::now() - start);
+    result.succeeded = true;
+    return result;
+}
+
+// monster.png becomes monster_00000.png, monster_00001.png and so on.
+std::filesystem::path FramePath(const std::filesystem::path& output, int index) {
+    char number[16];
+    std::snprintf(number, sizeof(number), "_%05d", index);
+    auto path = output;
+    path.replace_filename(output.stem().string() + number + output.extension().string());
+    return path;
+}
+
+}
+
+ExportFormat ExportFormatFromExtension(const std::filesystem::path& output) {
+    auto extension = output.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return (char)std::tolower(c);
+    });
+
+    if (extension == ".y4m") {
+        return ExportFormat::Y4m;
+    }
+    if (extension == ".png") {
+        return ExportFormat::Png;
+    }
+    return ExportFormat::RawBgra;
+}
+
+ExportResult ExportFrames(const ExportSettings& settings) {
+    ExportResult result;
+
+    // The clock lets frames last at most MAX_FRAME_DELTA.
+    if (settings.width <= 0 || settings.height <= 0 || settings.width > ExportSettings::MAX_SIZE ||
+        settings.height > ExportSettings::MAX_SIZE || settings.frame_count <= 0 ||
+        !(settings.fps * AnimationClock::MAX_FRAME_DELTA >= 1.0)) {
+        return result;
+    }
+    if (settings.format == ExportFormat::SharedMemory) {
+        return SinkFrames(settings);
+    }
+
+    std::error_code error;
+    if (settings.output.has_parent_path()) {
+        std::filesystem::create_directories(settings.output.parent_path(), error);
+    }
+
+    // Y4M and raw frames all go to one file, PNGs to one file each.
+    std::ofstream stream;
+    if (settings.format != ExportFormat::Png) {
+        stream.open(settings.output, std::ios::binary | std::ios::trunc);
+        if (!stream) {
+            return result;
+        }
+        if (settings.format == ExportFormat::Y4m) {
+            stream << Y4mHeader(settings);
+        }
+    }
+
+    auto encode_threads = settings.format == ExportFormat::Png ? std::max(settings.encode_threads, 1u) : 1u;
+    auto hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    auto render_threads = hardware_threads > encode_threads + 1 ? hardware_threads - encode_threads - 1 : 1u;
+
+    // Enough frames for every queue and every thread to hold one, so a stage with work
+    // never waits for a free frame.
+    auto frame_pool = 3 * QUEUE_DEPTH + encode_threads + 2;
+    BoundedQueue<FramePointer> free_frames(frame_pool);
+    BoundedQueue<FramePointer> to_convert(QUEUE_DEPTH), to_encode(QUEUE_DEPTH), to_write(QUEUE_DEPTH);
+    for (std::size_t i = 0; i < frame_pool; i++) {
+        free_frames.Push(std::make_unique<ExportFrame>());
+    }
+
+    // Set by the writer when the disk fails; everything else then drains and stops.
+    std::atomic<bool> failed = false;
+    auto start = Clock::now();
+
+    std::thread converter([&] {
+        FramePointer frame;
+        while (to_convert.Pop(frame)) {
+            auto begin = Clock::now();
+            if (settings.format == ExportFormat::Y4m) {
+                gfx::ConvertToI420(FrameSurface(*frame, settings), frame->converted);
+            }
+            else if (settings.format == ExportFormat::Png) {
+                gfx::FilterPngRows(FrameSurface(*frame, settings), frame->converted);
+            }
+            result.convert_seconds += Seconds(Clock::now() - begin);
+            to_encode.Push(std::move(frame));
+        }
+    });
+
+    std::vector<double> encode_seconds(encode_threads);
+    std::vector<std::thread> encoders;
+    for (unsigned t = 0; t < encode_threads; t++) {
+        encoders.emplace_back([&, t] {
+            FramePointer frame;
+            while (to_encode.Pop(frame)) {
+                auto begin = Clock::now();
+                if (settings.format == ExportFormat::Png) {
+                    gfx::EncodePng(settings.width, settings.height, frame->converted, frame->encoded);
+                }
+                encode_seconds[t] += Seconds(Clock::now() - begin);
+                to_write.Push(std::move(frame));
+            }
+        });
+    }
+
+    // Encoders finish out of order; frames are written in order.
+    std::thread writer([&] {
+        std::map<int, FramePointer> pending;
+        auto next = 0;
+        FramePointer frame;
+        while (to_write.Pop(frame)) {
+            auto index = frame->index;
+            pending.emplace(index, std::move(frame));
+
+            while (!pending.empty() && pending.begin()->first == next) {
+                auto ready = std::move(pending.begin()->second);
+                pending.erase(pending.begin());
+                next++;
+
+                auto begin = Clock::now();
+                if (!failed) {
+                    if (settings.format == ExportFormat::Y4m) {
+                        stream << "FRAME\n";
+                        stream.write((const char*)ready->converted.data(), (std::streamsize)ready->converted.size());
+                    }
+                    else if (settings.format == ExportFormat::RawBgra) {
+                        stream.write((const char*)ready->pixels.data(), (std::streamsize)ready->pixels.size());
+                    }
+                    else {
+                        std::ofstream file(FramePath(settings.output, ready->index), std::ios::binary | std::ios::trunc);
+                        file.write((const char*)ready->encoded.data(), (std::streamsize)ready->encoded.size());
+                        failed = !file;
+                    }
+                    failed = failed || (settings.format != ExportFormat::Png && !stream);
+                    result.frames += failed ? 0 : 1;
+                }
+                result.write_seconds += Seconds(Clock::now() - begin);
+
+                free_frames.Push(std::move(ready));
+            }
+        }
+    });
+
+    // Rendering stays on this thread, with the pool for its tiles. Every frame is drawn
+    // into the same target, so only what moved is redrawn, and then copied out.
+    {
+        ThreadPool pool(render_threads);
+        CpuRenderer renderer;
+        renderer.SetThreadPool(&pool);
+        renderer.SetBlendSpace(settings.linear_light ? gfx::BlendSpace::Linear : gfx::BlendSpace::Stored);
+        result.baked_geometry = !settings.geometry.empty() && renderer.LoadGeometry(settings.geometry);
+
+        std::vector<std::uint8_t> target_pixels((std::size_t)settings.width * settings.height * 4);
+        renderer.SetTarget({ target_pixels.data(), settings.width, settings.height, settings.width * 4 });
+
+        ExportAnimation animation(settings);
+        for (int i = 0; i < settings.frame_count && !failed; i++) {
+            auto scene = animation.Next();
+
+            FramePointer frame;
+            if (!free_frames.Pop(frame)) {
+                break;
+            }
+
+            auto begin = Clock::now();
+            renderer.Render(scene);
+            frame->index = i;
+            frame->pixels.assign(target_pixels.begin(), target_pixels.end());
+            result.render_seconds += Seconds(Clock::now() - begin);
+
+            to_convert.Push(std::move(frame));
+        }
+    }
+
+    // Each stage finishes what it has before the next one is told there is no more.
+    to_convert.Close();
+    converter.join();
+    to_encode.Close();
+    for (auto& encoder : encoders) {
+        encoder.join();
+    }
+    to_write.Close();
+    writer.join();
+
+    if (stream.is_open()) {
+        stream.close();
+        failed = failed || !stream;
+    }
+
+    result.seconds = Seconds(Clock::now() - start);
+    for (auto seconds : encode_seconds) {
+        result.encode_seconds += seconds;
+    }
+    result.succeeded = !failed && result.frames == settings.frame_count;
+    return result;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <filesystem>
+
+enum class ExportFormat {
+    // One YUV4MPEG2 file, 4:2:0, that ffmpeg and most players read directly.
+    Y4m,
+    // One file of BGRA8 frames back to back, with no header.
+    RawBgra,
+    // One PNG per frame, named after the output with the frame number appended.
+    Png,
+    // A FrameSink named after the output, for other processes to read from shared
+    // memory as frames are drawn.
+    SharedMemory
+};
+
+struct ExportSettings {
+    // Largest width or height, as large as TargetSizer allocates.
+    static constexpr int MAX_SIZE = 16384;
+
+    std::filesystem::path output;
+    ExportFormat format = ExportFormat::Y4m;
+    int width = 1280, height = 720;
+    double fps = 60.0;
+    int frame_count = 600;
+    // Threads compressing PNG frames, the slowest stage by far. The other formats
+    // only use one.
+    unsigned encode_threads = 2;
+    // Blends in linear light rather than as the window does.
+    bool linear_light = false;
+    // Flattened paths written by CpuRenderer::BakeGeometry. Paths are flattened at
+    // runtime if it's empty, missing or corrupt.
+    std::filesystem::path geometry;
+
+    // Slots of the ring for SharedMemory, FrameSink::DEFAULT_SLOTS by default.
+    int slots = 3;
+    // Spaces SharedMemory frames settings.fps apart, like a live source, rather than
+    // drawing them as fast as possible.
+    bool paced = false;
+};
+
+struct ExportResult {
+    bool succeeded = false;
+    int frames = 0;
+    double seconds = 0.0;
+    // Time each stage spent working rather than waiting, summed over its threads.
+    double render_seconds = 0.0, convert_seconds = 0.0, encode_seconds = 0.0, write_seconds = 0.0;
+
+    // The geometry file was loaded.
+    bool baked_geometry = false;
+
+    double FramesPerSecond() const { return seconds > 0.0 ? frames / seconds : 0.0; }
+};
+
+// Y4m for .y4m, Png for .png and RawBgra for anything else.
+ExportFormat ExportFormatFromExtension(const std::filesystem::path& output);
+
+// Renders frame_count frames of the animated monster with CpuRenderer, without a
+// window, and writes them to settings.output.
+//
+// Animation time comes from a deterministic AnimationClock at settings.fps, so every
+// export of the same settings is identical. The monster sways as in the window, its
+// eyes follow a cursor circling it, and it smiles every other second.
+//
+// Rendering, color conversion, compression and writing run as a pipeline, each stage
+// on its own threads and handing frames to the next through a short BoundedQueue. A
+// slow disk only stalls the renderer once every queue in between is full. SharedMemory
+// frames are drawn straight into the ring and never wait for readers.
+ExportResult ExportFrames(const ExportSettings& settings);
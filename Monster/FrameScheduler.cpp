@@ -0,0 +1,64 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+
+std::string_view FrameModeName(FrameMode mode) {
+    switch (mode) {
+    case FrameMode::VSync: return "vsync";
+    case FrameMode::FixedRate: return "fixed rate";
+    case FrameMode::OnDemand: return "on demand";
+    case FrameMode::Uncapped: return "uncapped";
+    default: return "unknown";
+    }
+}
+
+FrameScheduler::FrameScheduler() {
+    SetFrameRate(DEFAULT_FRAME_RATE);
+}
+
+void FrameScheduler::SetMode(FrameMode mode) {
+    this->mode = mode;
+    next_frame = Duration{ 0 };
+    invalid = true;
+}
+
+void FrameScheduler::SetFrameRate(double frames_per_second) {
+    auto seconds = 1.0 / std::max(frames_per_second, 1.0);
+    period = std::chrono::duration_cast<Duration>(std::chrono::duration<double>(seconds));
+}
+
+void FrameScheduler::SetAnimating(bool animating) {
+    this->animating = animating;
+}
+
+void FrameScheduler::Invalidate() {
+    invalid = true;
+}
+
+FrameScheduler::Duration FrameScheduler::TimeUntilNextFrame(Duration now) const {
+    switch (mode) {
+    case FrameMode::FixedRate:
+        return std::max(next_frame - now, Duration{ 0 });
+    case FrameMode::OnDemand:
+        return animating || invalid ? Duration{ 0 } : NEVER;
+    default:
+        return Duration{ 0 };
+    }
+}
+
+void FrameScheduler::OnFrame(Duration now) {
+    invalid = false;
+
+    // Deadlines advance by whole periods so the rate doesn't drift with wake-up
+    // latency. A frame more than a period late starts the schedule over rather than
+    // rendering a burst to catch up.
+    if (next_frame == Duration{ 0 } || now - next_frame >= period) {
+        next_frame = now + period;
+    }
+    else {
+        next_frame += period;
+    }
+}
+
+unsigned FrameScheduler::SyncInterval() const {
+    return mode == FrameMode::VSync || mode == FrameMode::OnDemand ? 1 : 0;
+}
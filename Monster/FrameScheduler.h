@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+enum class FrameMode : std::uint8_t {
+    // One frame per vertical blank.
+    VSync,
+    // Frames at a set rate, independent of the display.
+    FixedRate,
+    // Frames at vertical blank, but only while animating or after Invalidate.
+    OnDemand,
+    // Frames as fast as they can be drawn, for benchmarks.
+    Uncapped,
+    Count
+};
+
+std::string_view FrameModeName(FrameMode mode);
+
+// Decides when the message loop renders the next frame.
+//
+// The scheduler never reads a clock or blocks: the caller passes the current time,
+// from steady_clock in the app or a fake clock anywhere else, and does the waiting
+// itself, for as long as TimeUntilNextFrame says or until input arrives.
+class FrameScheduler {
+public:
+    using Duration = std::chrono::nanoseconds;
+
+    static constexpr Duration NEVER = Duration::max();
+    static constexpr double DEFAULT_FRAME_RATE = 60.0;
+
+    FrameScheduler();
+
+    void SetMode(FrameMode mode);
+    FrameMode Mode() const { return mode; }
+
+    // Rate of FixedRate mode.
+    void SetFrameRate(double frames_per_second);
+    Duration FramePeriod() const { return period; }
+
+    // OnDemand mode renders continuously while animating, and once after every
+    // Invalidate otherwise.
+    void SetAnimating(bool animating);
+    void Invalidate();
+
+    // Time from now until the next frame is due: zero to render now, NEVER to wait for
+    // input.
+    Duration TimeUntilNextFrame(Duration now) const;
+
+    // Records that a frame is being rendered at now.
+    void OnFrame(Duration now);
+
+    // Sync interval to present with.
+    unsigned SyncInterval() const;
+
+    // Whether to wait until the swap chain can queue another frame before rendering,
+    // so input is read as late as possible.
+    bool WaitsForSwapChain() const { return SyncInterval() != 0; }
+
+private:
+    FrameMode mode = FrameMode::VSync;
+    Duration period;
+    // Absolute time the next FixedRate frame is due, or zero before the first frame.
+    Duration next_frame{ 0 };
+
+    bool animating = true;
+    bool invalid = true;
+};
@@ -0,0 +1,247 @@
+#include "FrameSink.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t PAGE_SIZE = 4096;
+// As large as TargetSizer allocates.
+constexpr int MAX_FRAME_SIZE = 16384;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::int64_t>::is_always_lock_free,
+    "Atomics in shared memory have to be lock free to work across processes.");
+
+std::size_t AlignToPage(std::size_t size) {
+    return (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+std::size_t HeadersSize(std::size_t slot_count) {
+    return AlignToPage(sizeof(FrameRingHeader) + slot_count * sizeof(FrameSlotHeader));
+}
+
+// Value at fraction of the way through sorted values.
+double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    auto index = (std::size_t)std::ceil(fraction * (double)sorted.size());
+    return sorted[std::clamp<std::size_t>(index, 1, sorted.size()) - 1];
+}
+
+// Reads every byte of the frame, 64 bits at a time.
+std::uint64_t SumFrame(const FrameView& view) {
+    std::uint64_t sum = 0;
+    auto row_bytes = (std::size_t)view.width * 4;
+    for (int y = 0; y < view.height; y++) {
+        const auto* row = view.Row(y);
+        for (std::size_t i = 0; i + 8 <= row_bytes; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, row + i, sizeof(word));
+            sum += word;
+        }
+    }
+    return sum;
+}
+
+}
+
+std::int64_t SteadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+bool FrameSink::Create(const std::string& name, int width, int height, int new_slot_count) {
+    header = nullptr;
+    slots = nullptr;
+    slot_count = 0;
+    frames = 0;
+    if (width <= 0 || height <= 0 || width > MAX_FRAME_SIZE || height > MAX_FRAME_SIZE || new_slot_count <= 0 ||
+        new_slot_count > MAX_SLOTS) {
+        return false;
+    }
+
+    auto stride = (std::uint32_t)width * 4;
+    auto headers_size = HeadersSize((std::size_t)new_slot_count);
+    auto slot_size = AlignToPage((std::size_t)stride * height);
+    if (!memory.Create(name, headers_size + slot_size * new_slot_count)) {
+        return false;
+    }
+
+    // The memory starts out zeroed, so latest and every sequence are 0.
+    auto* base = memory.Data().data();
+    header = new (base) FrameRingHeader{ MAGIC, VERSION, (std::uint32_t)new_slot_count, 0, 0 };
+    slots = reinterpret_cast<FrameSlotHeader*>(base + sizeof(FrameRingHeader));
+    for (int i = 0; i < new_slot_count; i++) {
+        new (&slots[i]) FrameSlotHeader{ 0, 0, (std::uint32_t)width, (std::uint32_t)height, stride, FrameFormat::Bgra8,
+            headers_size + slot_size * i };
+    }
+    slot_count = new_slot_count;
+    return true;
+}
+
+gfx::Surface FrameSink::BeginFrame() {
+    auto frame = frames + 1;
+    auto& slot = Slot(frame);
+    slot.sequence.store(2 * frame - 1, std::memory_order_relaxed);
+    // Readers that see any of the new pixels see the odd sequence after them.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto* pixels = reinterpret_cast<std::uint8_t*>(memory.Data().data() + slot.offset);
+    return { pixels, (int)slot.width, (int)slot.height, (int)slot.stride };
+}
+
+void FrameSink::EndFrame(std::int64_t timestamp) {
+    auto frame = frames + 1;
+    auto& slot = Slot(frame);
+    slot.timestamp.store(timestamp, std::memory_order_relaxed);
+    slot.sequence.store(2 * frame, std::memory_order_release);
+    header->latest.store(frame, std::memory_order_release);
+    frames = frame;
+}
+
+bool FrameSource::Open(const std::string& name) {
+    header = nullptr;
+    slots = nullptr;
+    slot_count = 0;
+    if (!memory.Open(name)) {
+        return false;
+    }
+
+    auto data = memory.Data();
+    if (data.size() < sizeof(FrameRingHeader)) {
+        return false;
+    }
+    const auto* ring = reinterpret_cast<const FrameRingHeader*>(data.data());
+    if (ring->magic != FrameSink::MAGIC || ring->version != FrameSink::VERSION || ring->slot_count == 0 ||
+        ring->slot_count > (std::uint32_t)FrameSink::MAX_SLOTS || data.size() < HeadersSize(ring->slot_count)) {
+        return false;
+    }
+
+    // Every slot has to lie within the memory, whatever the headers say.
+    const auto* ring_slots = reinterpret_cast<const FrameSlotHeader*>(data.data() + sizeof(FrameRingHeader));
+    for (std::uint32_t i = 0; i < ring->slot_count; i++) {
+        const auto& slot = ring_slots[i];
+        if (slot.format != FrameFormat::Bgra8 || slot.width == 0 || slot.height == 0 ||
+            slot.width > (std::uint32_t)MAX_FRAME_SIZE || slot.height > (std::uint32_t)MAX_FRAME_SIZE ||
+            slot.stride < slot.width * 4 || slot.offset > data.size() ||
+            (std::uint64_t)slot.stride * slot.height > data.size() - slot.offset) {
+            return false;
+        }
+    }
+
+    header = ring;
+    slots = ring_slots;
+    slot_count = ring->slot_count;
+    return true;
+}
+
+bool FrameSource::Latest(FrameView& view, std::uint64_t after) const {
+    if (!header) {
+        return false;
+    }
+
+    // A slot that has already moved on means latest has too, so a few tries find a
+    // frame unless the producer laps the ring faster than this can look.
+    for (int attempt = 0; attempt < 4; attempt++) {
+        auto frame = header->latest.load(std::memory_order_acquire);
+        if (frame == 0 || frame <= after) {
+            return false;
+        }
+
+        const auto& slot = slots[(frame - 1) % slot_count];
+        if (slot.sequence.load(std::memory_order_acquire) != 2 * frame) {
+            continue;
+        }
+
+        view.frame = frame;
+        view.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        view.width = (int)slot.width;
+        view.height = (int)slot.height;
+        view.stride = (int)slot.stride;
+        view.format = slot.format;
+        view.pixels = reinterpret_cast<const std::uint8_t*>(memory.Data().data() + slot.offset);
+        return true;
+    }
+    return false;
+}
+
+bool FrameSource::IsIntact(const FrameView& view) const {
+    if (!header || view.frame == 0) {
+        return false;
+    }
+
+    // Whatever was read comes before the sequence is read again.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto& slot = slots[(view.frame - 1) % slot_count];
+    return slot.sequence.load(std::memory_order_relaxed) == 2 * view.frame;
+}
+
+WatchResult WatchFrames(const WatchSettings& settings) {
+    WatchResult result;
+    auto timeout = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(settings.timeout_seconds));
+
+    // The producer may not have started yet.
+    FrameSource source;
+    auto waiting_since = Clock::now();
+    while (!source.Open(settings.name)) {
+        if (Clock::now() - waiting_since > timeout) {
+            return result;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve((std::size_t)std::max(settings.frame_count, 0));
+    std::uint64_t last = 0;
+    Clock::time_point start, end;
+
+    waiting_since = Clock::now();
+    while (result.frames < settings.frame_count) {
+        FrameView view;
+        if (!source.Latest(view, last)) {
+            if (Clock::now() - waiting_since > timeout) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        auto seen = SteadyNanoseconds();
+        waiting_since = Clock::now();
+
+        // Timing starts with the first frame, so waiting for the producer doesn't count.
+        if (last == 0) {
+            start = waiting_since;
+        }
+        else {
+            result.dropped += (int)(view.frame - last - 1);
+        }
+        last = view.frame;
+
+        auto sum = SumFrame(view);
+        if (!source.IsIntact(view)) {
+            result.torn++;
+            continue;
+        }
+        result.sum += sum;
+        latencies.push_back((double)(seen - view.timestamp) * 1e-6);
+        result.bytes += (std::uint64_t)view.width * view.height * 4;
+        result.frames++;
+        end = Clock::now();
+    }
+    // Up to the last frame read, so a producer that stopped early doesn't count either.
+    if (result.frames > 0) {
+        result.seconds = std::chrono::duration<double>(end - start).count();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    result.median_latency_milliseconds = Percentile(latencies, 0.5);
+    result.p95_latency_milliseconds = Percentile(latencies, 0.95);
+    result.succeeded = result.frames == settings.frame_count;
+    return result;
+}
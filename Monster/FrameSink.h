@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Paint.h"
+#include "SharedMemory.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Pixel layouts a frame ring holds.
+enum class FrameFormat : std::uint32_t {
+    // Premultiplied BGRA8, as CpuRenderer draws it.
+    Bgra8 = 1
+};
+
+// A frame ring in shared memory starts with a FrameRingHeader and slot_count
+// FrameSlotHeaders. Each slot's pixels follow at its own page-aligned offset.
+//
+// Frame n, counting from 1, goes to slot (n - 1) % slot_count. While it is being written,
+// the slot's sequence is 2n - 1. Once it is complete, the sequence is 2n and then latest
+// becomes n. A reader takes latest, checks that the slot's sequence is 2n, reads the
+// frame in place and checks the sequence again. If it changed, the producer came round
+// the ring while the frame was being read, and the frame is dropped. The producer never
+// waits for readers, and readers never write to the ring.
+struct FrameRingHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t slot_count;
+    std::uint32_t reserved;
+    // Newest complete frame, 0 before the first.
+    std::atomic<std::uint64_t> latest;
+};
+
+struct FrameSlotHeader {
+    std::atomic<std::uint64_t> sequence;
+    // When the frame was completed, in nanoseconds on the steady clock, which processes
+    // on one machine share.
+    std::atomic<std::int64_t> timestamp;
+
+    // Fixed when the ring is created. offset is from the start of the ring.
+    std::uint32_t width, height, stride;
+    FrameFormat format;
+    std::uint64_t offset;
+};
+
+// Now on the clock frame timestamps are on.
+std::int64_t SteadyNanoseconds();
+
+// Writes frames into a ring of slots in shared memory, for other processes to read
+// without copying them out. The renderer draws straight into the slot the next frame
+// goes to, so nothing is copied on this side either.
+class FrameSink {
+public:
+    static constexpr std::uint32_t MAGIC = 0x4b4e5346; // "FSNK"
+    static constexpr std::uint32_t VERSION = 1;
+
+    // Gives a reader two frame times to read a frame. It's also the most buffers
+    // CpuRenderer tracks damage for, so drawing into the slots in turn only redraws
+    // what changed.
+    static constexpr int DEFAULT_SLOTS = 3;
+    static constexpr int MAX_SLOTS = 16;
+
+    // Returns false if the ring can't be created, or the size or slot count is out of
+    // range.
+    bool Create(const std::string& name, int width, int height, int slot_count = DEFAULT_SLOTS);
+    int SlotCount() const { return slot_count; }
+
+    // The slot the next frame is drawn into. Readers stop seeing the frame it held, but
+    // its pixels are still there.
+    gfx::Surface BeginFrame();
+    // Publishes the frame drawn since BeginFrame, completed at timestamp.
+    void EndFrame(std::int64_t timestamp);
+
+    // Frames published so far.
+    std::uint64_t Frames() const { return frames; }
+
+private:
+    SharedMemory memory;
+    FrameRingHeader* header = nullptr;
+    FrameSlotHeader* slots = nullptr;
+    int slot_count = 0;
+    std::uint64_t frames = 0;
+
+    FrameSlotHeader& Slot(std::uint64_t frame) const { return slots[(frame - 1) % slot_count]; }
+};
+
+// A frame in a ring, read in place. What it points to is only known to be the whole
+// frame if FrameSource::IsIntact says so after reading.
+struct FrameView {
+    std::uint64_t frame = 0;
+    std::int64_t timestamp = 0;
+    int width = 0, height = 0, stride = 0;
+    FrameFormat format = FrameFormat::Bgra8;
+    const std::uint8_t* pixels = nullptr;
+
+    const std::uint8_t* Row(int y) const { return pixels + (std::size_t)y * stride; }
+};
+
+// Reads the frames a FrameSink writes, from another process or this one.
+class FrameSource {
+public:
+    // Returns false if there is no ring by that name, or it isn't a valid one.
+    bool Open(const std::string& name);
+
+    // The newest complete frame, if it's newer than frame after.
+    bool Latest(FrameView& view, std::uint64_t after = 0) const;
+    // Whether view's frame hasn't been overwritten since Latest returned it. Checked
+    // after reading, since anything read may be torn otherwise.
+    bool IsIntact(const FrameView& view) const;
+
+private:
+    SharedMemory memory;
+    const FrameRingHeader* header = nullptr;
+    const FrameSlotHeader* slots = nullptr;
+    std::uint32_t slot_count = 0;
+};
+
+struct WatchSettings {
+    std::string name;
+    int frame_count = 600;
+    // Gives up once no new frame has come for this long, counting the wait for the
+    // ring to be created.
+    double timeout_seconds = 5.0;
+};
+
+struct WatchResult {
+    // frame_count frames were read.
+    bool succeeded = false;
+    // Frames read intact.
+    int frames = 0;
+    // Frames published that were never seen, and frames overwritten while being read.
+    int dropped = 0, torn = 0;
+    double seconds = 0.0;
+    // From a frame being completed to it being seen.
+    double median_latency_milliseconds = 0.0, p95_latency_milliseconds = 0.0;
+    std::uint64_t bytes = 0;
+    // Sum of the 64 bit words of every frame read intact.
+    std::uint64_t sum = 0;
+
+    double FramesPerSecond() const { return seconds > 0.0 ? frames / seconds : 0.0; }
+    double GigabytesPerSecond() const { return seconds > 0.0 ? bytes / seconds * 1e-9 : 0.0; }
+};
+
+// Reference consumer: reads frames from the ring named settings.name as they come, in
+// place, until frame_count were read intact. Every row is summed, to stand for a
+// consumer that reads the whole frame, and the frame is checked to have stayed intact
+// afterwards. Polls without sleeping, so frames are seen as soon as they are complete.
+WatchResult WatchFrames(const WatchSettings& settings);
@@ -0,0 +1,170 @@
+#include "Geometry.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace gfx {
+
+Matrix3x2 Matrix3x2::Rotation(float angle, Point center) {
+    auto radians = angle * std::numbers::pi_v<float> / 180.0f;
+    auto s = std::sin(radians), c = std::cos(radians);
+
+    return {
+        c, s,
+        -s, c,
+        center.x - center.x * c + center.y * s,
+        center.y - center.x * s - center.y * c
+    };
+}
+
+bool Matrix3x2::IsInvertible() const {
+    return Determinant() != 0.0f;
+}
+
+bool Matrix3x2::Invert() {
+    auto det = Determinant();
+    if (det == 0.0f) {
+        return false;
+    }
+
+    auto inv_det = 1.0f / det;
+    Matrix3x2 result = {
+        m22 * inv_det, -m12 * inv_det,
+        -m21 * inv_det, m11 * inv_det,
+        (m21 * dy - m22 * dx) * inv_det,
+        (m12 * dx - m11 * dy) * inv_det
+    };
+    *this = result;
+    return true;
+}
+
+float Matrix3x2::MaxScale() const {
+    // Largest singular value of the linear part.
+    auto a = m11 * m11 + m12 * m12;
+    auto b = m11 * m21 + m12 * m22;
+    auto c = m21 * m21 + m22 * m22;
+    auto half_trace = (a + c) * 0.5f;
+    auto disc = std::sqrt(std::max(0.0f, (a - c) * (a - c) * 0.25f + b * b));
+    return std::sqrt(half_trace + disc);
+}
+
+Matrix3x2 operator*(const Matrix3x2& a, const Matrix3x2& b) {
+    return {
+        a.m11 * b.m11 + a.m12 * b.m21,
+        a.m11 * b.m12 + a.m12 * b.m22,
+        a.m21 * b.m11 + a.m22 * b.m21,
+        a.m21 * b.m12 + a.m22 * b.m22,
+        a.dx * b.m11 + a.dy * b.m21 + b.dx,
+        a.dx * b.m12 + a.dy * b.m22 + b.dy
+    };
+}
+
+Rect TransformBounds(const Rect& rect, const Matrix3x2& matrix) {
+    Point corners[] = {
+        matrix.TransformPoint({ rect.left, rect.top }),
+        matrix.TransformPoint({ rect.right, rect.top }),
+        matrix.TransformPoint({ rect.left, rect.bottom }),
+        matrix.TransformPoint({ rect.right, rect.bottom })
+    };
+
+    Rect result = { corners[0].x, corners[0].y, corners[0].x, corners[0].y };
+    for (const auto& corner : corners) {
+        result.left = std::min(result.left, corner.x);
+        result.top = std::min(result.top, corner.y);
+        result.right = std::max(result.right, corner.x);
+        result.bottom = std::max(result.bottom, corner.y);
+    }
+    return result;
+}
+
+IntRect RoundOut(const Rect& rect) {
+    return {
+        (int)std::floor(rect.left), (int)std::floor(rect.top),
+        (int)std::ceil(rect.right), (int)std::ceil(rect.bottom)
+    };
+}
+
+IntRect Intersect(const IntRect& a, const IntRect& b) {
+    IntRect result = {
+        std::max(a.left, b.left), std::max(a.top, b.top),
+        std::min(a.right, b.right), std::min(a.bottom, b.bottom)
+    };
+    if (result.IsEmpty()) {
+        return {};
+    }
+    return result;
+}
+
+void Path::AddEllipse(const Ellipse& ellipse) {
+    constexpr float KAPPA = 0.5522847498f;
+    auto cx = ellipse.center.x, cy = ellipse.center.y;
+    auto rx = ellipse.radius_x, ry = ellipse.radius_y;
+    auto kx = rx * KAPPA, ky = ry * KAPPA;
+
+    BeginFigure({ cx + rx, cy }, FigureBegin::Filled);
+    AddBezier({ cx + rx, cy + ky }, { cx + kx, cy + ry }, { cx, cy + ry });
+    AddBezier({ cx - kx, cy + ry }, { cx - rx, cy + ky }, { cx - rx, cy });
+    AddBezier({ cx - rx, cy - ky }, { cx - kx, cy - ry }, { cx, cy - ry });
+    AddBezier({ cx + kx, cy - ry }, { cx + rx, cy - ky }, { cx + rx, cy });
+    EndFigure(FigureEnd::Closed);
+}
+
+void ReplayPath(std::span<const Point> points, std::span<const PathVerb> verbs, std::span<const PathFigure> figures,
+    PathSink& sink) {
+    for (const auto& figure : figures) {
+        auto index = figure.first_point;
+        sink.BeginFigure(points[index++], figure.filled ? FigureBegin::Filled : FigureBegin::Hollow);
+        for (auto v = figure.first_verb; v < figure.first_verb + figure.verb_count; v++) {
+            if (verbs[v] == PathVerb::Line) {
+                sink.AddLine(points[index++]);
+            }
+            else {
+                sink.AddBezier(points[index], points[index + 1], points[index + 2]);
+                index += 3;
+            }
+        }
+        sink.EndFigure(figure.closed ? FigureEnd::Closed : FigureEnd::Open);
+    }
+}
+
+void Path::Clear() {
+    points.clear();
+    verbs.clear();
+    figures.clear();
+}
+
+void TransformPoints(const Matrix3x2& matrix, FlattenedPath& path) {
+    for (auto& point : path.points) {
+        point = matrix.TransformPoint(point);
+    }
+}
+
+void TransformPath(const Matrix3x2& matrix, FlatPathView input, FlattenedPath& output) {
+    output.points.resize(input.points.size());
+    for (std::size_t i = 0; i < input.points.size(); i++) {
+        output.points[i] = matrix.TransformPoint(input.points[i]);
+    }
+    output.figures.assign(input.figures.begin(), input.figures.end());
+}
+
+std::uint64_t HashPath(const Path& path) {
+    // FNV-1a over the raw bytes of every array.
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    auto add = [&](const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const std::uint8_t*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+    };
+
+    add(path.Points().data(), path.Points().size() * sizeof(Point));
+    add(path.Verbs().data(), path.Verbs().size() * sizeof(PathVerb));
+    for (const auto& figure : path.Figures()) {
+        std::uint64_t fields[] = { figure.first_point, figure.first_verb, figure.verb_count,
+            (std::uint64_t)figure.filled | (std::uint64_t)figure.closed << 1 };
+        add(fields, sizeof(fields));
+    }
+    return hash;
+}
+
+}
@@ -0,0 +1,415 @@
+#pragma once
+
+#include "ConstexprMath.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Portable geometry types shared by the Direct2D and CPU render paths. They mirror
+// the D2D1 helpers (Point2F, Matrix3x2F, ArcSegment, ID2D1GeometrySink) closely enough
+// that shapes can be described once and fed to either backend.
+namespace gfx {
+
+struct Point {
+    float x = 0.0f, y = 0.0f;
+};
+
+struct Rect {
+    float left = 0.0f, top = 0.0f, right = 0.0f, bottom = 0.0f;
+};
+
+struct IntRect {
+    int left = 0, top = 0, right = 0, bottom = 0;
+
+    bool IsEmpty() const { return left >= right || top >= bottom; }
+    int Width() const { return right - left; }
+    int Height() const { return bottom - top; }
+};
+
+struct Ellipse {
+    Point center;
+    float radius_x = 0.0f, radius_y = 0.0f;
+};
+
+// Row-vector 3x2 affine matrix with the same layout and multiplication order as
+// D2D1::Matrix3x2F: (a * b) applies a first, then b.
+struct Matrix3x2 {
+    float m11 = 1.0f, m12 = 0.0f;
+    float m21 = 0.0f, m22 = 1.0f;
+    float dx = 0.0f, dy = 0.0f;
+
+    static constexpr Matrix3x2 Identity() { return {}; }
+    static constexpr Matrix3x2 Scale(float sx, float sy) { return { sx, 0.0f, 0.0f, sy, 0.0f, 0.0f }; }
+    static constexpr Matrix3x2 Translation(float x, float y) { return { 1.0f, 0.0f, 0.0f, 1.0f, x, y }; }
+    // Angle in degrees, clockwise in a y-down coordinate system (same as D2D).
+    static Matrix3x2 Rotation(float angle, Point center = {});
+
+    bool operator==(const Matrix3x2&) const = default;
+
+    float Determinant() const { return m11 * m22 - m12 * m21; }
+    bool IsInvertible() const;
+    bool Invert();
+
+    constexpr Point TransformPoint(Point p) const {
+        return { p.x * m11 + p.y * m21 + dx, p.x * m12 + p.y * m22 + dy };
+    }
+
+    // Largest factor by which the matrix can stretch a unit vector.
+    float MaxScale() const;
+};
+
+Matrix3x2 operator*(const Matrix3x2& a, const Matrix3x2& b);
+
+Rect TransformBounds(const Rect& rect, const Matrix3x2& matrix);
+IntRect RoundOut(const Rect& rect);
+IntRect Intersect(const IntRect& a, const IntRect& b);
+
+enum class FigureBegin { Filled, Hollow };
+enum class FigureEnd { Open, Closed };
+enum class SweepDirection { CounterClockwise, Clockwise };
+enum class ArcSize { Small, Large };
+
+struct ArcSegment {
+    Point point;
+    float radius_x = 0.0f, radius_y = 0.0f;
+    float rotation_angle = 0.0f;
+    SweepDirection sweep_direction = SweepDirection::CounterClockwise;
+    ArcSize arc_size = ArcSize::Small;
+};
+
+// Same call protocol as ID2D1GeometrySink, so shape builders can target either a
+// Direct2D path geometry or a gfx::Path.
+class PathSink {
+public:
+    constexpr virtual ~PathSink() = default;
+
+    virtual void BeginFigure(Point start, FigureBegin begin) = 0;
+    virtual void AddLine(Point point) = 0;
+    virtual void AddBezier(Point control1, Point control2, Point end) = 0;
+    virtual void AddQuadraticBezier(Point control, Point end) = 0;
+    virtual void AddArc(const ArcSegment& arc) = 0;
+    virtual void EndFigure(FigureEnd end) = 0;
+};
+
+// Calls add_cubic(control1, control2, end) for each of the cubics approximating arc, at
+// most one per quarter turn, or add_line(end) if it has a zero radius. Endpoint to
+// center parameterization as in the SVG implementation notes (F.6.5). Direct2D uses
+// the same rules, including scaling up radii that are too small.
+template <typename AddLine, typename AddCubic>
+constexpr void ArcToCubics(Point start, const ArcSegment& arc, AddLine add_line, AddCubic add_cubic) {
+    constexpr auto pi = std::numbers::pi_v<float>;
+
+    auto end = arc.point;
+    if (start.x == end.x && start.y == end.y) {
+        return;
+    }
+
+    auto rx = math::Abs(arc.radius_x), ry = math::Abs(arc.radius_y);
+    if (rx == 0.0f || ry == 0.0f) {
+        add_line(end);
+        return;
+    }
+
+    auto phi = arc.rotation_angle * pi / 180.0f;
+    auto cos_phi = math::Cos(phi), sin_phi = math::Sin(phi);
+
+    auto half_dx = (start.x - end.x) * 0.5f, half_dy = (start.y - end.y) * 0.5f;
+    auto x1 = cos_phi * half_dx + sin_phi * half_dy;
+    auto y1 = -sin_phi * half_dx + cos_phi * half_dy;
+
+    auto lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+    if (lambda > 1.0f) {
+        auto scale = math::Sqrt(lambda);
+        rx *= scale;
+        ry *= scale;
+    }
+
+    auto sweep = (arc.sweep_direction == SweepDirection::Clockwise);
+    auto large = (arc.arc_size == ArcSize::Large);
+
+    auto numerator = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+    auto denominator = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+    auto coef = math::Sqrt(std::max(0.0f, numerator / denominator));
+    if (large == sweep) {
+        coef = -coef;
+    }
+
+    auto cx1 = coef * rx * y1 / ry;
+    auto cy1 = -coef * ry * x1 / rx;
+    auto cx = cos_phi * cx1 - sin_phi * cy1 + (start.x + end.x) * 0.5f;
+    auto cy = sin_phi * cx1 + cos_phi * cy1 + (start.y + end.y) * 0.5f;
+
+    auto angle_between = [](float ux, float uy, float vx, float vy) {
+        return math::Atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+    };
+
+    auto theta = angle_between(1.0f, 0.0f, (x1 - cx1) / rx, (y1 - cy1) / ry);
+    auto delta = angle_between((x1 - cx1) / rx, (y1 - cy1) / ry, (-x1 - cx1) / rx, (-y1 - cy1) / ry);
+    if (!sweep && delta > 0.0f) {
+        delta -= 2.0f * pi;
+    }
+    else if (sweep && delta < 0.0f) {
+        delta += 2.0f * pi;
+    }
+
+    auto segments = std::max(1, (int)math::Ceil(math::Abs(delta) / (pi * 0.5f) - 0.001f));
+    auto step = delta / segments;
+    auto k = 4.0f / 3.0f * math::Tan(step * 0.25f);
+
+    auto point_at = [&](float t) {
+        auto x = rx * math::Cos(t), y = ry * math::Sin(t);
+        return Point{ cx + cos_phi * x - sin_phi * y, cy + sin_phi * x + cos_phi * y };
+    };
+    auto tangent_at = [&](float t) {
+        auto x = -rx * math::Sin(t), y = ry * math::Cos(t);
+        return Point{ cos_phi * x - sin_phi * y, sin_phi * x + cos_phi * y };
+    };
+
+    for (int i = 0; i < segments; i++) {
+        auto t0 = theta + step * i, t1 = theta + step * (i + 1);
+        auto p0 = point_at(t0), d0 = tangent_at(t0);
+        auto p1 = (i == segments - 1) ? end : point_at(t1);
+        auto d1 = tangent_at(t1);
+        add_cubic(Point{ p0.x + k * d0.x, p0.y + k * d0.y }, Point{ p1.x - k * d1.x, p1.y - k * d1.y }, p1);
+    }
+}
+
+enum class PathVerb : std::uint8_t { Line, Cubic };
+
+struct PathFigure {
+    std::size_t first_point = 0;
+    std::size_t first_verb = 0, verb_count = 0;
+    bool filled = true;
+    bool closed = false;
+};
+
+// Adds a path held as arrays to sink, figure by figure.
+void ReplayPath(std::span<const Point> points, std::span<const PathVerb> verbs, std::span<const PathFigure> figures,
+    PathSink& sink);
+
+// Recorded path made of lines and cubic Beziers. Quadratics and arcs are converted to
+// cubics when added.
+//
+// Recording is constexpr, so shapes can also be built at compile time and baked into
+// a StaticPath.
+class Path : public PathSink {
+public:
+    // Spelled out, since compilers won't run the implicit virtual one at compile time.
+    constexpr ~Path() override {}
+
+    constexpr void BeginFigure(Point start, FigureBegin begin) override {
+        PathFigure figure;
+        figure.first_point = points.size();
+        figure.first_verb = verbs.size();
+        figure.filled = (begin == FigureBegin::Filled);
+        figures.push_back(figure);
+        points.push_back(start);
+    }
+
+    constexpr void AddLine(Point point) override {
+        verbs.push_back(PathVerb::Line);
+        points.push_back(point);
+        figures.back().verb_count++;
+    }
+
+    constexpr void AddBezier(Point control1, Point control2, Point end) override {
+        verbs.push_back(PathVerb::Cubic);
+        points.push_back(control1);
+        points.push_back(control2);
+        points.push_back(end);
+        figures.back().verb_count++;
+    }
+
+    constexpr void AddQuadraticBezier(Point control, Point end) override {
+        auto start = points.back();
+        AddBezier(
+            { start.x + (control.x - start.x) * (2.0f / 3.0f), start.y + (control.y - start.y) * (2.0f / 3.0f) },
+            { end.x + (control.x - end.x) * (2.0f / 3.0f), end.y + (control.y - end.y) * (2.0f / 3.0f) },
+            end);
+    }
+
+    constexpr void AddArc(const ArcSegment& arc) override {
+        ArcToCubics(points.back(), arc, [&](Point end) { AddLine(end); },
+            [&](Point control1, Point control2, Point end) { AddBezier(control1, control2, end); });
+    }
+
+    constexpr void EndFigure(FigureEnd end) override {
+        figures.back().closed = (end == FigureEnd::Closed);
+    }
+
+    void AddEllipse(const Ellipse& ellipse);
+    void Clear();
+
+    // Replaces the path with copies of the arrays, such as those of a StaticPath.
+    constexpr void Assign(std::span<const Point> points, std::span<const PathVerb> verbs,
+        std::span<const PathFigure> figures) {
+        this->points.assign(points.begin(), points.end());
+        this->verbs.assign(verbs.begin(), verbs.end());
+        this->figures.assign(figures.begin(), figures.end());
+    }
+
+    constexpr const std::vector<Point>& Points() const { return points; }
+    constexpr const std::vector<PathVerb>& Verbs() const { return verbs; }
+    constexpr const std::vector<PathFigure>& Figures() const { return figures; }
+
+    // Moves points in place, keeping the verbs and figures. Callers that cache anything
+    // by path, like FlatteningCache, have to be told.
+    std::span<Point> MutablePoints() { return points; }
+
+    // Adds the path to another sink, such as a Direct2D geometry.
+    void Replay(PathSink& sink) const { ReplayPath(points, verbs, figures, sink); }
+
+    // Bounds of all points, control points included.
+    constexpr Rect ControlBounds() const {
+        if (points.empty()) {
+            return {};
+        }
+
+        Rect result = { points[0].x, points[0].y, points[0].x, points[0].y };
+        for (const auto& point : points) {
+            result.left = std::min(result.left, point.x);
+            result.top = std::min(result.top, point.y);
+            result.right = std::max(result.right, point.x);
+            result.bottom = std::max(result.bottom, point.y);
+        }
+        return result;
+    }
+
+private:
+    std::vector<Point> points;
+    std::vector<PathVerb> verbs;
+    std::vector<PathFigure> figures;
+};
+
+// A path reduced to straight segments. Each figure is a run of points; closed figures
+// have an implicit segment from the last point back to the first.
+//
+// Fixed-size fields, because baked geometry files store figures as they are.
+struct FlatFigure {
+    std::uint32_t first_point = 0, point_count = 0;
+    bool filled = true;
+    bool closed = false;
+};
+
+struct FlattenedPath {
+    std::vector<Point> points;
+    std::vector<FlatFigure> figures;
+
+    constexpr void Clear() {
+        points.clear();
+        figures.clear();
+    }
+
+    constexpr Rect Bounds() const {
+        if (points.empty()) {
+            return {};
+        }
+
+        Rect result = { points[0].x, points[0].y, points[0].x, points[0].y };
+        for (const auto& point : points) {
+            result.left = std::min(result.left, point.x);
+            result.top = std::min(result.top, point.y);
+            result.right = std::max(result.right, point.x);
+            result.bottom = std::max(result.bottom, point.y);
+        }
+        return result;
+    }
+};
+
+// Read-only flattened path whose storage lives elsewhere, such as a FlattenedPath or a
+// mapped geometry file.
+struct FlatPathView {
+    std::span<const Point> points;
+    std::span<const FlatFigure> figures;
+
+    FlatPathView() = default;
+    FlatPathView(std::span<const Point> points, std::span<const FlatFigure> figures) : points(points), figures(figures) {}
+    FlatPathView(const FlattenedPath& path) : points(path.points), figures(path.figures) {}
+};
+
+// Upper bound for CubicSegmentCount, so degenerate input can't explode the output.
+constexpr int MAX_CUBIC_SEGMENTS = 256;
+
+// Fewest line segments that keep a cubic within tolerance of its polyline.
+constexpr int CubicSegmentCount(Point p0, Point p1, Point p2, Point p3, float tolerance) {
+    // Wang's formula: n >= sqrt(d * (d - 1) / 8 * M / tolerance) for a curve of degree d,
+    // where M is the largest second difference of the control points.
+    auto ax = p0.x - 2.0f * p1.x + p2.x, ay = p0.y - 2.0f * p1.y + p2.y;
+    auto bx = p1.x - 2.0f * p2.x + p3.x, by = p1.y - 2.0f * p2.y + p3.y;
+    auto m = math::Sqrt(std::max(ax * ax + ay * ay, bx * bx + by * by));
+
+    auto n = math::Ceil(math::Sqrt(0.75f * m / tolerance));
+    return (int)std::clamp(n, 1.0f, (float)MAX_CUBIC_SEGMENTS);
+}
+
+// Walks the figures of path and emits step_count(p0, p1, p2, p3) evenly spaced points
+// per cubic, with all control points already transformed by matrix.
+template <typename StepCount>
+constexpr void FlattenFigures(const Path& path, const Matrix3x2& matrix, FlattenedPath& output, StepCount step_count) {
+    const auto& points = path.Points();
+    const auto& verbs = path.Verbs();
+
+    for (const auto& figure : path.Figures()) {
+        FlatFigure flat;
+        flat.first_point = (std::uint32_t)output.points.size();
+        flat.filled = figure.filled;
+        flat.closed = figure.closed;
+
+        auto index = figure.first_point;
+        auto current = matrix.TransformPoint(points[index++]);
+        output.points.push_back(current);
+
+        for (auto v = figure.first_verb; v < figure.first_verb + figure.verb_count; v++) {
+            if (verbs[v] == PathVerb::Line) {
+                current = matrix.TransformPoint(points[index++]);
+                output.points.push_back(current);
+                continue;
+            }
+
+            auto p0 = current;
+            auto p1 = matrix.TransformPoint(points[index]);
+            auto p2 = matrix.TransformPoint(points[index + 1]);
+            auto p3 = matrix.TransformPoint(points[index + 2]);
+            index += 3;
+
+            int steps = step_count(p0, p1, p2, p3);
+            for (int i = 1; i <= steps; i++) {
+                auto t = (float)i / steps, u = 1.0f - t;
+                auto a = u * u * u, b = 3.0f * u * u * t, c = 3.0f * u * t * t, d = t * t * t;
+                output.points.push_back({
+                    a * p0.x + b * p1.x + c * p2.x + d * p3.x,
+                    a * p0.y + b * p1.y + c * p2.y + d * p3.y });
+            }
+            current = p3;
+            output.points.back() = p3;
+        }
+
+        flat.point_count = (std::uint32_t)output.points.size() - flat.first_point;
+        output.figures.push_back(flat);
+    }
+}
+
+// Flattens every cubic into a fixed number of line segments after applying matrix.
+constexpr void FlattenPath(const Path& path, const Matrix3x2& matrix, int cubic_steps, FlattenedPath& output) {
+    FlattenFigures(path, matrix, output, [=](Point, Point, Point, Point) { return cubic_steps; });
+}
+
+// Flattens every cubic into as few line segments as keep it within tolerance, measured
+// after applying matrix.
+constexpr void FlattenPathAdaptive(const Path& path, const Matrix3x2& matrix, float tolerance, FlattenedPath& output) {
+    FlattenFigures(path, matrix, output, [=](Point p0, Point p1, Point p2, Point p3) {
+        return CubicSegmentCount(p0, p1, p2, p3, tolerance);
+    });
+}
+
+void TransformPoints(const Matrix3x2& matrix, FlattenedPath& path);
+
+// Replaces output with a transformed copy of input.
+void TransformPath(const Matrix3x2& matrix, FlatPathView input, FlattenedPath& output);
+
+// Fingerprint of a path's contents, for matching baked geometry to the path it came from.
+std::uint64_t HashPath(const Path& path);
+
+}
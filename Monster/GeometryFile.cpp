@@ -0,0 +1,116 @@
+#include "GeometryFile.h"
+#include <cstring>
+#include <fstream>
+
+namespace gfx {
+
+static_assert(sizeof(Point) == 8 && sizeof(FlatFigure) == 12, "geometry files store these as they are");
+
+bool GeometryFile::Open(const std::filesystem::path& filename) {
+    paths.clear();
+    file = MappedFile(filename);
+
+    auto fail = [&] {
+        paths.clear();
+        file = MappedFile();
+        return false;
+    };
+
+    auto data = file.Data();
+    if (data.size() < sizeof(Header)) {
+        return fail();
+    }
+
+    Header header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION) {
+        return fail();
+    }
+
+    auto records_size = (std::uint64_t)header.path_count * sizeof(Record);
+    auto figures_size = (std::uint64_t)header.figure_count * sizeof(FlatFigure);
+    auto points_size = (std::uint64_t)header.point_count * sizeof(Point);
+    if (data.size() != sizeof(Header) + records_size + figures_size + points_size) {
+        return fail();
+    }
+    if (Checksum(data.subspan(sizeof(Header))) != header.checksum) {
+        return fail();
+    }
+
+    // The mapping is page aligned and every section size is a multiple of four, so the
+    // arrays can be used in place.
+    const auto* records = reinterpret_cast<const Record*>(data.data() + sizeof(Header));
+    const auto* figures = reinterpret_cast<const FlatFigure*>(data.data() + sizeof(Header) + records_size);
+    const auto* points = reinterpret_cast<const Point*>(data.data() + sizeof(Header) + records_size + figures_size);
+
+    for (std::uint32_t i = 0; i < header.path_count; i++) {
+        const auto& record = records[i];
+        if ((std::uint64_t)record.first_figure + record.figure_count > header.figure_count ||
+            (std::uint64_t)record.first_point + record.point_count > header.point_count) {
+            return fail();
+        }
+
+        BakedPath path;
+        path.source_hash = record.source_hash;
+        path.level = record.level;
+        path.flattened = { { points + record.first_point, record.point_count },
+            { figures + record.first_figure, record.figure_count } };
+
+        for (const auto& figure : path.flattened.figures) {
+            if ((std::uint64_t)figure.first_point + figure.point_count > record.point_count) {
+                return fail();
+            }
+        }
+        paths.push_back(path);
+    }
+
+    tolerance = header.tolerance;
+    return true;
+}
+
+bool GeometryFile::Write(const std::filesystem::path& filename, float tolerance, std::span<const BakedPath> paths) {
+    std::vector<std::byte> body;
+    auto append = [&](const void* bytes, std::size_t size) {
+        const auto* begin = static_cast<const std::byte*>(bytes);
+        body.insert(body.end(), begin, begin + size);
+    };
+
+    Header header = { MAGIC, VERSION, tolerance, (std::uint32_t)paths.size(), 0, 0, 0 };
+    for (const auto& path : paths) {
+        Record record = { path.source_hash, path.level, header.figure_count, (std::uint32_t)path.flattened.figures.size(),
+            header.point_count, (std::uint32_t)path.flattened.points.size(), 0 };
+        append(&record, sizeof(record));
+        header.figure_count += record.figure_count;
+        header.point_count += record.point_count;
+    }
+    for (const auto& path : paths) {
+        append(path.flattened.figures.data(), path.flattened.figures.size_bytes());
+    }
+    for (const auto& path : paths) {
+        append(path.flattened.points.data(), path.flattened.points.size_bytes());
+    }
+    header.checksum = Checksum(body);
+
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(body.data()), (std::streamsize)body.size());
+    return (bool)stream;
+}
+
+std::uint64_t GeometryFile::Checksum(std::span<const std::byte> data) {
+    // FNV-1a over 64 bit words rather than bytes, which is plenty to catch a truncated
+    // or damaged file and keeps the check cheap next to mapping it.
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    std::size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ull;
+    }
+    for (; i < data.size(); i++) {
+        hash = (hash ^ (std::uint8_t)data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+}
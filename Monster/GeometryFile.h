@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Geometry.h"
+#include "MappedFile.h"
+#include <filesystem>
+#include <vector>
+
+namespace gfx {
+
+// One flattened path in a geometry file. source_hash is HashPath of the path it was
+// flattened from, level the FlatteningCache level of detail.
+struct BakedPath {
+    std::uint64_t source_hash = 0;
+    int level = 0;
+    FlatPathView flattened;
+};
+
+// Flattened paths baked ahead of time, so startup can skip tessellation. The file is
+// mapped read-only and its points and figures are used in place.
+//
+// Layout, all little-endian: a Header, path_count Records, then every figure and every
+// point. Figures index points relative to their own path.
+class GeometryFile {
+public:
+    static constexpr std::uint32_t MAGIC = 0x4f45474d; // "MGEO"
+    static constexpr std::uint32_t VERSION = 1;
+
+    // Maps and validates filename. Returns false and holds no paths if the file is
+    // missing, was written by another version, or fails its checksum.
+    bool Open(const std::filesystem::path& filename);
+
+    float Tolerance() const { return tolerance; }
+
+    // Views into the mapping; valid while the GeometryFile lives.
+    const std::vector<BakedPath>& Paths() const { return paths; }
+
+    static bool Write(const std::filesystem::path& filename, float tolerance, std::span<const BakedPath> paths);
+
+private:
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        float tolerance;
+        std::uint32_t path_count, figure_count, point_count;
+        std::uint64_t checksum;
+    };
+
+    struct Record {
+        std::uint64_t source_hash;
+        std::int32_t level;
+        std::uint32_t first_figure, figure_count;
+        std::uint32_t first_point, point_count;
+        std::uint32_t reserved;
+    };
+
+    MappedFile file;
+    float tolerance = 0.0f;
+    std::vector<BakedPath> paths;
+
+    static std::uint64_t Checksum(std::span<const std::byte> data);
+};
+
+}
@@ -0,0 +1,199 @@
+#include "Headless.h"
+#include "CpuRenderer.h"
+#include "FrameExport.h"
+#include "FrameSink.h"
+#include "TraceReplay.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+
+namespace {
+
+const wchar_t* const GEOMETRY_FALLBACK = L"The geometry file is missing, stale or corrupt, so paths were flattened at "
+    L"runtime.\n";
+
+bool HasFlag(std::span<const std::wstring> args, const wchar_t* flag) {
+    return std::find(args.begin(), args.end(), flag) != args.end();
+}
+
+bool RunExport(std::span<const std::wstring> args, int& exit_code, std::wstring& report) {
+    ExportSettings settings;
+    bool valid_size = true;
+    for (std::size_t i = 0; i + 1 < args.size(); i++) {
+        const auto& option = args[i];
+        const auto* value = args[i + 1].c_str();
+        if (option == L"-export") {
+            settings.output = value;
+        }
+        else if (option == L"-sink") {
+            settings.output = value;
+            settings.format = ExportFormat::SharedMemory;
+        }
+        else if (option == L"-slots") {
+            settings.slots = (int)std::wcstol(value, nullptr, 10);
+        }
+        else if (option == L"-size") {
+            valid_size = std::swscanf(value, L"%dx%d", &settings.width, &settings.height) == 2;
+        }
+        else if (option == L"-fps") {
+            settings.fps = std::wcstod(value, nullptr);
+        }
+        else if (option == L"-frames") {
+            settings.frame_count = (int)std::wcstol(value, nullptr, 10);
+        }
+        else if (option == L"-threads") {
+            settings.encode_threads = (unsigned)std::wcstoul(value, nullptr, 10);
+        }
+        else if (option == L"-geometry") {
+            settings.geometry = value;
+        }
+        else {
+            continue;
+        }
+        i++;
+    }
+
+    if (settings.output.empty()) {
+        return false;
+    }
+    // Checked before anything is allocated for frames of that size.
+    if (!valid_size || settings.width <= 0 || settings.height <= 0 || settings.width > ExportSettings::MAX_SIZE ||
+        settings.height > ExportSettings::MAX_SIZE) {
+        wchar_t text[128];
+        std::swprintf(text, 128, L"-size takes WIDTHxHEIGHT, each from 1 to %d.\n", ExportSettings::MAX_SIZE);
+        report = text;
+        exit_code = 2;
+        return true;
+    }
+    settings.linear_light = HasFlag(args, L"-linear");
+    settings.paced = HasFlag(args, L"-paced");
+    if (settings.format != ExportFormat::SharedMemory) {
+        settings.format = ExportFormatFromExtension(settings.output);
+    }
+
+    auto result = ExportFrames(settings);
+    wchar_t text[256];
+    std::swprintf(text, 256, L"Exported %d frames in %.2f s: %.1f frames/s (busy: render %.2f s, convert %.2f s, "
+        L"encode %.2f s, write %.2f s)%ls\n", result.frames, result.seconds, result.FramesPerSecond(),
+        result.render_seconds, result.convert_seconds, result.encode_seconds, result.write_seconds,
+        result.succeeded ? L"" : L". Export failed.");
+    report = text;
+    if (!settings.geometry.empty() && !result.baked_geometry) {
+        report += GEOMETRY_FALLBACK;
+    }
+
+    exit_code = result.succeeded ? 0 : 1;
+    return true;
+}
+
+bool RunReplay(std::span<const std::wstring> args, int& exit_code, std::wstring& report) {
+    ReplaySettings settings;
+    for (std::size_t i = 0; i + 1 < args.size(); i++) {
+        const auto& option = args[i];
+        const auto* value = args[i + 1].c_str();
+        if (option == L"-replay") {
+            settings.trace = value;
+        }
+        else if (option == L"-report") {
+            settings.report = value;
+        }
+        else if (option == L"-expect") {
+            settings.expected = value;
+        }
+        else if (option == L"-budget") {
+            settings.budget_milliseconds = std::wcstod(value, nullptr);
+        }
+        else if (option == L"-threads") {
+            settings.threads = (unsigned)std::wcstoul(value, nullptr, 10);
+        }
+        else if (option == L"-geometry") {
+            settings.geometry = value;
+        }
+        else {
+            continue;
+        }
+        i++;
+    }
+
+    if (settings.trace.empty()) {
+        return false;
+    }
+    settings.linear_light = HasFlag(args, L"-linear");
+
+    auto result = ReplayTrace(settings);
+    wchar_t text[320];
+    std::swprintf(text, 320, L"Replayed %d frames: median %.3f ms, 95th percentile %.3f ms, max %.3f ms, "
+        L"%" PRIu64 L" target allocations, checksum %016" PRIx64 L"%ls%ls%ls\n", result.frames,
+        result.median_milliseconds, result.p95_milliseconds, result.max_milliseconds, result.allocations,
+        result.checksum, result.read ? L"" : L". The trace is damaged.",
+        result.mismatches > 0 ? L". Frames differ from the reference." : L"",
+        result.over_budget ? L". Over budget." : L"");
+    report = text;
+    if (!settings.geometry.empty() && !result.baked_geometry) {
+        report += GEOMETRY_FALLBACK;
+    }
+    if (result.mismatches > 0) {
+        std::swprintf(text, 320, L"%d frames differ, the first one is frame %d.\n", result.mismatches, result.first_mismatch);
+        report += text;
+    }
+
+    exit_code = result.succeeded ? 0 : 1;
+    return true;
+}
+
+bool RunWatch(std::span<const std::wstring> args, int& exit_code, std::wstring& report) {
+    WatchSettings settings;
+    for (std::size_t i = 0; i + 1 < args.size(); i++) {
+        const auto& option = args[i];
+        const auto& value = args[i + 1];
+        if (option == L"-watch") {
+            settings.name = std::string(value.begin(), value.end());
+        }
+        else if (option == L"-frames") {
+            settings.frame_count = (int)std::wcstol(value.c_str(), nullptr, 10);
+        }
+        else {
+            continue;
+        }
+        i++;
+    }
+
+    if (settings.name.empty()) {
+        return false;
+    }
+
+    auto result = WatchFrames(settings);
+    wchar_t text[256];
+    std::swprintf(text, 256, L"Read %d frames in %.2f s: %.1f frames/s, %.2f GB/s, latency median %.3f ms, "
+        L"95th percentile %.3f ms, %d dropped, %d torn%ls\n", result.frames, result.seconds, result.FramesPerSecond(),
+        result.GigabytesPerSecond(), result.median_latency_milliseconds, result.p95_latency_milliseconds,
+        result.dropped, result.torn, result.succeeded ? L"" : L". The sink stopped early.");
+    report = text;
+
+    exit_code = result.succeeded ? 0 : 1;
+    return true;
+}
+
+bool RunBake(std::span<const std::wstring> args, int& exit_code, std::wstring& report) {
+    auto bake = std::find(args.begin(), args.end(), L"-bake");
+    if (bake == args.end() || bake + 1 == args.end()) {
+        return false;
+    }
+    std::filesystem::path filename = *(bake + 1);
+
+    CpuRenderer renderer;
+    auto succeeded = renderer.BakeGeometry(filename);
+    report = succeeded ? L"Baked geometry into " + filename.wstring() + L".\n"
+                       : L"Couldn't write " + filename.wstring() + L".\n";
+    exit_code = succeeded ? 0 : 1;
+    return true;
+}
+
+}
+
+bool RunHeadless(std::span<const std::wstring> args, int& exit_code, std::wstring& report) {
+    return RunExport(args, exit_code, report) || RunReplay(args, exit_code, report) ||
+        RunWatch(args, exit_code, report) || RunBake(args, exit_code, report);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <span>
+#include <string>
+
+// Runs the modes that need no window, picked by args, the command line without the
+// program name:
+//
+// -export frames.y4m [-size 1920x1080] [-fps 60] [-frames 600] [-threads 2] [-linear]
+// [-geometry geometry.bin] renders frames with CpuRenderer and writes them out. The
+// extension picks the format: .y4m, .png or raw BGRA. -linear blends in linear light.
+// -sink name instead of -export draws the frames into shared memory for other processes
+// to read, into a ring of -slots 3, as fast as possible or -paced at the frame rate.
+// Sides larger than ExportSettings::MAX_SIZE are refused.
+//
+// -replay trace.bin [-report frames.csv] [-expect reference.csv] [-budget 4.0]
+// [-threads 4] [-linear] [-geometry geometry.bin] plays a trace recorded with -record.
+// Fails when a frame's checksum differs from the reference report, or when the 95th
+// percentile frame takes longer than the budget in milliseconds.
+//
+// -watch name [-frames 600] reads frames another process draws with -sink name, in
+// place, and reports how fast and how late they came.
+//
+// -bake geometry.bin is the offline step for -geometry: it flattens the monster's paths
+// at every level CpuRenderer draws them and writes them out. Export and replay map the
+// file at startup instead of flattening, or flatten at runtime as before if it's
+// missing, stale or corrupt.
+//
+// Returns false if args ask for none of them. Otherwise sets exit_code and report, a
+// summary of the run to show the user.
+bool RunHeadless(std::span<const std::wstring> args, int& exit_code, std::wstring& report);
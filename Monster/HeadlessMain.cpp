@@ -0,0 +1,28 @@
+#include "Headless.h"
+#include <clocale>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Entry point of the portable build, for machines without a window system such as the
+// render farm. Takes the same options as Monster.exe without a window; see RunHeadless.
+int main(int argc, char** argv) {
+    std::setlocale(LC_ALL, "");
+
+    std::vector<std::wstring> args;
+    for (int i = 1; i < argc; i++) {
+        args.push_back(std::filesystem::path(argv[i]).wstring());
+    }
+
+    int exit_code = 0;
+    std::wstring report;
+    if (!RunHeadless(args, exit_code, report)) {
+        std::fprintf(stderr,
+            "Usage: %s -export frames.y4m | -sink name | -replay trace.bin | -watch name | -bake geometry.bin "
+            "[options]\n", argc > 0 ? argv[0] : "MonsterHeadless");
+        return 2;
+    }
+    std::printf("%ls", report.c_str());
+    return exit_code;
+}
@@ -0,0 +1,98 @@
+#include "HitTest.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+// Bands are cheap and edges are what a query pays for, so about one edge per band.
+constexpr std::size_t EDGES_PER_BAND = 1;
+constexpr std::size_t MAX_BANDS = 1024;
+
+}
+
+void PathHitTester::Build(FlatPathView path) {
+    bounds = {};
+    band_scale = 0.0f;
+    band_start.clear();
+    edges.clear();
+
+    std::vector<Edge> all;
+    for (const auto& figure : path.figures) {
+        if (!figure.filled || figure.point_count < 2) {
+            continue;
+        }
+
+        // Open figures are filled as if they were closed, like the rasterizer does.
+        auto points = path.points.subspan(figure.first_point, figure.point_count);
+        for (std::size_t i = 0; i < points.size(); i++) {
+            auto a = points[i], b = points[(i + 1) % points.size()];
+            if (a.y == b.y) {
+                continue;
+            }
+
+            auto winding = 1.0f;
+            if (a.y > b.y) {
+                std::swap(a, b);
+                winding = -1.0f;
+            }
+            all.push_back({ a.y, b.y, a.x, (b.x - a.x) / (b.y - a.y), winding });
+        }
+    }
+    if (all.empty()) {
+        return;
+    }
+
+    bounds = { all[0].x, all[0].top, all[0].x, all[0].bottom };
+    for (const auto& edge : all) {
+        auto end_x = edge.x + edge.slope * (edge.bottom - edge.top);
+        bounds.left = std::min({ bounds.left, edge.x, end_x });
+        bounds.right = std::max({ bounds.right, edge.x, end_x });
+        bounds.top = std::min(bounds.top, edge.top);
+        bounds.bottom = std::max(bounds.bottom, edge.bottom);
+    }
+
+    auto band_count = std::clamp(all.size() / EDGES_PER_BAND, std::size_t{ 1 }, MAX_BANDS);
+    band_scale = band_count / (bounds.bottom - bounds.top);
+    auto band_of = [&](float y) {
+        return std::min((std::size_t)std::max((y - bounds.top) * band_scale, 0.0f), band_count - 1);
+    };
+
+    // Counted, then placed, so each band's edges end up next to each other.
+    band_start.assign(band_count + 1, 0);
+    for (const auto& edge : all) {
+        for (auto b = band_of(edge.top); b <= band_of(edge.bottom); b++) {
+            band_start[b + 1]++;
+        }
+    }
+    for (std::size_t b = 0; b < band_count; b++) {
+        band_start[b + 1] += band_start[b];
+    }
+
+    edges.resize(band_start[band_count]);
+    std::vector<std::uint32_t> next(band_start.begin(), band_start.end() - 1);
+    for (const auto& edge : all) {
+        for (auto b = band_of(edge.top); b <= band_of(edge.bottom); b++) {
+            edges[next[b]++] = edge;
+        }
+    }
+}
+
+bool PathHitTester::Contains(Point p) const {
+    if (!(p.x >= bounds.left && p.x < bounds.right && p.y >= bounds.top && p.y < bounds.bottom)) {
+        return false;
+    }
+
+    auto band = std::min((std::size_t)((p.y - bounds.top) * band_scale), band_start.size() - 2);
+    auto winding = 0.0f;
+    for (auto i = band_start[band]; i < band_start[band + 1]; i++) {
+        const auto& edge = edges[i];
+        if (p.y >= edge.top && p.y < edge.bottom && edge.x + (p.y - edge.top) * edge.slope > p.x) {
+            winding += edge.winding;
+        }
+    }
+    return winding != 0.0f;
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Geometry.h"
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Answers whether points fall inside a flattened path, with the nonzero fill rule, by
+// looking at only a few of its edges.
+//
+// The path's bounds are cut into horizontal bands, and every band lists the edges that
+// cross it. A point counts crossings to its right among the edges of its own band, so
+// a query costs a handful of edges however long the path is. Build it once per shape,
+// in the shape's local space, and map points into that space instead of transforming
+// the path.
+class PathHitTester {
+public:
+    void Build(FlatPathView path);
+
+    bool IsEmpty() const { return edges.empty(); }
+    const Rect& Bounds() const { return bounds; }
+
+    bool Contains(Point p) const;
+
+private:
+    // Each edge goes down from top to bottom, and crosses x at top.
+    struct Edge {
+        float top, bottom;
+        float x, slope;
+        // +1 or -1, from the direction the path went.
+        float winding;
+    };
+
+    Rect bounds;
+    float band_scale = 0.0f;
+    // Band b lists edges[band_start[b]] to edges[band_start[b + 1]]; an edge spanning
+    // several bands is copied into each.
+    std::vector<std::uint32_t> band_start;
+    std::vector<Edge> edges;
+};
+
+}
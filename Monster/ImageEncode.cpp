@@ -0,0 +1,337 @@
+#include "ImageEncode.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+// Deflate limits (RFC 1951).
+constexpr std::size_t WINDOW_SIZE = 32768;
+constexpr std::size_t MIN_MATCH = 3;
+constexpr std::size_t MAX_MATCH = 258;
+// Candidates tried per position. Frames repeat so much that longer chains rarely pay.
+constexpr int MAX_CHAIN = 16;
+constexpr int HASH_BITS = 15;
+
+constexpr std::uint16_t LENGTH_BASE[] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+constexpr std::uint8_t LENGTH_EXTRA[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+constexpr std::uint16_t DISTANCE_BASE[] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+    4097, 6145, 8193, 12289, 16385, 24577
+};
+constexpr std::uint8_t DISTANCE_EXTRA[] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+constexpr std::array<std::uint32_t, 256> CRC_TABLE = [] {
+    std::array<std::uint32_t, 256> table = {};
+    for (std::uint32_t n = 0; n < 256; n++) {
+        auto c = n;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+    return table;
+}();
+
+std::uint32_t Crc32(std::span<const std::uint8_t> data, std::uint32_t crc = 0) {
+    crc = ~crc;
+    for (auto byte : data) {
+        crc = CRC_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+std::uint32_t Adler32(std::span<const std::uint8_t> data) {
+    // Largest run of bytes whose sums can't overflow before taking the modulo.
+    constexpr std::size_t RUN = 5552;
+
+    std::uint32_t a = 1, b = 0;
+    for (std::size_t start = 0; start < data.size(); start += RUN) {
+        auto end = std::min(start + RUN, data.size());
+        for (auto i = start; i < end; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+void AppendBigEndian(std::vector<std::uint8_t>& output, std::uint32_t value) {
+    output.push_back((std::uint8_t)(value >> 24));
+    output.push_back((std::uint8_t)(value >> 16));
+    output.push_back((std::uint8_t)(value >> 8));
+    output.push_back((std::uint8_t)value);
+}
+
+// Deflate packs bits starting from the least significant, but Huffman codes go in most
+// significant bit first.
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<std::uint8_t>& output) : output(output) {}
+
+    void Write(std::uint32_t value, int count) {
+        bits |= (std::uint64_t)value << bit_count;
+        bit_count += count;
+        while (bit_count >= 8) {
+            output.push_back((std::uint8_t)bits);
+            bits >>= 8;
+            bit_count -= 8;
+        }
+    }
+
+    void WriteCode(std::uint32_t code, int length) {
+        std::uint32_t reversed = 0;
+        for (int i = 0; i < length; i++) {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        Write(reversed, length);
+    }
+
+    void Flush() {
+        if (bit_count > 0) {
+            output.push_back((std::uint8_t)bits);
+        }
+        bits = 0;
+        bit_count = 0;
+    }
+
+private:
+    std::vector<std::uint8_t>& output;
+    std::uint64_t bits = 0;
+    int bit_count = 0;
+};
+
+// The fixed literal/length code of RFC 1951 section 3.2.6.
+void WriteSymbol(BitWriter& writer, unsigned symbol) {
+    if (symbol <= 143) {
+        writer.WriteCode(0x30 + symbol, 8);
+    }
+    else if (symbol <= 255) {
+        writer.WriteCode(0x190 + symbol - 144, 9);
+    }
+    else if (symbol <= 279) {
+        writer.WriteCode(symbol - 256, 7);
+    }
+    else {
+        writer.WriteCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+void WriteMatch(BitWriter& writer, std::size_t length, std::size_t distance) {
+    auto l = (std::size_t)(std::upper_bound(std::begin(LENGTH_BASE), std::end(LENGTH_BASE), length) -
+        std::begin(LENGTH_BASE)) - 1;
+    WriteSymbol(writer, 257 + (unsigned)l);
+    writer.Write((std::uint32_t)(length - LENGTH_BASE[l]), LENGTH_EXTRA[l]);
+
+    auto d = (std::size_t)(std::upper_bound(std::begin(DISTANCE_BASE), std::end(DISTANCE_BASE), distance) -
+        std::begin(DISTANCE_BASE)) - 1;
+    writer.WriteCode((std::uint32_t)d, 5);
+    writer.Write((std::uint32_t)(distance - DISTANCE_BASE[d]), DISTANCE_EXTRA[d]);
+}
+
+std::uint32_t Hash(const std::uint8_t* p) {
+    auto value = (std::uint32_t)p[0] | ((std::uint32_t)p[1] << 8) | ((std::uint32_t)p[2] << 16);
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Eight bytes at a time; the first byte that differs is the lowest set bit of the
+// difference.
+std::size_t MatchLength(const std::uint8_t* a, const std::uint8_t* b, std::size_t max_length) {
+    std::size_t length = 0;
+    while (length + 8 <= max_length) {
+        std::uint64_t x, y;
+        std::memcpy(&x, a + length, 8);
+        std::memcpy(&y, b + length, 8);
+        if (x != y) {
+            return length + std::countr_zero(x ^ y) / 8;
+        }
+        length += 8;
+    }
+    while (length < max_length && a[length] == b[length]) {
+        length++;
+    }
+    return length;
+}
+
+void AppendChunk(std::vector<std::uint8_t>& output, const char (&type)[5], std::span<const std::uint8_t> data) {
+    AppendBigEndian(output, (std::uint32_t)data.size());
+    auto start = output.size();
+    output.insert(output.end(), type, type + 4);
+    output.insert(output.end(), data.begin(), data.end());
+    AppendBigEndian(output, Crc32({ output.data() + start, output.size() - start }));
+}
+
+}
+
+std::size_t I420Size(int width, int height) {
+    auto chroma = (std::size_t)((width + 1) / 2) * ((height + 1) / 2);
+    return (std::size_t)width * height + 2 * chroma;
+}
+
+void ConvertToI420(const Surface& source, std::vector<std::uint8_t>& output) {
+    auto width = source.width, height = source.height;
+    auto chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+    output.resize(I420Size(width, height));
+
+    auto* luma = output.data();
+    auto* cb = luma + (std::size_t)width * height;
+    auto* cr = cb + (std::size_t)chroma_width * chroma_height;
+
+    // Fixed-point BT.601 with 8 fractional bits.
+    for (int y = 0; y < height; y++) {
+        const auto* row = source.Row(y);
+        auto* out = luma + (std::size_t)y * width;
+        for (int x = 0; x < width; x++) {
+            int b = row[x * 4], g = row[x * 4 + 1], r = row[x * 4 + 2];
+            out[x] = (std::uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+
+    for (int y = 0; y < chroma_height; y++) {
+        const auto* row0 = source.Row(2 * y);
+        const auto* row1 = source.Row(std::min(2 * y + 1, height - 1));
+        for (int x = 0; x < chroma_width; x++) {
+            auto x0 = 2 * x * 4, x1 = std::min(2 * x + 1, width - 1) * 4;
+            int b = (row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) >> 2;
+            int g = (row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1] + 2) >> 2;
+            int r = (row0[x0 + 2] + row0[x1 + 2] + row1[x0 + 2] + row1[x1 + 2] + 2) >> 2;
+            auto index = (std::size_t)y * chroma_width + x;
+            cb[index] = (std::uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            cr[index] = (std::uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+void FilterPngRows(const Surface& source, std::vector<std::uint8_t>& output) {
+    constexpr std::uint8_t SUB = 1, UP = 2;
+
+    auto row_bytes = (std::size_t)source.width * 3;
+    output.resize(source.height * (row_bytes + 1));
+
+    std::vector<std::uint8_t> previous(row_bytes, 0), current(row_bytes + 3, 0);
+    std::vector<std::uint8_t> sub(row_bytes), up(row_bytes);
+
+    for (int y = 0; y < source.height; y++) {
+        // Three zero bytes in front stand in for the pixel left of the first one.
+        const auto* pixels = source.Row(y);
+        auto* rgb = current.data() + 3;
+        for (int x = 0; x < source.width; x++) {
+            rgb[x * 3] = pixels[x * 4 + 2];
+            rgb[x * 3 + 1] = pixels[x * 4 + 1];
+            rgb[x * 3 + 2] = pixels[x * 4];
+        }
+
+        // Residuals are compared as signed bytes, the usual heuristic for which filter
+        // compresses best. Loops this simple vectorize.
+        unsigned sub_cost = 0, up_cost = 0;
+        for (std::size_t i = 0; i < row_bytes; i++) {
+            sub[i] = (std::uint8_t)(rgb[i] - rgb[i - 3]);
+            up[i] = (std::uint8_t)(rgb[i] - previous[i]);
+        }
+        for (std::size_t i = 0; i < row_bytes; i++) {
+            sub_cost += (unsigned)std::abs((int)(std::int8_t)sub[i]);
+            up_cost += (unsigned)std::abs((int)(std::int8_t)up[i]);
+        }
+
+        auto* out = output.data() + y * (row_bytes + 1);
+        out[0] = up_cost < sub_cost ? UP : SUB;
+        const auto& best = up_cost < sub_cost ? up : sub;
+        std::copy(best.begin(), best.end(), out + 1);
+        std::copy(rgb, rgb + row_bytes, previous.begin());
+    }
+}
+
+void CompressZlib(std::span<const std::uint8_t> data, std::vector<std::uint8_t>& output) {
+    // 32 KB window, no preset dictionary, fastest level; the check bits make it a
+    // multiple of 31.
+    output.push_back(0x78);
+    output.push_back(0x01);
+
+    BitWriter writer(output);
+    // One final block with fixed codes.
+    writer.Write(1, 1);
+    writer.Write(1, 2);
+
+    // head holds the latest position of each hash plus one, prev the one before it.
+    std::vector<std::uint32_t> head(std::size_t{ 1 } << HASH_BITS, 0);
+    std::vector<std::uint32_t> prev(WINDOW_SIZE, 0);
+    auto insert = [&](std::size_t position) {
+        auto h = Hash(data.data() + position);
+        prev[position % WINDOW_SIZE] = head[h];
+        head[h] = (std::uint32_t)position + 1;
+    };
+
+    std::size_t position = 0;
+    while (position < data.size()) {
+        std::size_t best_length = 0, best_distance = 0;
+        if (position + MIN_MATCH <= data.size()) {
+            auto max_length = std::min(MAX_MATCH, data.size() - position);
+            auto candidate = head[Hash(data.data() + position)];
+            for (int chain = 0; chain < MAX_CHAIN && candidate > 0; chain++) {
+                auto start = candidate - 1;
+                if (position - start > WINDOW_SIZE) {
+                    break;
+                }
+
+                auto length = MatchLength(data.data() + start, data.data() + position, max_length);
+                if (length > best_length) {
+                    best_length = length;
+                    best_distance = position - start;
+                    if (length == max_length) {
+                        break;
+                    }
+                }
+                candidate = prev[start % WINDOW_SIZE];
+            }
+            insert(position);
+        }
+
+        if (best_length >= MIN_MATCH) {
+            WriteMatch(writer, best_length, best_distance);
+            for (std::size_t i = 1; i < best_length && position + i + MIN_MATCH <= data.size(); i++) {
+                insert(position + i);
+            }
+            position += best_length;
+        }
+        else {
+            WriteSymbol(writer, data[position]);
+            position++;
+        }
+    }
+
+    WriteSymbol(writer, 256);
+    writer.Flush();
+    AppendBigEndian(output, Adler32(data));
+}
+
+void EncodePng(int width, int height, std::span<const std::uint8_t> filtered_rows, std::vector<std::uint8_t>& output) {
+    static constexpr std::uint8_t SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    output.assign(std::begin(SIGNATURE), std::end(SIGNATURE));
+
+    // 8 bits per channel, RGB, default compression, filtering and no interlacing.
+    std::vector<std::uint8_t> header;
+    AppendBigEndian(header, (std::uint32_t)width);
+    AppendBigEndian(header, (std::uint32_t)height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });
+    AppendChunk(output, "IHDR", header);
+
+    std::vector<std::uint8_t> compressed;
+    CompressZlib(filtered_rows, compressed);
+    AppendChunk(output, "IDAT", compressed);
+    AppendChunk(output, "IEND", {});
+}
+
+}
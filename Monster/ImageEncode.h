@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Paint.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Turns BGRA8 frames, as CpuRenderer draws them, into what video and image files store.
+// Alpha is ignored: frames are expected to be opaque.
+namespace gfx {
+
+// Bytes of a width x height 4:2:0 frame: full-size luma, then both chroma planes at
+// half size, rounded up.
+std::size_t I420Size(int width, int height);
+
+// Y4M's default 4:2:0 layout (C420jpeg): each chroma sample is the average of a 2x2
+// block of pixels. BT.601 limited range, the default of most players.
+void ConvertToI420(const Surface& source, std::vector<std::uint8_t>& output);
+
+// PNG scanlines of the image as 8-bit RGB, each one filtered with whichever of the Sub
+// and Up filters leaves the smaller residuals and prefixed with its filter type. Paeth
+// costs as much as both and barely helps on flat shapes.
+void FilterPngRows(const Surface& source, std::vector<std::uint8_t>& output);
+
+// zlib stream of data: greedy LZ77 over a 32 KB window with fixed Huffman codes. Much
+// faster than a full encoder, and filtered frames of flat shapes are mostly long
+// repeats, which is where nearly all the gain is.
+void CompressZlib(std::span<const std::uint8_t> data, std::vector<std::uint8_t>& output);
+
+// Complete PNG file of a width x height RGB image, from FilterPngRows' output.
+void EncodePng(int width, int height, std::span<const std::uint8_t> filtered_rows, std::vector<std::uint8_t>& output);
+
+}
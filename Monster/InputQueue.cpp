@@ -0,0 +1,83 @@
+#include "InputQueue.h"
+#include <algorithm>
+
+bool InputQueue::Push(const InputEvent& event) {
+    auto count = pushed.load(std::memory_order_relaxed);
+    if (count - popped.load(std::memory_order_acquire) == CAPACITY) {
+        return false;
+    }
+
+    events[count % CAPACITY] = event;
+    pushed.store(count + 1, std::memory_order_release);
+    return true;
+}
+
+bool InputQueue::Pop(InputEvent& event) {
+    auto count = popped.load(std::memory_order_relaxed);
+    if (count == pushed.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    event = events[count % CAPACITY];
+    popped.store(count + 1, std::memory_order_release);
+    return true;
+}
+
+bool InputQueue::Empty() const {
+    return popped.load(std::memory_order_relaxed) == pushed.load(std::memory_order_acquire);
+}
+
+InputState::InputState(std::int64_t ticks_per_second) : ticks_per_second((double)ticks_per_second) {}
+
+std::size_t InputState::Drain(InputQueue& queue) {
+    std::size_t count = 0;
+    InputEvent event;
+    while (queue.Pop(event)) {
+        Apply(event);
+        count++;
+    }
+    return count;
+}
+
+void InputState::Apply(const InputEvent& event) {
+    newest_time = std::max(newest_time, event.time);
+
+    switch (event.type) {
+    case InputType::ButtonDown:
+        mouse_down = true;
+        break;
+    case InputType::ButtonUp:
+        mouse_down = false;
+        break;
+    case InputType::MouseMove:
+    {
+        gfx::Point position = { (float)event.x, (float)event.y };
+        auto seconds = (event.time - move_time) / ticks_per_second;
+        if (move_time == 0 || seconds > STALE_SECONDS) {
+            // Starting to move again; there is nothing to measure the speed against.
+            velocity_x = 0.0;
+            velocity_y = 0.0;
+        }
+        else if (seconds > 0.0) {
+            // Exponential smoothing that weighs each move by how long it took, so the
+            // result doesn't depend on the mouse's report rate.
+            auto weight = std::min(seconds / SMOOTHING_SECONDS, 1.0);
+            velocity_x += ((position.x - mouse.x) / seconds - velocity_x) * weight;
+            velocity_y += ((position.y - mouse.y) / seconds - velocity_y) * weight;
+        }
+        mouse = position;
+        move_time = event.time;
+        break;
+    }
+    }
+}
+
+gfx::Point InputState::PredictMouse(std::int64_t time) const {
+    auto since_move = (time - move_time) / ticks_per_second;
+    if (move_time == 0 || since_move > STALE_SECONDS) {
+        return mouse;
+    }
+
+    auto ahead = std::clamp(since_move, 0.0, MAX_PREDICTION_SECONDS);
+    return { mouse.x + (float)(velocity_x * ahead), mouse.y + (float)(velocity_y * ahead) };
+}
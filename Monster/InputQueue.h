@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Geometry.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class InputType : std::uint8_t {
+    MouseMove,
+    ButtonDown,
+    ButtonUp
+};
+
+struct InputEvent {
+    InputType type = InputType::MouseMove;
+    std::int32_t x = 0, y = 0;
+    // Timer ticks when the event was received.
+    std::int64_t time = 0;
+};
+
+// Fixed-size ring of input events from one producer thread to one consumer thread,
+// without locks.
+//
+// Push drops the event when the ring is full. At 1 kHz mouse rates the ring holds
+// about a second of input, so that only happens if the consumer has stalled.
+class InputQueue {
+public:
+    static constexpr std::size_t CAPACITY = 1024;
+
+    bool Push(const InputEvent& event);
+    bool Pop(InputEvent& event);
+    bool Empty() const;
+
+private:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    std::array<InputEvent, CAPACITY> events;
+    // Free-running counts of pushed and popped events, each written by one side only.
+    alignas(64) std::atomic<std::size_t> pushed = 0;
+    alignas(64) std::atomic<std::size_t> popped = 0;
+};
+
+// Cursor and button state rebuilt from input events, plus the cursor's recent
+// velocity so it can be extrapolated ahead to when a frame will be seen.
+class InputState {
+public:
+    // Cursor velocity is smoothed over roughly this long.
+    static constexpr double SMOOTHING_SECONDS = 0.02;
+    // A cursor that hasn't moved for this long is taken to have stopped.
+    static constexpr double STALE_SECONDS = 0.05;
+    // Never extrapolates further ahead than this.
+    static constexpr double MAX_PREDICTION_SECONDS = 0.05;
+
+    explicit InputState(std::int64_t ticks_per_second);
+
+    // Applies every queued event. However many moves came in, the position ends up at
+    // the last one; the moves in between only feed the velocity. Returns the number of
+    // events applied.
+    std::size_t Drain(InputQueue& queue);
+    void Apply(const InputEvent& event);
+
+    gfx::Point Mouse() const { return mouse; }
+    bool MouseDown() const { return mouse_down; }
+    // Time of the newest event applied, or 0 before the first one.
+    std::int64_t NewestTime() const { return newest_time; }
+
+    // Where the cursor will be at time if it keeps moving the way it has been.
+    gfx::Point PredictMouse(std::int64_t time) const;
+
+private:
+    double ticks_per_second;
+
+    gfx::Point mouse;
+    bool mouse_down = false;
+    std::int64_t newest_time = 0;
+
+    // In pixels per second.
+    double velocity_x = 0.0, velocity_y = 0.0;
+    std::int64_t move_time = 0;
+};
@@ -0,0 +1,228 @@
+#include "InputTrace.h"
+#include <cstring>
+
+namespace {
+
+enum : std::uint8_t {
+    FLAG_PAUSED = 1,
+    FLAG_PREDICT_INPUT = 2,
+    FLAG_SIZE = 4,
+    FLAG_TIME_SCALE = 8
+};
+
+struct Header {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::int64_t ticks_per_second;
+    double fixed_step;
+};
+
+// Small values of either sign in few bytes: 0, -1, 1, -2 map to 0, 1, 2, 3.
+std::uint64_t ZigZag(std::int64_t value) {
+    return ((std::uint64_t)value << 1) ^ (std::uint64_t)(value >> 63);
+}
+
+std::int64_t UnZigZag(std::uint64_t value) {
+    return (std::int64_t)(value >> 1) ^ -(std::int64_t)(value & 1);
+}
+
+void PutVarint(std::vector<std::uint8_t>& output, std::uint64_t value) {
+    while (value >= 0x80) {
+        output.push_back((std::uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back((std::uint8_t)value);
+}
+
+template <typename T>
+void PutRaw(std::vector<std::uint8_t>& output, const T& value) {
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+    output.insert(output.end(), bytes, bytes + sizeof(value));
+}
+
+// Reads from data, and once anything runs past the end stays failed.
+struct Cursor {
+    const std::byte* data;
+    std::size_t size;
+    std::size_t offset;
+    bool failed = false;
+
+    std::uint8_t Byte() {
+        if (offset >= size) {
+            failed = true;
+            return 0;
+        }
+        return (std::uint8_t)data[offset++];
+    }
+
+    std::uint64_t Varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            auto byte = Byte();
+            value |= (std::uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+
+    template <typename T>
+    T Raw() {
+        T value{};
+        if (size - offset < sizeof(T)) {
+            failed = true;
+            return value;
+        }
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+};
+
+}
+
+bool TraceWriter::Open(const std::filesystem::path& filename, std::int64_t ticks_per_second, double fixed_step) {
+    stream.open(filename, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        return false;
+    }
+
+    Header header = { MAGIC, VERSION, ticks_per_second, fixed_step };
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    previous = {};
+    previous_event = {};
+    return (bool)stream;
+}
+
+void TraceWriter::Write(const TraceFrame& frame) {
+    if (!stream.is_open()) {
+        return;
+    }
+
+    auto size_changed = frame.width != previous.width || frame.height != previous.height ||
+        frame.dip_scale != previous.dip_scale;
+    auto time_scale_changed = frame.time_scale != previous.time_scale;
+
+    record.clear();
+    record.push_back((frame.paused ? FLAG_PAUSED : 0) | (frame.predict_input ? FLAG_PREDICT_INPUT : 0) |
+        (size_changed ? FLAG_SIZE : 0) | (time_scale_changed ? FLAG_TIME_SCALE : 0));
+    PutVarint(record, ZigZag(frame.time - previous.time));
+    PutVarint(record, ZigZag(frame.real_delta));
+    if (size_changed) {
+        PutVarint(record, frame.width);
+        PutVarint(record, frame.height);
+        PutRaw(record, frame.dip_scale);
+    }
+    if (time_scale_changed) {
+        PutRaw(record, frame.time_scale);
+    }
+
+    PutVarint(record, frame.events.size());
+    for (const auto& event : frame.events) {
+        record.push_back((std::uint8_t)event.type);
+        PutVarint(record, ZigZag((std::int64_t)event.x - previous_event.x));
+        PutVarint(record, ZigZag((std::int64_t)event.y - previous_event.y));
+        PutVarint(record, ZigZag(event.time - previous_event.time));
+        previous_event = event;
+    }
+
+    stream.write(reinterpret_cast<const char*>(record.data()), (std::streamsize)record.size());
+    previous.time = frame.time;
+    previous.width = frame.width;
+    previous.height = frame.height;
+    previous.dip_scale = frame.dip_scale;
+    previous.time_scale = frame.time_scale;
+}
+
+bool TraceWriter::Close() {
+    if (!stream.is_open()) {
+        return true;
+    }
+    stream.close();
+    return (bool)stream;
+}
+
+bool TraceReader::Open(const std::filesystem::path& filename) {
+    file = MappedFile(filename);
+    offset = 0;
+    failed = false;
+    previous = {};
+    previous_event = {};
+
+    auto data = file.Data();
+    Header header;
+    if (data.size() < sizeof(header)) {
+        file = MappedFile();
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != TraceWriter::MAGIC || header.version != TraceWriter::VERSION || header.ticks_per_second <= 0) {
+        file = MappedFile();
+        return false;
+    }
+
+    ticks_per_second = header.ticks_per_second;
+    fixed_step = header.fixed_step;
+    offset = sizeof(header);
+    return true;
+}
+
+bool TraceReader::Next(TraceFrame& frame) {
+    auto data = file.Data();
+    if (failed || offset >= data.size()) {
+        return false;
+    }
+
+    Cursor cursor = { data.data(), data.size(), offset };
+    auto flags = cursor.Byte();
+    frame.paused = (flags & FLAG_PAUSED) != 0;
+    frame.predict_input = (flags & FLAG_PREDICT_INPUT) != 0;
+    frame.time = previous.time + UnZigZag(cursor.Varint());
+    frame.real_delta = UnZigZag(cursor.Varint());
+
+    frame.width = previous.width;
+    frame.height = previous.height;
+    frame.dip_scale = previous.dip_scale;
+    if (flags & FLAG_SIZE) {
+        frame.width = (std::uint32_t)cursor.Varint();
+        frame.height = (std::uint32_t)cursor.Varint();
+        frame.dip_scale = cursor.Raw<float>();
+    }
+    frame.time_scale = flags & FLAG_TIME_SCALE ? cursor.Raw<double>() : previous.time_scale;
+
+    // Every event takes at least four bytes, which bounds the count of a damaged record.
+    auto event_count = cursor.Varint();
+    if (event_count > (data.size() - cursor.offset) / 4) {
+        cursor.failed = true;
+    }
+
+    frame.events.clear();
+    for (std::uint64_t i = 0; i < event_count && !cursor.failed; i++) {
+        InputEvent event;
+        auto type = cursor.Byte();
+        if (type > (std::uint8_t)InputType::ButtonUp) {
+            cursor.failed = true;
+        }
+        event.type = (InputType)type;
+        event.x = (std::int32_t)(previous_event.x + UnZigZag(cursor.Varint()));
+        event.y = (std::int32_t)(previous_event.y + UnZigZag(cursor.Varint()));
+        event.time = previous_event.time + UnZigZag(cursor.Varint());
+        frame.events.push_back(event);
+        previous_event = event;
+    }
+
+    if (cursor.failed) {
+        failed = true;
+        return false;
+    }
+
+    offset = cursor.offset;
+    previous.time = frame.time;
+    previous.width = frame.width;
+    previous.height = frame.height;
+    previous.dip_scale = frame.dip_scale;
+    previous.time_scale = frame.time_scale;
+    return true;
+}
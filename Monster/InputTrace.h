@@ -0,0 +1,81 @@
+#pragma once
+
+#include "InputQueue.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// Everything one simulation step of the window takes from outside: how long the clock
+// ran, the clock's settings, the window size and the input that arrived since the
+// step before. Replaying the steps in order repeats the session exactly.
+struct TraceFrame {
+    // Timer ticks when the step ran, on the same timer as the event times.
+    std::int64_t time = 0;
+    // What AnimationClock::RealDelta returned for the step, in nanoseconds.
+    std::int64_t real_delta = 0;
+    bool paused = false;
+    double time_scale = 1.0;
+    bool predict_input = false;
+
+    // Window size in pixels and DIPs per pixel.
+    std::uint32_t width = 0, height = 0;
+    float dip_scale = 1.0f;
+
+    std::vector<InputEvent> events;
+};
+
+// Writes TraceFrames to a compact binary file as they happen.
+//
+// Layout, all little-endian: a header of MAGIC, VERSION, timer ticks per second and
+// the clock's fixed step, then one record per frame. A record is a flags byte, the
+// frame's time and real delta as varints, the size and time scale only when they
+// changed, and the events, each a type byte followed by its position and time
+// relative to the event before as zigzag varints. A mouse moving at 1 kHz costs a few
+// bytes per event.
+class TraceWriter {
+public:
+    static constexpr std::uint32_t MAGIC = 0x4352544d; // "MTRC"
+    static constexpr std::uint32_t VERSION = 1;
+
+    bool Open(const std::filesystem::path& filename, std::int64_t ticks_per_second, double fixed_step);
+    bool IsOpen() const { return stream.is_open(); }
+
+    void Write(const TraceFrame& frame);
+
+    // Returns false if any write failed.
+    bool Close();
+
+private:
+    std::ofstream stream;
+    std::vector<std::uint8_t> record;
+    TraceFrame previous;
+    InputEvent previous_event;
+};
+
+// Reads a file written by TraceWriter back, frame by frame.
+class TraceReader {
+public:
+    // Returns false if the file is missing or has the wrong header.
+    bool Open(const std::filesystem::path& filename);
+
+    std::int64_t TicksPerSecond() const { return ticks_per_second; }
+    // AnimationClock::FixedStep of the recorded clock.
+    double FixedStep() const { return fixed_step; }
+
+    // Reads the next frame. Returns false at the end of the file, or before a damaged
+    // or truncated record, which Failed then tells apart.
+    bool Next(TraceFrame& frame);
+    bool Failed() const { return failed; }
+
+private:
+    MappedFile file;
+    std::size_t offset = 0;
+    std::int64_t ticks_per_second = 0;
+    double fixed_step = 0.0;
+    bool failed = false;
+
+    TraceFrame previous;
+    InputEvent previous_event;
+};
@@ -1,13 +1,84 @@
 #include "Monster.h"
+#include "Headless.h"
+#include <shellapi.h>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Shows up in the debugger, and in the console when started from one.
+void Report(const std::wstring& text) {
+    OutputDebugStringW(text.c_str());
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        auto console = CreateFileW(L"CONOUT$", GENERIC_WRITE, FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (console != INVALID_HANDLE_VALUE) {
+            DWORD written = 0;
+            WriteConsoleW(console, text.c_str(), (DWORD)text.size(), &written, nullptr);
+            CloseHandle(console);
+        }
+        FreeConsole();
+    }
+}
+
+// The command line without the program name.
+std::vector<std::wstring> CommandLineArgs() {
+    int argc = 0;
+    auto* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) {
+        return {};
+    }
+
+    std::vector<std::wstring> args(argv + (argc > 0 ? 1 : 0), argv + argc);
+    LocalFree(argv);
+    return args;
+}
+
+// Value following option on the command line, or empty if it isn't there.
+std::wstring OptionValue(const wchar_t* option) {
+    int argc = 0;
+    auto* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) {
+        return {};
+    }
+
+    std::wstring value;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::wcscmp(argv[i], option) == 0) {
+            value = argv[i + 1];
+            break;
+        }
+    }
+    LocalFree(argv);
+    return value;
+}
+
+}
 
 INT WINAPI wWinMain(_In_ [[maybe_unused]] HINSTANCE instance,
     _In_opt_ [[maybe_unused]] HINSTANCE prev_instance,
     _In_ [[maybe_unused]] PWSTR cmd_line,
     _In_ [[maybe_unused]] INT cmd_show) {
+    // Monster.exe -export, -sink, -replay, -watch and -bake run without a window.
+    int exit_code = 0;
+    std::wstring report;
+    if (RunHeadless(CommandLineArgs(), exit_code, report)) {
+        Report(report);
+        return exit_code;
+    }
+
     Monster monster;
+    if (cmd_line && std::wcsstr(cmd_line, L"-deterministic")) {
+        monster.UseDeterministicClock();
+    }
+    // Monster.exe -record trace.bin, to replay later with -replay.
+    auto trace = OptionValue(L"-record");
+    if (!trace.empty() && !monster.RecordTrace(trace)) {
+        Report(L"Could not create the trace file.\n");
+    }
 
     monster.InitializeWindow(instance, cmd_show);
     monster.RunMessageLoop();
 
     return 0;
-}
\ No newline at end of file
+}
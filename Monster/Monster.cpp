@@ -1,16 +1,79 @@
 #include "Monster.h"
 #include <windowsx.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
-#include <numbers>
+#include <cstdio>
+#include <random>
+#include <string>
 #include <dxgi1_6.h>
 
-Monster::Monster() : hwnd(nullptr), center(), transformation() {}
+namespace {
 
-void Monster::InitializeWindow(HINSTANCE instance, INT cmd_show) {
-    CreateDeviceIndependentResources();
+// Window pixels to DIPs, which the monster and the crowd are placed in.
+FLOAT DipScale() {
+    return 96.0f / (FLOAT)GetDpiForWindow(GetDesktopWindow());
+}
+
+FrameScheduler::Duration Now() {
+    return std::chrono::steady_clock::now().time_since_epoch();
+}
+
+// User and kernel time of the process so far, in 100 ns units.
+std::int64_t ProcessCpuTime() {
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+
+    ULARGE_INTEGER kernel_time = { kernel.dwLowDateTime, kernel.dwHighDateTime };
+    ULARGE_INTEGER user_time = { user.dwLowDateTime, user.dwHighDateTime };
+    return (std::int64_t)(kernel_time.QuadPart + user_time.QuadPart);
+}
+
+// Needs Windows 10 1803. Without it, waits fall back to millisecond timeouts.
+HANDLE CreateHighResolutionTimer() {
+    return CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+}
 
+// Adds timer to handles, armed to go off after wait, or turns wait into a timeout if
+// there's no timer.
+void ArmTimer(HANDLE timer, FrameScheduler::Duration wait, HANDLE* handles, DWORD& handle_count, DWORD& timeout) {
+    if (!timer) {
+        timeout = (DWORD)std::chrono::ceil<std::chrono::milliseconds>(wait).count();
+        return;
+    }
+
+    // Negative due times are relative, in 100 ns units.
+    LARGE_INTEGER due_time;
+    due_time.QuadPart = -std::max<LONGLONG>(wait.count() / 100, 1);
+    winrt::check_bool(SetWaitableTimer(timer, &due_time, 0, nullptr, nullptr, FALSE));
+    handles[handle_count++] = timer;
+}
+
+}
+
+Monster::Monster() : hwnd(nullptr), transformation() {
+    clock.SetFixedStep(SIMULATION_STEP);
+    simulation_scheduler.SetMode(FrameMode::FixedRate);
+    simulation_scheduler.SetFrameRate(1.0 / SIMULATION_STEP);
+
+    render_wake.attach(CreateEventW(nullptr, FALSE, FALSE, nullptr));
+    winrt::check_bool(bool(render_wake));
+    simulation_timer.attach(CreateHighResolutionTimer());
+    frame_timer.attach(CreateHighResolutionTimer());
+}
+
+Monster::~Monster() {
+    StopRenderThread();
+}
+
+void Monster::InitializeWindow(HINSTANCE instance, INT cmd_show) {
     WNDCLASSEX wcex = { sizeof(WNDCLASSEX) };
-    wcex.style = CS_HREDRAW | CS_VREDRAW;
+    // No CS_HREDRAW or CS_VREDRAW: the render thread redraws after a resize by itself, and
+    // repainting the whole window on every step of a drag only makes it flicker.
+    wcex.style = 0;
     wcex.lpfnWndProc = Monster::WindowProc;
     wcex.cbClsExtra = 0;
     wcex.cbWndExtra = sizeof(LONG_PTR);
@@ -37,30 +100,185 @@ void Monster::InitializeWindow(HINSTANCE instance, INT cmd_show) {
 
     winrt::check_pointer(hwnd);
 
-    CreateDeviceDependentResources();
-    CreateWindowSizeDependentResources();
+    // The window has its size by now, so the first snapshot is already waiting.
+    render_thread = std::thread(&Monster::RenderLoop, this);
 
     ShowWindow(hwnd, cmd_show);
 }
 
 void Monster::RunMessageLoop() {
-    MSG msg;
-
-    do {
-        mouse_down = (GetAsyncKeyState(VK_LBUTTON) < 0);
+    MSG msg = {};
 
+    while (msg.message != WM_QUIT) {
         if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
             if (msg.message != WM_QUIT) {
+                auto begin = timer.get_ticks();
                 TranslateMessage(&msg);
                 DispatchMessage(&msg);
+                if (input_ticks == 0) {
+                    input_begin = begin;
+                }
+                input_ticks += timer.get_ticks() - begin;
             }
         }
+        else if (input_pending && !crowd_mode) {
+            // Key presses go out as soon as the queue is empty instead of with the next
+            // step. Crowds are too big to copy that often and wait for the step.
+            PublishSnapshot();
+        }
+        else if (WaitForSimulationStep()) {
+            simulation_scheduler.OnFrame(Now());
+            Animate();
+            PublishSnapshot();
+        }
+    }
+}
+
+bool Monster::WaitForSimulationStep() {
+    // A paused clock only needs steps to pass input on.
+    auto wait = clock.IsPaused() && !input_pending ? FrameScheduler::NEVER :
+        simulation_scheduler.TimeUntilNextFrame(Now());
+    if (wait == FrameScheduler::Duration{ 0 }) {
+        return true;
+    }
+
+    HANDLE handles[1];
+    DWORD handle_count = 0;
+    DWORD timeout = INFINITE;
+    if (wait != FrameScheduler::NEVER) {
+        ArmTimer(simulation_timer.get(), wait, handles, handle_count, timeout);
+    }
+
+    // Sleeps until the step is due or input arrives, whichever comes first.
+    auto result = MsgWaitForMultipleObjectsEx(handle_count, handles, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+    return result != WAIT_OBJECT_0 + handle_count;
+}
+
+void Monster::UseDeterministicClock() {
+    clock.SetDeterministic(DETERMINISTIC_FRAME);
+    clock.Reset();
+    simulation_scheduler.SetFrameRate(1.0 / DETERMINISTIC_FRAME);
+}
+
+bool Monster::RecordTrace(const std::filesystem::path& filename) {
+    return trace.Open(filename, timer.get_frequency(), clock.FixedStep());
+}
+
+void Monster::Animate() {
+    auto begin = timer.get_ticks();
+
+    clock.Tick();
+    if (trace.IsOpen()) {
+        trace_frame.time = begin;
+        trace_frame.real_delta = std::llround(clock.RealDelta() * 1e9);
+        trace_frame.paused = clock.IsPaused();
+        trace_frame.time_scale = clock.TimeScale();
+        trace_frame.predict_input = predict_input;
+        trace_frame.width = width;
+        trace_frame.height = height;
+        trace_frame.dip_scale = DipScale();
+        trace.Write(trace_frame);
+        trace_frame.events.clear();
+    }
+    while (clock.Step()) {
+        previous_angle = current_angle;
+        current_angle = MonsterScene::SwayAngle(clock.StepTime());
+    }
+
+    // Interpolating puts what's drawn one step behind the simulation.
+    auto alpha = clock.Alpha();
+    angle = std::lerp(previous_angle, current_angle, (FLOAT)alpha);
+    if (crowd_mode) {
+        auto time = clock.StepTime() - (1.0 - alpha) * clock.FixedStep();
+        auto scale = DipScale();
+        crowd.Update(time, { mouse_x * scale, mouse_y * scale });
+    }
+
+    if (simulation_ticks == 0) {
+        simulation_begin = begin;
+    }
+    simulation_ticks += timer.get_ticks() - begin;
+}
+
+void Monster::OnInput(InputEvent event) {
+    event.time = timer.get_ticks();
+    if (event.type == InputType::MouseMove) {
+        mouse_x = event.x;
+        mouse_y = event.y;
+        mouse_time = event.time;
+    }
+
+    input_queue.Push(event);
+    SetEvent(render_wake.get());
+    if (trace.IsOpen()) {
+        trace_frame.events.push_back(event);
+    }
+
+    // The crowd's eyes follow the mouse through the simulation instead.
+    if (crowd_mode) {
+        input_pending = true;
+    }
+
+    // The crowd is placed in DIPs, like the monster.
+    if (crowd_mode && event.type == InputType::ButtonDown) {
+        auto scale = DipScale();
+        auto hit = crowd_index.HitTest(crowd, { event.x * scale, event.y * scale });
+        if (hit.instance != CrowdHit::NONE) {
+            auto& expression = crowd.expression[hit.instance];
+            expression = expression == Expression::Smile ? Expression::Sad : Expression::Smile;
+        }
+    }
+}
+
+void Monster::PublishSnapshot() {
+    auto& snapshot = snapshots.Back();
+    snapshot.sequence = ++published;
+    snapshot.width = width;
+    snapshot.height = height;
+    snapshot.resizing = resizing;
+
+    snapshot.scene.transformation = transformation;
+    snapshot.scene.angle = angle;
+    snapshot.predict_input = predict_input;
+
+    snapshot.crowd_mode = crowd_mode;
+    if (crowd_mode) {
+        // Each buffer copies the whole crowd once per generation, and otherwise only
+        // the arrays the simulation and clicks change.
+        if (snapshot.crowd_generation != crowd_generation) {
+            snapshot.crowd = crowd;
+            snapshot.crowd_generation = crowd_generation;
+        }
         else {
-            auto time = timer.get_time(2) * std::numbers::pi;
-            angle = std::sin(time) * 10.0f;
-            OnRender();
+            snapshot.crowd.CopyAnimation(crowd);
         }
-    } while (msg.message != WM_QUIT);
+        snapshot.input_time = mouse_time;
+    }
+
+    snapshot.frame_mode = frame_mode;
+    snapshot.animating = !clock.IsPaused();
+    snapshot.profiling = profiling;
+
+    snapshot.input_begin = input_begin;
+    snapshot.input_ticks = input_ticks;
+    snapshot.simulation_begin = simulation_begin;
+    snapshot.simulation_ticks = simulation_ticks;
+    input_ticks = 0;
+    simulation_ticks = 0;
+    input_pending = false;
+
+    snapshots.Publish();
+    SetEvent(render_wake.get());
+}
+
+void Monster::StopRenderThread() {
+    if (!render_thread.joinable()) {
+        return;
+    }
+
+    render_stop = true;
+    SetEvent(render_wake.get());
+    render_thread.join();
 }
 
 void Monster::CreateDeviceIndependentResources() {
@@ -69,16 +287,11 @@ void Monster::CreateDeviceIndependentResources() {
     // Initialize the Direct2D Factory.
     winrt::check_hresult(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, options, d2d_factory.put()));
 
-    monster_path = CreateMonster();
-    nose_path = CreateNose();
-    smile_path = CreateSmile();
-    sad_path = CreateSad();
+    d2d_renderer.CreateDeviceIndependentResources(d2d_factory.get());
+    d2d_renderer.SetProfiler(&profiler);
 }
 
 void Monster::CreateDeviceDependentResources() {
-    using D2D1::RadialGradientBrushProperties;
-    using D2D1::Point2F;
-
     // This flag adds support for surfaces with a different color channel ordering
     // than the API default. It is required for compatibility with Direct2D.
     UINT creationFlags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
@@ -136,38 +349,23 @@ void Monster::CreateDeviceDependentResources() {
     winrt::check_hresult(d2d_factory->CreateDevice(dxgi_device.get(), d2d_device.put()));
     winrt::check_hresult(d2d_device->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, d2d_context.put()));
 
-    winrt::check_hresult(d2d_context->CreateSolidColorBrush(brush_color, main_brush.put()));
-
-    winrt::com_ptr<ID2D1GradientStopCollection> rad_stops;
-    winrt::check_hresult(d2d_context->CreateGradientStopCollection(rad_stops_data, 3, rad_stops.put()));
-    winrt::check_hresult(d2d_context->CreateRadialGradientBrush(
-        RadialGradientBrushProperties(Point2F(0, 0), Point2F(0, 0), 150, 150),
-        rad_stops.get(), main_rad_brush.put()));
-
-    winrt::com_ptr<ID2D1GradientStopCollection> eye_stops;
-    winrt::check_hresult(d2d_context->CreateGradientStopCollection(eye_stops_data, 2, eye_stops.put()));
-    winrt::check_hresult(d2d_context->CreateRadialGradientBrush(
-        RadialGradientBrushProperties(Point2F(-43.0f, -12.0f), Point2F(0, 0), 34, 34),
-        eye_stops.get(), left_eye_brush.put()));
-    winrt::check_hresult(d2d_context->CreateRadialGradientBrush(
-        RadialGradientBrushProperties(Point2F(43.0f, -12.0f), Point2F(0, 0), 34, 34),
-        eye_stops.get(), right_eye_brush.put()));
+    d2d_renderer.CreateDeviceDependentResources(d2d_context.get());
 }
 
 void Monster::CreateWindowSizeDependentResources() {
-    using D2D1::Matrix3x2F;
-
     d2d_context->SetTarget(nullptr);
     d2d_target_bitmap = nullptr;
+    // Resized buffers start out undefined.
+    d2d_renderer.InvalidateTarget();
 
     if (swap_chain) {
         // If the swap chain already exists, resize it.
         auto hr = swap_chain->ResizeBuffers(
             2,
-            0,
-            0,
+            target_sizer.AllocatedWidth(),
+            target_sizer.AllocatedHeight(),
             DXGI_FORMAT_B8G8R8A8_UNORM,
-            0
+            swap_chain_flags
         );
         if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) {
             // If the device was removed for any reason, a new device and swap chain will need to be created.
@@ -191,10 +389,20 @@ void Monster::CreateWindowSizeDependentResources() {
         winrt::com_ptr<IDXGIFactory7> dxgi_factory;
         winrt::check_hresult(dxgi_adapter->GetParent(IID_PPV_ARGS(dxgi_factory.put())));
 
+        // Tearing lets uncapped frames present without waiting for vertical blank.
+        BOOL allow_tearing = FALSE;
+        tearing_supported = SUCCEEDED(dxgi_factory->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING,
+            &allow_tearing, sizeof(allow_tearing))) && allow_tearing;
+
+        swap_chain_flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+        if (tearing_supported) {
+            swap_chain_flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+        }
+
         DXGI_SWAP_CHAIN_DESC1 swapChainDesc = { 0 };
 
-        swapChainDesc.Width = 0;
-        swapChainDesc.Height = 0;
+        swapChainDesc.Width = target_sizer.AllocatedWidth();
+        swapChainDesc.Height = target_sizer.AllocatedHeight();
         swapChainDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
         swapChainDesc.Stereo = false;
         swapChainDesc.SampleDesc.Count = 1;
@@ -202,12 +410,20 @@ void Monster::CreateWindowSizeDependentResources() {
         swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
         swapChainDesc.BufferCount = 2;
         swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
-        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
-        swapChainDesc.Flags = 0;
+        // The frame latency waitable object needs the flip model. Sequential rather than
+        // discard, since scene frames only redraw what changed and rely on each buffer
+        // keeping its last frame.
+        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+        swapChainDesc.Flags = swap_chain_flags;
 
         winrt::com_ptr<IDXGISwapChain1> swap_chain1;
         dxgi_factory->CreateSwapChainForHwnd(d3d_device.get(), hwnd, &swapChainDesc, nullptr, nullptr, swap_chain1.put());
         swap_chain1.as(swap_chain);
+
+        // Rendering only once the previous frame is on screen keeps input latency to a
+        // single frame.
+        winrt::check_hresult(swap_chain->SetMaximumFrameLatency(1));
+        frame_latency_waitable.attach(swap_chain->GetFrameLatencyWaitableObject());
     }
 
     winrt::com_ptr<IDXGISurface2> dxgi_back_buffer;
@@ -226,55 +442,184 @@ void Monster::CreateWindowSizeDependentResources() {
     d2d_context->CreateBitmapFromDxgiSurface(dxgi_back_buffer.get(), &bitmapProperties, d2d_target_bitmap.put());
 
     d2d_context->SetTarget(d2d_target_bitmap.get());
+    target_allocations++;
 
-    transformation = Matrix3x2F::Scale(3.0f, 3.0f) * Matrix3x2F::Translation(d2d_context->GetSize().width / 2.0f,
-        d2d_context->GetSize().height / 2.0f);
+    winrt::check_hresult(swap_chain->SetSourceSize(target_width, target_height));
+    d2d_renderer.SetTargetSize(target_width, target_height);
+}
+
+void Monster::UpdateTargetSize() {
+    // Minimized windows keep their buffers for when they come back.
+    if (target_width == 0 || target_height == 0) {
+        return;
+    }
+
+    if (target_sizer.Update(target_width, target_height, target_resizing, Now()) || !swap_chain) {
+        CreateWindowSizeDependentResources();
+        return;
+    }
+
+    // The buffers are big enough, so only the part of them that is shown changes.
+    winrt::check_hresult(swap_chain->SetSourceSize(target_width, target_height));
+    d2d_renderer.SetTargetSize(target_width, target_height);
 }
 
 void Monster::HandleDeviceLost() {
+    frame_latency_waitable.close();
     swap_chain = nullptr;
 
     CreateDeviceDependentResources();
     CreateWindowSizeDependentResources();
 }
 
-void Monster::OnRender() {
-    using D2D1::Point2F;
-    using D2D1::Matrix3x2F;
-    using D2D1::Ellipse;
 
-    auto mouth_transformation = Matrix3x2F::Rotation(angle) * transformation;
-    auto left_ball = CreateBall(true), right_ball = CreateBall(false);
+void Monster::RenderLoop() {
+    CreateDeviceIndependentResources();
+    CreateDeviceDependentResources();
 
-    d2d_context->BeginDraw();
-    d2d_context->Clear(background_color);
+    // A frame runs from the end of one render to the end of the next.
+    profiler.BeginFrame();
 
-    d2d_context->SetTransform(transformation);
-    d2d_context->FillGeometry(monster_path.get(), main_rad_brush.get());
-    d2d_context->DrawGeometry(monster_path.get(), main_brush.get());
+    while (WaitForFrame()) {
+        scheduler.OnFrame(Now());
+        // No snapshot says when the size has settled, so a pending shrink is checked on
+        // every frame.
+        if (target_sizer.Settling()) {
+            UpdateTargetSize();
+        }
+        OnRender(snapshots.Front());
 
-    d2d_context->FillEllipse(left_eye, left_eye_brush.get());
-    d2d_context->FillEllipse(right_eye, right_eye_brush.get());
+        profiler.EndFrame();
+        profiler.BeginFrame();
+    }
+}
 
-    d2d_context->FillEllipse(left_ball, main_brush.get());
-    d2d_context->FillEllipse(right_ball, main_brush.get());
+bool Monster::WaitForFrame() {
+    while (!render_stop) {
+        TakeSnapshot();
+        if (!input_queue.Empty()) {
+            scheduler.Invalidate();
+        }
 
-    d2d_context->SetTransform(mouth_transformation);
-    main_brush->SetColor(nose_color);
-    d2d_context->FillGeometry(nose_path.get(), main_brush.get());
-    main_brush->SetColor(brush_color);
-    d2d_context->DrawGeometry(nose_path.get(), main_brush.get());
-    d2d_context->DrawGeometry(mouse_down ? smile_path.get() : sad_path.get(), main_brush.get(), 3.0f);
+        // Nothing to draw before the first snapshot or while minimized.
+        auto ready = swap_chain && target_width != 0 && target_height != 0;
+        auto wait = ready ? scheduler.TimeUntilNextFrame(Now()) : FrameScheduler::NEVER;
 
-    winrt::check_hresult(d2d_context->EndDraw());
+        HANDLE handles[2] = { render_wake.get() };
+        DWORD handle_count = 1;
+        DWORD timeout = INFINITE;
+        if (wait == FrameScheduler::Duration{ 0 }) {
+            if (!scheduler.WaitsForSwapChain() || !frame_latency_waitable) {
+                return true;
+            }
+            handles[handle_count++] = frame_latency_waitable.get();
+        }
+        else if (wait != FrameScheduler::NEVER) {
+            ArmTimer(frame_timer.get(), wait, handles, handle_count, timeout);
+        }
+
+        // Sleeps until the frame is due, a snapshot comes in or it's time to stop. A new
+        // snapshot can change the mode, so the wait starts over.
+        FrameProfiler::Zone zone(&profiler, FramePhase::Wait);
+        auto result = WaitForMultipleObjects(handle_count, handles, FALSE, timeout);
+        winrt::check_bool(result != WAIT_FAILED);
+        if (result != WAIT_OBJECT_0) {
+            TakeSnapshot();
+            return !render_stop;
+        }
+    }
+    return false;
+}
+
+void Monster::TakeSnapshot() {
+    if (!snapshots.Read()) {
+        return;
+    }
+
+    const auto& snapshot = snapshots.Front();
+    inverse_transformation = MonsterScene::InverseTransformation(snapshot.scene.transformation);
+    profiler.AddPhase(FramePhase::Input, snapshot.input_begin, snapshot.input_ticks);
+    profiler.AddPhase(FramePhase::Simulation, snapshot.simulation_begin, snapshot.simulation_ticks);
+
+    if (snapshot.frame_mode != scheduler.Mode()) {
+        scheduler.SetMode(snapshot.frame_mode);
+    }
+    scheduler.SetAnimating(snapshot.animating);
+    scheduler.Invalidate();
+
+    if (snapshot.profiling != profiler.IsEnabled()) {
+        SetProfiling(snapshot.profiling);
+    }
+
+    if (snapshot.width != target_width || snapshot.height != target_height || snapshot.resizing != target_resizing ||
+        !swap_chain) {
+        target_width = snapshot.width;
+        target_height = snapshot.height;
+        target_resizing = snapshot.resizing;
+        UpdateTargetSize();
+    }
+}
+
+void Monster::OnRender(const SceneSnapshot& snapshot) {
+    // Input is read as late as possible, right before drawing.
+    auto sample_time = timer.get_ticks();
+    input.Drain(input_queue);
+
+    auto input_time = snapshot.crowd_mode ? snapshot.input_time : input.NewestTime();
+    if (input_time > shown_input_time) {
+        profiler.SetInputTime(input_time);
+        shown_input_time = input_time;
+    }
+
+    if (snapshot.crowd_mode) {
+        d2d_renderer.RenderCrowd(snapshot.crowd);
+    }
+    else {
+        auto scene = snapshot.scene;
+        {
+            FrameProfiler::Zone zone(&profiler, FramePhase::Geometry);
+            // Predicted about as far ahead as the last frame took to get on screen.
+            auto mouse = snapshot.predict_input ? input.PredictMouse(sample_time + render_latency) : input.Mouse();
+            MonsterScene::CreateBalls(inverse_transformation, mouse, scene.left_ball, scene.right_ball);
+            auto seconds = smile_time != 0 ? (double)(sample_time - smile_time) / timer.get_frequency() : 0.0;
+            smile = MonsterScene::StepExpression(smile, input.MouseDown(), seconds);
+            smile_time = sample_time;
+            scene.smile = smile;
+        }
+        d2d_renderer.Render(scene);
+
+        // On-demand frames have to keep coming until the expression settles.
+        if (smile != (input.MouseDown() ? 1.0f : 0.0f)) {
+            scheduler.Invalidate();
+        }
+    }
+
+    // Telling DXGI what changed lets the compositor skip the rest.
+    std::array<RECT, gfx::DamageRegion::MAX_RECTS> dirty_rects;
+    UINT dirty_count = 0;
+    if (!d2d_renderer.IsFullDamage()) {
+        for (const auto& rect : d2d_renderer.Damage().Rects()) {
+            dirty_rects[dirty_count++] = { rect.left, rect.top, rect.right, rect.bottom };
+        }
+    }
 
     DXGI_PRESENT_PARAMETERS parameters = { 0 };
-    parameters.DirtyRectsCount = 0;
-    parameters.pDirtyRects = nullptr;
+    parameters.DirtyRectsCount = dirty_count;
+    parameters.pDirtyRects = dirty_count > 0 ? dirty_rects.data() : nullptr;
     parameters.pScrollRect = nullptr;
     parameters.pScrollOffset = nullptr;
 
-    auto hr = swap_chain->Present1(1, 0, &parameters);
+    auto sync_interval = scheduler.SyncInterval();
+    UINT flags = sync_interval == 0 && tearing_supported ? DXGI_PRESENT_ALLOW_TEARING : 0;
+
+    HRESULT hr;
+    {
+        // Includes the wait for vertical blank, if any.
+        FrameProfiler::Zone zone(&profiler, FramePhase::Present);
+        hr = swap_chain->Present1(sync_interval, flags, &parameters);
+    }
+    render_latency = timer.get_ticks() - sample_time;
+
     if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) {
         // If the device was removed for any reason, a new device and swap chain will need to be created.
         HandleDeviceLost();
@@ -285,143 +630,110 @@ void Monster::OnRender() {
 }
 
 void Monster::OnResize(UINT width, UINT height) {
-    CreateWindowSizeDependentResources();
-}
+    this->width = width;
+    this->height = height;
 
-winrt::com_ptr<ID2D1PathGeometry> Monster::CreateMonster() {
-    using D2D1::Point2F;
-    using D2D1::BezierSegment;
-
-    winrt::com_ptr<ID2D1PathGeometry> path;
-    winrt::com_ptr<ID2D1GeometrySink> path_sink;
-    d2d_factory->CreatePathGeometry(path.put());
-    path->Open(path_sink.put());
-
-    path_sink->BeginFigure(Point2F(-2.0f, -74.5f), D2D1_FIGURE_BEGIN_FILLED);
-    path_sink->AddBezier(BezierSegment(Point2F(7.7f, -74.5f), Point2F(14.5f, -74.4f), Point2F(23.1f, -71.9f)));
-    path_sink->AddBezier(BezierSegment(Point2F(30.2f, -69.8f), Point2F(37.5f, -67.6f), Point2F(40.1f, -62.4f)));
-    path_sink->AddBezier(BezierSegment(Point2F(40.4f, -61.7f), Point2F(41.2f, -59.8f), Point2F(42.3f, -59.8f)));
-    path_sink->AddBezier(BezierSegment(Point2F(43.9f, -59.8f), Point2F(44.9f, -63.6f), Point2F(45.6f, -65.4f)));
-    path_sink->AddBezier(BezierSegment(Point2F(48.6f, -73.1f), Point2F(60.3f, -79.3f), Point2F(71.1f, -78.8f)));
-    path_sink->AddBezier(BezierSegment(Point2F(72.0f, -78.8f), Point2F(85.9f, -77.8f), Point2F(92.0f, -67.3f)));
-    path_sink->AddBezier(BezierSegment(Point2F(99.2f, -54.9f), Point2F(90.5f, -37.9f), Point2F(83.2f, -30.1f)));
-    path_sink->AddBezier(BezierSegment(Point2F(79.0f, -25.6f), Point2F(69.8f, -18.0f), Point2F(69.8f, -18.0f)));
-    path_sink->AddBezier(BezierSegment(Point2F(71.9f, -7.4f), Point2F(74.7f, 2.9f), Point2F(78.2f, 13.0f)));
-    path_sink->AddBezier(BezierSegment(Point2F(84.3f, 30.5f), Point2F(88.2f, 35.3f), Point2F(91.3f, 49.6f)));
-    path_sink->AddBezier(BezierSegment(Point2F(94.0f, 61.8f), Point2F(96.2f, 71.7f), Point2F(92.3f, 83.2f)));
-    path_sink->AddBezier(BezierSegment(Point2F(87.5f, 97.7f), Point2F(76.5f, 105.6f), Point2F(72.4f, 108.4f)));
-    path_sink->AddBezier(BezierSegment(Point2F(62.1f, 115.6f), Point2F(52.4f, 117.1f), Point2F(37.4f, 119.5f)));
-    path_sink->AddBezier(BezierSegment(Point2F(26.8f, 121.2f), Point2F(16.3f, 121.3f), Point2F(4.1f, 121.5f)));
-    path_sink->AddBezier(BezierSegment(Point2F(0.3f, 121.6f), Point2F(-4.0f, 121.6f), Point2F(-8.9f, 121.5f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-21.2f, 121.3f), Point2F(-31.7f, 121.2f), Point2F(-42.3f, 119.5f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-56.1f, 117.4f), Point2F(-66.5f, 115.9f), Point2F(-77.3f, 108.4f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-81.3f, 105.6f), Point2F(-92.4f, 97.7f), Point2F(-97.2f, 83.2f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-101.0f, 71.7f), Point2F(-98.9f, 61.8f), Point2F(-96.2f, 49.6f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-93.6f, 37.5f), Point2F(-89.4f, 27.8f), Point2F(-83.1f, 13.0f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-77.3f, -0.7f), Point2F(-70.4f, -14.5f), Point2F(-74.6f, -18.0f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-74.6f, -18.0f), Point2F(-74.6f, -18.0f), Point2F(-74.6f, -18.0f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-80.2f, -22.6f), Point2F(-86.6f, -28.7f), Point2F(-88.0f, -30.1f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-92.9f, -35.0f), Point2F(-104.8f, -53.6f), Point2F(-96.8f, -67.3f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-90.7f, -77.8f), Point2F(-76.8f, -78.7f), Point2F(-75.9f, -78.8f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-65.1f, -79.3f), Point2F(-53.4f, -73.1f), Point2F(-50.4f, -65.4f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-49.8f, -63.6f), Point2F(-48.8f, -59.8f), Point2F(-47.2f, -59.8f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-46.0f, -59.8f), Point2F(-45.2f, -61.7f), Point2F(-44.9f, -62.4f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-42.4f, -67.6f), Point2F(-35.0f, -69.8f), Point2F(-27.9f, -71.9f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-19.0f, -74.5f), Point2F(-12.0f, -74.5f), Point2F(-2.0f, -74.55f)));
+    // Same DPI as the render target, so the monster lands where Direct2D draws it.
+    auto scale = DipScale();
+    transformation = MonsterScene::DefaultTransformation(width * scale, height * scale);
 
-    path_sink->EndFigure(D2D1_FIGURE_END_CLOSED);
-    path_sink->Close();
-
-    return path;
+    // Published right away, since the message loop doesn't run while the window is
+    // being dragged.
+    PublishSnapshot();
 }
 
-winrt::com_ptr<ID2D1PathGeometry> Monster::CreateNose() {
-    using D2D1::Point2F;
-    using D2D1::BezierSegment;
-
-    winrt::com_ptr<ID2D1PathGeometry> path;
-    winrt::com_ptr<ID2D1GeometrySink> path_sink;
-    d2d_factory->CreatePathGeometry(path.put());
-    path->Open(path_sink.put());
-
-    path_sink->BeginFigure(Point2F(0.0f, 38.3f), D2D1_FIGURE_BEGIN_FILLED);
-    path_sink->AddBezier(BezierSegment(Point2F(1.8f, 40.9f), Point2F(16.2f, 25.1f), Point2F(14.6f, 23.0f)));
-    path_sink->AddBezier(BezierSegment(Point2F(15.3f, 18.9f), Point2F(-16.4f, 19.2f), Point2F(-16.3f, 22.3f)));
-    path_sink->AddBezier(BezierSegment(Point2F(-16.7f, 26.2f), Point2F(-0.7f, 40.9f), Point2F(0.0f, 38.33f)));
-    path_sink->EndFigure(D2D1_FIGURE_END_CLOSED);
-    path_sink->Close();
-
-    return path;
+void Monster::SetResizing(bool resizing) {
+    this->resizing = resizing;
+    PublishSnapshot();
 }
 
-winrt::com_ptr<ID2D1PathGeometry> Monster::CreateSmile() {
-    using D2D1::Point2F;
-    using D2D1::SizeF;
-    using D2D1::ArcSegment;
-
-    winrt::com_ptr<ID2D1PathGeometry> path;
-    winrt::com_ptr<ID2D1GeometrySink> path_sink;
-    d2d_factory->CreatePathGeometry(path.put());
-    path->Open(path_sink.put());
-
-    path_sink->BeginFigure(Point2F(-40.0f, 75.0f), D2D1_FIGURE_BEGIN_HOLLOW);
-    path_sink->AddArc(ArcSegment(Point2F(40.0f, 75.0f), SizeF(10.0f, 7.0f), 0.0f, D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+void Monster::ToggleCrowdMode() {
+    crowd_mode = !crowd_mode;
+    if (!crowd_mode) {
+        return;
+    }
 
-    path_sink->EndFigure(D2D1_FIGURE_END_OPEN);
-    path_sink->Close();
+    // Scatter small monsters over the window, seeded so every run looks the same.
+    auto scale = DipScale();
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
 
-    return path;
+    crowd.Clear();
+    for (std::size_t i = 0; i < CROWD_SIZE; i++) {
+        crowd.Add({ unit(random) * width * scale, unit(random) * height * scale },
+            0.03f + 0.05f * unit(random), 2.0f * unit(random),
+            unit(random) < 0.5f ? Expression::Sad : Expression::Smile);
+    }
+    crowd.Update(clock.Time(), { mouse_x * scale, mouse_y * scale });
+    crowd_index.Build(crowd);
+    crowd_generation++;
 }
 
-winrt::com_ptr<ID2D1PathGeometry> Monster::CreateSad() {
-    using D2D1::Point2F;
-    using D2D1::SizeF;
-    using D2D1::ArcSegment;
-
-    winrt::com_ptr<ID2D1PathGeometry> path;
-    winrt::com_ptr<ID2D1GeometrySink> path_sink;
-    d2d_factory->CreatePathGeometry(path.put());
-    path->Open(path_sink.put());
-
-    path_sink->BeginFigure(Point2F(-40.0f, 75.0f), D2D1_FIGURE_BEGIN_HOLLOW);
-    path_sink->AddArc(ArcSegment(Point2F(40.0f, 75.0f), SizeF(8.0f, 3.0f), 0.0f, D2D1_SWEEP_DIRECTION_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+void Monster::CycleFrameMode() {
+    frame_mode = (FrameMode)(((int)frame_mode + 1) % (int)FrameMode::Count);
 
-    path_sink->EndFigure(D2D1_FIGURE_END_OPEN);
-    path_sink->Close();
-
-    return path;
+    auto name = FrameModeName(frame_mode);
+    std::wstring title = L"Direct2D Monster (" + std::wstring(name.begin(), name.end()) + L")";
+    SetWindowTextW(hwnd, title.c_str());
 }
 
-D2D1_ELLIPSE Monster::CreateBall(bool left_eye) {
-    using D2D1::Point2F;
-    using D2D1::Matrix3x2F;
-    using D2D1::Ellipse;
-
-    Matrix3x2F transformationCopy = transformation;
-    if (transformationCopy.IsInvertible()) {
-        transformationCopy.Invert();
+void Monster::SetProfiling(bool profiling) {
+    if (profiling) {
+        profile_cpu_start = ProcessCpuTime();
+        profile_ticks_start = timer.get_ticks();
+        profile_allocations_start = target_allocations + d2d_renderer.LayerAllocations();
+        profiler.SetEnabled(true);
+        return;
     }
 
-    auto mousePosTransformed = transformationCopy.TransformPoint(Point2F(mouse_x, mouse_y));
-
-    auto eye_x = left_eye ? -EYE_X_OFFSET : EYE_X_OFFSET;
-    auto eye_y = EYE_Y_OFFSET;
-    auto dist_x = mousePosTransformed.x - eye_x, dist_y = mousePosTransformed.y - eye_y;
-
-    auto dist_squared = dist_x * dist_x + dist_y * dist_y;
+    profiler.SetEnabled(false);
+    ReportFrameStatistics();
+    if (!profiler.ExportJson("monster_profile.json") ||
+        !profiler.ExportCsv("monster_profile.csv") ||
+        !profiler.ExportChromeTrace("monster_trace.json")) {
+        OutputDebugStringW(L"Failed to write the frame profile.\n");
+    }
+}
 
-    auto ball_orbit = EYE_RADIUS - EYE_BALL_RADIUS;
+void Monster::ReportFrameStatistics() {
+    auto frames = profiler.Frames();
+    if (frames.empty()) {
+        return;
+    }
 
-    D2D1_POINT_2F ball_pos;
-    if (dist_squared <= ball_orbit * ball_orbit) {
-        ball_pos = Point2F(mousePosTransformed.x, mousePosTransformed.y);
+    double sum = 0.0, sum_of_squares = 0.0;
+    for (const auto& frame : frames) {
+        auto milliseconds = profiler.TicksToMilliseconds(frame.end - frame.begin);
+        sum += milliseconds;
+        sum_of_squares += milliseconds * milliseconds;
     }
-    else {
-        auto fac = ball_orbit / std::sqrt(dist_squared);
-        ball_pos = Point2F(eye_x + dist_x * fac, eye_y + dist_y * fac);
+    auto mean = sum / frames.size();
+    auto deviation = std::sqrt(std::max(sum_of_squares / frames.size() - mean * mean, 0.0));
+
+    double latency_sum = 0.0;
+    std::size_t latency_count = 0;
+    for (const auto& frame : frames) {
+        if (frame.input_time != 0) {
+            latency_sum += profiler.TicksToMilliseconds(frame.end - frame.input_time);
+            latency_count++;
+        }
     }
-
-    return Ellipse(ball_pos, EYE_BALL_RADIUS, EYE_BALL_RADIUS);
+    auto latency = latency_count > 0 ? latency_sum / latency_count : 0.0;
+
+    // Process CPU time over wall time, so 100% is one core kept busy.
+    auto wall_seconds = profiler.TicksToMilliseconds(timer.get_ticks() - profile_ticks_start) / 1000.0;
+    auto cpu_seconds = (ProcessCpuTime() - profile_cpu_start) * 1e-7;
+    auto cpu_usage = wall_seconds > 0.0 ? 100.0 * cpu_seconds / wall_seconds : 0.0;
+
+    // Swap chain buffers and layer bitmaps, which a resize storm shows up in.
+    auto allocations = target_allocations + d2d_renderer.LayerAllocations() - profile_allocations_start;
+
+    auto name = FrameModeName(scheduler.Mode());
+    wchar_t line[256];
+    swprintf_s(line, L"%.*hs: %zu frames, %.3f ms +- %.3f ms, input latency %.3f ms, CPU %.1f%%, %llu target allocations\n",
+        (int)name.size(), name.data(), frames.size(), mean, deviation, latency, cpu_usage,
+        (unsigned long long)allocations);
+    OutputDebugStringW(line);
 }
 
 LRESULT Monster::WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam) {
@@ -460,6 +772,15 @@ LRESULT Monster::WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
             wasHandled = true;
             break;
 
+            case WM_ENTERSIZEMOVE:
+            case WM_EXITSIZEMOVE:
+            {
+                monster->SetResizing(message == WM_ENTERSIZEMOVE);
+            }
+            result = 0;
+            wasHandled = true;
+            break;
+
             case WM_DISPLAYCHANGE:
             {
                 InvalidateRect(hwnd, nullptr, FALSE);
@@ -470,7 +791,7 @@ LRESULT Monster::WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
 
             case WM_PAINT:
             {
-                monster->OnRender();
+                monster->input_pending = true;
                 ValidateRect(hwnd, nullptr);
             }
             result = 0;
@@ -479,16 +800,63 @@ LRESULT Monster::WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
 
             case WM_DESTROY:
             {
+                // The swap chain can't outlive the window.
+                monster->StopRenderThread();
                 PostQuitMessage(0);
             }
             result = 1;
             wasHandled = true;
             break;
 
+            case WM_KEYDOWN:
+            {
+                if (wParam == 'C') {
+                    monster->ToggleCrowdMode();
+                }
+                else if (wParam == 'P') {
+                    monster->profiling = !monster->profiling;
+                }
+                else if (wParam == 'I') {
+                    monster->predict_input = !monster->predict_input;
+                }
+                else if (wParam == 'M') {
+                    monster->CycleFrameMode();
+                }
+                else if (wParam == VK_SPACE) {
+                    monster->clock.SetPaused(!monster->clock.IsPaused());
+                }
+                else if (wParam == VK_OEM_PLUS) {
+                    monster->clock.SetTimeScale(monster->clock.TimeScale() * 2.0);
+                }
+                else if (wParam == VK_OEM_MINUS) {
+                    monster->clock.SetTimeScale(monster->clock.TimeScale() * 0.5);
+                }
+                monster->input_pending = true;
+            }
+            result = 0;
+            wasHandled = true;
+            break;
+
             case WM_MOUSEMOVE:
             {
-                monster->mouse_x = GET_X_LPARAM(lParam);
-                monster->mouse_y = GET_Y_LPARAM(lParam);
+                monster->OnInput({ InputType::MouseMove, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) });
+            }
+            result = 0;
+            wasHandled = true;
+            break;
+
+            case WM_LBUTTONDOWN:
+            case WM_LBUTTONUP:
+            {
+                // Captured, so releasing the button outside the window is seen too.
+                if (message == WM_LBUTTONDOWN) {
+                    SetCapture(hwnd);
+                    monster->OnInput({ InputType::ButtonDown, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) });
+                }
+                else {
+                    ReleaseCapture();
+                    monster->OnInput({ InputType::ButtonUp, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) });
+                }
             }
             result = 0;
             wasHandled = true;
@@ -1,26 +1,155 @@
 #pragma once
 
 #include "framework.h"
+#include "AnimationClock.h"
+#include "FrameScheduler.h"
+#include "InputQueue.h"
+#include "InputTrace.h"
+#include "MonsterHitTest.h"
+#include "RenderTargetPool.h"
 #include "Timer.h"
+#include "TripleBuffer.h"
+#include "D2DRenderer.h"
 #include <d2d1_3.h>
 #include <winrt/base.h>
 #include <d3d11_4.h>
-
+#include <atomic>
+#include <thread>
+
+// Everything the render thread needs for a frame, published by the UI thread.
+struct SceneSnapshot {
+    std::uint64_t sequence = 0;
+
+    // Client area in pixels. The swap chain's buffers are sized by a TargetSizer, which
+    // only shrinks them once resizing is over.
+    UINT width = 0, height = 0;
+    bool resizing = false;
+
+    // The render thread fills in the eyeballs and the expression from its own input.
+    SceneState scene;
+    // Extrapolate the cursor to when the frame will be seen. Toggled with the I key.
+    bool predict_input = false;
+
+    bool crowd_mode = false;
+    // Only filled in in crowd mode. Monsters only move when the crowd is scattered
+    // again, which bumps crowd_generation, so a snapshot that already holds that
+    // generation only takes the animation.
+    Crowd crowd;
+    std::uint64_t crowd_generation = 0;
+    // Newest mouse move the crowd's eyes follow.
+    std::int64_t input_time = 0;
+
+    FrameMode frame_mode = FrameMode::VSync;
+    // Whether the clock is running, so on-demand frames have to keep coming.
+    bool animating = true;
+    bool profiling = false;
+
+    // Timer ticks the UI thread spent on input and simulation for this snapshot.
+    std::int64_t input_begin = 0, input_ticks = 0;
+    std::int64_t simulation_begin = 0, simulation_ticks = 0;
+};
+
+// The UI thread owns the window, input and simulation, and publishes a SceneSnapshot
+// after every simulation step and every change of state. Mouse events go to the render
+// thread separately, through an InputQueue it reads right before drawing. The render
+// thread owns every Direct3D, DXGI and Direct2D object, and draws the latest snapshot
+// whenever its FrameScheduler asks for a frame. Neither thread ever waits for the other, so a slow
+// frame doesn't hold up input and a resize storm doesn't hold up rendering.
 class Monster {
 public:
     Monster();
+    ~Monster();
 
     void InitializeWindow(HINSTANCE instance, INT cmd_show);
+
+    // Plays the animation at a fixed frame rate regardless of how long frames take, so
+    // every run shows the same frames. For comparing profiles between builds.
+    void UseDeterministicClock();
+    // Writes every simulation step's clock, window size and input to filename, for
+    // ReplayTrace to play back without a window. Returns false if it can't be created.
+    bool RecordTrace(const std::filesystem::path& filename);
     void RunMessageLoop();
 
 private:
     // Window handle.
     HWND hwnd;
 
+    TripleBuffer<SceneSnapshot> snapshots;
+    // Mouse events from the UI thread, read by the render thread right before drawing.
+    InputQueue input_queue;
+    // Signaled when a snapshot or input is published or the render thread should stop.
+    winrt::handle render_wake;
+    std::atomic<bool> render_stop = false;
+    std::thread render_thread;
+
+    Timer timer;
+
+    // UI thread state.
+
+    // Steps the simulation at a fixed rate, whatever the frame mode.
+    FrameScheduler simulation_scheduler;
+    winrt::handle simulation_timer;
+    std::uint64_t published = 0;
+    bool input_pending = false;
+    std::int64_t input_begin = 0, input_ticks = 0;
+    std::int64_t simulation_begin = 0, simulation_ticks = 0;
+
+    UINT width = 0, height = 0;
+    // Between WM_ENTERSIZEMOVE and WM_EXITSIZEMOVE.
+    bool resizing = false;
+    gfx::Matrix3x2 transformation;
+
+    // The sway is simulated in fixed steps and interpolated between the last two. Space
+    // pauses the clock; + and - double and halve its speed.
+    static constexpr double SIMULATION_STEP = 1.0 / 120.0;
+    static constexpr double DETERMINISTIC_FRAME = 1.0 / 60.0;
+    AnimationClock clock;
+    FLOAT previous_angle = 0.0f, current_angle = 0.0f;
+
+    FLOAT angle = 0.0f;
+    INT mouse_x = 0, mouse_y = 0;
+    std::int64_t mouse_time = 0;
+    bool predict_input = false;
+
+    // Filled in as input arrives and written out with each simulation step.
+    TraceWriter trace;
+    TraceFrame trace_frame;
+
+    // Crowd mode, toggled with the C key. Clicking a monster changes its expression.
+    static constexpr std::size_t CROWD_SIZE = 10000;
+    Crowd crowd;
+    // Bumped whenever the crowd is scattered again.
+    std::uint64_t crowd_generation = 0;
+    CrowdHitIndex crowd_index;
+    bool crowd_mode = false;
+
+    // Cycled with the M key.
+    FrameMode frame_mode = FrameMode::VSync;
+
+    // Frame-phase profiler, toggled with the P key. Turning it off writes the recorded
+    // frames to the working directory.
+    bool profiling = false;
+
+    void OnResize(UINT width, UINT height);
+    void SetResizing(bool resizing);
+    void ToggleCrowdMode();
+    void CycleFrameMode();
+    void Animate();
+    void OnInput(InputEvent event);
+    void PublishSnapshot();
+    bool WaitForSimulationStep();
+    void StopRenderThread();
+
+    // Render thread state.
+
     // Direct3D objects.
     winrt::com_ptr<ID3D11Device5> d3d_device;
     winrt::com_ptr<ID3D11DeviceContext4> d3d_context;
     winrt::com_ptr<IDXGISwapChain4> swap_chain;
+    UINT swap_chain_flags = 0;
+    bool tearing_supported = false;
+    // Signaled whenever the swap chain can queue another frame.
+    winrt::handle frame_latency_waitable;
 
     // Direct2D objects.
     winrt::com_ptr<ID2D1Factory7> d2d_factory;
@@ -28,62 +157,47 @@ private:
     winrt::com_ptr<ID2D1DeviceContext6> d2d_context;
     winrt::com_ptr<ID2D1Bitmap1> d2d_target_bitmap;
 
-    winrt::com_ptr<ID2D1SolidColorBrush> main_brush;
-    winrt::com_ptr<ID2D1RadialGradientBrush> main_rad_brush;
-    winrt::com_ptr<ID2D1RadialGradientBrush> left_eye_brush;
-    winrt::com_ptr<ID2D1RadialGradientBrush> right_eye_brush;
-    winrt::com_ptr<ID2D1PathGeometry> monster_path;
-    winrt::com_ptr<ID2D1PathGeometry> nose_path;
-    winrt::com_ptr<ID2D1PathGeometry> smile_path, sad_path;
-    Timer timer;
-
-    D2D1::Matrix3x2F transformation;
-    D2D1_POINT_2F center;
-
-    FLOAT angle = 0.0f;
-    INT mouse_x = 0, mouse_y = 0;
-    bool mouse_down = false;
-
-    static constexpr FLOAT EYE_X_OFFSET = 43.0f;
-    static constexpr FLOAT EYE_Y_OFFSET = -12.0f;
-    static constexpr FLOAT EYE_RADIUS = 34.0f;
-    static constexpr FLOAT EYE_BALL_RADIUS = 8.0f;
-
-    static constexpr D2D1_ELLIPSE left_eye = { { -EYE_X_OFFSET, EYE_Y_OFFSET }, EYE_RADIUS, EYE_RADIUS };
-    static constexpr D2D1_ELLIPSE right_eye = { { EYE_X_OFFSET, EYE_Y_OFFSET }, EYE_RADIUS, EYE_RADIUS };
-
-    static constexpr D2D1_COLOR_F clear_color =
-    { .r = 1.0f, .g = 1.0f, .b = 1.0f, .a = 1.0f };
-    static constexpr D2D1_COLOR_F background_color =
-    { .r = 0.8f, .g = 0.76f, .b = 0.89f, .a = 1.0f };
-    static constexpr D2D1_COLOR_F brush_color =
-    { .r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 1.0f };
-    static constexpr D2D1_COLOR_F nose_color =
-    { .r = 0.4f, .g = 0.4f, .b = 0.4f, .a = 1.0f };
-
-    static constexpr D2D1_GRADIENT_STOP rad_stops_data[] = {
-        {.position = 0.0f, .color = {.r = 0.0f, .g = 1.0f, .b = 0.0f, .a = 1.0f } },
-        {.position = 0.6f, .color = {.r = 0.0f, .g = 0.7f, .b = 0.0f, .a = 1.0f } },
-        {.position = 1.0f, .color = {.r = 0.0f, .g = 0.3f, .b = 0.0f, .a = 1.0f } }
-    };
-    static constexpr D2D1_GRADIENT_STOP eye_stops_data[] = {
-        {.position = 0.9f, .color = {.r = 1.0f, .g = 1.0f, .b = 1.0f, .a = 1.0f } },
-        {.position = 1.0f, .color = {.r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 1.0f } },
-    };
+    D2DRenderer d2d_renderer;
+
+    FrameProfiler profiler{ timer };
+    // Process CPU time, counter ticks and target allocations when profiling started, for
+    // the summary.
+    std::int64_t profile_cpu_start = 0, profile_ticks_start = 0;
+    std::uint64_t profile_allocations_start = 0;
+
+    // Frame pacing, from the latest snapshot's mode.
+    FrameScheduler scheduler;
+    winrt::handle frame_timer;
+    // The part of the swap chain's buffers that is shown, which can be smaller than them.
+    UINT target_width = 0, target_height = 0;
+    bool target_resizing = false;
+    TargetSizer target_sizer;
+    // Times the swap chain's buffers were created or resized.
+    std::uint64_t target_allocations = 0;
+
+    InputState input{ timer.get_frequency() };
+    // Inverse of the latest snapshot's transformation, so the eyes don't invert it every frame.
+    gfx::Matrix3x2 inverse_transformation;
+    // Newest input shown so far, so each input counts towards the latency of one frame.
+    std::int64_t shown_input_time = 0;
+    // From reading input to Present returning, in the last frame.
+    std::int64_t render_latency = 0;
+    // The mouth eases towards a smile while the button is held, and back when released.
+    float smile = 0.0f;
+    std::int64_t smile_time = 0;
 
     void CreateDeviceDependentResources();
     void CreateDeviceIndependentResources();
     void CreateWindowSizeDependentResources();
+    void UpdateTargetSize();
     void HandleDeviceLost();
 
-    void OnRender();
-    void OnResize(UINT width, UINT height);
-
-    winrt::com_ptr<ID2D1PathGeometry> CreateMonster();
-    winrt::com_ptr<ID2D1PathGeometry> CreateNose();
-    winrt::com_ptr<ID2D1PathGeometry> CreateSmile();
-    winrt::com_ptr<ID2D1PathGeometry> CreateSad();
-    D2D1_ELLIPSE CreateBall(bool left_eye);
+    void RenderLoop();
+    bool WaitForFrame();
+    void TakeSnapshot();
+    void OnRender(const SceneSnapshot& snapshot);
+    void SetProfiling(bool profiling);
+    void ReportFrameStatistics();
 
     static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
-};
\ No newline at end of file
+};
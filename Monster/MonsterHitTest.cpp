@@ -0,0 +1,229 @@
+#include "MonsterHitTest.h"
+#include "Stroke.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+gfx::Rect Union(const gfx::Rect& a, const gfx::Rect& b) {
+    return {
+        std::min(a.left, b.left), std::min(a.top, b.top),
+        std::max(a.right, b.right), std::max(a.bottom, b.bottom)
+    };
+}
+
+bool Contains(const gfx::Rect& rect, gfx::Point p) {
+    return p.x >= rect.left && p.x < rect.right && p.y >= rect.top && p.y < rect.bottom;
+}
+
+bool Contains(const gfx::Ellipse& circle, gfx::Point p) {
+    auto x = p.x - circle.center.x, y = p.y - circle.center.y;
+    return x * x + y * y <= circle.radius_x * circle.radius_x;
+}
+
+gfx::Rect EllipseBounds(const gfx::Ellipse& ellipse) {
+    return {
+        ellipse.center.x - ellipse.radius_x, ellipse.center.y - ellipse.radius_y,
+        ellipse.center.x + ellipse.radius_x, ellipse.center.y + ellipse.radius_y
+    };
+}
+
+// The shape flattened at compile time, within MonsterHitTester::TOLERANCE.
+template <const auto& shape>
+constexpr auto flattened_shape = gfx::BakeFlattened<shape, MonsterHitTester::TOLERANCE>();
+
+// Builds fill from the path's filled figures and outline from its stroke.
+void BuildTesters(gfx::FlatPathView flattened, const gfx::StrokeStyle& style,
+    gfx::PathHitTester* fill, gfx::PathHitTester& outline) {
+    gfx::FlattenedPath stroked;
+    gfx::StrokePath(flattened, style, MonsterHitTester::TOLERANCE, stroked);
+
+    if (fill) {
+        fill->Build(flattened);
+    }
+    outline.Build(stroked);
+}
+
+}
+
+MonsterHitTester::MonsterHitTester() {
+    gfx::StrokeStyle mouth_style = { .width = MonsterScene::MOUTH_STROKE_WIDTH };
+
+    BuildTesters(flattened_shape<MonsterScene::monster_shape>.View(), {}, &body, body_outline);
+    BuildTesters(flattened_shape<MonsterScene::nose_shape>.View(), {}, &nose, nose_outline);
+    BuildTesters(flattened_shape<MonsterScene::smile_shape>.View(), mouth_style, nullptr, smile_outline);
+    BuildTesters(flattened_shape<MonsterScene::sad_shape>.View(), mouth_style, nullptr, sad_outline);
+
+    // The nose and mouth turn around the origin, so they can reach as far as their
+    // farthest corner does in any direction.
+    auto turning = Union(Union(nose_outline.Bounds(), smile_outline.Bounds()), sad_outline.Bounds());
+    auto reach = 0.0f;
+    for (auto x : { turning.left, turning.right }) {
+        for (auto y : { turning.top, turning.bottom }) {
+            reach = std::max(reach, std::hypot(x, y));
+        }
+    }
+
+    turning_reach = reach;
+    bounds = Union(body_outline.Bounds(), { -reach, -reach, reach, reach });
+    bounds = Union(bounds, Union(EllipseBounds(MonsterScene::left_eye), EllipseBounds(MonsterScene::right_eye)));
+}
+
+MonsterPart MonsterHitTester::HitTest(gfx::Point p, float angle, float smile) const {
+    if (!Contains(bounds, p)) {
+        return MonsterPart::None;
+    }
+
+    // Most points are too far out for the nose and mouth, and skip turning them back.
+    if (p.x * p.x + p.y * p.y <= turning_reach * turning_reach) {
+        auto turned = gfx::Matrix3x2::Rotation(-angle).TransformPoint(p);
+        if ((smile >= 0.5f ? smile_outline : sad_outline).Contains(turned)) {
+            return MonsterPart::Mouth;
+        }
+        if (nose.Contains(turned) || nose_outline.Contains(turned)) {
+            return MonsterPart::Nose;
+        }
+    }
+    if (Contains(MonsterScene::left_eye, p) || Contains(MonsterScene::right_eye, p)) {
+        return MonsterPart::Eye;
+    }
+    if (body.Contains(p) || body_outline.Contains(p)) {
+        return MonsterPart::Body;
+    }
+    return MonsterPart::None;
+}
+
+MonsterPart MonsterHitTester::HitTest(const SceneState& scene, gfx::Point p) const {
+    auto local = MonsterScene::InverseTransformation(scene.transformation).TransformPoint(p);
+    return HitTest(local, scene.angle, scene.smile);
+}
+
+void CrowdHitIndex::Build(const Crowd& crowd) {
+    auto count = crowd.Size();
+    columns = rows = 0;
+    cell_start.clear();
+    entries.clear();
+    instance_bounds.clear();
+    instance_cells.clear();
+    if (count == 0) {
+        return;
+    }
+
+    auto& bounds = instance_bounds;
+    bounds.resize(count);
+    auto extent = 0.0f;
+    for (std::size_t i = 0; i < count; i++) {
+        bounds[i] = InstanceBounds(crowd, i);
+        extent += std::max(bounds[i].right - bounds[i].left, bounds[i].bottom - bounds[i].top);
+    }
+    auto total = bounds[0];
+    for (const auto& rect : bounds) {
+        total = Union(total, rect);
+    }
+
+    // Cells about as big as a monster, as long as there aren't too many of them.
+    auto width = total.right - total.left, height = total.bottom - total.top;
+    auto cell_size = std::max({ extent / count, std::max(width, height) / (MAX_CELLS_PER_SIDE - 1), 1e-3f });
+    origin = { total.left, total.top };
+    cell_scale = 1.0f / cell_size;
+    columns = (int)(width * cell_scale) + 1;
+    rows = (int)(height * cell_scale) + 1;
+
+    // Counted, then placed in instance order, so every cell lists monsters bottom to top.
+    instance_cells.resize(count);
+    cell_start.assign((std::size_t)columns * rows + 1, 0);
+    for (std::size_t i = 0; i < count; i++) {
+        auto cells = instance_cells[i] = CellRange(bounds[i]);
+        for (auto y = cells.top; y <= cells.bottom; y++) {
+            for (auto x = cells.left; x <= cells.right; x++) {
+                cell_start[(std::size_t)y * columns + x + 1]++;
+            }
+        }
+    }
+    for (std::size_t c = 1; c < cell_start.size(); c++) {
+        cell_start[c] += cell_start[c - 1];
+    }
+
+    entries.resize(cell_start.back());
+    std::vector<std::uint32_t> next(cell_start.begin(), cell_start.end() - 1);
+    for (std::size_t i = 0; i < count; i++) {
+        auto cells = instance_cells[i];
+        for (auto y = cells.top; y <= cells.bottom; y++) {
+            for (auto x = cells.left; x <= cells.right; x++) {
+                entries[next[(std::size_t)y * columns + x]++] = { bounds[i], (std::uint32_t)i };
+            }
+        }
+    }
+}
+
+bool CrowdHitIndex::Update(const Crowd& crowd) {
+    auto count = crowd.Size();
+    if (count != instance_cells.size()) {
+        Build(crowd);
+        return true;
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        instance_bounds[i] = InstanceBounds(crowd, i);
+        auto cells = CellRange(instance_bounds[i]);
+        const auto& old_cells = instance_cells[i];
+        if (cells.left != old_cells.left || cells.top != old_cells.top ||
+            cells.right != old_cells.right || cells.bottom != old_cells.bottom) {
+            Build(crowd);
+            return true;
+        }
+    }
+
+    for (auto& entry : entries) {
+        entry.bounds = instance_bounds[entry.instance];
+    }
+    return false;
+}
+
+CrowdHit CrowdHitIndex::HitTest(const Crowd& crowd, gfx::Point p) const {
+    auto x = (int)std::floor((p.x - origin.x) * cell_scale);
+    auto y = (int)std::floor((p.y - origin.y) * cell_scale);
+    if (x < 0 || x >= columns || y < 0 || y >= rows) {
+        return {};
+    }
+
+    auto cell = (std::size_t)y * columns + x;
+    for (auto i = cell_start[cell + 1]; i > cell_start[cell]; i--) {
+        const auto& entry = entries[i - 1];
+        if (Contains(entry.bounds, p)) {
+            auto part = HitInstance(crowd, entry.instance, p);
+            if (part != MonsterPart::None) {
+                return { entry.instance, part };
+            }
+        }
+    }
+    return {};
+}
+
+void CrowdHitIndex::HitTest(const Crowd& crowd, std::span<const gfx::Point> points, std::span<CrowdHit> hits) const {
+    auto count = std::min(points.size(), hits.size());
+    for (std::size_t i = 0; i < count; i++) {
+        hits[i] = HitTest(crowd, points[i]);
+    }
+}
+
+gfx::Rect CrowdHitIndex::InstanceBounds(const Crowd& crowd, std::size_t i) const {
+    const auto& local = tester.Bounds();
+    auto s = MonsterScene::SCALE * crowd.scale[i];
+    auto x = crowd.position_x[i], y = crowd.position_y[i];
+    return { x + local.left * s, y + local.top * s, x + local.right * s, y + local.bottom * s };
+}
+
+gfx::IntRect CrowdHitIndex::CellRange(const gfx::Rect& rect) const {
+    return {
+        (int)std::floor((rect.left - origin.x) * cell_scale), (int)std::floor((rect.top - origin.y) * cell_scale),
+        (int)std::floor((rect.right - origin.x) * cell_scale), (int)std::floor((rect.bottom - origin.y) * cell_scale)
+    };
+}
+
+MonsterPart CrowdHitIndex::HitInstance(const Crowd& crowd, std::uint32_t i, gfx::Point p) const {
+    // The inverse of a scale and translation, written out, as in Crowd::Update.
+    auto inverse_scale = 1.0f / (MonsterScene::SCALE * crowd.scale[i]);
+    gfx::Point local = { (p.x - crowd.position_x[i]) * inverse_scale, (p.y - crowd.position_y[i]) * inverse_scale };
+    return tester.HitTest(local, crowd.angle[i], crowd.expression[i] == Expression::Smile ? 1.0f : 0.0f);
+}
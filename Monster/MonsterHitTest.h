@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Crowd.h"
+#include "HitTest.h"
+#include "MonsterScene.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+enum class MonsterPart : std::uint8_t { None, Body, Eye, Nose, Mouth };
+
+// Finds the part of the monster under a point, topmost first: mouth, nose, eye, body.
+// Strokes count as part of what they outline. Every shape is flattened once, in the
+// monster's local space, and shared by every monster that is tested.
+class MonsterHitTester {
+public:
+    // In units of the monster's local space, a fraction of a pixel at MonsterScene::SCALE.
+    static constexpr float TOLERANCE = 0.05f;
+
+    MonsterHitTester();
+
+    // p is in the monster's local space. The nose and mouth are turned by angle, and
+    // the mouth is whichever expression smile is closer to.
+    MonsterPart HitTest(gfx::Point p, float angle, float smile) const;
+
+    // p is in the scene's target units.
+    MonsterPart HitTest(const SceneState& scene, gfx::Point p) const;
+
+    // Local bounds of everything that can be hit.
+    const gfx::Rect& Bounds() const { return bounds; }
+
+private:
+    gfx::PathHitTester body, body_outline;
+    gfx::PathHitTester nose, nose_outline;
+    gfx::PathHitTester smile_outline, sad_outline;
+    // Farthest the nose and mouth reach from the origin they turn around.
+    float turning_reach = 0.0f;
+    gfx::Rect bounds;
+};
+
+struct CrowdHit {
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+    std::uint32_t instance = NONE;
+    MonsterPart part = MonsterPart::None;
+};
+
+// Finds which monster of a crowd is under a point, and which part of it.
+//
+// A uniform grid over the crowd's bounds, about one monster wide per cell, lists every
+// monster whose bounds overlap each cell in drawing order. A query reads the list of
+// one cell from the top down and runs MonsterHitTester on monsters whose bounds contain
+// the point, until one of them is hit. Monsters of a crowd are all about the same size,
+// which is what a grid is good at; a BVH would only add levels to walk.
+class CrowdHitIndex {
+public:
+    void Build(const Crowd& crowd);
+
+    // After monsters moved or were rescaled. Monsters that stay in the cells they were
+    // in only have their bounds refreshed; the grid is rebuilt if any of them left, or
+    // the crowd changed size. Returns whether it was rebuilt.
+    bool Update(const Crowd& crowd);
+
+    // crowd has to be the one the index was built or last updated for.
+    CrowdHit HitTest(const Crowd& crowd, gfx::Point p) const;
+    void HitTest(const Crowd& crowd, std::span<const gfx::Point> points, std::span<CrowdHit> hits) const;
+
+private:
+    static constexpr int MAX_CELLS_PER_SIDE = 1024;
+
+    struct Entry {
+        gfx::Rect bounds;
+        std::uint32_t instance;
+    };
+
+    MonsterHitTester tester;
+
+    gfx::Point origin;
+    float cell_scale = 0.0f;
+    int columns = 0, rows = 0;
+    // Cell c lists entries[cell_start[c]] to entries[cell_start[c + 1]], by instance.
+    std::vector<std::uint32_t> cell_start;
+    std::vector<Entry> entries;
+    // Bounds of each monster, and the cells it was entered into, inclusive.
+    std::vector<gfx::Rect> instance_bounds;
+    std::vector<gfx::IntRect> instance_cells;
+
+    gfx::Rect InstanceBounds(const Crowd& crowd, std::size_t i) const;
+    gfx::IntRect CellRange(const gfx::Rect& rect) const;
+    MonsterPart HitInstance(const Crowd& crowd, std::uint32_t i, gfx::Point p) const;
+};
@@ -0,0 +1,118 @@
+#include "MonsterScene.h"
+#include "EyeTracking.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+void MonsterScene::CreateMonster(gfx::PathSink& sink) {
+    monster_shape.Replay(sink);
+}
+
+void MonsterScene::CreateNose(gfx::PathSink& sink) {
+    nose_shape.Replay(sink);
+}
+
+void MonsterScene::CreateSmile(gfx::PathSink& sink) {
+    smile_shape.Replay(sink);
+}
+
+void MonsterScene::CreateSad(gfx::PathSink& sink) {
+    sad_shape.Replay(sink);
+}
+
+float MonsterScene::StepExpression(float smile, bool smiling, double seconds) {
+    auto step = (float)(std::max(seconds, 0.0) / EXPRESSION_SECONDS);
+    return smiling ? std::min(smile + step, 1.0f) : std::max(smile - step, 0.0f);
+}
+
+float MonsterScene::SwayAngle(double time) {
+    return (float)std::sin(time * std::numbers::pi) * 10.0f;
+}
+
+gfx::Matrix3x2 MonsterScene::DefaultTransformation(float width, float height) {
+    using gfx::Matrix3x2;
+
+    return Matrix3x2::Scale(SCALE, SCALE) * Matrix3x2::Translation(width / 2.0f, height / 2.0f);
+}
+
+gfx::Ellipse MonsterScene::CreateBall(const gfx::Matrix3x2& transformation, gfx::Point mouse, bool left_eye) {
+    gfx::Matrix3x2 transformationCopy = transformation;
+    if (transformationCopy.IsInvertible()) {
+        transformationCopy.Invert();
+    }
+
+    auto mousePosTransformed = transformationCopy.TransformPoint(mouse);
+
+    auto eye_x = left_eye ? -EYE_X_OFFSET : EYE_X_OFFSET;
+    auto eye_y = EYE_Y_OFFSET;
+    auto dist_x = mousePosTransformed.x - eye_x, dist_y = mousePosTransformed.y - eye_y;
+
+    auto dist_squared = dist_x * dist_x + dist_y * dist_y;
+
+    auto ball_orbit = EYE_RADIUS - EYE_BALL_RADIUS;
+
+    gfx::Point ball_pos;
+    if (dist_squared <= ball_orbit * ball_orbit) {
+        ball_pos = mousePosTransformed;
+    }
+    else {
+        auto fac = ball_orbit / std::sqrt(dist_squared);
+        ball_pos = { eye_x + dist_x * fac, eye_y + dist_y * fac };
+    }
+
+    return { ball_pos, EYE_BALL_RADIUS, EYE_BALL_RADIUS };
+}
+
+gfx::Matrix3x2 MonsterScene::InverseTransformation(const gfx::Matrix3x2& transformation) {
+    gfx::Matrix3x2 inverse = transformation;
+    if (inverse.IsInvertible()) {
+        inverse.Invert();
+    }
+    return inverse;
+}
+
+void MonsterScene::CreateBalls(const gfx::Matrix3x2& inverse_transformation, gfx::Point mouse,
+    gfx::Ellipse& left_ball, gfx::Ellipse& right_ball) {
+    auto local_mouse = inverse_transformation.TransformPoint(mouse);
+    auto orbit = EYE_RADIUS - EYE_BALL_RADIUS;
+
+    left_ball = { gfx::TrackEye(left_eye.center, orbit, local_mouse), EYE_BALL_RADIUS, EYE_BALL_RADIUS };
+    right_ball = { gfx::TrackEye(right_eye.center, orbit, local_mouse), EYE_BALL_RADIUS, EYE_BALL_RADIUS };
+}
+
+std::array<gfx::Rect, 3> MonsterScene::DynamicBounds(const SceneState& scene) {
+    // Nose, smile and sad mouth together, so the expression can change too. Blends stay
+    // inside the control bounds of the two. Padded by half the widest stroke.
+    constexpr auto mouth_bounds = [] {
+        gfx::Rect bounds = nose_shape.control_bounds;
+        for (const auto& shape : { smile_shape.control_bounds, sad_shape.control_bounds }) {
+            bounds = { std::min(bounds.left, shape.left), std::min(bounds.top, shape.top),
+                std::max(bounds.right, shape.right), std::max(bounds.bottom, shape.bottom) };
+        }
+        auto pad = MOUTH_STROKE_WIDTH * 0.5f;
+        return gfx::Rect{ bounds.left - pad, bounds.top - pad, bounds.right + pad, bounds.bottom + pad };
+    }();
+
+    auto ball_bounds = [&](const gfx::Ellipse& ball) {
+        gfx::Rect bounds = {
+            ball.center.x - ball.radius_x, ball.center.y - ball.radius_y,
+            ball.center.x + ball.radius_x, ball.center.y + ball.radius_y
+        };
+        return gfx::TransformBounds(bounds, scene.transformation);
+    };
+
+    return {
+        ball_bounds(scene.left_ball),
+        ball_bounds(scene.right_ball),
+        gfx::TransformBounds(mouth_bounds, scene.MouthTransformation())
+    };
+}
+
+SceneState MonsterScene::CreateScene(const gfx::Matrix3x2& transformation, float angle, gfx::Point mouse, bool mouse_down) {
+    SceneState scene;
+    scene.transformation = transformation;
+    scene.angle = angle;
+    CreateBalls(InverseTransformation(transformation), mouse, scene.left_ball, scene.right_ball);
+    scene.smile = mouse_down ? 1.0f : 0.0f;
+    return scene;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Geometry.h"
+#include "Paint.h"
+#include "StaticPath.h"
+#include <array>
+#include <string_view>
+
+// Everything a backend needs to draw one frame of the monster.
+struct SceneState {
+    gfx::Matrix3x2 transformation;
+    float angle = 0.0f;
+    gfx::Ellipse left_ball, right_ball;
+    // The mouth goes from sad at 0 to smiling at 1, blending the two in between.
+    float smile = 0.0f;
+
+    // Nose and mouth rotate around the monster's origin.
+    gfx::Matrix3x2 MouthTransformation() const {
+        return gfx::Matrix3x2::Rotation(angle) * transformation;
+    }
+};
+
+// Shape and style data of the monster, shared by all render backends.
+class MonsterScene {
+public:
+    static constexpr float EYE_X_OFFSET = 43.0f;
+    static constexpr float EYE_Y_OFFSET = -12.0f;
+    static constexpr float EYE_RADIUS = 34.0f;
+    static constexpr float EYE_BALL_RADIUS = 8.0f;
+    static constexpr float BODY_GRADIENT_RADIUS = 150.0f;
+    static constexpr float SCALE = 3.0f;
+    static constexpr float MOUTH_STROKE_WIDTH = 3.0f;
+    // Seconds the mouth takes to go from sad to smiling, or back.
+    static constexpr double EXPRESSION_SECONDS = 0.15;
+
+    static constexpr gfx::Ellipse left_eye = { { -EYE_X_OFFSET, EYE_Y_OFFSET }, EYE_RADIUS, EYE_RADIUS };
+    static constexpr gfx::Ellipse right_eye = { { EYE_X_OFFSET, EYE_Y_OFFSET }, EYE_RADIUS, EYE_RADIUS };
+
+    static constexpr gfx::Color clear_color =
+    { .r = 1.0f, .g = 1.0f, .b = 1.0f, .a = 1.0f };
+    static constexpr gfx::Color background_color =
+    { .r = 0.8f, .g = 0.76f, .b = 0.89f, .a = 1.0f };
+    static constexpr gfx::Color brush_color =
+    { .r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 1.0f };
+    static constexpr gfx::Color nose_color =
+    { .r = 0.4f, .g = 0.4f, .b = 0.4f, .a = 1.0f };
+
+    static constexpr gfx::GradientStop rad_stops_data[] = {
+        {.position = 0.0f, .color = {.r = 0.0f, .g = 1.0f, .b = 0.0f, .a = 1.0f } },
+        {.position = 0.6f, .color = {.r = 0.0f, .g = 0.7f, .b = 0.0f, .a = 1.0f } },
+        {.position = 1.0f, .color = {.r = 0.0f, .g = 0.3f, .b = 0.0f, .a = 1.0f } }
+    };
+    static constexpr gfx::GradientStop eye_stops_data[] = {
+        {.position = 0.9f, .color = {.r = 1.0f, .g = 1.0f, .b = 1.0f, .a = 1.0f } },
+        {.position = 1.0f, .color = {.r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 1.0f } },
+    };
+
+    // Shapes in SVG path syntax, in the monster's local space.
+    static constexpr std::string_view monster_path_data =
+        "M-2 -74.5"
+        " C7.7 -74.5 14.5 -74.4 23.1 -71.9"
+        " C30.2 -69.8 37.5 -67.6 40.1 -62.4"
+        " C40.4 -61.7 41.2 -59.8 42.3 -59.8"
+        " C43.9 -59.8 44.9 -63.6 45.6 -65.4"
+        " C48.6 -73.1 60.3 -79.3 71.1 -78.8"
+        " C72 -78.8 85.9 -77.8 92 -67.3"
+        " C99.2 -54.9 90.5 -37.9 83.2 -30.1"
+        " C79 -25.6 69.8 -18 69.8 -18"
+        " C71.9 -7.4 74.7 2.9 78.2 13"
+        " C84.3 30.5 88.2 35.3 91.3 49.6"
+        " C94 61.8 96.2 71.7 92.3 83.2"
+        " C87.5 97.7 76.5 105.6 72.4 108.4"
+        " C62.1 115.6 52.4 117.1 37.4 119.5"
+        " C26.8 121.2 16.3 121.3 4.1 121.5"
+        " C0.3 121.6 -4 121.6 -8.9 121.5"
+        " C-21.2 121.3 -31.7 121.2 -42.3 119.5"
+        " C-56.1 117.4 -66.5 115.9 -77.3 108.4"
+        " C-81.3 105.6 -92.4 97.7 -97.2 83.2"
+        " C-101 71.7 -98.9 61.8 -96.2 49.6"
+        " C-93.6 37.5 -89.4 27.8 -83.1 13"
+        " C-77.3 -0.7 -70.4 -14.5 -74.6 -18"
+        " C-74.6 -18 -74.6 -18 -74.6 -18"
+        " C-80.2 -22.6 -86.6 -28.7 -88 -30.1"
+        " C-92.9 -35 -104.8 -53.6 -96.8 -67.3"
+        " C-90.7 -77.8 -76.8 -78.7 -75.9 -78.8"
+        " C-65.1 -79.3 -53.4 -73.1 -50.4 -65.4"
+        " C-49.8 -63.6 -48.8 -59.8 -47.2 -59.8"
+        " C-46 -59.8 -45.2 -61.7 -44.9 -62.4"
+        " C-42.4 -67.6 -35 -69.8 -27.9 -71.9"
+        " C-19 -74.5 -12 -74.5 -2 -74.55"
+        " Z";
+
+    static constexpr std::string_view nose_path_data =
+        "M0 38.3"
+        " C1.8 40.9 16.2 25.1 14.6 23"
+        " C15.3 18.9 -16.4 19.2 -16.3 22.3"
+        " C-16.7 26.2 -0.7 40.9 0 38.33"
+        " Z";
+
+    static constexpr std::string_view smile_path_data =
+        "M-40 75"
+        " A10 7 0 0 0 40 75";
+
+    static constexpr std::string_view sad_path_data =
+        "M-40 75"
+        " A8 3 0 0 1 40 75";
+
+    // The path data above, parsed at compile time along with its bounds. Create* replay
+    // these instead of parsing, and paths can be filled straight from them with
+    // StaticPath::CopyTo.
+    static constexpr auto monster_shape = gfx::BakeSvgPath<monster_path_data, gfx::FigureBegin::Filled>();
+    static constexpr auto nose_shape = gfx::BakeSvgPath<nose_path_data, gfx::FigureBegin::Filled>();
+    static constexpr auto smile_shape = gfx::BakeSvgPath<smile_path_data, gfx::FigureBegin::Hollow>();
+    static constexpr auto sad_shape = gfx::BakeSvgPath<sad_path_data, gfx::FigureBegin::Hollow>();
+
+    static void CreateMonster(gfx::PathSink& sink);
+    static void CreateNose(gfx::PathSink& sink);
+    static void CreateSmile(gfx::PathSink& sink);
+    static void CreateSad(gfx::PathSink& sink);
+
+    // Moves smile towards 1 while smiling and towards 0 otherwise, for seconds of time.
+    static float StepExpression(float smile, bool smiling, double seconds);
+
+    // Tilt in degrees of a monster swaying from side to side, every two seconds of
+    // animation time.
+    static float SwayAngle(double time);
+
+    // Centers the monster in a render target of the given size.
+    static gfx::Matrix3x2 DefaultTransformation(float width, float height);
+
+    // Eyeball that follows the mouse but stays inside its eye socket.
+    static gfx::Ellipse CreateBall(const gfx::Matrix3x2& transformation, gfx::Point mouse, bool left_eye);
+
+    // What CreateBall maps the mouse with. Callers that keep the transformation around
+    // compute this once whenever it changes and pass it to CreateBalls.
+    static gfx::Matrix3x2 InverseTransformation(const gfx::Matrix3x2& transformation);
+
+    // Both eyeballs at once, without inverting the transformation again.
+    static void CreateBalls(const gfx::Matrix3x2& inverse_transformation, gfx::Point mouse,
+        gfx::Ellipse& left_ball, gfx::Ellipse& right_ball);
+
+    // Bounds of the parts that move between frames with the same transformation: both
+    // eyeballs, and the nose and mouth at any expression. In render target units,
+    // strokes included.
+    static std::array<gfx::Rect, 3> DynamicBounds(const SceneState& scene);
+
+    static SceneState CreateScene(const gfx::Matrix3x2& transformation, float angle, gfx::Point mouse, bool mouse_down);
+};
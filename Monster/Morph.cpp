@@ -0,0 +1,266 @@
+#include "Morph.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+static_assert(sizeof(Point) == 2 * sizeof(float), "Points are blended as arrays of floats");
+
+struct Cubic {
+    Point p0, p1, p2, p3;
+};
+
+struct CubicFigure {
+    std::vector<Cubic> segments;
+    bool filled = true;
+    bool closed = false;
+};
+
+Point Lerp(Point a, Point b, float t) {
+    return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t };
+}
+
+float Distance(Point a, Point b) {
+    return std::hypot(b.x - a.x, b.y - a.y);
+}
+
+// Somewhere between the chord and the control polygon, which bound the arc length.
+float ApproximateLength(const Cubic& cubic) {
+    auto chord = Distance(cubic.p0, cubic.p3);
+    auto polygon = Distance(cubic.p0, cubic.p1) + Distance(cubic.p1, cubic.p2) + Distance(cubic.p2, cubic.p3);
+    return (chord + polygon) * 0.5f;
+}
+
+Cubic LineCubic(Point a, Point b) {
+    return { a, Lerp(a, b, 1.0f / 3.0f), Lerp(a, b, 2.0f / 3.0f), b };
+}
+
+std::vector<CubicFigure> ToCubics(const Path& path) {
+    const auto& points = path.Points();
+    const auto& verbs = path.Verbs();
+
+    std::vector<CubicFigure> figures;
+    for (const auto& figure : path.Figures()) {
+        CubicFigure cubic_figure;
+        cubic_figure.filled = figure.filled;
+        cubic_figure.closed = figure.closed;
+
+        auto index = figure.first_point;
+        auto start = points[index++];
+        auto current = start;
+        for (auto v = figure.first_verb; v < figure.first_verb + figure.verb_count; v++) {
+            if (verbs[v] == PathVerb::Line) {
+                cubic_figure.segments.push_back(LineCubic(current, points[index]));
+                index++;
+            }
+            else {
+                cubic_figure.segments.push_back({ current, points[index], points[index + 1], points[index + 2] });
+                index += 3;
+            }
+            current = cubic_figure.segments.back().p3;
+        }
+
+        // The closing segment is made explicit, so it can bend like the others.
+        if (figure.closed && (current.x != start.x || current.y != start.y)) {
+            cubic_figure.segments.push_back(LineCubic(current, start));
+        }
+        figures.push_back(std::move(cubic_figure));
+    }
+    return figures;
+}
+
+// Halves the longest segment until there are count of them.
+void SplitTo(std::vector<Cubic>& segments, std::size_t count) {
+    while (segments.size() < count) {
+        auto longest = std::max_element(segments.begin(), segments.end(), [](const Cubic& a, const Cubic& b) {
+            return ApproximateLength(a) < ApproximateLength(b);
+        });
+
+        // De Casteljau at t = 0.5.
+        auto c = *longest;
+        auto p01 = Lerp(c.p0, c.p1, 0.5f), p12 = Lerp(c.p1, c.p2, 0.5f), p23 = Lerp(c.p2, c.p3, 0.5f);
+        auto p012 = Lerp(p01, p12, 0.5f), p123 = Lerp(p12, p23, 0.5f);
+        auto middle = Lerp(p012, p123, 0.5f);
+
+        *longest = { c.p0, p01, p012, middle };
+        segments.insert(longest + 1, { middle, p123, p23, c.p3 });
+    }
+}
+
+void AppendCoordinates(const std::vector<CubicFigure>& figures, std::vector<float>& output) {
+    for (const auto& figure : figures) {
+        output.push_back(figure.segments.front().p0.x);
+        output.push_back(figure.segments.front().p0.y);
+        for (const auto& segment : figure.segments) {
+            for (auto p : { segment.p1, segment.p2, segment.p3 }) {
+                output.push_back(p.x);
+                output.push_back(p.y);
+            }
+        }
+    }
+}
+
+struct BlendSpan {
+    const float* base;
+    // Each target's offsets start stride floats after the previous target's.
+    const float* offsets;
+    std::size_t stride;
+    const float* weights;
+    std::size_t target_count;
+    float* output;
+    std::size_t length;
+};
+
+// Multiplies and adds in the same order as BlendSse2, which gives the same result.
+// BlendAvx2 fuses them, so its results can differ in the last bit.
+void BlendScalar(const BlendSpan& span, std::size_t begin) {
+    for (auto i = begin; i < span.length; i++) {
+        auto value = span.base[i];
+        for (std::size_t t = 0; t < span.target_count; t++) {
+            value += span.weights[t] * span.offsets[t * span.stride + i];
+        }
+        span.output[i] = value;
+    }
+}
+
+#if GFX_SIMD_X86
+
+void BlendSse2(const BlendSpan& span) {
+    std::size_t i = 0;
+    for (; i + 4 <= span.length; i += 4) {
+        auto value = _mm_loadu_ps(span.base + i);
+        for (std::size_t t = 0; t < span.target_count; t++) {
+            auto offset = _mm_loadu_ps(span.offsets + t * span.stride + i);
+            value = _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(span.weights[t]), offset));
+        }
+        _mm_storeu_ps(span.output + i, value);
+    }
+
+    BlendScalar(span, i);
+}
+
+GFX_TARGET_AVX2
+void BlendAvx2(const BlendSpan& span) {
+    std::size_t i = 0;
+    for (; i + 8 <= span.length; i += 8) {
+        auto value = _mm256_loadu_ps(span.base + i);
+        for (std::size_t t = 0; t < span.target_count; t++) {
+            auto offset = _mm256_loadu_ps(span.offsets + t * span.stride + i);
+            value = _mm256_fmadd_ps(_mm256_set1_ps(span.weights[t]), offset, value);
+        }
+        _mm256_storeu_ps(span.output + i, value);
+    }
+
+    // The scalar tail would pay for the dirty upper halves on every instruction.
+    _mm256_zeroupper();
+    BlendScalar(span, i);
+}
+
+#endif
+
+}
+
+bool PathMorph::Build(std::span<const Path* const> paths) {
+    shape.Clear();
+    base.clear();
+    offsets.clear();
+    target_count = 0;
+
+    if (paths.empty()) {
+        return false;
+    }
+
+    std::vector<std::vector<CubicFigure>> converted;
+    for (const auto* path : paths) {
+        converted.push_back(ToCubics(*path));
+    }
+
+    auto& reference = converted[0];
+    for (const auto& figures : converted) {
+        if (figures.size() != reference.size()) {
+            return false;
+        }
+        for (std::size_t f = 0; f < figures.size(); f++) {
+            if (figures[f].closed != reference[f].closed || figures[f].segments.empty()) {
+                return false;
+            }
+        }
+    }
+
+    for (std::size_t f = 0; f < reference.size(); f++) {
+        std::size_t count = 0;
+        for (const auto& figures : converted) {
+            count = std::max(count, figures[f].segments.size());
+        }
+        for (auto& figures : converted) {
+            SplitTo(figures[f].segments, count);
+        }
+    }
+
+    for (const auto& figure : reference) {
+        shape.BeginFigure(figure.segments.front().p0, figure.filled ? FigureBegin::Filled : FigureBegin::Hollow);
+        for (const auto& segment : figure.segments) {
+            shape.AddBezier(segment.p1, segment.p2, segment.p3);
+        }
+        shape.EndFigure(figure.closed ? FigureEnd::Closed : FigureEnd::Open);
+    }
+
+    AppendCoordinates(reference, base);
+    for (std::size_t p = 1; p < converted.size(); p++) {
+        auto first = offsets.size();
+        AppendCoordinates(converted[p], offsets);
+        for (std::size_t i = 0; i < base.size(); i++) {
+            offsets[first + i] -= base[i];
+        }
+    }
+    target_count = converted.size() - 1;
+    return true;
+}
+
+void PathMorph::Evaluate(std::span<const float> weights, std::span<Point> output) const {
+    Evaluate(weights, output, DetectSimdLevel());
+}
+
+void PathMorph::Evaluate(std::span<const float> weights, std::span<Point> output, SimdLevel level) const {
+    BlendSpan span = {
+        base.data(), offsets.data(), base.size(), weights.data(), std::min(weights.size(), target_count),
+        reinterpret_cast<float*>(output.data()), std::min(output.size() * 2, base.size())
+    };
+
+#if GFX_SIMD_X86
+    if (level == SimdLevel::Avx2) {
+        BlendAvx2(span);
+        return;
+    }
+    if (level == SimdLevel::Sse2) {
+        BlendSse2(span);
+        return;
+    }
+#endif
+
+    BlendScalar(span, 0);
+}
+
+void PathMorph::Evaluate(std::span<const float> weights, Path& output) const {
+    if (output.Points().size() != PointCount() || output.Verbs().size() != shape.Verbs().size()) {
+        output = shape;
+    }
+    Evaluate(weights, output.MutablePoints());
+}
+
+void PathMorph::EvaluateBatch(std::span<const float> weights, std::span<Point> output) const {
+    auto point_count = PointCount();
+    if (point_count == 0 || target_count == 0) {
+        return;
+    }
+
+    auto level = DetectSimdLevel();
+    auto count = std::min(weights.size() / target_count, output.size() / point_count);
+    for (std::size_t i = 0; i < count; i++) {
+        Evaluate(weights.subspan(i * target_count, target_count), output.subspan(i * point_count, point_count), level);
+    }
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Geometry.h"
+#include "Simd.h"
+#include <span>
+#include <vector>
+
+namespace gfx {
+
+// Blends between paths that draw the same figures in different shapes, such as the
+// expressions of a face, without building any geometry per blend.
+//
+// Build converts every path to cubics and splits the longest segments of the paths
+// with fewer, until corresponding figures have as many segments as each other. Point i
+// of one path then matches point i of every other, and a blend is the base path plus a
+// weighted sum of each target's offsets from it: one multiply and add per target and
+// coordinate, without branches or allocations.
+class PathMorph {
+public:
+    // paths[0] is the base and the rest are blend targets. Returns false if they don't
+    // have the same number of figures, or a figure is closed in one path and open in
+    // another.
+    bool Build(std::span<const Path* const> paths);
+
+    std::size_t TargetCount() const { return target_count; }
+    std::size_t PointCount() const { return shape.Points().size(); }
+
+    // The base path after conversion. Blends have its verbs and figures.
+    const Path& Shape() const { return shape; }
+
+    // One weight per target. Weights between 0 and 1 that add up to at most 1 keep the
+    // result inside the control bounds of the paths.
+    void Evaluate(std::span<const float> weights, std::span<Point> output) const;
+    void Evaluate(std::span<const float> weights, std::span<Point> output, SimdLevel level) const;
+
+    // Turns output into a copy of Shape() the first time, then only moves its points.
+    void Evaluate(std::span<const float> weights, Path& output) const;
+
+    // Many blends at once, such as one per monster of a crowd: weights holds
+    // TargetCount() weights per blend and output PointCount() points per blend.
+    void EvaluateBatch(std::span<const float> weights, std::span<Point> output) const;
+
+private:
+    Path shape;
+    std::size_t target_count = 0;
+
+    // Coordinates as x, y pairs: the base path, then the offsets of every target from it.
+    std::vector<float> base;
+    std::vector<float> offsets;
+};
+
+}
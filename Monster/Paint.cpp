@@ -0,0 +1,781 @@
+#include "Paint.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+std::uint32_t ToByte(float value) {
+    return (std::uint32_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+}
+
+std::uint32_t MulDiv255(std::uint32_t a, std::uint32_t b) {
+    auto product = a * b + 128;
+    return (product + (product >> 8)) >> 8;
+}
+
+// Source-over of a premultiplied color scaled by coverage.
+void BlendPixel(std::uint8_t* dst, std::uint32_t src, std::uint32_t coverage) {
+    if (coverage == 0) {
+        return;
+    }
+
+    auto alpha = MulDiv255(src >> 24, coverage);
+    if (alpha == 0) {
+        return;
+    }
+    if (alpha == 255) {
+        std::memcpy(dst, &src, 4);
+        return;
+    }
+
+    auto inverse = 255 - alpha;
+    for (int channel = 0; channel < 4; channel++) {
+        auto s = MulDiv255((src >> (channel * 8)) & 0xff, coverage);
+        dst[channel] = (std::uint8_t)(s + MulDiv255(dst[channel], inverse));
+    }
+}
+
+// Interpolates two packed pixels two channels at a time; weight is in [0, 256].
+std::uint32_t LerpPixel(std::uint32_t a, std::uint32_t b, std::uint32_t weight) {
+    auto rb = ((a & 0xff00ff) * (256 - weight) + (b & 0xff00ff) * weight) >> 8;
+    auto ag = (((a >> 8) & 0xff00ff) * (256 - weight) + ((b >> 8) & 0xff00ff) * weight) >> 8;
+    return (rb & 0xff00ff) | ((ag & 0xff00ff) << 8);
+}
+
+// Premultiplied source-over of packed pixels, dividing by 255 exactly.
+std::uint32_t SourceOver(std::uint32_t src, std::uint32_t dst) {
+    auto inverse = 255 - (src >> 24);
+    auto rb = (dst & 0xff00ff) * inverse + 0x800080;
+    rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+    auto ag = ((dst >> 8) & 0xff00ff) * inverse + 0x800080;
+    ag = (ag + ((ag >> 8) & 0xff00ff)) & 0xff00ff00;
+    return src + (rb | ag);
+}
+
+constexpr int LINEAR_STEPS = 4095;
+
+// Color channel bytes decoded to linear light, and linear light in LINEAR_STEPS + 1
+// steps encoded back to bytes. Alpha isn't encoded and skips both. from_linear is
+// padded so 32-bit gathers of its last entries stay inside.
+struct LinearTables {
+    std::array<float, 256> to_linear;
+    std::array<std::uint8_t, LINEAR_STEPS + 4> from_linear;
+};
+
+const LinearTables& GetLinearTables() {
+    static const LinearTables tables = [] {
+        LinearTables built = {};
+        for (int i = 0; i < 256; i++) {
+            built.to_linear[i] = SrgbToLinear(i / 255.0f);
+        }
+        for (int i = 0; i <= LINEAR_STEPS; i++) {
+            built.from_linear[i] = (std::uint8_t)ToByte(LinearToSrgb((float)i / LINEAR_STEPS));
+        }
+        return built;
+    }();
+    return tables;
+}
+
+int EncodeIndex(float value) {
+    return (int)(std::min(value, 1.0f) * LINEAR_STEPS + 0.5f);
+}
+
+std::uint8_t AlphaByte(float alpha) {
+    return (std::uint8_t)(std::min(alpha, 1.0f) * 255.0f + 0.5f);
+}
+
+// Blue, green, red and alpha in [0, 1], premultiplied in linear light.
+std::array<float, 4> LinearPremultiplied(const Color& color) {
+    auto a = std::clamp(color.a, 0.0f, 1.0f);
+    return {
+        SrgbToLinear(std::clamp(color.b, 0.0f, 1.0f)) * a,
+        SrgbToLinear(std::clamp(color.g, 0.0f, 1.0f)) * a,
+        SrgbToLinear(std::clamp(color.r, 0.0f, 1.0f)) * a,
+        a
+    };
+}
+
+// BlendPixel in linear light, for a source premultiplied there and split into blue,
+// green, red and alpha.
+void BlendPixelLinear(std::uint8_t* dst, float b, float g, float r, float a, std::uint32_t coverage,
+    const LinearTables& tables) {
+    if (coverage == 0) {
+        return;
+    }
+
+    auto weight = (float)coverage * (1.0f / 255.0f);
+    auto alpha = a * weight;
+    auto inverse = 1.0f - alpha;
+    dst[0] = tables.from_linear[EncodeIndex(b * weight + tables.to_linear[dst[0]] * inverse)];
+    dst[1] = tables.from_linear[EncodeIndex(g * weight + tables.to_linear[dst[1]] * inverse)];
+    dst[2] = tables.from_linear[EncodeIndex(r * weight + tables.to_linear[dst[2]] * inverse)];
+    dst[3] = AlphaByte(alpha + (float)dst[3] * (1.0f / 255.0f) * inverse);
+}
+
+// Filters four premultiplied pixels and blends the result source-over, both in linear
+// light. fx and fy are in [0, 256], as for LerpPixel.
+void BlendBilinearLinear(std::uint8_t* dst, const std::uint32_t (&texels)[4], std::uint32_t fx, std::uint32_t fy,
+    const LinearTables& tables) {
+    float weights[4] = {
+        (float)((256 - fx) * (256 - fy)), (float)(fx * (256 - fy)), (float)((256 - fx) * fy), (float)(fx * fy)
+    };
+
+    float color[4] = {};
+    for (int i = 0; i < 4; i++) {
+        auto weight = weights[i] * (1.0f / 65536.0f);
+        for (int channel = 0; channel < 3; channel++) {
+            color[channel] += weight * tables.to_linear[(texels[i] >> (channel * 8)) & 0xff];
+        }
+        color[3] += weight * (float)(texels[i] >> 24) * (1.0f / 255.0f);
+    }
+
+    auto inverse = 1.0f - color[3];
+    for (int channel = 0; channel < 3; channel++) {
+        dst[channel] = tables.from_linear[EncodeIndex(color[channel] + tables.to_linear[dst[channel]] * inverse)];
+    }
+    dst[3] = AlphaByte(color[3] + (float)dst[3] * (1.0f / 255.0f) * inverse);
+}
+
+// A span being shaded, with what its paint needs worked out up front.
+struct Span {
+    std::uint8_t* dst;
+    const std::uint8_t* coverage;
+    int x, y, length;
+
+    // Solid paints: the packed premultiplied color, and in linear space its channels
+    // premultiplied in linear light and the pixel it leaves where it covers fully.
+    std::uint32_t color;
+    std::array<float, 4> linear_color;
+    std::uint32_t linear_opaque;
+
+    // Radial gradients. Every pixel is sampled at its center from its absolute
+    // position, so a pixel gets the same color whichever span it is part of.
+    Matrix3x2 unit;
+    const std::uint32_t* lut;
+    const float* linear_lut;
+
+    float RowU() const { return (y + 0.5f) * unit.m21 + unit.dx; }
+    float RowV() const { return (y + 0.5f) * unit.m22 + unit.dy; }
+
+    int RadialIndex(int i) const {
+        auto px = (float)(x + i) + 0.5f;
+        auto u = px * unit.m11 + RowU();
+        auto v = px * unit.m12 + RowV();
+        return GradientLut::Index(std::sqrt(u * u + v * v));
+    }
+};
+
+void ShadeSolidScalar(const Span& span, int begin) {
+    for (int i = begin; i < span.length; i++) {
+        BlendPixel(span.dst + i * 4, span.color, span.coverage[i]);
+    }
+}
+
+void ShadeRadialScalar(const Span& span, int begin) {
+    for (int i = begin; i < span.length; i++) {
+        if (span.coverage[i] != 0) {
+            BlendPixel(span.dst + i * 4, span.lut[span.RadialIndex(i)], span.coverage[i]);
+        }
+    }
+}
+
+void ShadeSolidLinearScalar(const Span& span, int begin, const LinearTables& tables) {
+    const auto& color = span.linear_color;
+    for (int i = begin; i < span.length; i++) {
+        BlendPixelLinear(span.dst + i * 4, color[0], color[1], color[2], color[3], span.coverage[i], tables);
+    }
+}
+
+void ShadeRadialLinearScalar(const Span& span, int begin, const LinearTables& tables) {
+    constexpr int SIZE = GradientLut::SIZE;
+
+    for (int i = begin; i < span.length; i++) {
+        if (span.coverage[i] == 0) {
+            continue;
+        }
+        const auto* lut = span.linear_lut + span.RadialIndex(i);
+        BlendPixelLinear(span.dst + i * 4, lut[0], lut[SIZE], lut[2 * SIZE], lut[3 * SIZE], span.coverage[i], tables);
+    }
+}
+
+#if GFX_SIMD_X86
+
+// MulDiv255 on eight 16-bit lanes.
+__m128i MulDiv255x8(__m128i a, __m128i b) {
+    auto product = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+}
+
+// BlendPixel for two pixels widened to 16 bits per channel. coverage holds each
+// pixel's coverage in all four of its channels.
+__m128i BlendPixelsx2(__m128i dst, __m128i src, __m128i coverage) {
+    auto s = MulDiv255x8(src, coverage);
+    auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    auto inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return _mm_add_epi16(s, MulDiv255x8(dst, inverse));
+}
+
+// BlendPixel for the four pixels at dst, with one coverage byte each.
+void BlendPixelsSse2(std::uint8_t* dst, __m128i src, std::uint32_t coverage) {
+    auto zero = _mm_setzero_si128();
+
+    // Spread each pixel's coverage byte over its four channels.
+    auto spread = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)coverage), _mm_cvtsi32_si128((int)coverage));
+    spread = _mm_unpacklo_epi16(spread, spread);
+
+    auto pixels = _mm_loadu_si128((const __m128i*)dst);
+    auto low = BlendPixelsx2(_mm_unpacklo_epi8(pixels, zero), _mm_unpacklo_epi8(src, zero),
+        _mm_unpacklo_epi8(spread, zero));
+    auto high = BlendPixelsx2(_mm_unpackhi_epi8(pixels, zero), _mm_unpackhi_epi8(src, zero),
+        _mm_unpackhi_epi8(spread, zero));
+    _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(low, high));
+}
+
+// Span::RadialIndex of the four pixels from i on.
+__m128i RadialIndicesSse2(const Span& span, int i) {
+    constexpr float LAST = GradientLut::SIZE - 1;
+
+    auto px = _mm_add_ps(_mm_cvtepi32_ps(_mm_set1_epi32(span.x + i)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+    auto u = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(span.unit.m11)), _mm_set1_ps(span.RowU()));
+    auto v = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(span.unit.m12)), _mm_set1_ps(span.RowV()));
+    auto position = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(u, u), _mm_mul_ps(v, v)));
+    position = _mm_add_ps(_mm_mul_ps(position, _mm_set1_ps(LAST)), _mm_set1_ps(0.5f));
+    position = _mm_min_ps(_mm_max_ps(position, _mm_setzero_ps()), _mm_set1_ps(LAST));
+    return _mm_cvttps_epi32(position);
+}
+
+// BlendPixelLinear for the four pixels at dst, with the source split into channels.
+// SSE2 has no gathers, so the tables are read one lane at a time.
+void BlendPixelsLinearSse2(std::uint8_t* dst, __m128 b, __m128 g, __m128 r, __m128 a, std::uint32_t coverage,
+    const LinearTables& tables) {
+    auto zero = _mm_setzero_si128();
+    auto one = _mm_set1_ps(1.0f);
+    auto to_unit = _mm_set1_ps(1.0f / 255.0f);
+
+    auto weight = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)coverage), zero), zero);
+    auto scale = _mm_mul_ps(_mm_cvtepi32_ps(weight), to_unit);
+    auto alpha = _mm_mul_ps(a, scale);
+    auto inverse = _mm_sub_ps(one, alpha);
+
+    alignas(16) std::uint8_t pixels[16];
+    _mm_store_si128((__m128i*)pixels, _mm_loadu_si128((const __m128i*)dst));
+    const auto& to_linear = tables.to_linear;
+    auto db = _mm_setr_ps(to_linear[pixels[0]], to_linear[pixels[4]], to_linear[pixels[8]], to_linear[pixels[12]]);
+    auto dg = _mm_setr_ps(to_linear[pixels[1]], to_linear[pixels[5]], to_linear[pixels[9]], to_linear[pixels[13]]);
+    auto dr = _mm_setr_ps(to_linear[pixels[2]], to_linear[pixels[6]], to_linear[pixels[10]], to_linear[pixels[14]]);
+    auto da = _mm_mul_ps(_mm_setr_ps(pixels[3], pixels[7], pixels[11], pixels[15]), to_unit);
+
+    auto steps = _mm_set1_ps((float)LINEAR_STEPS), half = _mm_set1_ps(0.5f);
+    auto encode = [&](__m128 source, __m128 backdrop) {
+        auto value = _mm_add_ps(_mm_mul_ps(source, scale), _mm_mul_ps(backdrop, inverse));
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(value, one), steps), half));
+    };
+    alignas(16) std::int32_t indices[3][4];
+    _mm_store_si128((__m128i*)indices[0], encode(b, db));
+    _mm_store_si128((__m128i*)indices[1], encode(g, dg));
+    _mm_store_si128((__m128i*)indices[2], encode(r, dr));
+
+    auto out_alpha = _mm_add_ps(alpha, _mm_mul_ps(da, inverse));
+    out_alpha = _mm_add_ps(_mm_mul_ps(_mm_min_ps(out_alpha, one), _mm_set1_ps(255.0f)), half);
+    alignas(16) std::int32_t alphas[4];
+    _mm_store_si128((__m128i*)alphas, _mm_cvttps_epi32(out_alpha));
+
+    for (int i = 0; i < 4; i++) {
+        dst[i * 4] = tables.from_linear[indices[0][i]];
+        dst[i * 4 + 1] = tables.from_linear[indices[1][i]];
+        dst[i * 4 + 2] = tables.from_linear[indices[2][i]];
+        dst[i * 4 + 3] = (std::uint8_t)alphas[i];
+    }
+}
+
+void ShadeSolidSse2(const Span& span) {
+    auto src = _mm_set1_epi32((int)span.color);
+    auto opaque = (span.color >> 24) == 255;
+
+    int i = 0;
+    for (; i + 4 <= span.length; i += 4) {
+        std::uint32_t coverage;
+        std::memcpy(&coverage, span.coverage + i, 4);
+        if (coverage == 0) {
+            continue;
+        }
+        if (opaque && coverage == 0xffffffff) {
+            _mm_storeu_si128((__m128i*)(span.dst + i * 4), src);
+            continue;
+        }
+        BlendPixelsSse2(span.dst + i * 4, src, coverage);
+    }
+
+    ShadeSolidScalar(span, i);
+}
+
+void ShadeRadialSse2(const Span& span) {
+    int i = 0;
+    for (; i + 4 <= span.length; i += 4) {
+        std::uint32_t coverage;
+        std::memcpy(&coverage, span.coverage + i, 4);
+        if (coverage == 0) {
+            continue;
+        }
+
+        alignas(16) std::int32_t index[4];
+        _mm_store_si128((__m128i*)index, RadialIndicesSse2(span, i));
+        auto src = _mm_setr_epi32((int)span.lut[index[0]], (int)span.lut[index[1]],
+            (int)span.lut[index[2]], (int)span.lut[index[3]]);
+        BlendPixelsSse2(span.dst + i * 4, src, coverage);
+    }
+
+    ShadeRadialScalar(span, i);
+}
+
+void ShadeSolidLinearSse2(const Span& span, const LinearTables& tables) {
+    const auto& color = span.linear_color;
+    auto b = _mm_set1_ps(color[0]), g = _mm_set1_ps(color[1]), r = _mm_set1_ps(color[2]), a = _mm_set1_ps(color[3]);
+    auto opaque = color[3] >= 1.0f;
+
+    int i = 0;
+    for (; i + 4 <= span.length; i += 4) {
+        std::uint32_t coverage;
+        std::memcpy(&coverage, span.coverage + i, 4);
+        if (coverage == 0) {
+            continue;
+        }
+        if (opaque && coverage == 0xffffffff) {
+            _mm_storeu_si128((__m128i*)(span.dst + i * 4), _mm_set1_epi32((int)span.linear_opaque));
+            continue;
+        }
+        BlendPixelsLinearSse2(span.dst + i * 4, b, g, r, a, coverage, tables);
+    }
+
+    ShadeSolidLinearScalar(span, i, tables);
+}
+
+void ShadeRadialLinearSse2(const Span& span, const LinearTables& tables) {
+    constexpr int SIZE = GradientLut::SIZE;
+    const auto* lut = span.linear_lut;
+
+    int i = 0;
+    for (; i + 4 <= span.length; i += 4) {
+        std::uint32_t coverage;
+        std::memcpy(&coverage, span.coverage + i, 4);
+        if (coverage == 0) {
+            continue;
+        }
+
+        alignas(16) std::int32_t index[4];
+        _mm_store_si128((__m128i*)index, RadialIndicesSse2(span, i));
+        auto channel = [&](int offset) {
+            return _mm_setr_ps(lut[offset + index[0]], lut[offset + index[1]], lut[offset + index[2]],
+                lut[offset + index[3]]);
+        };
+        BlendPixelsLinearSse2(span.dst + i * 4, channel(0), channel(SIZE), channel(2 * SIZE), channel(3 * SIZE),
+            coverage, tables);
+    }
+
+    ShadeRadialLinearScalar(span, i, tables);
+}
+
+GFX_TARGET_AVX2
+__m256i MulDiv255x16(__m256i a, __m256i b) {
+    auto product = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+}
+
+GFX_TARGET_AVX2
+__m256i BlendPixelsx4(__m256i dst, __m256i src, __m256i coverage) {
+    auto s = MulDiv255x16(src, coverage);
+    auto alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    auto inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+    return _mm256_add_epi16(s, MulDiv255x16(dst, inverse));
+}
+
+// BlendPixel for the eight pixels at dst, with one coverage byte each.
+GFX_TARGET_AVX2
+void BlendPixelsAvx2(std::uint8_t* dst, __m256i src, std::uint64_t coverage) {
+    auto zero = _mm256_setzero_si256();
+
+    // One coverage byte per 32-bit lane, then copied into all four bytes.
+    auto spread = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)coverage));
+    spread = _mm256_mullo_epi32(spread, _mm256_set1_epi32(0x01010101));
+
+    auto pixels = _mm256_loadu_si256((const __m256i*)dst);
+    auto low = BlendPixelsx4(_mm256_unpacklo_epi8(pixels, zero), _mm256_unpacklo_epi8(src, zero),
+        _mm256_unpacklo_epi8(spread, zero));
+    auto high = BlendPixelsx4(_mm256_unpackhi_epi8(pixels, zero), _mm256_unpackhi_epi8(src, zero),
+        _mm256_unpackhi_epi8(spread, zero));
+    _mm256_storeu_si256((__m256i*)dst, _mm256_packus_epi16(low, high));
+}
+
+// Span::RadialIndex of the eight pixels from i on.
+GFX_TARGET_AVX2
+__m256i RadialIndicesAvx2(const Span& span, int i) {
+    constexpr float LAST = GradientLut::SIZE - 1;
+
+    auto lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    auto px = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_set1_epi32(span.x + i)), lanes);
+    auto u = _mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(span.unit.m11)), _mm256_set1_ps(span.RowU()));
+    auto v = _mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(span.unit.m12)), _mm256_set1_ps(span.RowV()));
+    auto position = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(u, u), _mm256_mul_ps(v, v)));
+    position = _mm256_add_ps(_mm256_mul_ps(position, _mm256_set1_ps(LAST)), _mm256_set1_ps(0.5f));
+    position = _mm256_min_ps(_mm256_max_ps(position, _mm256_setzero_ps()), _mm256_set1_ps(LAST));
+    return _mm256_cvttps_epi32(position);
+}
+
+// Bytes of from_linear for a blended channel, one per 32-bit lane.
+GFX_TARGET_AVX2
+__m256i EncodeLinearAvx2(__m256 value, const LinearTables& tables) {
+    auto index = _mm256_min_ps(value, _mm256_set1_ps(1.0f));
+    index = _mm256_add_ps(_mm256_mul_ps(index, _mm256_set1_ps((float)LINEAR_STEPS)), _mm256_set1_ps(0.5f));
+    auto bytes = _mm256_i32gather_epi32((const int*)tables.from_linear.data(), _mm256_cvttps_epi32(index), 1);
+    return _mm256_and_si256(bytes, _mm256_set1_epi32(0xff));
+}
+
+// BlendPixelLinear for the eight pixels at dst, with the source split into channels.
+GFX_TARGET_AVX2
+void BlendPixelsLinearAvx2(std::uint8_t* dst, __m256 b, __m256 g, __m256 r, __m256 a, std::uint64_t coverage,
+    const LinearTables& tables) {
+    auto one = _mm256_set1_ps(1.0f);
+    auto to_unit = _mm256_set1_ps(1.0f / 255.0f);
+    auto mask = _mm256_set1_epi32(0xff);
+
+    auto scale = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)coverage)));
+    scale = _mm256_mul_ps(scale, to_unit);
+    auto alpha = _mm256_mul_ps(a, scale);
+    auto inverse = _mm256_sub_ps(one, alpha);
+
+    auto pixels = _mm256_loadu_si256((const __m256i*)dst);
+    const auto* to_linear = tables.to_linear.data();
+    auto db = _mm256_i32gather_ps(to_linear, _mm256_and_si256(pixels, mask), 4);
+    auto dg = _mm256_i32gather_ps(to_linear, _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask), 4);
+    auto dr = _mm256_i32gather_ps(to_linear, _mm256_and_si256(_mm256_srli_epi32(pixels, 16), mask), 4);
+    auto da = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(pixels, 24)), to_unit);
+
+    auto ob = _mm256_add_ps(_mm256_mul_ps(b, scale), _mm256_mul_ps(db, inverse));
+    auto og = _mm256_add_ps(_mm256_mul_ps(g, scale), _mm256_mul_ps(dg, inverse));
+    auto orr = _mm256_add_ps(_mm256_mul_ps(r, scale), _mm256_mul_ps(dr, inverse));
+    auto oa = _mm256_add_ps(alpha, _mm256_mul_ps(da, inverse));
+    oa = _mm256_add_ps(_mm256_mul_ps(_mm256_min_ps(oa, one), _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f));
+
+    auto result = _mm256_or_si256(EncodeLinearAvx2(ob, tables), _mm256_slli_epi32(EncodeLinearAvx2(og, tables), 8));
+    result = _mm256_or_si256(result, _mm256_slli_epi32(EncodeLinearAvx2(orr, tables), 16));
+    result = _mm256_or_si256(result, _mm256_slli_epi32(_mm256_cvttps_epi32(oa), 24));
+    _mm256_storeu_si256((__m256i*)dst, result);
+}
+
+GFX_TARGET_AVX2
+void ShadeSolidAvx2(const Span& span) {
+    auto src = _mm256_set1_epi32((int)span.color);
+    auto opaque = (span.color >> 24) == 255;
+
+    int i = 0;
+    for (; i + 8 <= span.length; i += 8) {
+        std::uint64_t coverage;
+        std::memcpy(&coverage, span.coverage + i, 8);
+        if (coverage == 0) {
+            continue;
+        }
+        if (opaque && coverage == ~0ull) {
+            _mm256_storeu_si256((__m256i*)(span.dst + i * 4), src);
+            continue;
+        }
+        BlendPixelsAvx2(span.dst + i * 4, src, coverage);
+    }
+
+    ShadeSolidScalar(span, i);
+}
+
+GFX_TARGET_AVX2
+void ShadeRadialAvx2(const Span& span) {
+    int i = 0;
+    for (; i + 8 <= span.length; i += 8) {
+        std::uint64_t coverage;
+        std::memcpy(&coverage, span.coverage + i, 8);
+        if (coverage == 0) {
+            continue;
+        }
+
+        auto src = _mm256_i32gather_epi32((const int*)span.lut, RadialIndicesAvx2(span, i), 4);
+        BlendPixelsAvx2(span.dst + i * 4, src, coverage);
+    }
+
+    ShadeRadialScalar(span, i);
+}
+
+GFX_TARGET_AVX2
+void ShadeSolidLinearAvx2(const Span& span, const LinearTables& tables) {
+    const auto& color = span.linear_color;
+    auto b = _mm256_set1_ps(color[0]), g = _mm256_set1_ps(color[1]);
+    auto r = _mm256_set1_ps(color[2]), a = _mm256_set1_ps(color[3]);
+    auto opaque = color[3] >= 1.0f;
+
+    int i = 0;
+    for (; i + 8 <= span.length; i += 8) {
+        std::uint64_t coverage;
+        std::memcpy(&coverage, span.coverage + i, 8);
+        if (coverage == 0) {
+            continue;
+        }
+        if (opaque && coverage == ~0ull) {
+            _mm256_storeu_si256((__m256i*)(span.dst + i * 4), _mm256_set1_epi32((int)span.linear_opaque));
+            continue;
+        }
+        BlendPixelsLinearAvx2(span.dst + i * 4, b, g, r, a, coverage, tables);
+    }
+
+    ShadeSolidLinearScalar(span, i, tables);
+}
+
+GFX_TARGET_AVX2
+void ShadeRadialLinearAvx2(const Span& span, const LinearTables& tables) {
+    constexpr int SIZE = GradientLut::SIZE;
+    const auto* lut = span.linear_lut;
+
+    int i = 0;
+    for (; i + 8 <= span.length; i += 8) {
+        std::uint64_t coverage;
+        std::memcpy(&coverage, span.coverage + i, 8);
+        if (coverage == 0) {
+            continue;
+        }
+
+        auto index = RadialIndicesAvx2(span, i);
+        BlendPixelsLinearAvx2(span.dst + i * 4, _mm256_i32gather_ps(lut, index, 4),
+            _mm256_i32gather_ps(lut + SIZE, index, 4), _mm256_i32gather_ps(lut + 2 * SIZE, index, 4),
+            _mm256_i32gather_ps(lut + 3 * SIZE, index, 4), coverage, tables);
+    }
+
+    ShadeRadialLinearScalar(span, i, tables);
+}
+
+#endif
+
+}
+
+std::uint32_t PackPremultiplied(const Color& color, BlendSpace space) {
+    if (space == BlendSpace::Linear) {
+        auto linear = LinearPremultiplied(color);
+        auto b = ToByte(LinearToSrgb(linear[0]));
+        auto g = ToByte(LinearToSrgb(linear[1]));
+        auto r = ToByte(LinearToSrgb(linear[2]));
+        return (ToByte(linear[3]) << 24) | (r << 16) | (g << 8) | b;
+    }
+
+    auto a = ToByte(color.a);
+    auto r = MulDiv255(ToByte(color.r), a);
+    auto g = MulDiv255(ToByte(color.g), a);
+    auto b = MulDiv255(ToByte(color.b), a);
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+float SrgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSrgb(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+Color EvaluateGradient(std::span<const GradientStop> stops, float position) {
+    if (stops.empty()) {
+        return {};
+    }
+    if (position <= stops.front().position) {
+        return stops.front().color;
+    }
+    if (position >= stops.back().position) {
+        return stops.back().color;
+    }
+
+    std::size_t i = 1;
+    while (stops[i].position < position) {
+        i++;
+    }
+
+    const auto& from = stops[i - 1];
+    const auto& to = stops[i];
+    auto range = to.position - from.position;
+    auto t = range > 0.0f ? (position - from.position) / range : 1.0f;
+
+    return {
+        from.color.r + (to.color.r - from.color.r) * t,
+        from.color.g + (to.color.g - from.color.g) * t,
+        from.color.b + (to.color.b - from.color.b) * t,
+        from.color.a + (to.color.a - from.color.a) * t
+    };
+}
+
+GradientLut::GradientLut(std::span<const GradientStop> stops) {
+    for (int i = 0; i < SIZE; i++) {
+        auto color = EvaluateGradient(stops, (float)i / (SIZE - 1));
+        colors[i] = PackPremultiplied(color);
+
+        auto linear = LinearPremultiplied(color);
+        for (int channel = 0; channel < 4; channel++) {
+            linear_colors[channel * SIZE + i] = linear[channel];
+        }
+    }
+}
+
+Paint Paint::Solid(const Color& color) {
+    Paint paint;
+    paint.kind = Kind::Solid;
+    paint.color = color;
+    return paint;
+}
+
+Paint Paint::RadialGradient(Point center, float radius_x, float radius_y,
+    const GradientLut& gradient, const Matrix3x2& transformation) {
+    Paint paint;
+    paint.kind = Kind::RadialGradient;
+    paint.gradient = &gradient;
+
+    auto inverse = transformation;
+    inverse.Invert();
+    paint.unit = inverse * Matrix3x2::Translation(-center.x, -center.y) *
+        Matrix3x2::Scale(1.0f / radius_x, 1.0f / radius_y);
+    return paint;
+}
+
+void FillSurface(const Surface& surface, const Color& color, BlendSpace space) {
+    FillRect(surface, { 0, 0, surface.width, surface.height }, color, space);
+}
+
+void FillRect(const Surface& surface, const IntRect& rect, const Color& color, BlendSpace space) {
+    auto packed = PackPremultiplied(color, space);
+    for (int y = rect.top; y < rect.bottom; y++) {
+        auto* row = surface.Row(y);
+        for (int x = rect.left; x < rect.right; x++) {
+            std::memcpy(row + x * 4, &packed, 4);
+        }
+    }
+}
+
+void CopyRect(const Surface& target, const Surface& source, const IntRect& rect) {
+    if (rect.IsEmpty()) {
+        return;
+    }
+    for (int y = rect.top; y < rect.bottom; y++) {
+        std::memcpy(target.Row(y) + rect.left * 4, source.Row(y) + rect.left * 4, (std::size_t)rect.Width() * 4);
+    }
+}
+
+void DrawBitmap(const Surface& target, const IntRect& clip, const Surface& source, const IntRect& source_rect,
+    const Rect& destination, BlendSpace space) {
+    auto bounds = Intersect(clip, RoundOut(destination));
+    auto source_width = source_rect.Width(), source_height = source_rect.Height();
+    if (bounds.IsEmpty() || source_width <= 0 || source_height <= 0) {
+        return;
+    }
+
+    auto scale_x = source_width / (destination.right - destination.left);
+    auto scale_y = source_height / (destination.bottom - destination.top);
+
+    // Source x in 16.16 fixed point, stepped across the row.
+    auto u_start = (std::int32_t)(((bounds.left + 0.5f - destination.left) * scale_x - 0.5f) * 65536.0f);
+    auto u_step = (std::int32_t)(scale_x * 65536.0f);
+    const auto& tables = GetLinearTables();
+
+    for (int y = bounds.top; y < bounds.bottom; y++) {
+        auto v = (y + 0.5f - destination.top) * scale_y - 0.5f;
+        auto v0 = (int)std::floor(v);
+        auto fy = (std::uint32_t)((v - v0) * 256.0f);
+        const auto* row0 = source.Row(source_rect.top + std::clamp(v0, 0, source_height - 1));
+        const auto* row1 = source.Row(source_rect.top + std::clamp(v0 + 1, 0, source_height - 1));
+        auto* dst = target.Row(y);
+
+        auto u = u_start;
+        for (int x = bounds.left; x < bounds.right; x++, u += u_step) {
+            auto u0 = u >> 16;
+            auto fx = (std::uint32_t)(u >> 8) & 0xff;
+            auto x0 = (std::size_t)(source_rect.left + std::clamp(u0, 0, source_width - 1)) * 4;
+            auto x1 = (std::size_t)(source_rect.left + std::clamp(u0 + 1, 0, source_width - 1)) * 4;
+
+            std::uint32_t p00, p01, p10, p11;
+            std::memcpy(&p00, row0 + x0, 4);
+            std::memcpy(&p01, row0 + x1, 4);
+            std::memcpy(&p10, row1 + x0, 4);
+            std::memcpy(&p11, row1 + x1, 4);
+            if ((p00 | p01 | p10 | p11) == 0) {
+                continue;
+            }
+            if (space == BlendSpace::Linear) {
+                BlendBilinearLinear(dst + x * 4, { p00, p01, p10, p11 }, fx, fy, tables);
+                continue;
+            }
+
+            auto pixel = LerpPixel(LerpPixel(p00, p01, fx), LerpPixel(p10, p11, fx), fy);
+            std::uint32_t background;
+            std::memcpy(&background, dst + x * 4, 4);
+            auto result = SourceOver(pixel, background);
+            std::memcpy(dst + x * 4, &result, 4);
+        }
+    }
+}
+
+void ShadeSpan(const Surface& surface, const Paint& paint, int x, int y, int length, const std::uint8_t* coverage) {
+    ShadeSpan(surface, paint, x, y, length, coverage, DetectSimdLevel());
+}
+
+void ShadeSpan(const Surface& surface, const Paint& paint, int x, int y, int length, const std::uint8_t* coverage,
+    SimdLevel level) {
+    Span span = {};
+    span.dst = surface.Row(y) + (std::size_t)x * 4;
+    span.coverage = coverage;
+    span.x = x;
+    span.y = y;
+    span.length = length;
+
+    auto solid = paint.kind == Paint::Kind::Solid;
+    if (solid) {
+        span.color = PackPremultiplied(paint.color);
+    }
+    else {
+        span.unit = paint.unit;
+        span.lut = paint.gradient->Data();
+        span.linear_lut = paint.gradient->LinearData();
+    }
+
+    if (paint.space == BlendSpace::Linear) {
+        const auto& tables = GetLinearTables();
+        if (solid) {
+            span.linear_color = LinearPremultiplied(paint.color);
+            // Full coverage of an opaque color replaces the backdrop entirely.
+            std::uint8_t opaque[4] = {};
+            const auto& color = span.linear_color;
+            BlendPixelLinear(opaque, color[0], color[1], color[2], color[3], 255, tables);
+            std::memcpy(&span.linear_opaque, opaque, 4);
+        }
+
+#if GFX_SIMD_X86
+        if (level == SimdLevel::Avx2) {
+            solid ? ShadeSolidLinearAvx2(span, tables) : ShadeRadialLinearAvx2(span, tables);
+            return;
+        }
+        if (level == SimdLevel::Sse2) {
+            solid ? ShadeSolidLinearSse2(span, tables) : ShadeRadialLinearSse2(span, tables);
+            return;
+        }
+#endif
+
+        solid ? ShadeSolidLinearScalar(span, 0, tables) : ShadeRadialLinearScalar(span, 0, tables);
+        return;
+    }
+
+#if GFX_SIMD_X86
+    if (level == SimdLevel::Avx2) {
+        solid ? ShadeSolidAvx2(span) : ShadeRadialAvx2(span);
+        return;
+    }
+    if (level == SimdLevel::Sse2) {
+        solid ? ShadeSolidSse2(span) : ShadeRadialSse2(span);
+        return;
+    }
+#endif
+
+    solid ? ShadeSolidScalar(span, 0) : ShadeRadialScalar(span, 0);
+}
+
+}
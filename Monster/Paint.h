@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Geometry.h"
+#include "Simd.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace gfx {
+
+struct Color {
+    float r = 0.0f, g = 0.0f, b = 0.0f, a = 1.0f;
+};
+
+struct GradientStop {
+    float position = 0.0f;
+    Color color;
+};
+
+// Space colors are blended and filtered in. Stored works on the encoded values as
+// Direct2D does with 8-bit targets. Linear decodes them to linear light first and
+// encodes the result again, as an sRGB render target would, so antialiased edges and
+// translucent colors keep their brightness. Gradients are interpolated in the stored
+// space either way.
+enum class BlendSpace { Stored, Linear };
+
+// BGRA8 pixels owned by the caller.
+struct Surface {
+    std::uint8_t* pixels = nullptr;
+    int width = 0, height = 0;
+    int stride = 0;
+
+    std::uint8_t* Row(int y) const { return pixels + (std::size_t)y * stride; }
+};
+
+// Premultiplied BGRA8 color packed as 0xAARRGGBB. In linear space the color is
+// premultiplied in linear light and the result encoded again.
+std::uint32_t PackPremultiplied(const Color& color, BlendSpace space = BlendSpace::Stored);
+
+// The sRGB transfer function and its inverse, exact rather than through tables.
+float SrgbToLinear(float value);
+float LinearToSrgb(float value);
+
+// Gradient colors are interpolated in the stored (gamma 2.2) color space and clamped
+// at the ends, matching the defaults of ID2D1GradientStopCollection.
+Color EvaluateGradient(std::span<const GradientStop> stops, float position);
+
+// A gradient sampled at SIZE evenly spaced positions from 0 to 1, as packed
+// premultiplied colors. Build one per stop collection and share it between paints.
+class GradientLut {
+public:
+    static constexpr int SIZE = 1024;
+
+    GradientLut() = default;
+    explicit GradientLut(std::span<const GradientStop> stops);
+
+    // Nearest entry; positions outside [0, 1] clamp like the stops do.
+    std::uint32_t Sample(float position) const { return colors[Index(position)]; }
+    const std::uint32_t* Data() const { return colors.data(); }
+    // The same colors decoded to linear light and premultiplied there: SIZE blue values,
+    // then SIZE green, red and alpha values, so each channel can be gathered on its own.
+    const float* LinearData() const { return linear_colors.data(); }
+
+    static int Index(float position) {
+        return (int)std::clamp(position * (SIZE - 1) + 0.5f, 0.0f, (float)(SIZE - 1));
+    }
+
+private:
+    std::array<std::uint32_t, SIZE> colors = {};
+    std::array<float, SIZE * 4> linear_colors = {};
+};
+
+// What a filled shape is shaded with. Radial gradients are defined in the local space
+// of the shape; unit maps device pixels onto the gradient's unit circle.
+struct Paint {
+    enum class Kind { Solid, RadialGradient };
+
+    Kind kind = Kind::Solid;
+    Color color;
+    BlendSpace space = BlendSpace::Stored;
+
+    const GradientLut* gradient = nullptr;
+    Matrix3x2 unit;
+
+    static Paint Solid(const Color& color);
+    // The LUT has to outlive the paint.
+    static Paint RadialGradient(Point center, float radius_x, float radius_y,
+        const GradientLut& gradient, const Matrix3x2& transformation);
+};
+
+void FillSurface(const Surface& surface, const Color& color, BlendSpace space = BlendSpace::Stored);
+void FillRect(const Surface& surface, const IntRect& rect, const Color& color, BlendSpace space = BlendSpace::Stored);
+// Replaces rect of target with the same rect of source, without blending.
+void CopyRect(const Surface& target, const Surface& source, const IntRect& rect);
+
+// Stretches source_rect of source over destination with bilinear filtering and
+// blends it source-over into target, touching only pixels inside clip. Both surfaces
+// hold premultiplied pixels, encoded for space.
+void DrawBitmap(const Surface& target, const IntRect& clip, const Surface& source, const IntRect& source_rect,
+    const Rect& destination, BlendSpace space = BlendSpace::Stored);
+
+// Shades one row span at (x, y) with the paint and blends it source-over into the
+// surface, weighted by 8-bit coverage, in the paint's blend space. Spans are shaded 8
+// (AVX2) or 4 (SSE2) pixels at a time; the scalar level is the reference the others
+// are checked against.
+//
+// Linear blending decodes through a 256 entry table, blends in float and encodes
+// through a table of 4096 linear steps, fine enough that a pixel decoded and encoded
+// again comes back unchanged. Every level does the same float operations in the same
+// order, so they match exactly in both spaces.
+void ShadeSpan(const Surface& surface, const Paint& paint, int x, int y, int length, const std::uint8_t* coverage);
+void ShadeSpan(const Surface& surface, const Paint& paint, int x, int y, int length, const std::uint8_t* coverage,
+    SimdLevel level);
+
+}
@@ -0,0 +1,247 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace {
+
+struct Percentiles {
+    double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+};
+
+// Nearest rank.
+Percentiles ComputePercentiles(std::vector<double> values) {
+    if (values.empty()) {
+        return {};
+    }
+
+    std::sort(values.begin(), values.end());
+    auto at = [&](double fraction) {
+        auto rank = (std::size_t)std::ceil(fraction * values.size());
+        return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+    };
+    return { at(0.50), at(0.95), at(0.99) };
+}
+
+}
+
+std::string_view FramePhaseName(FramePhase phase) {
+    switch (phase) {
+    case FramePhase::Input: return "input";
+    case FramePhase::Simulation: return "simulation";
+    case FramePhase::Geometry: return "geometry";
+    case FramePhase::DrawSubmission: return "draw_submission";
+    case FramePhase::Present: return "present";
+    case FramePhase::Wait: return "wait";
+    default: return "unknown";
+    }
+}
+
+FrameProfiler::FrameProfiler(Timer& timer) : timer(timer), slots(std::make_unique<Slot[]>(CAPACITY)) {}
+
+void FrameProfiler::SetEnabled(bool enabled) {
+    this->enabled = enabled;
+    in_frame = false;
+}
+
+void FrameProfiler::BeginFrame() {
+    if (!enabled) {
+        return;
+    }
+
+    current = {};
+    current.frame = frame_counter++;
+    current.begin = timer.get_ticks();
+    in_frame = true;
+}
+
+void FrameProfiler::EndFrame() {
+    if (!enabled || !in_frame) {
+        return;
+    }
+
+    current.end = timer.get_ticks();
+    in_frame = false;
+
+    // Odd sequence numbers mark a slot that is being written.
+    auto index = written.load(std::memory_order_relaxed);
+    auto& slot = slots[index % CAPACITY];
+    auto sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timing = current;
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    written.store(index + 1, std::memory_order_release);
+}
+
+FrameProfiler::Zone::Zone(FrameProfiler* profiler, FramePhase phase) : profiler(profiler), phase(phase) {
+    if (profiler && profiler->in_frame) {
+        begin = profiler->timer.get_ticks();
+    }
+    else {
+        this->profiler = nullptr;
+    }
+}
+
+FrameProfiler::Zone::~Zone() {
+    if (profiler) {
+        profiler->AddPhase(phase, begin, profiler->timer.get_ticks() - begin);
+    }
+}
+
+void FrameProfiler::SetInputTime(std::int64_t ticks) {
+    if (in_frame) {
+        current.input_time = ticks;
+    }
+}
+
+void FrameProfiler::AddPhase(FramePhase phase, std::int64_t begin, std::int64_t ticks) {
+    if (!in_frame || ticks <= 0) {
+        return;
+    }
+
+    auto index = (std::size_t)phase;
+    if (current.phase_ticks[index] == 0) {
+        current.phase_begin[index] = begin;
+    }
+    current.phase_ticks[index] += ticks;
+}
+
+std::vector<FrameTiming> FrameProfiler::Frames() const {
+    std::vector<FrameTiming> frames;
+
+    auto end = written.load(std::memory_order_acquire);
+    auto first = end > CAPACITY ? end - CAPACITY : 0;
+    for (auto i = first; i < end; i++) {
+        const auto& slot = slots[i % CAPACITY];
+        auto before = slot.sequence.load(std::memory_order_acquire);
+        auto timing = slot.timing;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto after = slot.sequence.load(std::memory_order_relaxed);
+
+        // Every pass over the ring adds two to a slot's sequence. Anything else means the
+        // writer touched the slot meanwhile and it holds a newer frame by now.
+        auto expected = 2 * (i / CAPACITY + 1);
+        if (before == expected && after == expected) {
+            frames.push_back(timing);
+        }
+    }
+    return frames;
+}
+
+double FrameProfiler::TicksToMilliseconds(std::int64_t ticks) const {
+    return ticks * 1000.0 / timer.get_frequency();
+}
+
+bool FrameProfiler::ExportJson(const std::filesystem::path& filename) const {
+    auto frames = Frames();
+    std::ofstream stream(filename);
+
+    auto write_percentiles = [&](std::string_view name, const Percentiles& percentiles, bool last) {
+        stream << "    \"" << name << "\": { \"p50_ms\": " << percentiles.p50 << ", \"p95_ms\": " << percentiles.p95
+            << ", \"p99_ms\": " << percentiles.p99 << " }" << (last ? "\n" : ",\n");
+    };
+
+    stream << "{\n  \"frame_count\": " << frames.size() << ",\n  \"percentiles\": {\n";
+    std::vector<double> values;
+    for (std::size_t phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+        values.clear();
+        for (const auto& frame : frames) {
+            values.push_back(TicksToMilliseconds(frame.phase_ticks[phase]));
+        }
+        write_percentiles(FramePhaseName((FramePhase)phase), ComputePercentiles(values), false);
+    }
+    values.clear();
+    for (const auto& frame : frames) {
+        values.push_back(TicksToMilliseconds(frame.end - frame.begin));
+    }
+    write_percentiles("frame", ComputePercentiles(values), false);
+    values.clear();
+    for (const auto& frame : frames) {
+        if (frame.input_time != 0) {
+            values.push_back(TicksToMilliseconds(frame.end - frame.input_time));
+        }
+    }
+    write_percentiles("input_latency", ComputePercentiles(values), true);
+
+    stream << "  },\n  \"frames\": [\n";
+    for (std::size_t i = 0; i < frames.size(); i++) {
+        const auto& frame = frames[i];
+        stream << "    { \"frame\": " << frame.frame << ", \"frame_ms\": " << TicksToMilliseconds(frame.end - frame.begin);
+        for (std::size_t phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+            stream << ", \"" << FramePhaseName((FramePhase)phase) << "_ms\": "
+                << TicksToMilliseconds(frame.phase_ticks[phase]);
+        }
+        if (frame.input_time != 0) {
+            stream << ", \"input_latency_ms\": " << TicksToMilliseconds(frame.end - frame.input_time);
+        }
+        stream << (i + 1 < frames.size() ? " },\n" : " }\n");
+    }
+    stream << "  ]\n}\n";
+    return (bool)stream;
+}
+
+bool FrameProfiler::ExportCsv(const std::filesystem::path& filename) const {
+    auto frames = Frames();
+    std::ofstream stream(filename);
+
+    stream << "frame,frame_ms";
+    for (std::size_t phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+        stream << ',' << FramePhaseName((FramePhase)phase) << "_ms";
+    }
+    stream << ",input_latency_ms\n";
+
+    for (const auto& frame : frames) {
+        stream << frame.frame << ',' << TicksToMilliseconds(frame.end - frame.begin);
+        for (std::size_t phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+            stream << ',' << TicksToMilliseconds(frame.phase_ticks[phase]);
+        }
+        // Left empty for frames without new input.
+        stream << ',';
+        if (frame.input_time != 0) {
+            stream << TicksToMilliseconds(frame.end - frame.input_time);
+        }
+        stream << '\n';
+    }
+    return (bool)stream;
+}
+
+bool FrameProfiler::ExportChromeTrace(const std::filesystem::path& filename) const {
+    auto frames = Frames();
+    std::ofstream stream(filename);
+    if (frames.empty()) {
+        stream << "{ \"traceEvents\": [] }\n";
+        return (bool)stream;
+    }
+
+    // Complete ("X") events in microseconds from the first recorded frame.
+    auto origin = frames.front().begin;
+    auto microseconds = [&](std::int64_t ticks) {
+        return TicksToMilliseconds(ticks) * 1000.0;
+    };
+
+    bool first = true;
+    auto write_event = [&](std::string_view name, std::int64_t begin, std::int64_t duration) {
+        stream << (first ? "\n" : ",\n") << "  { \"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": "
+            << microseconds(begin - origin) << ", \"dur\": " << microseconds(duration) << " }";
+        first = false;
+    };
+
+    stream << "{ \"traceEvents\": [";
+    for (const auto& frame : frames) {
+        write_event("frame", frame.begin, frame.end - frame.begin);
+        for (std::size_t phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+            if (frame.phase_ticks[phase] > 0) {
+                write_event(FramePhaseName((FramePhase)phase), frame.phase_begin[phase], frame.phase_ticks[phase]);
+            }
+        }
+        if (frame.input_time != 0) {
+            // Counter track, so latency shows up as a graph above the frames.
+            stream << ",\n  { \"name\": \"input_latency\", \"ph\": \"C\", \"pid\": 1, \"ts\": "
+                << microseconds(frame.end - origin) << ", \"args\": { \"ms\": "
+                << TicksToMilliseconds(frame.end - frame.input_time) << " } }";
+        }
+    }
+    stream << "\n], \"displayTimeUnit\": \"ms\" }\n";
+    return (bool)stream;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Timer.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+enum class FramePhase : std::uint8_t {
+    Input,
+    Simulation,
+    Geometry,
+    DrawSubmission,
+    Present,
+    // Time blocked on the GPU, such as flushing the command batch in EndDraw.
+    Wait,
+    Count
+};
+
+constexpr std::size_t FRAME_PHASE_COUNT = (std::size_t)FramePhase::Count;
+
+std::string_view FramePhaseName(FramePhase phase);
+
+// Timings of one frame in Timer ticks. A phase that ran several times in the frame
+// keeps its first start and the sum of its durations.
+struct FrameTiming {
+    std::uint64_t frame = 0;
+    std::int64_t begin = 0, end = 0;
+    std::array<std::int64_t, FRAME_PHASE_COUNT> phase_begin = {};
+    std::array<std::int64_t, FRAME_PHASE_COUNT> phase_ticks = {};
+    // Newest input the frame shows, or 0 if it shows no new input. The frame's input
+    // latency runs from there to its end, after Present.
+    std::int64_t input_time = 0;
+};
+
+// Per-frame phase timings, kept for the last CAPACITY frames.
+//
+// One thread records frames: BeginFrame, any number of Zones, EndFrame. Finished
+// frames go into a ring buffer that other threads can read with Frames() without
+// locking; frames overwritten while being copied are dropped from the copy.
+//
+// While disabled, a Zone costs one branch and BeginFrame/EndFrame return at once.
+class FrameProfiler {
+public:
+    static constexpr std::size_t CAPACITY = 4096;
+
+    explicit FrameProfiler(Timer& timer);
+
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return enabled; }
+
+    void BeginFrame();
+    void EndFrame();
+
+    // Times its own lifetime as part of the current frame. A null profiler is allowed.
+    class Zone {
+    public:
+        Zone(FrameProfiler* profiler, FramePhase phase);
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        FrameProfiler* profiler;
+        FramePhase phase;
+        std::int64_t begin = 0;
+    };
+
+    void SetInputTime(std::int64_t ticks);
+
+    // Adds a phase timed outside a Zone, such as on another thread, to the current frame.
+    void AddPhase(FramePhase phase, std::int64_t begin, std::int64_t ticks);
+
+    // Oldest first.
+    std::vector<FrameTiming> Frames() const;
+
+    double TicksToMilliseconds(std::int64_t ticks) const;
+
+    // p50/p95/p99 of every phase, the whole frame and input latency, plus the raw frames.
+    bool ExportJson(const std::filesystem::path& filename) const;
+    // One row per frame, durations in milliseconds.
+    bool ExportCsv(const std::filesystem::path& filename) const;
+    // Chrome trace event format, for chrome://tracing or Perfetto.
+    bool ExportChromeTrace(const std::filesystem::path& filename) const;
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> sequence = 0;
+        FrameTiming timing;
+    };
+
+    Timer& timer;
+    bool enabled = false;
+    bool in_frame = false;
+    FrameTiming current;
+    std::uint64_t frame_counter = 0;
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<std::uint64_t> written = 0;
+};
@@ -0,0 +1,202 @@
+#include "Rasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+constexpr float MAX_COORDINATE = (float)(1 << 20);
+
+std::int32_t ToFixed(float value) {
+    value = std::clamp(value, -MAX_COORDINATE, MAX_COORDINATE);
+    return (std::int32_t)std::lround(value * SUBPIXEL_ONE);
+}
+
+std::int32_t FloorDiv(std::int32_t value) {
+    return value >> SUBPIXEL_SHIFT;
+}
+
+}
+
+void AppendEdge(std::vector<Edge>& edges, Point a, Point b) {
+    auto x0 = ToFixed(a.x), y0 = ToFixed(a.y);
+    auto x1 = ToFixed(b.x), y1 = ToFixed(b.y);
+
+    if (y0 == y1) {
+        return;
+    }
+    if (y0 < y1) {
+        edges.push_back({ x0, y0, x1, y1, 1 });
+    }
+    else {
+        edges.push_back({ x1, y1, x0, y0, -1 });
+    }
+}
+
+void AppendPolygons(std::vector<Edge>& edges, FlatPathView path) {
+    for (const auto& figure : path.figures) {
+        if (!figure.filled || figure.point_count < 2) {
+            continue;
+        }
+
+        const auto* points = &path.points[figure.first_point];
+        for (std::size_t i = 1; i < figure.point_count; i++) {
+            AppendEdge(edges, points[i - 1], points[i]);
+        }
+        // Filling always treats figures as closed.
+        AppendEdge(edges, points[figure.point_count - 1], points[0]);
+    }
+}
+
+IntRect EdgeBounds(std::span<const Edge> edges) {
+    if (edges.empty()) {
+        return {};
+    }
+
+    auto left = std::min(edges[0].x0, edges[0].x1), right = std::max(edges[0].x0, edges[0].x1);
+    auto top = edges[0].y0, bottom = edges[0].y1;
+    for (const auto& edge : edges) {
+        left = std::min({ left, edge.x0, edge.x1 });
+        right = std::max({ right, edge.x0, edge.x1 });
+        top = std::min(top, edge.y0);
+        bottom = std::max(bottom, edge.y1);
+    }
+
+    return {
+        FloorDiv(left), FloorDiv(top),
+        FloorDiv(right + SUBPIXEL_ONE - 1) + 1, FloorDiv(bottom + SUBPIXEL_ONE - 1)
+    };
+}
+
+void Rasterizer::Reset(const IntRect& new_clip) {
+    clip = new_clip;
+    if (clip.IsEmpty()) {
+        clip = {};
+    }
+
+    // One extra cell per row receives the spill-over of the rightmost pixel.
+    row_stride = clip.Width() + 1;
+    cells.assign((std::size_t)row_stride * clip.Height(), 0);
+    backdrop.assign(clip.Height(), 0);
+    coverage.resize(clip.Width());
+    touched_top = touched_bottom = clip.top;
+}
+
+void Rasterizer::AddEdges(std::span<const Edge> edges) {
+    for (const auto& edge : edges) {
+        AddEdge(edge);
+    }
+}
+
+void Rasterizer::AddEdge(const Edge& edge) {
+    if (clip.IsEmpty()) {
+        return;
+    }
+
+    auto first_row = std::max(FloorDiv(edge.y0), clip.top);
+    auto last_row = std::min(FloorDiv(edge.y1 - 1), clip.bottom - 1);
+    if (first_row > last_row) {
+        return;
+    }
+
+    if (touched_top == touched_bottom) {
+        touched_top = first_row;
+        touched_bottom = last_row + 1;
+    }
+    else {
+        touched_top = std::min(touched_top, first_row);
+        touched_bottom = std::max(touched_bottom, last_row + 1);
+    }
+
+    // x at a row boundary is always derived from the original endpoints, so every
+    // clip rectangle sees exactly the same row segments.
+    auto x_at = [&](std::int32_t y) {
+        return edge.x0 + (std::int32_t)((std::int64_t)(edge.x1 - edge.x0) * (y - edge.y0) / (edge.y1 - edge.y0));
+    };
+
+    for (auto row = first_row; row <= last_row; row++) {
+        auto ya = std::max(edge.y0, row << SUBPIXEL_SHIFT);
+        auto yb = std::min(edge.y1, (row + 1) << SUBPIXEL_SHIFT);
+        auto xa = (ya == edge.y0) ? edge.x0 : x_at(ya);
+        auto xb = (yb == edge.y1) ? edge.x1 : x_at(yb);
+        AddRowSegment(row, xa, ya, xb, yb, edge.dir);
+    }
+}
+
+void Rasterizer::AddRowSegment(int row, std::int32_t xa, std::int32_t ya, std::int32_t xb, std::int32_t yb, std::int32_t dir) {
+    auto* cell_row = &cells[(std::size_t)(row - clip.top) * row_stride];
+    auto& row_backdrop = backdrop[row - clip.top];
+
+    // Walk left to right; dy of each piece is positive and dir carries the winding.
+    if (xa > xb) {
+        std::swap(xa, xb);
+        std::swap(ya, yb);
+    }
+
+    auto y_at = [&](std::int32_t x) {
+        return ya + (std::int32_t)((std::int64_t)(yb - ya) * (x - xa) / (xb - xa));
+    };
+
+    auto add_piece = [&](int cell, std::int32_t px0, std::int32_t py0, std::int32_t px1, std::int32_t py1) {
+        auto dy = py1 > py0 ? py1 - py0 : py0 - py1;
+        if (dy == 0) {
+            return;
+        }
+
+        auto total = dy * SUBPIXEL_ONE;
+        if (cell < clip.left) {
+            row_backdrop += dir * total;
+            return;
+        }
+        if (cell >= clip.right) {
+            return;
+        }
+
+        // Area right of the edge inside this cell, the rest spills into the next cell.
+        auto mid_x2 = px0 + px1 - 2 * (cell << SUBPIXEL_SHIFT);
+        auto spill = (dy * mid_x2) >> 1;
+        cell_row[cell - clip.left] += dir * (total - spill);
+        cell_row[cell - clip.left + 1] += dir * spill;
+    };
+
+    auto first_cell = FloorDiv(xa);
+    auto last_cell = (xb > xa) ? FloorDiv(xb - 1) : first_cell;
+    if (first_cell == last_cell) {
+        add_piece(first_cell, xa, ya, xb, yb);
+        return;
+    }
+
+    // Everything left of the clip collapses into the backdrop in one step.
+    auto cell = first_cell;
+    auto px = xa;
+    auto py = ya;
+    if (cell < clip.left) {
+        auto bx = clip.left << SUBPIXEL_SHIFT;
+        if (xb <= bx) {
+            add_piece(cell, xa, ya, xb, yb);
+            return;
+        }
+        auto by = y_at(bx);
+        auto dy = by > py ? by - py : py - by;
+        row_backdrop += dir * dy * SUBPIXEL_ONE;
+        cell = clip.left;
+        px = bx;
+        py = by;
+    }
+
+    auto stop_cell = std::min(last_cell, clip.right - 1);
+    for (; cell <= stop_cell; cell++) {
+        auto bx = (cell + 1) << SUBPIXEL_SHIFT;
+        if (cell == last_cell || bx >= xb) {
+            add_piece(cell, px, py, xb, yb);
+            return;
+        }
+        auto by = y_at(bx);
+        add_piece(cell, px, py, bx, by);
+        px = bx;
+        py = by;
+    }
+}
+
+}
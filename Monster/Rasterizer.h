@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Geometry.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace gfx {
+
+// Line segment in 24.8 fixed point, stored top to bottom. dir is +1 for edges that
+// go down in the source path and -1 for edges that go up.
+struct Edge {
+    std::int32_t x0, y0, x1, y1;
+    std::int32_t dir;
+};
+
+constexpr int SUBPIXEL_SHIFT = 8;
+constexpr int SUBPIXEL_ONE = 1 << SUBPIXEL_SHIFT;
+// Accumulated area of a fully covered pixel.
+constexpr int COVERAGE_ONE = SUBPIXEL_ONE * SUBPIXEL_ONE;
+
+void AppendEdge(std::vector<Edge>& edges, Point a, Point b);
+// Appends the edges of every filled figure, closing each one.
+void AppendPolygons(std::vector<Edge>& edges, FlatPathView path);
+IntRect EdgeBounds(std::span<const Edge> edges);
+
+// Anti-aliased scanline rasterizer using exact area coverage.
+//
+// Every edge is walked cell by cell and its signed area is written into an
+// accumulation buffer; a prefix sum along each row then yields the winding-weighted
+// coverage of each pixel. All arithmetic is integer, so the result does not depend
+// on the order in which edges are added, and contributions left of the clip
+// rectangle are folded into a per-row backdrop instead of being dropped.
+class Rasterizer {
+public:
+    void Reset(const IntRect& clip);
+    void AddEdge(const Edge& edge);
+    void AddEdges(std::span<const Edge> edges);
+
+    const IntRect& Clip() const { return clip; }
+
+    // Resolves the accumulated edges into 8-bit coverage and calls
+    // span(y, x, length, coverage) for every row of the clip rectangle that was
+    // touched. Resets the accumulation buffer as it goes.
+    template <typename SpanFunction>
+    void Sweep(SpanFunction&& span);
+
+private:
+    IntRect clip;
+    int row_stride = 0;
+    std::vector<std::int32_t> cells;
+    std::vector<std::int32_t> backdrop;
+    std::vector<std::uint8_t> coverage;
+    int touched_top = 0, touched_bottom = 0;
+
+    void AddRowSegment(int row, std::int32_t xa, std::int32_t ya, std::int32_t xb, std::int32_t yb, std::int32_t dir);
+};
+
+template <typename SpanFunction>
+void Rasterizer::Sweep(SpanFunction&& span) {
+    auto width = clip.Width();
+
+    for (auto y = touched_top; y < touched_bottom; y++) {
+        auto* row = &cells[(std::size_t)(y - clip.top) * row_stride];
+        auto sum = backdrop[y - clip.top];
+        backdrop[y - clip.top] = 0;
+
+        for (int x = 0; x < width; x++) {
+            sum += row[x];
+            row[x] = 0;
+            auto area = sum < 0 ? -sum : sum;
+            if (area > COVERAGE_ONE) {
+                area = COVERAGE_ONE;
+            }
+            coverage[x] = (std::uint8_t)((area * 255 + COVERAGE_ONE / 2) >> (2 * SUBPIXEL_SHIFT));
+        }
+        row[width] = 0;
+
+        span(y, clip.left, width, coverage.data());
+    }
+
+    touched_top = touched_bottom = clip.top;
+}
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "Crowd.h"
+
+// Something that can draw a SceneState or a whole Crowd: the Direct2D swap chain
+// path or the portable CPU rasterizer.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual void Render(const SceneState& scene) = 0;
+    virtual void RenderCrowd(const Crowd& crowd) = 0;
+};
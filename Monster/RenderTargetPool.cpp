@@ -0,0 +1,55 @@
+#include "RenderTargetPool.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+constexpr std::uint32_t MIN_SIZE_CLASS = 64;
+
+}
+
+std::uint32_t SizeClass(std::uint32_t size) {
+    if (size <= MIN_SIZE_CLASS) {
+        return MIN_SIZE_CLASS;
+    }
+
+    // 1024, 1280, 1536, 1792, 2048, 2560 and so on.
+    auto step = std::bit_floor(size) / 4;
+    return (size + step - 1) / step * step;
+}
+
+bool TargetSizer::Update(std::uint32_t width, std::uint32_t height, bool resizing, Duration now) {
+    auto fit_width = Fit(width), fit_height = Fit(height);
+
+    if (width > allocated_width || height > allocated_height) {
+        allocated_width = resizing ? std::max(fit_width, allocated_width) : fit_width;
+        allocated_height = resizing ? std::max(fit_height, allocated_height) : fit_height;
+        shrink_pending = false;
+        return true;
+    }
+
+    if (resizing || (fit_width == allocated_width && fit_height == allocated_height)) {
+        shrink_pending = false;
+        return false;
+    }
+
+    if (!shrink_pending || fit_width != shrink_width || fit_height != shrink_height) {
+        shrink_pending = true;
+        shrink_width = fit_width;
+        shrink_height = fit_height;
+        shrink_since = now;
+        return false;
+    }
+    if (now - shrink_since < SETTLE) {
+        return false;
+    }
+
+    allocated_width = fit_width;
+    allocated_height = fit_height;
+    shrink_pending = false;
+    return true;
+}
+
+std::uint32_t TargetSizer::Fit(std::uint32_t size) {
+    return std::max(std::min(SizeClass(size), MAX_SIZE), size);
+}
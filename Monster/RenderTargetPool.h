@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Render targets are allocated at the size class of what they show rather than at its
+// exact size, so a window resized by a few pixels keeps its targets and only changes
+// how much of them it uses. Classes are a quarter of a power of two apart, which
+// leaves at most 25% slack in each dimension.
+std::uint32_t SizeClass(std::uint32_t size);
+
+// What a pooled target is looked up by: its size class, and a format standing for
+// everything else targets have to agree on to be shared, such as pixel format or DPI.
+struct TargetKey {
+    std::uint32_t width = 0, height = 0;
+    std::uint32_t format = 0;
+
+    static TargetKey ForSize(std::uint32_t width, std::uint32_t height, std::uint32_t format = 0) {
+        return { SizeClass(width), SizeClass(height), format };
+    }
+
+    bool operator==(const TargetKey&) const = default;
+};
+
+// Targets that are not in use, kept for the next request of the same key. Target is
+// anything movable that owns one, like a pixel buffer or a COM pointer to a bitmap.
+//
+// Resizing back and forth across a size class boundary, as a window edge being dragged
+// does, then swaps between pooled targets instead of allocating new ones.
+template <class Target>
+class RenderTargetPool {
+public:
+    // Idle targets beyond this are dropped, oldest first.
+    static constexpr std::size_t MAX_IDLE = 4;
+
+    // An idle target of key if there is one, otherwise create(key).
+    template <class Create>
+    Target Acquire(const TargetKey& key, Create&& create) {
+        for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+            if (it->key == key) {
+                auto target = std::move(it->target);
+                idle.erase(std::next(it).base());
+                return target;
+            }
+        }
+        allocations++;
+        return create(key);
+    }
+
+    void Release(const TargetKey& key, Target target) {
+        if (idle.size() == MAX_IDLE) {
+            idle.erase(idle.begin());
+        }
+        idle.push_back({ key, std::move(target) });
+    }
+
+    // Drops every idle target, for when they can't be used anymore.
+    void Clear() { idle.clear(); }
+
+    // Targets created by Acquire so far.
+    std::uint64_t Allocations() const { return allocations; }
+
+private:
+    struct Entry {
+        TargetKey key;
+        Target target;
+    };
+
+    // Oldest first.
+    std::vector<Entry> idle;
+    std::uint64_t allocations = 0;
+};
+
+// Decides the size a window's render target is allocated at as the window is resized.
+//
+// A target that is too small is reallocated right away, one size class up. While the
+// window is being resized, it never shrinks, and each dimension keeps the largest
+// class it has reached, so dragging an edge reallocates once per class at most. After
+// that, a target of a larger class than needed shrinks once the size has stayed the
+// same for SETTLE.
+//
+// Like FrameScheduler, it never reads a clock: the caller passes the time.
+class TargetSizer {
+public:
+    using Duration = std::chrono::nanoseconds;
+
+    static constexpr Duration SETTLE = std::chrono::milliseconds(300);
+    // The largest texture Direct3D 11 allows.
+    static constexpr std::uint32_t MAX_SIZE = 16384;
+
+    // Returns true if the target has to be allocated again, at AllocatedWidth() x
+    // AllocatedHeight(), to show width x height pixels. resizing is whether the user is
+    // still resizing the window.
+    bool Update(std::uint32_t width, std::uint32_t height, bool resizing, Duration now);
+
+    std::uint32_t AllocatedWidth() const { return allocated_width; }
+    std::uint32_t AllocatedHeight() const { return allocated_height; }
+    // Whether a smaller allocation is waiting for the size to settle, so Update has to
+    // be called again even if nothing changes.
+    bool Settling() const { return shrink_pending; }
+
+private:
+    std::uint32_t allocated_width = 0, allocated_height = 0;
+
+    // Smaller allocation waiting for the size to settle, and since when.
+    bool shrink_pending = false;
+    std::uint32_t shrink_width = 0, shrink_height = 0;
+    Duration shrink_since{ 0 };
+
+    static std::uint32_t Fit(std::uint32_t size);
+};
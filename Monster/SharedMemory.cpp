@@ -0,0 +1,169 @@
+#include "SharedMemory.h"
+#include <cstdint>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+// Local\ keeps the name to this session, which needs no privileges.
+std::wstring MappingName(const std::string& name) {
+    return L"Local\\" + std::wstring(name.begin(), name.end());
+}
+#else
+// POSIX names start with a slash and have no other.
+std::string ObjectName(const std::string& name) {
+    return name.starts_with('/') ? name : "/" + name;
+}
+#endif
+
+}
+
+SharedMemory::~SharedMemory() {
+    Close();
+}
+
+SharedMemory::SharedMemory(SharedMemory&& other) noexcept
+    : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)),
+#ifdef _WIN32
+    mapping(std::exchange(other.mapping, nullptr)) {}
+#else
+    created_name(std::exchange(other.created_name, {})) {}
+#endif
+
+SharedMemory& SharedMemory::operator=(SharedMemory&& other) noexcept {
+    if (this != &other) {
+        Close();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+#ifdef _WIN32
+        mapping = std::exchange(other.mapping, nullptr);
+#else
+        created_name = std::exchange(other.created_name, {});
+#endif
+    }
+    return *this;
+}
+
+bool SharedMemory::Create(const std::string& name, std::size_t new_size) {
+    Close();
+    if (name.empty() || new_size == 0) {
+        return false;
+    }
+
+#ifdef _WIN32
+    // Pages backed by the paging file start out zeroed.
+    auto name_w = MappingName(name);
+    mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((std::uint64_t)new_size >> 32),
+        (DWORD)new_size, name_w.c_str());
+    if (!mapping) {
+        return false;
+    }
+    // A mapping that already existed keeps its old size, which may be too small.
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        Close();
+        return false;
+    }
+    data = static_cast<std::byte*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, new_size));
+    if (!data) {
+        Close();
+        return false;
+    }
+    size = new_size;
+#else
+    auto object_name = ObjectName(name);
+    shm_unlink(object_name.c_str());
+    auto file = shm_open(object_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (file < 0) {
+        return false;
+    }
+    created_name = object_name;
+
+    // Growing a new object zero fills it.
+    auto view = ftruncate(file, (off_t)new_size) == 0 ?
+        mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+    close(file);
+    if (view == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    data = static_cast<std::byte*>(view);
+    size = new_size;
+#endif
+    return true;
+}
+
+bool SharedMemory::Open(const std::string& name) {
+    Close();
+    if (name.empty()) {
+        return false;
+    }
+
+#ifdef _WIN32
+    auto name_w = MappingName(name);
+    mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, name_w.c_str());
+    if (!mapping) {
+        return false;
+    }
+    data = static_cast<std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    MEMORY_BASIC_INFORMATION info;
+    if (!data || VirtualQuery(data, &info, sizeof(info)) == 0) {
+        Close();
+        return false;
+    }
+    // Whole pages, which is at least what was asked for.
+    size = info.RegionSize;
+#else
+    auto file = shm_open(ObjectName(name).c_str(), O_RDONLY, 0);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        auto view = mmap(nullptr, (std::size_t)status.st_size, PROT_READ, MAP_SHARED, file, 0);
+        if (view != MAP_FAILED) {
+            data = static_cast<std::byte*>(view);
+            size = (std::size_t)status.st_size;
+        }
+    }
+    close(file);
+    if (!data) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+void SharedMemory::Close() {
+#ifdef _WIN32
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+#else
+    if (data) {
+        munmap(data, size);
+    }
+    // Processes that mapped it keep their view; it only stops being found by name.
+    if (!created_name.empty()) {
+        shm_unlink(created_name.c_str());
+        created_name.clear();
+    }
+#endif
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+// A named block of memory that other processes can map while this one has it open: a
+// file mapping in the Local namespace on Windows, a POSIX shared memory object on
+// Linux. Data() is empty until Create or Open succeeds.
+class SharedMemory {
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+
+    SharedMemory(SharedMemory&& other) noexcept;
+    SharedMemory& operator=(SharedMemory&& other) noexcept;
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Creates name with size zeroed bytes, readable and writable. Returns false if it
+    // can't be created, or on Windows if another process has one by that name. POSIX
+    // objects outlive a process that crashes, so on Linux one left under the name is
+    // replaced.
+    bool Create(const std::string& name, std::size_t size);
+    // Maps a block another process created, read-only. Returns false if there is none.
+    bool Open(const std::string& name);
+
+    std::span<std::byte> Data() const { return { data, size }; }
+
+private:
+    std::byte* data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    // The name only exists while a handle to the mapping is open.
+    void* mapping = nullptr;
+#else
+    // Created blocks are unlinked when closed.
+    std::string created_name;
+#endif
+
+    void Close();
+};
@@ -0,0 +1,44 @@
+#include "Simd.h"
+
+#if GFX_SIMD_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace gfx {
+
+namespace {
+
+SimdLevel QuerySimdLevel() {
+#if !GFX_SIMD_X86
+    return SimdLevel::Scalar;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool os_saves_state = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!fma || !os_saves_state || !avx) {
+        return SimdLevel::Sse2;
+    }
+
+    // The OS has to preserve the YMM registers across context switches.
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return SimdLevel::Sse2;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0 ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#endif
+}
+
+}
+
+SimdLevel DetectSimdLevel() {
+    static const SimdLevel level = QuerySimdLevel();
+    return level;
+}
+
+}
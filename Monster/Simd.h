@@ -0,0 +1,29 @@
+#pragma once
+
+// Compiler and CPU glue for the batched kernels that have hand-written x86 paths.
+// Kernels always keep a scalar version, so other architectures still build.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GFX_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define GFX_SIMD_X86 0
+#endif
+
+// MSVC allows any intrinsic in any function; GCC and Clang need the instruction set
+// enabled per function so the rest of the file keeps the baseline target.
+#if GFX_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define GFX_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define GFX_TARGET_AVX2
+#endif
+
+namespace gfx {
+
+// Instruction sets the kernels have code paths for, from slowest to fastest.
+enum class SimdLevel { Scalar, Sse2, Avx2 };
+
+// Best level supported by both the CPU and the OS. Detected once.
+SimdLevel DetectSimdLevel();
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Geometry.h"
+#include "SvgPath.h"
+#include <array>
+#include <string_view>
+
+// Paths and flattened paths baked into fixed-size arrays at compile time, for shapes
+// that never change. They are built with the same constexpr Path, ParseSvgPath and
+// FlattenPathAdaptive as at runtime, once to size the arrays and once to fill them,
+// and cost nothing at startup. They have the same points as runtime parsing and
+// flattening, except that arcs, through ConstexprMath, may land a unit in the last
+// place away.
+namespace gfx {
+
+struct StaticPathSize {
+    std::size_t points = 0, verbs = 0, figures = 0;
+};
+
+template <StaticPathSize size>
+struct StaticPath {
+    std::array<Point, size.points> points{};
+    std::array<PathVerb, size.verbs> verbs{};
+    std::array<PathFigure, size.figures> figures{};
+    Rect control_bounds;
+
+    // Copies the arrays into path, without going through its sink methods.
+    void CopyTo(Path& path) const { path.Assign(points, verbs, figures); }
+    void Replay(PathSink& sink) const { ReplayPath(points, verbs, figures, sink); }
+};
+
+struct StaticFlatSize {
+    std::size_t points = 0, figures = 0;
+};
+
+template <StaticFlatSize size>
+struct StaticFlatPath {
+    std::array<Point, size.points> points{};
+    std::array<FlatFigure, size.figures> figures{};
+    Rect bounds;
+
+    FlatPathView View() const { return { points, figures }; }
+};
+
+// Path data parsed at compile time. data has to be a constant with static storage, such
+// as a static constexpr std::string_view member.
+template <const std::string_view& data, FigureBegin begin>
+constexpr Path ParsedSvgPath() {
+    Path path;
+    ParseSvgPath(data, path, begin);
+    return path;
+}
+
+template <const std::string_view& data, FigureBegin begin>
+constexpr StaticPathSize SvgPathSize() {
+    auto path = ParsedSvgPath<data, begin>();
+    return { path.Points().size(), path.Verbs().size(), path.Figures().size() };
+}
+
+template <const std::string_view& data, FigureBegin begin>
+constexpr auto BakeSvgPath() {
+    auto path = ParsedSvgPath<data, begin>();
+    StaticPath<SvgPathSize<data, begin>()> result;
+    std::copy(path.Points().begin(), path.Points().end(), result.points.begin());
+    std::copy(path.Verbs().begin(), path.Verbs().end(), result.verbs.begin());
+    std::copy(path.Figures().begin(), path.Figures().end(), result.figures.begin());
+    result.control_bounds = path.ControlBounds();
+    return result;
+}
+
+// shape, a StaticPath, flattened in its own space with FlattenPathAdaptive.
+template <const auto& shape, float tolerance>
+constexpr FlattenedPath FlattenedStaticPath() {
+    Path path;
+    path.Assign(shape.points, shape.verbs, shape.figures);
+    FlattenedPath flattened;
+    FlattenPathAdaptive(path, Matrix3x2::Identity(), tolerance, flattened);
+    return flattened;
+}
+
+template <const auto& shape, float tolerance>
+constexpr StaticFlatSize FlatSize() {
+    auto flattened = FlattenedStaticPath<shape, tolerance>();
+    return { flattened.points.size(), flattened.figures.size() };
+}
+
+template <const auto& shape, float tolerance>
+constexpr auto BakeFlattened() {
+    auto flattened = FlattenedStaticPath<shape, tolerance>();
+    StaticFlatPath<FlatSize<shape, tolerance>()> result;
+    std::copy(flattened.points.begin(), flattened.points.end(), result.points.begin());
+    std::copy(flattened.figures.begin(), flattened.figures.end(), result.figures.begin());
+    result.bounds = flattened.Bounds();
+    return result;
+}
+
+}
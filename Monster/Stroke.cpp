@@ -0,0 +1,307 @@
+#include "Stroke.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace gfx {
+
+namespace {
+
+constexpr float EPSILON = 1e-5f;
+
+Point Add(Point a, Point b) { return { a.x + b.x, a.y + b.y }; }
+Point Subtract(Point a, Point b) { return { a.x - b.x, a.y - b.y }; }
+Point Multiply(Point a, float s) { return { a.x * s, a.y * s }; }
+float Dot(Point a, Point b) { return a.x * b.x + a.y * b.y; }
+float Cross(Point a, Point b) { return a.x * b.y - a.y * b.x; }
+
+Point Normalize(Point v) {
+    auto length = std::sqrt(Dot(v, v));
+    return length > 0.0f ? Multiply(v, 1.0f / length) : Point{};
+}
+
+// Left of the direction in a y-down coordinate system, half_width long.
+Point Normal(Point direction, float half_width) {
+    return { -direction.y * half_width, direction.x * half_width };
+}
+
+bool SamePoint(Point a, Point b) {
+    return std::abs(a.x - b.x) + std::abs(a.y - b.y) <= EPSILON;
+}
+
+class Outliner {
+public:
+    Outliner(const StrokeStyle& style, float tolerance, FlattenedPath& output, FrameArena* scratch)
+        : style(style), half_width(style.width * 0.5f), tolerance(tolerance), output(output), points(scratch) {}
+
+    void Figure(std::span<const Point> input, bool closed);
+
+private:
+    const StrokeStyle& style;
+    float half_width;
+    float tolerance;
+    FlattenedPath& output;
+    // The figure without repeated points.
+    ArenaVector<Point> points;
+    std::size_t polygon_start = 0;
+
+    void BeginPolygon() { polygon_start = output.points.size(); }
+    void AddPoint(Point p) { output.points.push_back(p); }
+    void EndPolygon();
+
+    // Points around center from just past start, turning by angle radians.
+    void AddArc(Point center, Point start, float angle);
+
+    void Segment(Point a, Point b);
+    void Join(Point a, Point b, Point c);
+    // direction points away from the stroke.
+    void Cap(Point p, Point direction);
+    // A figure that never leaves its start point.
+    void Dot(Point p);
+};
+
+void Outliner::Figure(std::span<const Point> input, bool closed) {
+    points.clear();
+    for (auto p : input) {
+        if (points.empty() || !SamePoint(p, points.back())) {
+            points.push_back(p);
+        }
+    }
+    if (closed && points.size() > 1 && SamePoint(points.front(), points.back())) {
+        points.pop_back();
+    }
+    if (points.empty()) {
+        return;
+    }
+    if (points.size() == 1) {
+        if (!closed) {
+            Dot(points[0]);
+        }
+        return;
+    }
+
+    auto count = points.size();
+    auto segments = closed ? count : count - 1;
+    for (std::size_t i = 0; i < segments; i++) {
+        Segment(points[i], points[(i + 1) % count]);
+    }
+
+    auto first_join = closed ? 0 : 1;
+    auto last_join = closed ? count : count - 1;
+    for (auto i = (std::size_t)first_join; i < last_join; i++) {
+        Join(points[(i + count - 1) % count], points[i], points[(i + 1) % count]);
+    }
+
+    if (!closed) {
+        Cap(points[0], Normalize(Subtract(points[0], points[1])));
+        Cap(points[count - 1], Normalize(Subtract(points[count - 1], points[count - 2])));
+    }
+}
+
+void Outliner::EndPolygon() {
+    auto first = output.points.begin() + polygon_start;
+    auto count = output.points.size() - polygon_start;
+
+    auto area = 0.0f;
+    for (std::size_t i = 0; i < count; i++) {
+        area += Cross(first[i], first[(i + 1) % count]);
+    }
+    if (count < 3 || area == 0.0f) {
+        output.points.resize(polygon_start);
+        return;
+    }
+
+    // Everything winds with negative area, so overlaps add up instead of cancelling out.
+    if (area > 0.0f) {
+        std::reverse(first, output.points.end());
+    }
+
+    FlatFigure figure;
+    figure.first_point = (std::uint32_t)polygon_start;
+    figure.point_count = (std::uint32_t)count;
+    figure.filled = true;
+    figure.closed = true;
+    output.figures.push_back(figure);
+}
+
+void Outliner::AddArc(Point center, Point start, float angle) {
+    // Largest step whose chord stays within tolerance of the circle.
+    auto ratio = std::clamp(1.0f - tolerance / half_width, -1.0f, 1.0f);
+    auto max_step = std::max(2.0f * std::acos(ratio), 1e-3f);
+    auto steps = std::clamp((int)std::ceil(std::abs(angle) / max_step), 1, MAX_CUBIC_SEGMENTS);
+
+    auto offset = Subtract(start, center);
+    for (int i = 1; i <= steps; i++) {
+        auto a = angle * i / steps;
+        auto c = std::cos(a), s = std::sin(a);
+        AddPoint({ center.x + offset.x * c - offset.y * s, center.y + offset.x * s + offset.y * c });
+    }
+}
+
+void Outliner::Segment(Point a, Point b) {
+    auto n = Normal(Normalize(Subtract(b, a)), half_width);
+
+    BeginPolygon();
+    AddPoint(Add(a, n));
+    AddPoint(Add(b, n));
+    AddPoint(Subtract(b, n));
+    AddPoint(Subtract(a, n));
+    EndPolygon();
+}
+
+void Outliner::Join(Point a, Point b, Point c) {
+    auto d1 = Normalize(Subtract(b, a)), d2 = Normalize(Subtract(c, b));
+    auto cross = Cross(d1, d2);
+    auto reverses = std::abs(cross) <= EPSILON && gfx::Dot(d1, d2) < 0.0f;
+    if (std::abs(cross) <= EPSILON && !reverses) {
+        return;
+    }
+
+    // The gap opens on the side away from the turn.
+    auto side = cross > 0.0f ? -1.0f : 1.0f;
+    auto n1 = Multiply(Normal(d1, half_width), side), n2 = Multiply(Normal(d2, half_width), side);
+    auto p1 = Add(b, n1), p2 = Add(b, n2);
+
+    if (style.join == LineJoin::Round) {
+        BeginPolygon();
+        AddPoint(b);
+        AddPoint(p1);
+        // Where the path doubles back, the arc goes around the front.
+        AddArc(b, p1, reverses ? -std::numbers::pi_v<float> : std::atan2(Cross(n1, n2), gfx::Dot(n1, n2)));
+        EndPolygon();
+        return;
+    }
+
+    // Outward along the bisector; straight ahead where the path doubles back.
+    auto bisector = reverses ? d1 : Normalize(Add(n1, n2));
+    auto cos_half = gfx::Dot(bisector, n1) / half_width;
+    auto fits = cos_half > EPSILON && 1.0f / cos_half <= style.miter_limit;
+
+    BeginPolygon();
+    AddPoint(b);
+    AddPoint(p1);
+    if (style.join == LineJoin::Bevel || (style.join == LineJoin::MiterOrBevel && !fits)) {
+        // Nothing in between.
+    }
+    else if (fits) {
+        AddPoint(Add(b, Multiply(bisector, half_width / cos_half)));
+    }
+    else {
+        // Cut off square to the bisector, miter_limit half widths out.
+        auto along = gfx::Dot(d1, bisector);
+        auto extent = std::max((style.miter_limit * half_width - gfx::Dot(n1, bisector)) / along, 0.0f);
+        AddPoint(Add(p1, Multiply(d1, extent)));
+        AddPoint(Subtract(p2, Multiply(d2, extent)));
+    }
+    AddPoint(p2);
+    EndPolygon();
+}
+
+void Outliner::Cap(Point p, Point direction) {
+    auto n = Normal(direction, half_width);
+
+    switch (style.cap) {
+    case LineCap::Flat:
+        break;
+    case LineCap::Square:
+    {
+        auto out = Multiply(direction, half_width);
+        BeginPolygon();
+        AddPoint(Add(p, n));
+        AddPoint(Add(Add(p, n), out));
+        AddPoint(Add(Subtract(p, n), out));
+        AddPoint(Subtract(p, n));
+        EndPolygon();
+        break;
+    }
+    case LineCap::Round:
+        // Half a turn from one side to the other, through the direction.
+        BeginPolygon();
+        AddPoint(Add(p, n));
+        AddArc(p, Add(p, n), -std::numbers::pi_v<float>);
+        EndPolygon();
+        break;
+    }
+}
+
+void Outliner::Dot(Point p) {
+    switch (style.cap) {
+    case LineCap::Flat:
+        break;
+    case LineCap::Square:
+        BeginPolygon();
+        AddPoint({ p.x - half_width, p.y - half_width });
+        AddPoint({ p.x + half_width, p.y - half_width });
+        AddPoint({ p.x + half_width, p.y + half_width });
+        AddPoint({ p.x - half_width, p.y + half_width });
+        EndPolygon();
+        break;
+    case LineCap::Round:
+    {
+        Point start = { p.x + half_width, p.y };
+        BeginPolygon();
+        AddPoint(start);
+        AddArc(p, start, 2.0f * std::numbers::pi_v<float>);
+        output.points.pop_back();
+        EndPolygon();
+        break;
+    }
+    }
+}
+
+}
+
+void StrokePath(FlatPathView path, const StrokeStyle& style, float tolerance, FlattenedPath& output,
+    FrameArena* scratch) {
+    if (!(style.width > 0.0f)) {
+        return;
+    }
+
+    Outliner outliner(style, tolerance, output, scratch);
+    for (const auto& figure : path.figures) {
+        outliner.Figure(path.points.subspan(figure.first_point, figure.point_count), figure.closed);
+    }
+}
+
+FlatPathView StrokeCache::Get(const Path& path, const Matrix3x2& transformation, const StrokeStyle& style,
+    FlatteningCache& flattening_cache) {
+    use_counter++;
+
+    auto level = FlatteningCache::LevelOfDetail(transformation.MaxScale());
+    for (auto& entry : entries) {
+        if (entry.path == &path && entry.level == level && entry.style == style) {
+            entry.last_use = use_counter;
+            return entry.outline;
+        }
+    }
+
+    // Reuse the least recently used entry once the cache is full.
+    Entry* entry;
+    if (entries.size() < MAX_ENTRIES) {
+        entry = &entries.emplace_back();
+    }
+    else {
+        entry = &*std::min_element(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.last_use < b.last_use;
+        });
+    }
+
+    entry->path = &path;
+    entry->level = level;
+    entry->style = style;
+    entry->last_use = use_counter;
+    entry->outline.Clear();
+    StrokePath(flattening_cache.Get(path, transformation), style,
+        FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(level), entry->outline);
+    return entry->outline;
+}
+
+void StrokeCache::Invalidate(const Path& path) {
+    std::erase_if(entries, [&](const Entry& entry) { return entry.path == &path; });
+}
+
+void StrokeCache::Clear() {
+    entries.clear();
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FlatteningCache.h"
+#include "FrameArena.h"
+#include "Geometry.h"
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Same shapes as D2D1_LINE_JOIN: Miter cuts off miters past the limit, MiterOrBevel
+// bevels them instead.
+enum class LineJoin { Miter, Bevel, Round, MiterOrBevel };
+enum class LineCap { Flat, Square, Round };
+
+// Defaults match Direct2D's default stroke style.
+struct StrokeStyle {
+    float width = 1.0f;
+    LineJoin join = LineJoin::Miter;
+    LineCap cap = LineCap::Flat;
+    // In half widths, measured from the joint.
+    float miter_limit = 10.0f;
+    // The width is in target pixels whatever the transformation, like
+    // D2D1_STROKE_TRANSFORM_TYPE_HAIRLINE.
+    bool hairline = false;
+
+    bool operator==(const StrokeStyle&) const = default;
+};
+
+// Appends the outline of every figure to output as closed, filled polygons: one per
+// segment, join and cap. They all wind the same way, so a nonzero fill draws their
+// union. Round joins and caps stay within tolerance of a true arc. Scratch memory comes
+// from scratch if there is one, and from the heap otherwise.
+void StrokePath(FlatPathView path, const StrokeStyle& style, float tolerance, FlattenedPath& output,
+    FrameArena* scratch = nullptr);
+
+// Outlines of paths in their own local space, one per level of detail and stroke style,
+// so a stroke drawn again at another angle or position only needs its outline
+// transformed. Levels are FlatteningCache's.
+//
+// Entries are keyed by the address of the path, like FlatteningCache. Hairlines
+// depend on the whole transformation and are never cached.
+class StrokeCache {
+public:
+    static constexpr std::size_t MAX_ENTRIES = 64;
+
+    // The view stays valid until the next call to Get, Invalidate or Clear.
+    FlatPathView Get(const Path& path, const Matrix3x2& transformation, const StrokeStyle& style,
+        FlatteningCache& flattening_cache);
+
+    void Invalidate(const Path& path);
+    void Clear();
+
+    std::size_t Size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        const Path* path = nullptr;
+        int level = 0;
+        StrokeStyle style;
+        std::uint64_t last_use = 0;
+        FlattenedPath outline;
+    };
+
+    std::vector<Entry> entries;
+    std::uint64_t use_counter = 0;
+};
+
+}
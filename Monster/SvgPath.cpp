@@ -0,0 +1,15 @@
+#include "SvgPath.h"
+#include "MappedFile.h"
+
+namespace gfx {
+
+bool LoadSvgPath(const std::filesystem::path& filename, PathSink& sink, FigureBegin begin) {
+    MappedFile file(filename);
+    auto data = file.Data();
+    if (data.empty()) {
+        return false;
+    }
+    return ParseSvgPath({ reinterpret_cast<const char*>(data.data()), data.size() }, sink, begin);
+}
+
+}
@@ -0,0 +1,359 @@
+#pragma once
+
+#include "Geometry.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+
+namespace gfx {
+
+// What ParseSvgPath runs. All of it is constexpr, so path data can also be parsed at
+// compile time, into a Path and from there into a StaticPath.
+class SvgPathParser {
+public:
+    constexpr SvgPathParser(std::string_view data, PathSink& sink, FigureBegin begin) : data(data), sink(sink), begin(begin) {}
+
+    constexpr bool Parse() {
+        char command = 0;
+        while (true) {
+            SkipSeparators();
+            if (position == data.size()) {
+                break;
+            }
+
+            auto c = data[position];
+            if (IsCommand(c)) {
+                // Path data has to start with a moveto.
+                if (command == 0 && c != 'M' && c != 'm') {
+                    return Fail();
+                }
+                command = c;
+                position++;
+            }
+            // More numbers repeat the previous command; only Z takes none.
+            else if (!IsNumberStart(c) || command == 0 || command == 'Z' || command == 'z') {
+                return Fail();
+            }
+
+            if (!Command(command)) {
+                return Fail();
+            }
+
+            // Coordinates after a moveto are implicit linetos.
+            if (command == 'M') {
+                command = 'L';
+            }
+            else if (command == 'm') {
+                command = 'l';
+            }
+        }
+
+        EndFigure(FigureEnd::Open);
+        return true;
+    }
+
+private:
+    std::string_view data;
+    std::size_t position = 0;
+    PathSink& sink;
+    FigureBegin begin;
+
+    bool in_figure = false;
+    Point current = {}, figure_start = {};
+    // Control point of the previous segment, for the smooth commands S and T.
+    Point last_cubic_control = {}, last_quadratic_control = {};
+    bool has_cubic_control = false, has_quadratic_control = false;
+
+    static constexpr bool IsCommand(char c) {
+        switch (c) {
+        case 'M': case 'm': case 'Z': case 'z': case 'L': case 'l': case 'H': case 'h': case 'V': case 'v':
+        case 'C': case 'c': case 'S': case 's': case 'Q': case 'q': case 'T': case 't': case 'A': case 'a':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    static constexpr bool IsNumberStart(char c) {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.';
+    }
+
+    constexpr void SkipSeparators() {
+        while (position < data.size()) {
+            auto c = data[position];
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != ',') {
+                break;
+            }
+            position++;
+        }
+    }
+
+    constexpr bool Number(float& value) {
+        SkipSeparators();
+        // from_chars takes a leading minus but not a plus.
+        if (position < data.size() && data[position] == '+') {
+            position++;
+        }
+        if (std::is_constant_evaluated()) {
+            return Decimal(value);
+        }
+
+        const auto* first = data.data() + position;
+        const auto* last = data.data() + data.size();
+        auto [end, error] = std::from_chars(first, last, value);
+        if (error != std::errc()) {
+            return false;
+        }
+        position += end - first;
+        return true;
+    }
+
+    // Stands in for from_chars, which can't run at compile time, with the same syntax.
+    // Scales the digits by an exact power of ten in double, which is exact for the
+    // short decimals path data is made of.
+    constexpr bool Decimal(float& value) {
+        auto index = position;
+        auto is_digit = [&](std::size_t i) { return i < data.size() && data[i] >= '0' && data[i] <= '9'; };
+
+        auto negative = index < data.size() && data[index] == '-';
+        index += negative ? 1 : 0;
+
+        // Digits past the 19th, which don't fit, only move the decimal point.
+        std::uint64_t digits = 0;
+        int exponent = 0, digit_count = 0;
+        auto add_digit = [&](char c, bool fraction) {
+            if (digits < 100000000000000000ull) {
+                digits = digits * 10 + (std::uint64_t)(c - '0');
+                exponent -= fraction ? 1 : 0;
+            }
+            else {
+                exponent += fraction ? 0 : 1;
+            }
+            digit_count++;
+        };
+        for (; is_digit(index); index++) {
+            add_digit(data[index], false);
+        }
+        if (index < data.size() && data[index] == '.') {
+            for (index++; is_digit(index); index++) {
+                add_digit(data[index], true);
+            }
+        }
+        if (digit_count == 0) {
+            return false;
+        }
+
+        // An exponent counts only with digits after the e and its sign.
+        if (index < data.size() && (data[index] == 'e' || data[index] == 'E')) {
+            auto next = index + 1;
+            auto exponent_negative = next < data.size() && data[next] == '-';
+            next += (next < data.size() && (data[next] == '-' || data[next] == '+')) ? 1 : 0;
+            if (is_digit(next)) {
+                int written = 0;
+                for (; is_digit(next); next++) {
+                    written = std::min(written * 10 + (data[next] - '0'), 1000);
+                }
+                exponent += exponent_negative ? -written : written;
+                index = next;
+            }
+        }
+
+        auto power = 1.0;
+        for (int i = 0; i < (exponent < 0 ? -exponent : exponent); i++) {
+            power *= 10.0;
+        }
+        auto result = exponent < 0 ? (double)digits / power : (double)digits * power;
+        value = (float)(negative ? -result : result);
+        position = index;
+        return true;
+    }
+
+    constexpr bool Coordinate(Point& point, bool relative) {
+        if (!Number(point.x) || !Number(point.y)) {
+            return false;
+        }
+        if (relative) {
+            point.x += current.x;
+            point.y += current.y;
+        }
+        return true;
+    }
+
+    // Arc flags are single digits that may run into the next number, as in "a5 5 0 0110 10".
+    constexpr bool Flag(bool& value) {
+        SkipSeparators();
+        if (position == data.size() || (data[position] != '0' && data[position] != '1')) {
+            return false;
+        }
+        value = data[position++] == '1';
+        return true;
+    }
+
+    constexpr bool Command(char command) {
+        bool relative = command >= 'a';
+        bool cubic = false, quadratic = false;
+
+        switch (command) {
+        case 'M': case 'm':
+        {
+            Point point;
+            if (!Coordinate(point, relative)) {
+                return false;
+            }
+            EndFigure(FigureEnd::Open);
+            sink.BeginFigure(point, begin);
+            in_figure = true;
+            current = figure_start = point;
+            break;
+        }
+        case 'Z': case 'z':
+            EndFigure(FigureEnd::Closed);
+            current = figure_start;
+            break;
+        case 'L': case 'l':
+        {
+            Point point;
+            if (!Coordinate(point, relative)) {
+                return false;
+            }
+            LineTo(point);
+            break;
+        }
+        case 'H': case 'h':
+        {
+            float x;
+            if (!Number(x)) {
+                return false;
+            }
+            LineTo({ relative ? current.x + x : x, current.y });
+            break;
+        }
+        case 'V': case 'v':
+        {
+            float y;
+            if (!Number(y)) {
+                return false;
+            }
+            LineTo({ current.x, relative ? current.y + y : y });
+            break;
+        }
+        case 'C': case 'c': case 'S': case 's':
+        {
+            Point control1, control2, end;
+            if (command == 'S' || command == 's') {
+                control1 = Reflect(last_cubic_control, has_cubic_control);
+            }
+            else if (!Coordinate(control1, relative)) {
+                return false;
+            }
+            if (!Coordinate(control2, relative) || !Coordinate(end, relative)) {
+                return false;
+            }
+            EnsureFigure();
+            sink.AddBezier(control1, control2, end);
+            last_cubic_control = control2;
+            current = end;
+            cubic = true;
+            break;
+        }
+        case 'Q': case 'q': case 'T': case 't':
+        {
+            Point control, end;
+            if (command == 'T' || command == 't') {
+                control = Reflect(last_quadratic_control, has_quadratic_control);
+            }
+            else if (!Coordinate(control, relative)) {
+                return false;
+            }
+            if (!Coordinate(end, relative)) {
+                return false;
+            }
+            EnsureFigure();
+            sink.AddQuadraticBezier(control, end);
+            last_quadratic_control = control;
+            current = end;
+            quadratic = true;
+            break;
+        }
+        case 'A': case 'a':
+        {
+            float radius_x, radius_y, rotation;
+            bool large_arc, sweep;
+            Point end;
+            if (!Number(radius_x) || !Number(radius_y) || !Number(rotation) ||
+                !Flag(large_arc) || !Flag(sweep) || !Coordinate(end, relative)) {
+                return false;
+            }
+            // Zero radii make a straight line (SVG implementation notes, F.6.6).
+            if (radius_x == 0.0f || radius_y == 0.0f) {
+                LineTo(end);
+                break;
+            }
+            EnsureFigure();
+            sink.AddArc({ end, math::Abs(radius_x), math::Abs(radius_y), rotation,
+                sweep ? SweepDirection::Clockwise : SweepDirection::CounterClockwise,
+                large_arc ? ArcSize::Large : ArcSize::Small });
+            current = end;
+            break;
+        }
+        }
+
+        has_cubic_control = cubic;
+        has_quadratic_control = quadratic;
+        return true;
+    }
+
+    constexpr Point Reflect(Point control, bool has_control) const {
+        if (!has_control) {
+            return current;
+        }
+        return { 2.0f * current.x - control.x, 2.0f * current.y - control.y };
+    }
+
+    constexpr void LineTo(Point point) {
+        EnsureFigure();
+        sink.AddLine(point);
+        current = point;
+    }
+
+    // Drawing after Z continues from where the closed figure started.
+    constexpr void EnsureFigure() {
+        if (!in_figure) {
+            sink.BeginFigure(current, begin);
+            in_figure = true;
+            figure_start = current;
+        }
+    }
+
+    constexpr void EndFigure(FigureEnd end) {
+        if (in_figure) {
+            sink.EndFigure(end);
+            in_figure = false;
+        }
+    }
+
+    constexpr bool Fail() {
+        EndFigure(FigureEnd::Open);
+        return false;
+    }
+};
+
+
+// Replays SVG path data (the d attribute of a <path>) into sink. Supports every path
+// command, absolute and relative: M, L, H, V, C, S, Q, T, A and Z. Every figure starts
+// with begin, since fill rules are not part of path data.
+//
+// Reads straight out of data without allocating. On a syntax error it stops, keeps the
+// figures parsed so far, as SVG renderers do, and returns false.
+constexpr bool ParseSvgPath(std::string_view data, PathSink& sink, FigureBegin begin = FigureBegin::Filled) {
+    return SvgPathParser(data, sink, begin).Parse();
+}
+
+// ParseSvgPath over a file holding nothing but path data, parsed from a read-only
+// mapping. Returns false if the file can't be opened or doesn't parse.
+bool LoadSvgPath(const std::filesystem::path& filename, PathSink& sink, FigureBegin begin = FigureBegin::Filled);
+
+}
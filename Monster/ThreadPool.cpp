@@ -0,0 +1,106 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned thread_count) : thread_count(std::max(1u, thread_count)) {
+    queues = std::make_unique<Queue[]>(this->thread_count);
+
+    for (unsigned thread = 1; thread < this->thread_count; thread++) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const Task& task) {
+    if (count == 0) {
+        return;
+    }
+    if (thread_count == 1) {
+        for (std::size_t index = 0; index < count; index++) {
+            task(index, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        current = &task;
+        remaining = count;
+
+        for (unsigned thread = 0; thread < thread_count; thread++) {
+            std::lock_guard queue_lock(queues[thread].mutex);
+            queues[thread].begin = count * thread / thread_count;
+            queues[thread].end = count * (thread + 1) / thread_count;
+        }
+
+        generation++;
+    }
+    wake.notify_all();
+
+    Participate(0);
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [&] { return remaining == 0; });
+    current = nullptr;
+}
+
+void ThreadPool::WorkerLoop(unsigned thread) {
+    unsigned seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        Participate(thread);
+    }
+}
+
+void ThreadPool::Participate(unsigned thread) {
+    std::size_t index;
+    while (Pop(thread, index)) {
+        (*current)(index, thread);
+
+        if (remaining.fetch_sub(1) == 1) {
+            std::lock_guard lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::Pop(unsigned thread, std::size_t& index) {
+    {
+        auto& own = queues[thread];
+        std::lock_guard lock(own.mutex);
+        if (own.begin != own.end) {
+            index = --own.end;
+            return true;
+        }
+    }
+
+    for (unsigned offset = 1; offset < thread_count; offset++) {
+        auto& victim = queues[(thread + offset) % thread_count];
+        std::lock_guard lock(victim.mutex);
+        if (victim.begin != victim.end) {
+            index = victim.begin++;
+            return true;
+        }
+    }
+
+    return false;
+}
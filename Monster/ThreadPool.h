@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fork-join pool with one queue per thread. Each ParallelFor seeds the queues with
+// contiguous index ranges; threads pop from the back of their own queue and steal
+// from the front of the others once it runs dry. A queue only ever holds what is left
+// of its range, so it is just the range, and nothing is allocated per call.
+class ThreadPool {
+public:
+    using Task = std::function<void(std::size_t index, unsigned thread)>;
+
+    // thread_count includes the thread that calls ParallelFor.
+    explicit ThreadPool(unsigned thread_count = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned ThreadCount() const { return thread_count; }
+
+    // Runs task for every index in [0, count) and returns when all of them are done.
+    // The caller runs tasks as thread 0. Must not be called concurrently or from
+    // inside a task, and tasks must not throw.
+    void ParallelFor(std::size_t count, const Task& task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        // Indices not taken yet.
+        std::size_t begin = 0, end = 0;
+    };
+
+    unsigned thread_count;
+    std::vector<std::thread> workers;
+    std::unique_ptr<Queue[]> queues;
+
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const Task* current = nullptr;
+    std::atomic<std::size_t> remaining = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    void WorkerLoop(unsigned thread);
+    void Participate(unsigned thread);
+    bool Pop(unsigned thread, std::size_t& index);
+};
@@ -4,11 +4,13 @@ Timer::Timer() {
     QueryPerformanceFrequency(&frequency);
 }
 
-double Timer::get_time(int seconds) {
+std::int64_t Timer::get_ticks() {
     LARGE_INTEGER curr_counter;
     QueryPerformanceCounter(&curr_counter);
 
-    auto difference = curr_counter.QuadPart % (frequency.QuadPart * seconds);
+    return curr_counter.QuadPart;
+}
 
-    return (double)difference / (double)frequency.QuadPart;
-}
\ No newline at end of file
+std::int64_t Timer::get_frequency() const {
+    return frequency.QuadPart;
+}
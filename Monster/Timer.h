@@ -2,12 +2,15 @@
 
 #include "framework.h"
 #include <profileapi.h>
+#include <cstdint>
 
 class Timer {
 public:
 	Timer();
 
-	double get_time(int seconds);
+	// Raw performance counter value and its ticks per second.
+	std::int64_t get_ticks();
+	std::int64_t get_frequency() const;
 private:
 	LARGE_INTEGER frequency;
 };
@@ -0,0 +1,217 @@
+#include "TraceReplay.h"
+#include "AnimationClock.h"
+#include "CpuRenderer.h"
+#include "InputTrace.h"
+#include "MonsterScene.h"
+#include "RenderTargetPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// FNV-1a over 64 bit words of every row, leaving out the padding at the end of rows.
+std::uint64_t HashSurface(const gfx::Surface& surface) {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    auto row_bytes = (std::size_t)surface.width * 4;
+    for (int y = 0; y < surface.height; y++) {
+        const auto* row = surface.Row(y);
+        std::size_t i = 0;
+        for (; i + 8 <= row_bytes; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, row + i, sizeof(word));
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+        for (; i < row_bytes; i++) {
+            hash = (hash ^ row[i]) * 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
+
+// Checksums of a report, indexed by frame.
+bool ReadChecksums(const std::filesystem::path& filename, std::vector<std::uint64_t>& checksums) {
+    std::ifstream stream(filename);
+    if (!stream) {
+        return false;
+    }
+
+    std::string line;
+    std::getline(stream, line);
+    while (std::getline(stream, line)) {
+        int frame = 0;
+        double milliseconds = 0.0;
+        std::uint64_t checksum = 0;
+        if (std::sscanf(line.c_str(), "%d,%lf,%" SCNx64, &frame, &milliseconds, &checksum) != 3 || frame < 0) {
+            return false;
+        }
+        if ((std::size_t)frame >= checksums.size()) {
+            checksums.resize((std::size_t)frame + 1);
+        }
+        checksums[frame] = checksum;
+    }
+    return true;
+}
+
+// Value at fraction of the way through sorted values.
+double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    auto index = (std::size_t)std::ceil(fraction * (double)sorted.size());
+    return sorted[std::clamp<std::size_t>(index, 1, sorted.size()) - 1];
+}
+
+}
+
+ReplayResult ReplayTrace(const ReplaySettings& settings) {
+    ReplayResult result;
+
+    TraceReader reader;
+    if (!reader.Open(settings.trace)) {
+        return result;
+    }
+
+    std::vector<std::uint64_t> expected;
+    if (!settings.expected.empty() && !ReadChecksums(settings.expected, expected)) {
+        return result;
+    }
+
+    std::ofstream report;
+    if (!settings.report.empty()) {
+        report.open(settings.report, std::ios::trunc);
+        if (!report) {
+            return result;
+        }
+        report << "frame,milliseconds,checksum\n";
+    }
+
+    ThreadPool pool(settings.threads > 0 ? settings.threads : std::max(std::thread::hardware_concurrency(), 1u));
+    CpuRenderer renderer;
+    renderer.SetThreadPool(&pool);
+    renderer.SetBlendSpace(settings.linear_light ? gfx::BlendSpace::Linear : gfx::BlendSpace::Stored);
+    result.baked_geometry = !settings.geometry.empty() && renderer.LoadGeometry(settings.geometry);
+    // Allocated like the window's swap chain, with slack, so resizes cost the same.
+    TargetSizer sizer;
+    std::vector<std::uint8_t> target_pixels;
+    gfx::Surface target;
+
+    // The window's simulation state, as Animate and OnRender keep it.
+    AnimationClock clock;
+    clock.SetFixedStep(reader.FixedStep());
+    clock.Reset();
+    auto previous_angle = 0.0f, current_angle = 0.0f;
+
+    InputState input(reader.TicksPerSecond());
+    gfx::Matrix3x2 transformation, inverse_transformation;
+    auto dip_scale = 0.0f;
+    auto smile = 0.0f;
+    std::int64_t smile_time = 0;
+
+    std::vector<double> milliseconds;
+    std::uint64_t target_allocations = 0;
+    std::uint64_t checksum = 0xcbf29ce484222325ull;
+
+    TraceFrame frame;
+    while (reader.Next(frame)) {
+        // Resizing is part of the frame, as in the window.
+        auto begin = Clock::now();
+
+        auto now = std::chrono::nanoseconds((std::int64_t)((double)frame.time * 1e9 / reader.TicksPerSecond()));
+        if (sizer.Update(frame.width, frame.height, false, now)) {
+            target_pixels = std::vector<std::uint8_t>((std::size_t)sizer.AllocatedWidth() * sizer.AllocatedHeight() * 4);
+            target_allocations++;
+        }
+        auto resized = (int)frame.width != target.width || (int)frame.height != target.height;
+        target = { target_pixels.data(), (int)frame.width, (int)frame.height, (int)sizer.AllocatedWidth() * 4 };
+        renderer.SetTarget(target);
+        if (resized || frame.dip_scale != dip_scale) {
+            dip_scale = frame.dip_scale;
+            transformation = MonsterScene::DefaultTransformation(frame.width * dip_scale, frame.height * dip_scale);
+            inverse_transformation = MonsterScene::InverseTransformation(transformation);
+        }
+        clock.SetPaused(frame.paused);
+        clock.SetTimeScale(frame.time_scale);
+        for (const auto& event : frame.events) {
+            input.Apply(event);
+        }
+
+        clock.Tick(frame.real_delta * 1e-9);
+        while (clock.Step()) {
+            previous_angle = current_angle;
+            current_angle = MonsterScene::SwayAngle(clock.StepTime());
+        }
+
+        SceneState scene;
+        scene.transformation = transformation;
+        scene.angle = std::lerp(previous_angle, current_angle, (float)clock.Alpha());
+
+        auto mouse = frame.predict_input ? input.PredictMouse(frame.time) : input.Mouse();
+        MonsterScene::CreateBalls(inverse_transformation, mouse, scene.left_ball, scene.right_ball);
+        auto seconds = smile_time != 0 ? (double)(frame.time - smile_time) / reader.TicksPerSecond() : 0.0;
+        smile = MonsterScene::StepExpression(smile, input.MouseDown(), seconds);
+        smile_time = frame.time;
+        scene.smile = smile;
+
+        // A minimized window has nothing to draw.
+        auto drawn = target.width > 0 && target.height > 0;
+        if (drawn) {
+            renderer.Render(scene);
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+        auto frame_checksum = drawn ? HashSurface(target) : 0;
+        checksum = (checksum ^ frame_checksum) * 0x100000001b3ull;
+        if (drawn) {
+            milliseconds.push_back(elapsed);
+        }
+
+        if (!settings.expected.empty() &&
+            ((std::size_t)result.frames >= expected.size() || expected[result.frames] != frame_checksum)) {
+            if (result.mismatches++ == 0) {
+                result.first_mismatch = result.frames;
+            }
+        }
+
+        if (report.is_open()) {
+            char line[64];
+            std::snprintf(line, sizeof(line), "%d,%.4f,%016" PRIx64 "\n", result.frames, drawn ? elapsed : 0.0, frame_checksum);
+            report << line;
+        }
+        result.frames++;
+    }
+
+    // Frames the expected run had and this one didn't.
+    if (!settings.expected.empty() && expected.size() > (std::size_t)result.frames) {
+        if (result.mismatches == 0) {
+            result.first_mismatch = result.frames;
+        }
+        result.mismatches += (int)(expected.size() - result.frames);
+    }
+
+    std::sort(milliseconds.begin(), milliseconds.end());
+    result.median_milliseconds = Percentile(milliseconds, 0.5);
+    result.p95_milliseconds = Percentile(milliseconds, 0.95);
+    result.max_milliseconds = milliseconds.empty() ? 0.0 : milliseconds.back();
+    result.over_budget = settings.budget_milliseconds > 0.0 && result.p95_milliseconds > settings.budget_milliseconds;
+
+    result.allocations = target_allocations + renderer.LayerAllocations();
+    result.checksum = checksum;
+    result.read = !reader.Failed();
+    auto written = true;
+    if (report.is_open()) {
+        report.close();
+        written = (bool)report;
+    }
+    result.succeeded = result.read && written && result.mismatches == 0 && !result.over_budget;
+    return result;
+}
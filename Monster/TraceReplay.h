@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+struct ReplaySettings {
+    // Written by the window with -record.
+    std::filesystem::path trace;
+    // CSV of every frame's render time and checksum. Not written if empty.
+    std::filesystem::path report;
+    // Report of an earlier replay whose checksums every frame has to match. Not
+    // checked if empty.
+    std::filesystem::path expected;
+    // Fails the replay if the 95th percentile frame takes longer. Not checked if 0.
+    double budget_milliseconds = 0.0;
+    // Render threads, counting the replaying one. 0 uses every hardware thread.
+    unsigned threads = 0;
+    // Blends in linear light rather than as the window does. Changes every checksum.
+    bool linear_light = false;
+    // Flattened paths written by CpuRenderer::BakeGeometry. Paths are flattened at
+    // runtime if it's empty, missing or corrupt.
+    std::filesystem::path geometry;
+};
+
+struct ReplayResult {
+    bool succeeded = false;
+    // The trace could be read to its end.
+    bool read = false;
+    int frames = 0;
+    // Frames whose checksum differs from the expected report, or that it lacks.
+    int mismatches = 0;
+    int first_mismatch = -1;
+    bool over_budget = false;
+    // The geometry file was loaded.
+    bool baked_geometry = false;
+
+    // Target and layer buffers allocated, which resizing the window in the trace
+    // causes as it would in the window.
+    std::uint64_t allocations = 0;
+
+    // Render times of frames that drew something, including resizing the target.
+    double median_milliseconds = 0.0, p95_milliseconds = 0.0, max_milliseconds = 0.0;
+    // Checksum of every frame's checksum, to compare whole runs at a glance.
+    std::uint64_t checksum = 0;
+};
+
+// Replays a trace without a window: steps the clock and applies the input of every
+// recorded simulation step the way the window does, builds the scene with the same
+// CreateBalls and StepExpression calls as OnRender, and draws it with CpuRenderer.
+//
+// Each step is rendered once, into the same target, so partial redraws are exercised
+// as in the window. The time of the scene update and draw is measured per frame, and
+// the pixels are checksummed. Rendering is deterministic, so the same trace gives the
+// same checksums on any machine and thread count, while the times show whether a
+// change kept within budget.
+//
+// The replay follows the steps rather than the window's frames, which come at their
+// own pace, and predicts input to the time of the step. Crowds aren't recorded.
+ReplayResult ReplayTrace(const ReplaySettings& settings);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands the latest value from one writer thread to one reader thread, without locks
+// and without either side ever waiting.
+//
+// The writer fills in Back() and calls Publish(). The reader calls Read() and uses
+// Front() until its next Read(). Values published in between two reads are skipped,
+// but each side only ever touches a slot the other one can't reach, so a value is
+// never seen half written.
+//
+// Back() holds an older value after Publish(), so the writer has to set every field.
+template <typename T>
+class TripleBuffer {
+public:
+    T& Back() { return slots[back]; }
+    const T& Front() const { return slots[front]; }
+
+    // Makes Back() the latest value and takes the spare slot in its place.
+    void Publish() {
+        auto state = middle.exchange((std::uint8_t)(back | FRESH), std::memory_order_acq_rel);
+        back = state & INDEX;
+    }
+
+    // Moves Front() to the latest value. Returns false, keeping Front() as it is, if
+    // nothing was published since the last read.
+    bool Read() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        auto state = middle.exchange(front, std::memory_order_acq_rel);
+        front = state & INDEX;
+        return true;
+    }
+
+private:
+    static constexpr std::uint8_t INDEX = 3;
+    static constexpr std::uint8_t FRESH = 4;
+
+    std::array<T, 3> slots = {};
+
+    // Owned by the writer and the reader respectively; kept on separate cache lines so
+    // they don't slow each other down.
+    alignas(64) std::uint8_t back = 0;
+    alignas(64) std::uint8_t front = 1;
+    // The spare slot, plus FRESH while it holds a value the reader hasn't taken.
+    alignas(64) std::atomic<std::uint8_t> middle = 2;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Benchmarks for MonsterBench, with nothing beyond the standard library either.
+// BENCHMARK(Name) { ... } defines one, which times its work with bench::Measure and
+// prints its own table. MonsterBench runs every benchmark, or those named on its
+// command line.
+namespace bench {
+
+using Function = void (*)();
+
+struct Registration {
+    Registration(const char* name, Function function);
+};
+
+// MonsterBench -quick runs every measurement once, to check the benchmarks still work
+// without waiting for numbers worth reading.
+bool Quick();
+
+// Median seconds one call to work takes. After a call to warm up, work runs in five
+// batches, each as many calls as fit in about a tenth of a second, and the median
+// batch's average is taken.
+template <class Work>
+double Measure(Work&& work) {
+    using Clock = std::chrono::steady_clock;
+
+    work();
+    if (Quick()) {
+        return 0.0;
+    }
+
+    std::vector<double> batches;
+    for (int batch = 0; batch < 5; batch++) {
+        int calls = 0;
+        auto start = Clock::now();
+        std::chrono::duration<double> elapsed{};
+        do {
+            work();
+            calls++;
+            elapsed = Clock::now() - start;
+        } while (elapsed.count() < 0.1);
+        batches.push_back(elapsed.count() / calls);
+    }
+    std::sort(batches.begin(), batches.end());
+    return batches[batches.size() / 2];
+}
+
+// Keeps the compiler from dropping work whose result is otherwise unused: value's
+// address escapes into code the compiler can't see through, which may read all memory.
+template <class T>
+void KeepAlive(const T& value) {
+#ifdef _MSC_VER
+    // MSVC has no inline assembly on x64; a volatile store and load stand in for it.
+    static const void* volatile sink;
+    sink = &value;
+    (void)sink;
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+}
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static const bench::Registration name##_registration(#name, &name); \
+    static void name()
@@ -0,0 +1,60 @@
+#include "Bench.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchmarkCase {
+    std::string name;
+    bench::Function function;
+};
+
+std::vector<BenchmarkCase>& BenchmarkCases() {
+    static std::vector<BenchmarkCase> cases;
+    return cases;
+}
+
+bool quick = false;
+
+}
+
+namespace bench {
+
+Registration::Registration(const char* name, Function function) {
+    BenchmarkCases().push_back({ name, function });
+}
+
+bool Quick() {
+    return quick;
+}
+
+}
+
+// MonsterBench [-quick] [Name...] runs the benchmarks named, or all of them.
+int main(int argc, char** argv) {
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-quick") {
+            quick = true;
+        }
+        else {
+            names.push_back(arg);
+        }
+    }
+
+    int ran = 0;
+    for (const auto& benchmark : BenchmarkCases()) {
+        if (!names.empty() && std::find(names.begin(), names.end(), benchmark.name) == names.end()) {
+            continue;
+        }
+        std::printf("%s\n", benchmark.name.c_str());
+        std::fflush(stdout);
+        benchmark.function();
+        std::printf("\n");
+        ran++;
+    }
+    return ran > 0 ? 0 : 1;
+}
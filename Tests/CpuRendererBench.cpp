@@ -0,0 +1,89 @@
+#include "Bench.h"
+#include "CpuRenderer.h"
+#include "TestScene.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <cstdio>
+
+// Frames per second of the scene at 1080p, 4K and 8K, against render threads. Frames
+// are drawn in full, as offline rendering does for frames that change everywhere.
+BENCHMARK(RenderFrames) {
+    std::printf("%-10s %8s %12s %10s\n", "size", "threads", "ms/frame", "frames/s");
+    for (int height : { 1080, 2160, 4320 }) {
+        auto width = height * 16 / 9;
+        TestTarget target(width, height);
+        for (unsigned threads : { 1u, 2u, 4u, 8u, 16u }) {
+            CpuRenderer renderer;
+            ThreadPool pool(threads);
+            renderer.SetTarget(target.surface);
+            renderer.SetThreadPool(threads > 1 ? &pool : nullptr);
+
+            int frame = 0;
+            auto seconds = bench::Measure([&] {
+                renderer.InvalidateTarget();
+                renderer.Render(TestScene(width, height, frame++));
+            });
+            std::printf("%4dx%-5d %8u %12.3f %10.1f\n", width, height, threads, seconds * 1e3,
+                seconds > 0.0 ? 1.0 / seconds : 0.0);
+        }
+    }
+}
+
+// Consecutive frames redrawing only the pixels the moving parts cover now and covered
+// the frame before, against drawing every frame in full, on one thread. Pixels are the
+// average the frame wrote.
+BENCHMARK(DamagedFrames) {
+    std::printf("%-10s %-8s %14s %12s %10s\n", "size", "redraw", "pixels/frame", "ms/frame", "speedup");
+    for (int height : { 720, 1080, 2160 }) {
+        auto width = height * 16 / 9;
+        TestTarget target(width, height);
+        double full_seconds = 0.0;
+        for (bool full : { true, false }) {
+            CpuRenderer renderer;
+            renderer.SetTarget(target.surface);
+
+            int frame = 0;
+            std::int64_t pixels = 0, frames = 0;
+            auto seconds = bench::Measure([&] {
+                if (full) {
+                    renderer.InvalidateTarget();
+                }
+                renderer.Render(TestScene(width, height, frame++));
+                pixels += renderer.Damage().Area();
+                frames++;
+            });
+            full_seconds = full ? seconds : full_seconds;
+            std::printf("%4dx%-5d %-8s %14lld %12.3f %9.1fx\n", width, height, full ? "full" : "damaged",
+                (long long)(pixels / frames), seconds * 1e3, seconds > 0.0 ? full_seconds / seconds : 0.0);
+        }
+    }
+}
+
+// Frames drawn in full from the cached layer of the body and eye sockets, against
+// rebuilding the layer every frame by nudging the transformation back and forth, on one
+// thread.
+BENCHMARK(RetainedLayer) {
+    std::printf("%-10s %-8s %12s %10s\n", "size", "layer", "ms/frame", "speedup");
+    for (int height : { 720, 1080, 2160 }) {
+        auto width = height * 16 / 9;
+        TestTarget target(width, height);
+        double rebuilt_seconds = 0.0;
+        for (bool rebuild : { true, false }) {
+            CpuRenderer renderer;
+            renderer.SetTarget(target.surface);
+
+            int frame = 0;
+            auto seconds = bench::Measure([&] {
+                auto scene = TestScene(width, height, frame++);
+                if (rebuild && frame % 2) {
+                    scene.transformation = scene.transformation * gfx::Matrix3x2::Translation(0.5f, 0.0f);
+                }
+                renderer.InvalidateTarget();
+                renderer.Render(scene);
+            });
+            rebuilt_seconds = rebuild ? seconds : rebuilt_seconds;
+            std::printf("%4dx%-5d %-8s %12.3f %9.1fx\n", width, height, rebuild ? "rebuilt" : "cached", seconds * 1e3,
+                seconds > 0.0 ? rebuilt_seconds / seconds : 0.0);
+        }
+    }
+}
@@ -0,0 +1,163 @@
+#include "CpuRenderer.h"
+#include "Test.h"
+#include "TestScene.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Renders frame_count consecutive frames with and without a pool of thread_count
+// threads, and requires every one of them to be identical.
+void RequireSameAsSingleThreaded(int width, int height, unsigned thread_count, int frame_count) {
+    test::Scope scope(std::to_string(width) + "x" + std::to_string(height) + " on " +
+        std::to_string(thread_count) + " threads");
+    TestTarget single_target(width, height), parallel_target(width, height);
+    CpuRenderer single, parallel;
+    ThreadPool pool(thread_count);
+    single.SetTarget(single_target.surface);
+    parallel.SetTarget(parallel_target.surface);
+    parallel.SetThreadPool(&pool);
+
+    for (int frame = 0; frame < frame_count; frame++) {
+        test::Scope frame_scope("frame " + std::to_string(frame));
+        auto scene = TestScene(width, height, frame);
+        single.Render(scene);
+        parallel.Render(scene);
+        REQUIRE(single_target.pixels == parallel_target.pixels);
+    }
+}
+
+// Renders frame_count frames into target_count surfaces taking turns, redrawing only
+// what changed since each was last drawn, and requires every frame to match the same
+// frame drawn in full by a fresh renderer. From frame 20 to 29 the monster sits
+// elsewhere, as after a resize of the window, which restarts the damage history twice.
+void RequireSameAsFullRedraw(int width, int height, int target_count, int frame_count) {
+    test::Scope scope(std::to_string(target_count) + " surfaces");
+    std::vector<TestTarget> targets;
+    for (int i = 0; i < target_count; i++) {
+        targets.emplace_back(width, height);
+    }
+    CpuRenderer damaged;
+    damaged.SetTargetCount(target_count);
+
+    auto partial_frames = 0;
+    for (int frame = 0; frame < frame_count; frame++) {
+        test::Scope frame_scope("frame " + std::to_string(frame));
+        auto scene = frame >= 20 && frame < 30 ? TestScene(width + 200, height, frame) : TestScene(width, height, frame);
+        auto& target = targets[frame % target_count];
+        damaged.SetTarget(target.surface);
+        damaged.Render(scene);
+        partial_frames += damaged.Damage().Area() < (std::int64_t)width * height ? 1 : 0;
+
+        TestTarget full(width, height);
+        CpuRenderer fresh;
+        fresh.SetTarget(full.surface);
+        fresh.Render(scene);
+        REQUIRE(target.pixels == full.pixels);
+    }
+    // Otherwise the partial path went untested.
+    CHECK(partial_frames > frame_count / 2);
+}
+
+std::uint32_t Pixel(const gfx::Surface& surface, int x, int y) {
+    const auto* pixel = surface.Row(y) + x * 4;
+    return (std::uint32_t)pixel[0] | (std::uint32_t)pixel[1] << 8 | (std::uint32_t)pixel[2] << 16 |
+        (std::uint32_t)pixel[3] << 24;
+}
+
+}
+
+TEST(CpuRenderer, ParallelTilesMatchSingleThreaded) {
+    for (unsigned threads : { 2u, 3u, 8u }) {
+        RequireSameAsSingleThreaded(1280, 720, threads, 40);
+    }
+}
+
+TEST(CpuRenderer, ParallelTilesMatchSingleThreadedOnPartialTiles) {
+    // Neither size is a multiple of TILE_SIZE, so the last row and column are cut off.
+    RequireSameAsSingleThreaded(333, 217, 4, 10);
+    RequireSameAsSingleThreaded(CpuRenderer::TILE_SIZE + 1, 3 * CpuRenderer::TILE_SIZE - 1, 4, 10);
+}
+
+TEST(CpuRenderer, PartialRedrawsMatchFullRedraws) {
+    for (int target_count = 1; target_count <= gfx::DamageTracker::MAX_BUFFER_AGE; target_count++) {
+        RequireSameAsFullRedraw(400, 300, target_count, 60);
+    }
+}
+
+TEST(CpuRenderer, LayerFollowsTransformationAndSize) {
+    // The same renderer across a move, a resize and a move back, each checked against a
+    // renderer that never had a layer.
+    struct Step {
+        int width, height;
+        gfx::Matrix3x2 offset;
+    };
+    const Step steps[] = {
+        { 320, 240, gfx::Matrix3x2::Identity() },
+        { 320, 240, gfx::Matrix3x2::Translation(17.0f, -9.0f) },
+        { 400, 300, gfx::Matrix3x2::Identity() },
+        { 300, 400, gfx::Matrix3x2::Rotation(0.2f) },
+        { 320, 240, gfx::Matrix3x2::Identity() },
+    };
+
+    CpuRenderer renderer;
+    for (std::size_t i = 0; i < std::size(steps); i++) {
+        test::Scope scope("step " + std::to_string(i));
+        const auto& step = steps[i];
+        TestTarget target(step.width, step.height);
+        renderer.SetTarget(target.surface);
+        for (int frame = 0; frame < 3; frame++) {
+            auto scene = TestScene(step.width, step.height, frame);
+            scene.transformation = scene.transformation * step.offset;
+            renderer.Render(scene);
+
+            TestTarget full(step.width, step.height);
+            CpuRenderer fresh;
+            fresh.SetTarget(full.surface);
+            fresh.Render(scene);
+            REQUIRE(target.pixels == full.pixels);
+        }
+    }
+}
+
+TEST(CpuRenderer, DrawsTheMonster) {
+    TestTarget target(640, 480);
+    CpuRenderer renderer;
+    renderer.SetTarget(target.surface);
+    renderer.Render(TestScene(640, 480, 0));
+
+    auto background = gfx::PackPremultiplied(MonsterScene::background_color);
+    CHECK_EQ(Pixel(target.surface, 0, 0), background);
+    CHECK_EQ(Pixel(target.surface, 639, 479), background);
+    // Inside the body, between the eyes and the nose.
+    CHECK(Pixel(target.surface, 320, 255) != background);
+}
+
+TEST(ThreadPool, RunsEveryIndexOnce) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> runs(1000);
+    std::atomic<bool> bad_thread = false;
+    for (int call = 0; call < 20; call++) {
+        pool.ParallelFor(runs.size(), [&](std::size_t index, unsigned thread) {
+            if (thread >= pool.ThreadCount()) {
+                bad_thread = true;
+            }
+            runs[index]++;
+        });
+    }
+    CHECK(!bad_thread);
+    for (const auto& count : runs) {
+        REQUIRE_EQ(count.load(), 20);
+    }
+}
+
+TEST(ThreadPool, RunsNothingForNoIndices) {
+    ThreadPool pool(3);
+    std::atomic<int> runs = 0;
+    pool.ParallelFor(0, [&](std::size_t, unsigned) { runs++; });
+    CHECK_EQ(runs.load(), 0);
+}
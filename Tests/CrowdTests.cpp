@@ -0,0 +1,95 @@
+#include "CpuRenderer.h"
+#include "Crowd.h"
+#include "Test.h"
+#include "TestScene.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+TEST(Crowd, EyesFollowTheTargetLikeCreateBall) {
+    auto crowd = TestCrowd(500, 1280, 720);
+    for (gfx::Point target : { gfx::Point{ 640.0f, 360.0f }, gfx::Point{ -50.0f, 900.0f }, gfx::Point{ 1200.0f, 10.0f } }) {
+        crowd.Update(0.25, target);
+
+        // In local units, where a socket is 68 across.
+        float worst = 0.0f;
+        for (std::size_t i = 0; i < crowd.Size(); i++) {
+            // The transformation each monster is drawn with.
+            auto s = MonsterScene::SCALE * crowd.scale[i];
+            auto transformation = gfx::Matrix3x2::Scale(s, s) *
+                gfx::Matrix3x2::Translation(crowd.position_x[i], crowd.position_y[i]);
+            auto left = MonsterScene::CreateBall(transformation, target, true);
+            auto right = MonsterScene::CreateBall(transformation, target, false);
+            worst = std::max({ worst, std::abs(crowd.left_ball_x[i] - left.center.x),
+                std::abs(crowd.left_ball_y[i] - left.center.y), std::abs(crowd.right_ball_x[i] - right.center.x),
+                std::abs(crowd.right_ball_y[i] - right.center.y) });
+            CHECK_EQ(crowd.angle[i], MonsterScene::SwayAngle(0.25 + crowd.phase[i]));
+        }
+        CHECK_NEAR(worst, 0.0f, 1e-3);
+    }
+}
+
+TEST(Crowd, CopyingTheAnimationMatchesAFullCopy) {
+    // What a snapshot that already holds the crowd ends up with, some frames and clicks
+    // later.
+    auto crowd = TestCrowd(300, 1280, 720);
+    crowd.Update(0.0, { 0.0f, 0.0f });
+    auto copy = crowd;
+
+    crowd.Update(2.5, { 900.0f, 100.0f });
+    for (std::size_t i = 0; i < crowd.Size(); i += 7) {
+        crowd.expression[i] = crowd.expression[i] == Expression::Smile ? Expression::Sad : Expression::Smile;
+    }
+    copy.CopyAnimation(crowd);
+
+    CrowdAtlas atlas;
+    std::vector<CrowdSprite> expected, sprites;
+    crowd.BuildSprites(atlas, expected);
+    copy.BuildSprites(atlas, sprites);
+    REQUIRE_EQ(sprites.size(), expected.size());
+    for (std::size_t i = 0; i < sprites.size(); i++) {
+        const auto &a = sprites[i].destination, &b = expected[i].destination;
+        REQUIRE(sprites[i].cell == expected[i].cell && a.left == b.left && a.top == b.top && a.right == b.right &&
+            a.bottom == b.bottom);
+    }
+}
+
+TEST(Crowd, BuildsFourSpritesPerMonsterInDrawingOrder) {
+    auto crowd = TestCrowd(100, 1280, 720);
+    crowd.Update(1.0, { 100.0f, 100.0f });
+    CrowdAtlas atlas;
+    std::vector<CrowdSprite> sprites;
+    crowd.BuildSprites(atlas, sprites);
+
+    REQUIRE_EQ(sprites.size(), crowd.Size() * 4);
+    for (std::size_t i = 0; i < crowd.Size(); i++) {
+        CHECK_EQ(sprites[i * 4].cell, CrowdAtlas::BODY_CELL);
+        CHECK_EQ(sprites[i * 4 + 1].cell, CrowdAtlas::BALL_CELL);
+        CHECK_EQ(sprites[i * 4 + 2].cell, CrowdAtlas::BALL_CELL);
+        CHECK_EQ(sprites[i * 4 + 3].cell, CrowdAtlas::MouthCell(crowd.angle[i], crowd.expression[i]));
+        // The body is centered where the monster is.
+        const auto& body = sprites[i * 4].destination;
+        CHECK(body.left < crowd.position_x[i] && crowd.position_x[i] < body.right);
+        CHECK(body.top < crowd.position_y[i] && crowd.position_y[i] < body.bottom);
+    }
+}
+
+TEST(Crowd, RendersTheSameOnAnyThreadCount) {
+    auto crowd = TestCrowd(2000, 800, 600);
+    TestTarget single_target(800, 600), parallel_target(800, 600);
+    CpuRenderer single, parallel;
+    ThreadPool pool(4);
+    single.SetTarget(single_target.surface);
+    parallel.SetTarget(parallel_target.surface);
+    parallel.SetThreadPool(&pool);
+
+    for (int frame = 0; frame < 5; frame++) {
+        test::Scope scope("frame " + std::to_string(frame));
+        crowd.Update(frame / 60.0, { 400.0f + frame * 20.0f, 300.0f });
+        single.RenderCrowd(crowd);
+        parallel.RenderCrowd(crowd);
+        REQUIRE(single_target.pixels == parallel_target.pixels);
+    }
+}
@@ -0,0 +1,50 @@
+#include "Bench.h"
+#include "EyeTracking.h"
+#include "MonsterScene.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Eyes per second through TrackEyes at every level the CPU runs, for arrays that stay in
+// cache and ones that don't, against CreateBall inverting the transformation per eye.
+BENCHMARK(TrackEyes) {
+    constexpr float ORBIT = MonsterScene::EYE_RADIUS - MonsterScene::EYE_BALL_RADIUS;
+
+    std::printf("%9s %-12s %14s\n", "eyes", "path", "Meyes/s");
+    for (std::size_t count : { 1000u, 100000u, 4000000u }) {
+        std::mt19937 random(2);
+        std::uniform_real_distribution<float> coordinate(-200.0f, 200.0f);
+        std::vector<float> target_x(count), target_y(count), ball_x(count), ball_y(count);
+        for (std::size_t i = 0; i < count; i++) {
+            target_x[i] = coordinate(random);
+            target_y[i] = coordinate(random);
+        }
+
+        auto report = [&](const char* path, double seconds) {
+            std::printf("%9zu %-12s %14.1f\n", count, path, seconds > 0.0 ? count / seconds * 1e-6 : 0.0);
+        };
+
+        auto transformation = MonsterScene::DefaultTransformation(1920.0f, 1080.0f);
+        report("CreateBall", bench::Measure([&] {
+            for (std::size_t i = 0; i < count; i++) {
+                auto ball = MonsterScene::CreateBall(transformation, { target_x[i], target_y[i] }, true);
+                ball_x[i] = ball.center.x;
+                ball_y[i] = ball.center.y;
+            }
+            bench::KeepAlive(ball_x);
+        }));
+
+        std::pair<gfx::SimdLevel, const char*> levels[] = {
+            { gfx::SimdLevel::Scalar, "scalar" }, { gfx::SimdLevel::Sse2, "SSE2" }, { gfx::SimdLevel::Avx2, "AVX2" }
+        };
+        for (auto [level, name] : levels) {
+            if (level > gfx::DetectSimdLevel()) {
+                continue;
+            }
+            report(name, bench::Measure([&] {
+                gfx::TrackEyes(MonsterScene::left_eye.center, ORBIT, target_x, target_y, ball_x, ball_y, level);
+                bench::KeepAlive(ball_x);
+            }));
+        }
+    }
+}
@@ -0,0 +1,136 @@
+#include "EyeTracking.h"
+#include "MonsterScene.h"
+#include "Test.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr float ORBIT = MonsterScene::EYE_RADIUS - MonsterScene::EYE_BALL_RADIUS;
+
+// The SIMD paths refine a reciprocal square root estimate, so they may be a few units in
+// the last place off. Eyeballs are within 70 local units of the origin, where that is
+// well under this.
+constexpr double SIMD_TOLERANCE = 1e-4;
+
+const char* LevelName(gfx::SimdLevel level) {
+    switch (level) {
+    case gfx::SimdLevel::Avx2:
+        return "AVX2";
+    case gfx::SimdLevel::Sse2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+// Every level this CPU can run.
+std::vector<gfx::SimdLevel> SupportedLevels() {
+    std::vector<gfx::SimdLevel> levels = { gfx::SimdLevel::Scalar };
+    if (GFX_SIMD_X86) {
+        levels.push_back(gfx::SimdLevel::Sse2);
+    }
+    if (gfx::DetectSimdLevel() == gfx::SimdLevel::Avx2) {
+        levels.push_back(gfx::SimdLevel::Avx2);
+    }
+    return levels;
+}
+
+// Mouse positions all over and around a 1280x720 window, plus the awkward ones: right on
+// an eye, on the edge of its orbit, and far away.
+std::vector<gfx::Point> TestMice(const gfx::Matrix3x2& transformation) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> x(-400.0f, 1680.0f), y(-400.0f, 1120.0f);
+
+    std::vector<gfx::Point> mice;
+    for (int i = 0; i < 1003; i++) {
+        mice.push_back({ x(random), y(random) });
+    }
+    for (const auto& eye : { MonsterScene::left_eye, MonsterScene::right_eye }) {
+        mice.push_back(transformation.TransformPoint(eye.center));
+        mice.push_back(transformation.TransformPoint({ eye.center.x + ORBIT, eye.center.y }));
+        mice.push_back(transformation.TransformPoint({ eye.center.x, eye.center.y - ORBIT }));
+    }
+    mice.push_back({ 1e6f, -1e6f });
+    return mice;
+}
+
+// Checks TrackEyes against CreateBall, the per-call math the window used before, for
+// every mouse and eye at every level.
+void CheckAgainstCreateBall(const gfx::Matrix3x2& transformation) {
+    auto mice = TestMice(transformation);
+    auto inverse = MonsterScene::InverseTransformation(transformation);
+    std::vector<float> target_x, target_y;
+    for (auto mouse : mice) {
+        auto local = inverse.TransformPoint(mouse);
+        target_x.push_back(local.x);
+        target_y.push_back(local.y);
+    }
+
+    for (auto level : SupportedLevels()) {
+        test::Scope scope(LevelName(level));
+        for (bool left : { true, false }) {
+            auto eye = left ? MonsterScene::left_eye.center : MonsterScene::right_eye.center;
+            std::vector<float> ball_x(mice.size()), ball_y(mice.size());
+            gfx::TrackEyes(eye, ORBIT, target_x, target_y, ball_x, ball_y, level);
+
+            double worst = 0.0;
+            for (std::size_t i = 0; i < mice.size(); i++) {
+                auto expected = MonsterScene::CreateBall(transformation, mice[i], left).center;
+                worst = std::max({ worst, (double)std::abs(ball_x[i] - expected.x),
+                    (double)std::abs(ball_y[i] - expected.y) });
+            }
+            // The scalar path is the same math, so it has to be exact.
+            CHECK_NEAR(worst, 0.0, level == gfx::SimdLevel::Scalar ? 0.0 : SIMD_TOLERANCE);
+        }
+    }
+}
+
+}
+
+TEST(EyeTracking, MatchesCreateBall) {
+    CheckAgainstCreateBall(MonsterScene::DefaultTransformation(1280.0f, 720.0f));
+}
+
+TEST(EyeTracking, MatchesCreateBallWhenRotated) {
+    CheckAgainstCreateBall(gfx::Matrix3x2::Rotation(-7.5f) * MonsterScene::DefaultTransformation(1280.0f, 720.0f));
+}
+
+TEST(EyeTracking, HandlesEveryRemainderCount) {
+    // Counts around the vector widths, so every tail length goes through the scalar loop.
+    for (auto level : SupportedLevels()) {
+        for (std::size_t count = 0; count <= 17; count++) {
+            test::Scope scope(std::string(LevelName(level)) + ", " + std::to_string(count) + " eyes");
+            std::vector<float> target_x(count), target_y(count), ball_x(count, NAN), ball_y(count, NAN);
+            for (std::size_t i = 0; i < count; i++) {
+                target_x[i] = 100.0f * (float)i;
+                target_y[i] = -3.0f * (float)i;
+            }
+            gfx::TrackEyes({ 0.0f, 0.0f }, ORBIT, target_x, target_y, ball_x, ball_y, level);
+            for (std::size_t i = 0; i < count; i++) {
+                auto expected = gfx::TrackEye({ 0.0f, 0.0f }, ORBIT, { target_x[i], target_y[i] });
+                REQUIRE_NEAR(ball_x[i], expected.x, SIMD_TOLERANCE);
+                REQUIRE_NEAR(ball_y[i], expected.y, SIMD_TOLERANCE);
+            }
+        }
+    }
+}
+
+TEST(EyeTracking, CreateBallsMatchesCreateBall) {
+    auto transformation = MonsterScene::DefaultTransformation(1920.0f, 1080.0f);
+    auto inverse = MonsterScene::InverseTransformation(transformation);
+    for (auto mouse : TestMice(transformation)) {
+        gfx::Ellipse left, right;
+        MonsterScene::CreateBalls(inverse, mouse, left, right);
+        auto expected_left = MonsterScene::CreateBall(transformation, mouse, true);
+        auto expected_right = MonsterScene::CreateBall(transformation, mouse, false);
+        REQUIRE_EQ(left.center.x, expected_left.center.x);
+        REQUIRE_EQ(left.center.y, expected_left.center.y);
+        REQUIRE_EQ(right.center.x, expected_right.center.x);
+        REQUIRE_EQ(right.center.y, expected_right.center.y);
+        CHECK_EQ(left.radius_x, expected_left.radius_x);
+    }
+}
@@ -0,0 +1,71 @@
+#include "Bench.h"
+#include "FlatteningCache.h"
+#include "MonsterScene.h"
+#include <cstdio>
+
+namespace {
+
+// Closed figures have a segment back to their first point.
+std::size_t SegmentCount(const gfx::FlattenedPath& path) {
+    std::size_t count = 0;
+    for (const auto& figure : path.figures) {
+        count += figure.closed ? figure.point_count : figure.point_count - 1;
+    }
+    return count;
+}
+
+}
+
+// Segments and time to flatten the monster's outline, nose and mouths at a range of
+// scales: in a fixed 16 steps per cubic as the CPU renderer used to, adaptively within
+// 0.2 pixels, and through a FlatteningCache that already holds the level, which leaves
+// only the transformation to apply.
+BENCHMARK(FlattenPaths) {
+    gfx::Path paths[4];
+    MonsterScene::CreateMonster(paths[0]);
+    MonsterScene::CreateNose(paths[1]);
+    MonsterScene::CreateSmile(paths[2]);
+    MonsterScene::CreateSad(paths[3]);
+
+    std::printf("%6s %14s %10s %17s %11s %10s\n", "scale", "fixed segments", "fixed us", "adaptive segments",
+        "adaptive us", "cached us");
+    for (float scale : { 0.1f, 0.5f, 1.0f, 3.0f, 10.0f, 40.0f }) {
+        auto transformation = gfx::Matrix3x2::Scale(scale, scale) * gfx::Matrix3x2::Translation(960.0f, 540.0f);
+        gfx::FlattenedPath output;
+
+        std::size_t fixed_segments = 0, adaptive_segments = 0;
+        for (const auto& path : paths) {
+            output.Clear();
+            gfx::FlattenPath(path, transformation, 16, output);
+            fixed_segments += SegmentCount(output);
+            output.Clear();
+            gfx::FlattenPathAdaptive(path, transformation, 0.2f, output);
+            adaptive_segments += SegmentCount(output);
+        }
+
+        auto fixed = bench::Measure([&] {
+            for (const auto& path : paths) {
+                output.Clear();
+                gfx::FlattenPath(path, transformation, 16, output);
+            }
+            bench::KeepAlive(output);
+        });
+        auto adaptive = bench::Measure([&] {
+            for (const auto& path : paths) {
+                output.Clear();
+                gfx::FlattenPathAdaptive(path, transformation, 0.2f, output);
+            }
+            bench::KeepAlive(output);
+        });
+        gfx::FlatteningCache cache;
+        auto cached = bench::Measure([&] {
+            for (const auto& path : paths) {
+                gfx::TransformPath(transformation, cache.Get(path, transformation), output);
+            }
+            bench::KeepAlive(output);
+        });
+
+        std::printf("%6.1f %14zu %10.2f %17zu %11.2f %10.2f\n", scale, fixed_segments, fixed * 1e6, adaptive_segments,
+            adaptive * 1e6, cached * 1e6);
+    }
+}
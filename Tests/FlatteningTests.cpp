@@ -0,0 +1,91 @@
+#include "FlatteningCache.h"
+#include "MonsterScene.h"
+#include "Test.h"
+#include "TestGeometry.h"
+#include <string>
+
+namespace {
+
+struct TestPath {
+    const char* name;
+    void (*create)(gfx::PathSink&);
+};
+
+constexpr TestPath TEST_PATHS[] = {
+    { "monster", MonsterScene::CreateMonster },
+    { "nose", MonsterScene::CreateNose },
+    { "smile", MonsterScene::CreateSmile },
+    { "sad", MonsterScene::CreateSad },
+};
+
+// Slack for the reference itself not being the curve, and for float rounding.
+constexpr double SLACK = 0.01;
+
+}
+
+TEST(Flattening, AdaptiveStaysWithinTolerance) {
+    for (const auto& test_path : TEST_PATHS) {
+        gfx::Path path;
+        test_path.create(path);
+        for (float scale : { 0.1f, 1.0f, 3.0f, 10.0f, 40.0f }) {
+            test::Scope scope(std::string(test_path.name) + " at scale " + std::to_string(scale));
+            auto transformation = gfx::Matrix3x2::Scale(scale, scale);
+            gfx::FlattenedPath adaptive;
+            gfx::FlattenPathAdaptive(path, transformation, 0.2f, adaptive);
+            CHECK(Deviation(FineCurve(path, transformation), adaptive) <= 0.2 + SLACK);
+        }
+    }
+}
+
+TEST(Flattening, SegmentsGrowWithScale) {
+    gfx::Path path;
+    MonsterScene::CreateMonster(path);
+    std::size_t previous = 0;
+    for (float scale : { 0.1f, 0.5f, 1.0f, 3.0f, 10.0f, 40.0f }) {
+        test::Scope scope("scale " + std::to_string(scale));
+        gfx::FlattenedPath adaptive;
+        gfx::FlattenPathAdaptive(path, gfx::Matrix3x2::Scale(scale, scale), 0.2f, adaptive);
+        CHECK(adaptive.points.size() >= previous);
+        previous = adaptive.points.size();
+    }
+    // The fixed-step flattener used 16 per cubic; close up the adaptive one needs more.
+    gfx::FlattenedPath fixed;
+    gfx::FlattenPath(path, gfx::Matrix3x2::Identity(), 16, fixed);
+    CHECK(previous > fixed.points.size());
+}
+
+TEST(Flattening, CachedLevelsStayWithinToleranceForTheirScales) {
+    for (const auto& test_path : TEST_PATHS) {
+        gfx::Path path;
+        test_path.create(path);
+        gfx::FlatteningCache cache;
+        // Both ends of several levels, and scales in between, rotated so the scale isn't
+        // only along the axes.
+        for (float scale = 0.3f; scale < 20.0f; scale *= 1.13f) {
+            test::Scope scope(std::string(test_path.name) + " at scale " + std::to_string(scale));
+            auto transformation = gfx::Matrix3x2::Rotation(17.0f) * gfx::Matrix3x2::Scale(scale, scale) *
+                gfx::Matrix3x2::Translation(640.0f, 360.0f);
+            gfx::FlattenedPath transformed;
+            gfx::TransformPath(transformation, cache.Get(path, transformation), transformed);
+            CHECK(Deviation(FineCurve(path, transformation), transformed) <= gfx::FlatteningCache::TOLERANCE + SLACK);
+        }
+    }
+}
+
+TEST(Flattening, CacheReusesALevelWithinItsScales) {
+    gfx::Path path;
+    MonsterScene::CreateMonster(path);
+    gfx::FlatteningCache cache;
+
+    auto level = gfx::FlatteningCache::LevelOfDetail(3.0f);
+    auto first = cache.Get(path, gfx::Matrix3x2::Scale(3.0f, 3.0f));
+    for (float scale : { 2.9f, 3.0f, 3.05f }) {
+        REQUIRE_EQ(gfx::FlatteningCache::LevelOfDetail(scale), level);
+        auto again = cache.Get(path, gfx::Matrix3x2::Scale(scale, scale) * gfx::Matrix3x2::Translation(100.0f, 5.0f));
+        CHECK(again.points.data() == first.points.data());
+    }
+    CHECK_EQ(cache.Size(), 1u);
+
+    cache.Get(path, gfx::Matrix3x2::Scale(12.0f, 12.0f));
+    CHECK_EQ(cache.Size(), 2u);
+}
@@ -0,0 +1,162 @@
+#include "CpuRenderer.h"
+#include "FrameArena.h"
+#include "Test.h"
+#include "TestScene.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// Every call into the global heap MonsterTests makes, on any thread, is counted here.
+// Only the tests below read the count.
+namespace {
+
+std::atomic<std::uint64_t> heap_calls = 0;
+
+void* CountedAllocate(std::size_t size, std::size_t alignment) {
+    heap_calls.fetch_add(1, std::memory_order_relaxed);
+    size = size ? size : 1;
+#ifdef _WIN32
+    auto* pointer = _aligned_malloc(size, alignment);
+#else
+    auto* pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void CountedFree(void* pointer) {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+}
+
+void* operator new(std::size_t size) {
+    return CountedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return CountedAllocate(size, std::max((std::size_t)alignment, (std::size_t)__STDCPP_DEFAULT_NEW_ALIGNMENT__));
+}
+
+void operator delete(void* pointer) noexcept {
+    CountedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    CountedFree(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    CountedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    CountedFree(pointer);
+}
+
+namespace {
+
+// Heap calls frame_count frames of scenes make, once warm_up frames of the same
+// sequence have let every buffer the renderer keeps grow to fit. The scenes are built
+// beforehand, so only rendering is counted.
+template <class Render>
+std::uint64_t SteadyStateHeapCalls(int warm_up, int frame_count, Render&& render) {
+    for (int frame = 0; frame < warm_up; frame++) {
+        render(frame);
+    }
+    auto before = heap_calls.load();
+    for (int frame = warm_up; frame < warm_up + frame_count; frame++) {
+        render(frame);
+    }
+    return heap_calls.load() - before;
+}
+
+}
+
+TEST(FrameArena, ReusesItsMemoryAfterReset) {
+    gfx::FrameArena arena;
+    auto* first = arena.Allocate(100, 8);
+    auto numbers = arena.AllocateArray<std::uint32_t>(10);
+    CHECK(reinterpret_cast<std::uintptr_t>(numbers.data()) % alignof(std::uint32_t) == 0);
+    CHECK(numbers[0] == 0 && numbers[9] == 0);
+    auto* aligned = arena.Allocate(1, 64);
+    CHECK(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+    CHECK(arena.Used() >= 141);
+    auto allocations = arena.HeapAllocations();
+    CHECK(allocations >= 1);
+
+    arena.Reset();
+    CHECK_EQ(arena.Used(), (std::size_t)0);
+    CHECK(arena.Peak() >= 141);
+    CHECK(arena.Allocate(100, 8) == first);
+    CHECK_EQ(arena.HeapAllocations(), allocations);
+}
+
+TEST(FrameArena, MergesOverflowingFramesIntoOneBlock) {
+    // A frame many blocks long, counting the list of them growing.
+    gfx::FrameArena arena;
+    auto calls = heap_calls.load();
+    for (int i = 0; i < 64; i++) {
+        arena.Allocate(gfx::FrameArena::MIN_BLOCK_SIZE / 2 + 1, 16);
+    }
+    CHECK_EQ(arena.HeapAllocations(), heap_calls.load() - calls);
+    CHECK(arena.HeapAllocations() > 1);
+
+    // The next one like it fits in the block Reset merged them into.
+    arena.Reset();
+    auto allocations = arena.HeapAllocations();
+    calls = heap_calls.load();
+    for (int i = 0; i < 64; i++) {
+        arena.Allocate(gfx::FrameArena::MIN_BLOCK_SIZE / 2 + 1, 16);
+    }
+    arena.Reset();
+    CHECK_EQ(arena.HeapAllocations(), allocations);
+    CHECK_EQ(heap_calls.load(), calls);
+}
+
+TEST(FrameArena, SceneMakesNoHeapCallsAfterWarmUp) {
+    constexpr int WIDTH = 1920, HEIGHT = 1080, WARM_UP = 60, FRAMES = 240;
+    std::vector<SceneState> scenes;
+    for (int frame = 0; frame < WARM_UP + FRAMES; frame++) {
+        scenes.push_back(TestScene(WIDTH, HEIGHT, frame));
+    }
+
+    for (unsigned threads : { 1u, 4u }) {
+        test::Scope scope(std::to_string(threads) + " threads");
+        TestTarget target(WIDTH, HEIGHT);
+        ThreadPool pool(threads);
+        CpuRenderer renderer;
+        renderer.SetTarget(target.surface);
+        renderer.SetThreadPool(&pool);
+
+        CHECK_EQ(SteadyStateHeapCalls(WARM_UP, FRAMES, [&](int frame) { renderer.Render(scenes[frame]); }),
+            (std::uint64_t)0);
+        CHECK(renderer.Arena().Peak() > 0);
+    }
+}
+
+TEST(FrameArena, CrowdMakesNoHeapCallsAfterWarmUp) {
+    constexpr int WIDTH = 1920, HEIGHT = 1080, WARM_UP = 10, FRAMES = 60;
+    auto crowd = TestCrowd(10000, WIDTH, HEIGHT);
+    TestTarget target(WIDTH, HEIGHT);
+    ThreadPool pool(4);
+    CpuRenderer renderer;
+    renderer.SetTarget(target.surface);
+    renderer.SetThreadPool(&pool);
+
+    CHECK_EQ(SteadyStateHeapCalls(WARM_UP, FRAMES, [&](int frame) {
+        crowd.Update(frame / 60.0, { 300.0f + frame, 200.0f });
+        renderer.RenderCrowd(crowd);
+    }), (std::uint64_t)0);
+}
@@ -0,0 +1,68 @@
+#include "Bench.h"
+#include "FrameScheduler.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+// Frame rate, frame-time spread and CPU use of the message loop in each mode on the
+// real clock, rendering a frame of 2 ms of busy work and sleeping as long as the
+// scheduler says. There is no swap chain here, so VSync runs as uncapped would before
+// Present blocks, and OnDemand is measured idle, with nothing invalidated after its
+// first frame.
+BENCHMARK(FramePacing) {
+    using Clock = std::chrono::steady_clock;
+    auto length = bench::Quick() ? 50ms : 2s;
+
+    std::printf("%-11s %8s %16s %16s %8s\n", "mode", "fps", "mean frame ms", "frame ms stddev", "CPU %");
+    for (auto mode : { FrameMode::VSync, FrameMode::FixedRate, FrameMode::OnDemand, FrameMode::Uncapped }) {
+        FrameScheduler scheduler;
+        scheduler.SetMode(mode);
+        scheduler.SetAnimating(false);
+
+        std::vector<double> intervals;
+        auto start = Clock::now();
+        auto cpu_start = std::clock();
+        auto previous = start;
+        std::size_t frames = 0;
+        while (Clock::now() - start < length) {
+            auto now = Clock::now();
+            auto wait = scheduler.TimeUntilNextFrame(now.time_since_epoch());
+            if (wait == FrameScheduler::NEVER) {
+                // Stands in for waiting on input that never comes.
+                std::this_thread::sleep_for(length - (now - start));
+                continue;
+            }
+            if (wait > 0ns) {
+                std::this_thread::sleep_for(wait);
+                now = Clock::now();
+            }
+            scheduler.OnFrame(now.time_since_epoch());
+            if (frames++ > 0) {
+                intervals.push_back(std::chrono::duration<double, std::milli>(now - previous).count());
+            }
+            previous = now;
+            while (Clock::now() - now < 2ms) {
+            }
+        }
+        auto wall = std::chrono::duration<double>(Clock::now() - start).count();
+        auto cpu = (double)(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+        double mean = 0.0, variance = 0.0;
+        for (auto interval : intervals) {
+            mean += interval;
+        }
+        mean = intervals.empty() ? 0.0 : mean / intervals.size();
+        for (auto interval : intervals) {
+            variance += (interval - mean) * (interval - mean);
+        }
+        variance = intervals.empty() ? 0.0 : variance / intervals.size();
+
+        std::printf("%-11s %8.1f %16.3f %16.3f %8.1f\n", FrameModeName(mode).data(), frames / wall,
+            mean, std::sqrt(variance), 100.0 * cpu / wall);
+    }
+}
@@ -0,0 +1,167 @@
+#include "FrameScheduler.h"
+#include "Test.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+using Duration = FrameScheduler::Duration;
+
+// Drives a scheduler the way the message loop does, on a fake clock: wait as long as it
+// says, oversleeping by up to wake_up_latency, render for render_time, repeat. Returns
+// the times frames started at.
+std::vector<Duration> RunLoop(FrameScheduler& scheduler, Duration length, Duration render_time,
+    Duration wake_up_latency = 0ns, unsigned seed = 0) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<Duration::rep> latency(0, wake_up_latency.count());
+
+    std::vector<Duration> frames;
+    Duration now = 1s;
+    auto end = now + length;
+    while (now < end) {
+        auto wait = scheduler.TimeUntilNextFrame(now);
+        if (wait == FrameScheduler::NEVER) {
+            break;
+        }
+        if (wait > 0ns) {
+            now += wait + Duration(latency(random));
+        }
+        scheduler.OnFrame(now);
+        frames.push_back(now);
+        now += render_time;
+    }
+    return frames;
+}
+
+}
+
+TEST(FrameScheduler, FixedRateHoldsTheRate) {
+    for (double rate : { 24.0, 30.0, 60.0, 144.0 }) {
+        test::Scope scope(std::to_string(rate) + " fps");
+        FrameScheduler scheduler;
+        scheduler.SetMode(FrameMode::FixedRate);
+        scheduler.SetFrameRate(rate);
+
+        auto frames = RunLoop(scheduler, 10s, 2ms);
+        CHECK_NEAR((double)frames.size(), rate * 10.0, 1.0);
+        for (std::size_t i = 1; i < frames.size(); i++) {
+            REQUIRE_EQ((frames[i] - frames[i - 1]).count(), scheduler.FramePeriod().count());
+        }
+    }
+}
+
+TEST(FrameScheduler, FixedRateDoesNotDriftWithWakeUpLatency) {
+    // Oversleeping by up to 3 ms every frame delays frames but not the deadlines, so
+    // after a minute frame n still starts within the latency of n periods in.
+    FrameScheduler scheduler;
+    scheduler.SetMode(FrameMode::FixedRate);
+    scheduler.SetFrameRate(60.0);
+
+    auto frames = RunLoop(scheduler, 60s, 4ms, 3ms, 7);
+    CHECK_NEAR((double)frames.size(), 3600.0, 1.0);
+    auto period = scheduler.FramePeriod();
+    Duration worst = 0ns;
+    for (std::size_t i = 0; i < frames.size(); i++) {
+        worst = std::max(worst, frames[i] - (frames[0] + (Duration::rep)i * period));
+    }
+    CHECK(worst >= 0ns);
+    CHECK(worst <= 3ms);
+}
+
+TEST(FrameScheduler, FixedRateStartsOverAfterAStallInsteadOfBursting) {
+    FrameScheduler scheduler;
+    scheduler.SetMode(FrameMode::FixedRate);
+    scheduler.SetFrameRate(50.0);
+    auto period = scheduler.FramePeriod();
+
+    Duration now = 1s;
+    scheduler.OnFrame(now);
+    // The next frame is due a period later, not before.
+    CHECK_EQ(scheduler.TimeUntilNextFrame(now + 5ms).count(), (period - 5ms).count());
+
+    // Rendered 100 ms late: due at once, then a whole period after that rather than five
+    // frames straight away to catch up.
+    now += period + 100ms;
+    CHECK_EQ(scheduler.TimeUntilNextFrame(now).count(), 0);
+    scheduler.OnFrame(now);
+    CHECK_EQ(scheduler.TimeUntilNextFrame(now).count(), period.count());
+
+    // Less than a period late keeps the cadence: the next deadline is still on the grid.
+    auto due = now + period;
+    now = due + period / 2;
+    scheduler.OnFrame(now);
+    CHECK_EQ(scheduler.TimeUntilNextFrame(now).count(), (due + period - now).count());
+}
+
+TEST(FrameScheduler, OnDemandRendersOnlyWhenSomethingChanged) {
+    FrameScheduler scheduler;
+    scheduler.SetMode(FrameMode::OnDemand);
+    scheduler.SetAnimating(false);
+
+    // Switching modes draws one frame, so the window shows the new state.
+    Duration now = 1s;
+    CHECK_EQ(scheduler.TimeUntilNextFrame(now).count(), 0);
+    scheduler.OnFrame(now);
+    CHECK(scheduler.TimeUntilNextFrame(now) == FrameScheduler::NEVER);
+    CHECK(RunLoop(scheduler, 10s, 1ms).empty());
+
+    // One frame per Invalidate, however many come before it.
+    scheduler.Invalidate();
+    scheduler.Invalidate();
+    CHECK_EQ(RunLoop(scheduler, 10s, 1ms).size(), 1u);
+
+    // Continuous while animating.
+    scheduler.SetAnimating(true);
+    CHECK_EQ(RunLoop(scheduler, 1s, 10ms).size(), 100u);
+    scheduler.SetAnimating(false);
+    CHECK(RunLoop(scheduler, 1s, 10ms).empty());
+}
+
+TEST(FrameScheduler, VSyncAndUncappedLeavePacingToPresent) {
+    FrameScheduler scheduler;
+    for (auto mode : { FrameMode::VSync, FrameMode::Uncapped }) {
+        test::Scope scope(std::string(FrameModeName(mode)));
+        scheduler.SetMode(mode);
+        scheduler.SetAnimating(false);
+        for (Duration now : { Duration(1s), 1s + 1ns, Duration(2s) }) {
+            scheduler.OnFrame(now);
+            CHECK_EQ(scheduler.TimeUntilNextFrame(now).count(), 0);
+        }
+    }
+
+    scheduler.SetMode(FrameMode::VSync);
+    CHECK_EQ(scheduler.SyncInterval(), 1u);
+    CHECK(scheduler.WaitsForSwapChain());
+    scheduler.SetMode(FrameMode::OnDemand);
+    CHECK_EQ(scheduler.SyncInterval(), 1u);
+    scheduler.SetMode(FrameMode::Uncapped);
+    CHECK_EQ(scheduler.SyncInterval(), 0u);
+    CHECK(!scheduler.WaitsForSwapChain());
+    scheduler.SetMode(FrameMode::FixedRate);
+    CHECK_EQ(scheduler.SyncInterval(), 0u);
+}
+
+TEST(FrameScheduler, SwitchingModesStartsTheScheduleOver) {
+    FrameScheduler scheduler;
+    scheduler.SetMode(FrameMode::FixedRate);
+    scheduler.OnFrame(1s);
+    CHECK(scheduler.TimeUntilNextFrame(1s) > 0ns);
+
+    scheduler.SetMode(FrameMode::FixedRate);
+    CHECK_EQ(scheduler.TimeUntilNextFrame(1s).count(), 0);
+}
+
+TEST(FrameScheduler, FrameRateIsAtLeastOne) {
+    FrameScheduler scheduler;
+    CHECK_EQ(scheduler.FramePeriod().count(), std::chrono::duration_cast<Duration>(1s / 60.0).count());
+    scheduler.SetFrameRate(0.0);
+    CHECK_EQ(scheduler.FramePeriod().count(), Duration(1s).count());
+    scheduler.SetFrameRate(-5.0);
+    CHECK_EQ(scheduler.FramePeriod().count(), Duration(1s).count());
+}
@@ -0,0 +1,58 @@
+#include "Bench.h"
+#include "FrameSink.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// 4K frames through a shared-memory ring to the reference consumer on another thread:
+// published as fast as the producer can fill them, and paced at 60 frames per second.
+// Each frame is filled with memset, standing in for the renderer drawing it, and the
+// consumer reads every row in place.
+BENCHMARK(FrameSinkThroughput) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int WIDTH = 3840, HEIGHT = 2160;
+    auto read_frames = bench::Quick() ? 3 : 240;
+
+    std::printf("%-9s %12s %12s %8s %9s %9s %8s %6s\n", "producer", "produced/s", "read/s", "GB/s",
+        "median ms", "p95 ms", "dropped", "torn");
+    for (auto paced : { false, true }) {
+        auto name = "MonsterBench-" + std::to_string(SteadyNanoseconds());
+        FrameSink sink;
+        if (!sink.Create(name, WIDTH, HEIGHT)) {
+            std::printf("can't create a shared-memory ring\n");
+            return;
+        }
+
+        std::atomic<bool> done = false;
+        double produce_seconds = 0.0;
+        std::thread producer([&] {
+            auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 60.0));
+            auto start = Clock::now(), next = start;
+            while (!done.load(std::memory_order_acquire)) {
+                auto surface = sink.BeginFrame();
+                std::memset(surface.pixels, (int)(sink.Frames() & 0xff), (std::size_t)surface.stride * surface.height);
+                sink.EndFrame(SteadyNanoseconds());
+                if (paced) {
+                    next += interval;
+                    std::this_thread::sleep_until(next);
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+            produce_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        });
+
+        auto result = WatchFrames({ .name = name, .frame_count = read_frames });
+        done.store(true, std::memory_order_release);
+        producer.join();
+
+        std::printf("%-9s %12.1f %12.1f %8.2f %9.3f %9.3f %8d %6d\n", paced ? "60 fps" : "unpaced",
+            produce_seconds > 0.0 ? sink.Frames() / produce_seconds : 0.0, result.FramesPerSecond(),
+            result.GigabytesPerSecond(), result.median_latency_milliseconds, result.p95_latency_milliseconds,
+            result.dropped, result.torn);
+    }
+}
@@ -0,0 +1,173 @@
+#include "FrameSink.h"
+#include "Test.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+// A name no other test run is using at the same time.
+std::string RingName(const char* test) {
+    return std::string("MonsterTests-") + test + "-" + std::to_string(SteadyNanoseconds());
+}
+
+// Fills every 64 bit word of the frame with its number.
+void DrawFrame(const gfx::Surface& surface, std::uint64_t frame) {
+    for (int y = 0; y < surface.height; y++) {
+        auto* row = surface.Row(y);
+        for (int x = 0; x + 1 < surface.width; x += 2) {
+            std::memcpy(row + x * 4, &frame, sizeof(frame));
+        }
+    }
+}
+
+// Whether every 64 bit word of the frame is the frame's number.
+bool HoldsFrame(const FrameView& view) {
+    for (int y = 0; y < view.height; y++) {
+        const auto* row = view.Row(y);
+        for (int x = 0; x + 1 < view.width; x += 2) {
+            std::uint64_t word;
+            std::memcpy(&word, row + x * 4, sizeof(word));
+            if (word != view.frame) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::uint64_t Publish(FrameSink& sink) {
+    auto frame = sink.Frames() + 1;
+    DrawFrame(sink.BeginFrame(), frame);
+    sink.EndFrame(SteadyNanoseconds());
+    return frame;
+}
+
+}
+
+TEST(FrameSink, RejectsBadRings) {
+    FrameSink sink;
+    auto name = RingName("bad");
+    CHECK(!sink.Create(name, 0, 64));
+    CHECK(!sink.Create(name, 64, 20000));
+    CHECK(!sink.Create(name, 64, 64, 0));
+    CHECK(!sink.Create(name, 64, 64, FrameSink::MAX_SLOTS + 1));
+
+    FrameSource source;
+    CHECK(!source.Open(name));
+    FrameView view;
+    CHECK(!source.Latest(view));
+}
+
+TEST(FrameSink, ReadsBackWhatWasWritten) {
+    FrameSink sink;
+    auto name = RingName("round-trip");
+    REQUIRE(sink.Create(name, 96, 54));
+    FrameSource source;
+    REQUIRE(source.Open(name));
+
+    FrameView view;
+    CHECK(!source.Latest(view));
+
+    for (int i = 0; i < 2 * sink.SlotCount() + 1; i++) {
+        auto before = SteadyNanoseconds();
+        auto frame = Publish(sink);
+        REQUIRE(source.Latest(view));
+        CHECK_EQ(view.frame, frame);
+        CHECK_EQ(view.width, 96);
+        CHECK_EQ(view.height, 54);
+        CHECK(view.stride >= 96 * 4);
+        CHECK(view.format == FrameFormat::Bgra8);
+        CHECK(view.timestamp >= before);
+        CHECK(HoldsFrame(view));
+        CHECK(source.IsIntact(view));
+
+        // Nothing newer until the next frame.
+        FrameView newer;
+        CHECK(!source.Latest(newer, view.frame));
+    }
+}
+
+TEST(FrameSink, DetectsFramesOverwrittenWhileRead) {
+    FrameSink sink;
+    auto name = RingName("torn");
+    REQUIRE(sink.Create(name, 64, 32));
+    FrameSource source;
+    REQUIRE(source.Open(name));
+
+    Publish(sink);
+    FrameView view;
+    REQUIRE(source.Latest(view));
+
+    // Frames in the other slots leave it alone.
+    for (int i = 1; i < sink.SlotCount(); i++) {
+        Publish(sink);
+    }
+    CHECK(source.IsIntact(view));
+
+    // Starting to draw the frame after them takes its slot, before it's published.
+    sink.BeginFrame();
+    CHECK(!source.IsIntact(view));
+    sink.EndFrame(SteadyNanoseconds());
+    CHECK(!source.IsIntact(view));
+
+    FrameView latest;
+    REQUIRE(source.Latest(latest, view.frame));
+    CHECK_EQ(latest.frame, (std::uint64_t)sink.SlotCount() + 1);
+}
+
+TEST(FrameSink, ProducerNeverWaitsForReaders) {
+    // A reader sits on a frame and another reads as fast as it can. The producer still
+    // finishes every frame, and every frame a reader got intact is whole.
+    FrameSink sink;
+    auto name = RingName("stress");
+    REQUIRE(sink.Create(name, 256, 64));
+
+    FrameSource stuck;
+    REQUIRE(stuck.Open(name));
+    Publish(sink);
+    FrameView held;
+    REQUIRE(stuck.Latest(held));
+
+    constexpr std::uint64_t FRAMES = 20000;
+    std::atomic<bool> done = false;
+    int intact = 0, whole = 0;
+    std::thread reader([&] {
+        FrameSource source;
+        if (!source.Open(name)) {
+            return;
+        }
+        std::uint64_t last = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            FrameView view;
+            if (!source.Latest(view, last)) {
+                std::this_thread::yield();
+                continue;
+            }
+            last = view.frame;
+            auto holds = HoldsFrame(view);
+            if (!source.IsIntact(view)) {
+                continue;
+            }
+            intact++;
+            whole += holds;
+        }
+    });
+
+    for (std::uint64_t i = 1; i < FRAMES; i++) {
+        Publish(sink);
+        // Lets the reader start on a frame before it's overwritten, even on one core.
+        if (i % 8 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    CHECK_EQ(sink.Frames(), FRAMES);
+    CHECK(intact > 0);
+    CHECK_EQ(whole, intact);
+    CHECK(!stuck.IsIntact(held));
+}
@@ -0,0 +1,77 @@
+#include "Bench.h"
+#include "CpuRenderer.h"
+#include "FlatteningCache.h"
+#include "MonsterScene.h"
+#include "TestScene.h"
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+// Startup with and without a geometry file: 200 distinct shapes, each the monster's
+// body slightly reshaped, flattened at runtime against mapping, checking and looking
+// them up in a file baked beforehand, and the monster's first frame at 1280x720 from a
+// new CpuRenderer, flattening its paths or loading what -bake wrote.
+BENCHMARK(GeometryStartup) {
+    constexpr int SHAPES = 200;
+    auto directory = std::filesystem::temp_directory_path();
+    auto shapes_file = directory / "MonsterBench-shapes.bin", monster_file = directory / "MonsterBench-monster.bin";
+
+    std::vector<gfx::Path> shapes(SHAPES);
+    for (int i = 0; i < SHAPES; i++) {
+        MonsterScene::monster_shape.CopyTo(shapes[i]);
+        auto stretch = 1.0f + 0.002f * i;
+        for (auto& point : shapes[i].MutablePoints()) {
+            point.x *= stretch;
+        }
+    }
+    std::vector<const gfx::Path*> shape_pointers;
+    for (const auto& shape : shapes) {
+        shape_pointers.push_back(&shape);
+    }
+
+    gfx::FlatteningCache cache;
+    auto flatten = [&] {
+        cache.Clear();
+        for (const auto& shape : shapes) {
+            bench::KeepAlive(cache.Get(shape, gfx::Matrix3x2::Identity()));
+        }
+    };
+    auto shapes_runtime = bench::Measure(flatten);
+    flatten();
+    cache.Save(shapes_file);
+    auto shapes_mapped = bench::Measure([&] {
+        cache.Clear();
+        cache.Load(shapes_file, shape_pointers);
+        for (const auto& shape : shapes) {
+            bench::KeepAlive(cache.Get(shape, gfx::Matrix3x2::Identity()));
+        }
+    });
+
+    {
+        CpuRenderer baker;
+        baker.BakeGeometry(monster_file);
+    }
+    auto scene = TestScene(1280, 720, 0);
+    TestTarget target(1280, 720);
+    auto first_frame = [&](bool load) {
+        return bench::Measure([&] {
+            CpuRenderer renderer;
+            if (load) {
+                renderer.LoadGeometry(monster_file);
+            }
+            renderer.SetTarget(target.surface);
+            renderer.Render(scene);
+            bench::KeepAlive(target.pixels);
+        });
+    };
+    auto monster_runtime = first_frame(false);
+    auto monster_mapped = first_frame(true);
+
+    std::printf("%-24s %14s %14s\n", "startup", "runtime ms", "from file ms");
+    std::printf("%-24s %14.3f %14.3f\n", "200 shapes", shapes_runtime * 1e3, shapes_mapped * 1e3);
+    std::printf("%-24s %14.3f %14.3f\n", "monster's first frame", monster_runtime * 1e3, monster_mapped * 1e3);
+
+    std::error_code error;
+    std::filesystem::remove(shapes_file, error);
+    std::filesystem::remove(monster_file, error);
+}
@@ -0,0 +1,211 @@
+#include "CpuRenderer.h"
+#include "FlatteningCache.h"
+#include "GeometryFile.h"
+#include "MonsterScene.h"
+#include "Test.h"
+#include "TestScene.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using gfx::FlatteningCache;
+
+// A file in the temporary directory, removed again when it goes out of scope.
+struct TemporaryFile {
+    std::filesystem::path path;
+
+    explicit TemporaryFile(const char* name)
+        : path(std::filesystem::temp_directory_path() / ("MonsterTests-" + std::string(name))) {}
+    ~TemporaryFile() {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+};
+
+// Overwrites one byte of the file, at offset from its end.
+void DamageByte(const std::filesystem::path& path, std::uint64_t offset_from_end) {
+    std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+    stream.seekg(0, std::ios::end);
+    auto position = (std::streamoff)stream.tellg() - (std::streamoff)offset_from_end;
+    stream.seekg(position);
+    auto byte = (char)stream.get();
+    stream.seekp(position);
+    stream.put((char)(byte ^ 0x5a));
+}
+
+// The paths CpuRenderer bakes, built the same way, so their hashes match.
+struct MonsterPaths {
+    gfx::Path monster, nose, smile, sad, left_eye, right_eye, unit_circle;
+
+    MonsterPaths() {
+        MonsterScene::monster_shape.CopyTo(monster);
+        MonsterScene::nose_shape.CopyTo(nose);
+        MonsterScene::smile_shape.CopyTo(smile);
+        MonsterScene::sad_shape.CopyTo(sad);
+        left_eye.AddEllipse(MonsterScene::left_eye);
+        right_eye.AddEllipse(MonsterScene::right_eye);
+        unit_circle.AddEllipse({ { 0.0f, 0.0f }, 1.0f, 1.0f });
+    }
+
+    std::vector<const gfx::Path*> All() const {
+        return { &monster, &nose, &smile, &sad, &left_eye, &right_eye, &unit_circle };
+    }
+};
+
+bool SamePath(gfx::FlatPathView a, gfx::FlatPathView b) {
+    if (a.points.size() != b.points.size() || a.figures.size() != b.figures.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.points.size(); i++) {
+        if (a.points[i].x != b.points[i].x || a.points[i].y != b.points[i].y) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < a.figures.size(); i++) {
+        const auto &x = a.figures[i], &y = b.figures[i];
+        if (x.first_point != y.first_point || x.point_count != y.point_count || x.filled != y.filled ||
+            x.closed != y.closed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Frames of the animated scene from a renderer that loaded filename, or tried to.
+std::vector<std::uint8_t> RenderFrames(const std::filesystem::path& filename, bool& loaded) {
+    TestTarget target(320, 240);
+    CpuRenderer renderer;
+    loaded = !filename.empty() && renderer.LoadGeometry(filename);
+    renderer.SetTarget(target.surface);
+    std::vector<std::uint8_t> frames;
+    for (int frame = 0; frame < 40; frame += 3) {
+        renderer.Render(TestScene(320, 240, frame));
+        frames.insert(frames.end(), target.pixels.begin(), target.pixels.end());
+    }
+    return frames;
+}
+
+}
+
+TEST(GeometryFile, ReadsBackWhatWasWritten) {
+    TemporaryFile file("round-trip.bin");
+    MonsterPaths paths;
+    std::vector<gfx::FlattenedPath> flattened(3);
+    gfx::FlattenPathAdaptive(paths.monster, gfx::Matrix3x2::Identity(), 0.2f, flattened[0]);
+    gfx::FlattenPathAdaptive(paths.smile, gfx::Matrix3x2::Identity(), 0.05f, flattened[1]);
+    gfx::FlattenPathAdaptive(paths.left_eye, gfx::Matrix3x2::Scale(3.0f, 3.0f), 0.2f, flattened[2]);
+    std::vector<gfx::BakedPath> baked = {
+        { gfx::HashPath(paths.monster), 0, flattened[0] },
+        { gfx::HashPath(paths.smile), 4, flattened[1] },
+        { gfx::HashPath(paths.left_eye), -3, flattened[2] },
+    };
+    REQUIRE(gfx::GeometryFile::Write(file.path, 0.2f, baked));
+
+    gfx::GeometryFile opened;
+    REQUIRE(opened.Open(file.path));
+    CHECK_EQ(opened.Tolerance(), 0.2f);
+    REQUIRE_EQ(opened.Paths().size(), baked.size());
+    for (std::size_t i = 0; i < baked.size(); i++) {
+        test::Scope scope("path " + std::to_string(i));
+        const auto& path = opened.Paths()[i];
+        CHECK_EQ(path.source_hash, baked[i].source_hash);
+        CHECK_EQ(path.level, baked[i].level);
+        CHECK(SamePath(path.flattened, baked[i].flattened));
+    }
+}
+
+TEST(GeometryFile, RejectsDamagedFiles) {
+    TemporaryFile file("damaged.bin");
+    MonsterPaths paths;
+    gfx::FlattenedPath flattened;
+    gfx::FlattenPathAdaptive(paths.monster, gfx::Matrix3x2::Identity(), 0.2f, flattened);
+    std::vector<gfx::BakedPath> baked = { { gfx::HashPath(paths.monster), 0, flattened } };
+
+    gfx::GeometryFile opened;
+    CHECK(!opened.Open(file.path));
+    CHECK(opened.Paths().empty());
+
+    // A flipped bit in the points, which only the checksum catches.
+    REQUIRE(gfx::GeometryFile::Write(file.path, 0.2f, baked));
+    DamageByte(file.path, 5);
+    CHECK(!opened.Open(file.path));
+    CHECK(opened.Paths().empty());
+
+    // A truncated file.
+    REQUIRE(gfx::GeometryFile::Write(file.path, 0.2f, baked));
+    std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) - 8);
+    CHECK(!opened.Open(file.path));
+
+    // Another version.
+    REQUIRE(gfx::GeometryFile::Write(file.path, 0.2f, baked));
+    {
+        std::fstream stream(file.path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp(4);
+        auto version = gfx::GeometryFile::VERSION + 1;
+        stream.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    CHECK(!opened.Open(file.path));
+
+    REQUIRE(gfx::GeometryFile::Write(file.path, 0.2f, baked));
+    CHECK(opened.Open(file.path));
+}
+
+TEST(GeometryFile, BakeHoldsEveryLevelOfEveryPath) {
+    TemporaryFile file("bake.bin");
+    CpuRenderer renderer;
+    REQUIRE(renderer.BakeGeometry(file.path));
+
+    gfx::GeometryFile opened;
+    REQUIRE(opened.Open(file.path));
+    CHECK_EQ(opened.Tolerance(), FlatteningCache::TOLERANCE);
+    MonsterPaths paths;
+    auto first = FlatteningCache::LevelOfDetail(CpuRenderer::BAKE_MIN_SCALE);
+    auto last = FlatteningCache::LevelOfDetail(CpuRenderer::BAKE_MAX_SCALE);
+    for (const auto* path : paths.All()) {
+        auto hash = gfx::HashPath(*path);
+        for (auto level = first; level <= last; level++) {
+            test::Scope scope("level " + std::to_string(level));
+            auto found = false;
+            for (const auto& baked : opened.Paths()) {
+                if (baked.source_hash == hash && baked.level == level) {
+                    // What FlatteningCache flattens at runtime for that level.
+                    gfx::FlattenedPath runtime;
+                    gfx::FlattenPathAdaptive(*path, gfx::Matrix3x2::Identity(),
+                        FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(level), runtime);
+                    found = SamePath(baked.flattened, runtime);
+                }
+            }
+            CHECK(found);
+        }
+    }
+}
+
+TEST(GeometryFile, RendererFallsBackToRuntimeFlattening) {
+    TemporaryFile file("renderer.bin");
+    {
+        CpuRenderer baker;
+        REQUIRE(baker.BakeGeometry(file.path));
+    }
+
+    bool loaded = false;
+    auto runtime = RenderFrames({}, loaded);
+    CHECK(!loaded);
+
+    auto baked = RenderFrames(file.path, loaded);
+    CHECK(loaded);
+    CHECK(baked == runtime);
+
+    DamageByte(file.path, 100);
+    auto damaged = RenderFrames(file.path, loaded);
+    CHECK(!loaded);
+    CHECK(damaged == runtime);
+
+    TemporaryFile missing("missing.bin");
+    auto fallback = RenderFrames(missing.path, loaded);
+    CHECK(!loaded);
+    CHECK(fallback == runtime);
+}
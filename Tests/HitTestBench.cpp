@@ -0,0 +1,78 @@
+#include "Bench.h"
+#include "MonsterHitTest.h"
+#include "TestScene.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Crowd hit testing at several crowd sizes over a 1920x1080 target: building the index,
+// refitting it after every monster moved a little, and random point queries one at a
+// time and batched, against testing every monster's shapes from the top down as
+// per-instance FillContainsPoint calls would.
+BENCHMARK(CrowdHitTest) {
+    constexpr int WIDTH = 1920, HEIGHT = 1080;
+
+    std::printf("%9s %10s %10s %10s %10s %10s %16s\n", "monsters", "build ms", "refit ms", "rebuilt %", "query ns",
+        "batch ns", "brute force ns");
+    for (std::size_t count : { 1000u, 10000u, 100000u }) {
+        auto crowd = TestCrowd(count, WIDTH, HEIGHT);
+        crowd.Update(0.5, { WIDTH / 2.0f, HEIGHT / 2.0f });
+
+        std::mt19937 random(4);
+        std::uniform_real_distribution<float> x(0.0f, (float)WIDTH), y(0.0f, (float)HEIGHT);
+        std::vector<gfx::Point> points(bench::Quick() ? 100 : 100000);
+        for (auto& point : points) {
+            point = { x(random), y(random) };
+        }
+        std::vector<CrowdHit> hits(points.size());
+
+        CrowdHitIndex index;
+        auto build = bench::Measure([&] {
+            index.Build(crowd);
+        });
+        // Alternately nudged back and forth, as a slowly swaying crowd would move. A
+        // monster that happens to cross a cell boundary makes it rebuild.
+        auto nudge = 1e-3f;
+        int refits = 0, rebuilds = 0;
+        auto refit = bench::Measure([&] {
+            for (auto& position : crowd.position_x) {
+                position += nudge;
+            }
+            nudge = -nudge;
+            refits++;
+            rebuilds += index.Update(crowd);
+        });
+
+        auto query = bench::Measure([&] {
+            for (std::size_t i = 0; i < points.size(); i++) {
+                hits[i] = index.HitTest(crowd, points[i]);
+            }
+            bench::KeepAlive(hits);
+        });
+        auto batch = bench::Measure([&] {
+            index.HitTest(crowd, points, hits);
+            bench::KeepAlive(hits);
+        });
+
+        // Every monster for a few points, which is plenty to time it.
+        MonsterHitTester tester;
+        auto brute_points = std::min<std::size_t>(points.size(), 100);
+        auto brute_force = bench::Measure([&] {
+            for (std::size_t p = 0; p < brute_points; p++) {
+                auto point = points[p];
+                for (auto i = crowd.Size(); i > 0; i--) {
+                    auto inverse_scale = 1.0f / (MonsterScene::SCALE * crowd.scale[i - 1]);
+                    gfx::Point local = { (point.x - crowd.position_x[i - 1]) * inverse_scale,
+                        (point.y - crowd.position_y[i - 1]) * inverse_scale };
+                    if (tester.HitTest(local, crowd.angle[i - 1], 0.0f) != MonsterPart::None) {
+                        break;
+                    }
+                }
+            }
+        });
+
+        std::printf("%9zu %10.3f %10.3f %10.0f %10.1f %10.1f %16.1f\n", count, build * 1e3, refit * 1e3,
+            100.0 * rebuilds / refits, query / points.size() * 1e9, batch / points.size() * 1e9, brute_force / brute_points * 1e9);
+    }
+}
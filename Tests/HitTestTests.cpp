@@ -0,0 +1,175 @@
+#include "MonsterHitTest.h"
+#include "Stroke.h"
+#include "Test.h"
+#include "TestGeometry.h"
+#include "TestScene.h"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void CheckAgainstWinding(gfx::FlatPathView path) {
+    gfx::PathHitTester tester;
+    tester.Build(path);
+    const auto& bounds = tester.Bounds();
+
+    // Points all over the bounds and a margin around them.
+    std::mt19937 random(5);
+    auto margin = 0.1f * (bounds.right - bounds.left);
+    std::uniform_real_distribution<float> x(bounds.left - margin, bounds.right + margin);
+    std::uniform_real_distribution<float> y(bounds.top - margin, bounds.bottom + margin);
+    int inside = 0, mismatches = 0;
+    for (int i = 0; i < 200000; i++) {
+        gfx::Point p = { x(random), y(random) };
+        auto expected = WindingContains(path, p);
+        inside += expected;
+        mismatches += tester.Contains(p) != expected;
+    }
+    CHECK(inside > 0);
+    CHECK_EQ(mismatches, 0);
+}
+
+// The topmost monster whose shapes hold p, trying every monster from the last drawn.
+CrowdHit BruteForceHit(const MonsterHitTester& tester, const Crowd& crowd, gfx::Point p) {
+    for (auto i = crowd.Size(); i > 0; i--) {
+        auto inverse_scale = 1.0f / (MonsterScene::SCALE * crowd.scale[i - 1]);
+        gfx::Point local = { (p.x - crowd.position_x[i - 1]) * inverse_scale,
+            (p.y - crowd.position_y[i - 1]) * inverse_scale };
+        auto part = tester.HitTest(local, crowd.angle[i - 1],
+            crowd.expression[i - 1] == Expression::Smile ? 1.0f : 0.0f);
+        if (part != MonsterPart::None) {
+            return { (std::uint32_t)(i - 1), part };
+        }
+    }
+    return {};
+}
+
+// Random points over the crowd, and the center of every monster's left eye, which is
+// always on some monster.
+std::vector<gfx::Point> TestPoints(const Crowd& crowd, int width, int height, unsigned seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> x(-50.0f, width + 50.0f), y(-50.0f, height + 50.0f);
+    std::vector<gfx::Point> points;
+    for (int i = 0; i < 20000; i++) {
+        points.push_back({ x(random), y(random) });
+    }
+    for (std::size_t i = 0; i < crowd.Size(); i++) {
+        auto s = MonsterScene::SCALE * crowd.scale[i];
+        points.push_back({ crowd.position_x[i] + MonsterScene::left_eye.center.x * s,
+            crowd.position_y[i] + MonsterScene::left_eye.center.y * s });
+    }
+    return points;
+}
+
+void CheckIndexAgainstBruteForce(const CrowdHitIndex& index, const MonsterHitTester& tester, const Crowd& crowd,
+    const std::vector<gfx::Point>& points) {
+    int hits = 0, mismatches = 0;
+    for (auto p : points) {
+        auto expected = BruteForceHit(tester, crowd, p);
+        auto hit = index.HitTest(crowd, p);
+        hits += expected.instance != CrowdHit::NONE;
+        mismatches += hit.instance != expected.instance || hit.part != expected.part;
+    }
+    CHECK(hits > 0);
+    CHECK_EQ(mismatches, 0);
+}
+
+}
+
+TEST(HitTest, PathTesterMatchesWindingOverEveryEdge) {
+    gfx::Path body;
+    MonsterScene::CreateMonster(body);
+    gfx::FlattenedPath flattened;
+    gfx::FlattenPathAdaptive(body, gfx::Matrix3x2::Identity(), MonsterHitTester::TOLERANCE, flattened);
+    {
+        test::Scope scope("body");
+        CheckAgainstWinding(flattened);
+    }
+
+    // A stroke overlaps itself at every join, which only nonzero filling gets right.
+    gfx::FlattenedPath outline;
+    gfx::StrokePath(flattened, { .width = 6.0f, .join = gfx::LineJoin::Round }, MonsterHitTester::TOLERANCE, outline);
+    {
+        test::Scope scope("round-joined outline");
+        CheckAgainstWinding(outline);
+    }
+}
+
+TEST(HitTest, FindsEachPartOfTheMonster) {
+    MonsterHitTester tester;
+    CHECK(tester.HitTest(MonsterScene::left_eye.center, 0.0f, 0.0f) == MonsterPart::Eye);
+    CHECK(tester.HitTest(MonsterScene::right_eye.center, 0.0f, 1.0f) == MonsterPart::Eye);
+    CHECK(tester.HitTest({ 0.0f, -55.0f }, 0.0f, 0.0f) == MonsterPart::Body);
+    CHECK(tester.HitTest({ 1000.0f, 0.0f }, 0.0f, 0.0f) == MonsterPart::None);
+
+    // The end of the first segment of the mouths and the start of the nose are on their
+    // outlines, and the parts turn with the angle.
+    auto on_curve = [](const auto& shape, std::size_t i) { return shape.points[i]; };
+    for (float angle : { 0.0f, 10.0f, -25.0f }) {
+        test::Scope scope("angle " + std::to_string(angle));
+        auto turn = gfx::Matrix3x2::Rotation(angle);
+        CHECK(tester.HitTest(turn.TransformPoint(on_curve(MonsterScene::smile_shape, 3)), angle, 1.0f) ==
+            MonsterPart::Mouth);
+        CHECK(tester.HitTest(turn.TransformPoint(on_curve(MonsterScene::sad_shape, 3)), angle, 0.0f) ==
+            MonsterPart::Mouth);
+        CHECK(tester.HitTest(turn.TransformPoint(on_curve(MonsterScene::nose_shape, 0)), angle, 0.0f) ==
+            MonsterPart::Nose);
+    }
+}
+
+TEST(HitTest, CrowdIndexMatchesBruteForce) {
+    MonsterHitTester tester;
+    for (std::size_t count : { 1u, 50u, 2000u }) {
+        test::Scope scope(std::to_string(count) + " monsters");
+        auto crowd = TestCrowd(count, 1280, 720);
+        crowd.Update(0.7, { 640.0f, 360.0f });
+        CrowdHitIndex index;
+        index.Build(crowd);
+        CheckIndexAgainstBruteForce(index, tester, crowd, TestPoints(crowd, 1280, 720, 9));
+    }
+}
+
+TEST(HitTest, CrowdIndexFollowsMovingMonsters) {
+    MonsterHitTester tester;
+    auto crowd = TestCrowd(500, 1280, 720);
+    crowd.Update(0.0, { 0.0f, 0.0f });
+    CrowdHitIndex index;
+    index.Build(crowd);
+
+    // Nudged by a hair, every monster stays in its cells and only its bounds change.
+    for (auto& x : crowd.position_x) {
+        x += 1e-3f;
+    }
+    CHECK(!index.Update(crowd));
+    CheckIndexAgainstBruteForce(index, tester, crowd, TestPoints(crowd, 1280, 720, 10));
+
+    // Moved far and grown, they leave their cells and the grid is rebuilt.
+    for (std::size_t i = 0; i < crowd.Size(); i++) {
+        crowd.position_x[i] = 1280.0f - crowd.position_x[i];
+        crowd.scale[i] *= 1.5f;
+    }
+    CHECK(index.Update(crowd));
+    CheckIndexAgainstBruteForce(index, tester, crowd, TestPoints(crowd, 1280, 720, 11));
+
+    crowd.Add({ 640.0f, 360.0f }, 0.1f, 0.0f, Expression::Smile);
+    crowd.Update(0.0, { 0.0f, 0.0f });
+    CHECK(index.Update(crowd));
+    CheckIndexAgainstBruteForce(index, tester, crowd, TestPoints(crowd, 1280, 720, 12));
+}
+
+TEST(HitTest, BatchMatchesSingleQueries) {
+    auto crowd = TestCrowd(1000, 1920, 1080);
+    crowd.Update(1.3, { 100.0f, 900.0f });
+    CrowdHitIndex index;
+    index.Build(crowd);
+
+    auto points = TestPoints(crowd, 1920, 1080, 13);
+    std::vector<CrowdHit> hits(points.size());
+    index.HitTest(crowd, points, hits);
+    for (std::size_t i = 0; i < points.size(); i++) {
+        auto hit = index.HitTest(crowd, points[i]);
+        REQUIRE_EQ(hits[i].instance, hit.instance);
+        REQUIRE(hits[i].part == hit.part);
+    }
+}
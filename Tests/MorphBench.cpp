@@ -0,0 +1,72 @@
+#include "Bench.h"
+#include "MonsterScene.h"
+#include "Morph.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Mouth blends per second for crowd-sized batches: between sad and smiling as the crowd
+// does, and over three blend shapes, at every level the CPU runs and through
+// EvaluateBatch.
+BENCHMARK(MorphBlends) {
+    gfx::Path sad, smile, open, wide;
+    MonsterScene::CreateSad(sad);
+    MonsterScene::CreateSmile(smile);
+    // Made-up extra expressions, to have more targets to blend.
+    MonsterScene::CreateSmile(open);
+    for (auto& point : open.MutablePoints()) {
+        point.y *= 1.8f;
+    }
+    MonsterScene::CreateSad(wide);
+    for (auto& point : wide.MutablePoints()) {
+        point.x *= 1.4f;
+    }
+
+    const gfx::Path* two[] = { &sad, &smile };
+    const gfx::Path* four[] = { &sad, &smile, &open, &wide };
+    std::pair<const char*, std::span<const gfx::Path* const>> morphs[] = { { "sad/smile", two }, { "3 targets", four } };
+
+    std::printf("%-10s %8s %8s %-8s %12s\n", "morph", "points", "blends", "path", "Mblends/s");
+    for (auto [name, paths] : morphs) {
+        gfx::PathMorph morph;
+        morph.Build(paths);
+
+        for (std::size_t count : { 1000u, 100000u }) {
+            std::mt19937 random(3);
+            std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+            std::vector<float> weights(count * morph.TargetCount());
+            for (auto& weight : weights) {
+                weight = unit(random) / morph.TargetCount();
+            }
+            std::vector<gfx::Point> output(count * morph.PointCount());
+
+            auto report = [&](const char* path, double seconds) {
+                std::printf("%-10s %8zu %8zu %-8s %12.1f\n", name, morph.PointCount(), count, path,
+                    seconds > 0.0 ? count / seconds * 1e-6 : 0.0);
+            };
+
+            std::pair<gfx::SimdLevel, const char*> levels[] = {
+                { gfx::SimdLevel::Scalar, "scalar" }, { gfx::SimdLevel::Sse2, "SSE2" }, { gfx::SimdLevel::Avx2, "AVX2" }
+            };
+            for (auto [level, level_name] : levels) {
+                if (level > gfx::DetectSimdLevel()) {
+                    continue;
+                }
+                report(level_name, bench::Measure([&] {
+                    auto targets = morph.TargetCount(), points = morph.PointCount();
+                    for (std::size_t i = 0; i < count; i++) {
+                        morph.Evaluate(std::span<const float>(weights).subspan(i * targets, targets),
+                            std::span<gfx::Point>(output).subspan(i * points, points), level);
+                    }
+                    bench::KeepAlive(output);
+                }));
+            }
+            report("batch", bench::Measure([&] {
+                morph.EvaluateBatch(weights, output);
+                bench::KeepAlive(output);
+            }));
+        }
+    }
+}
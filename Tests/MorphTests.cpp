@@ -0,0 +1,219 @@
+#include "MonsterScene.h"
+#include "Morph.h"
+#include "Test.h"
+#include "TestGeometry.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* LevelName(gfx::SimdLevel level) {
+    switch (level) {
+    case gfx::SimdLevel::Avx2:
+        return "AVX2";
+    case gfx::SimdLevel::Sse2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+std::vector<gfx::SimdLevel> SupportedLevels() {
+    std::vector<gfx::SimdLevel> levels = { gfx::SimdLevel::Scalar };
+    if (GFX_SIMD_X86) {
+        levels.push_back(gfx::SimdLevel::Sse2);
+    }
+    if (gfx::DetectSimdLevel() == gfx::SimdLevel::Avx2) {
+        levels.push_back(gfx::SimdLevel::Avx2);
+    }
+    return levels;
+}
+
+// AVX2 fuses the multiply and add, so it rounds once where the others round twice.
+constexpr double FMA_TOLERANCE = 1e-4;
+
+// A closed polygon with corners on a circle, starting at angle zero.
+gfx::Path Polygon(int corners, float radius) {
+    gfx::Path path;
+    path.BeginFigure({ radius, 0.0f }, gfx::FigureBegin::Filled);
+    for (int i = 1; i < corners; i++) {
+        auto angle = 6.2831853f * i / corners;
+        path.AddLine({ radius * std::cos(angle), radius * std::sin(angle) });
+    }
+    path.EndFigure(gfx::FigureEnd::Closed);
+    return path;
+}
+
+gfx::Path Square(float half_size) {
+    gfx::Path path;
+    path.BeginFigure({ -half_size, -half_size }, gfx::FigureBegin::Filled);
+    path.AddLine({ half_size, -half_size });
+    path.AddLine({ half_size, half_size });
+    path.AddLine({ -half_size, half_size });
+    path.EndFigure(gfx::FigureEnd::Closed);
+    return path;
+}
+
+struct Mouths {
+    gfx::Path sad, smile;
+    gfx::PathMorph morph;
+
+    Mouths() {
+        MonsterScene::CreateSad(sad);
+        MonsterScene::CreateSmile(smile);
+        const gfx::Path* paths[] = { &sad, &smile };
+        morph.Build(paths);
+    }
+};
+
+// How far apart two paths with the same figures draw, both ways round.
+double CurveDistance(const gfx::Path& a, const gfx::Path& b) {
+    auto scale = gfx::Matrix3x2::Scale(MonsterScene::SCALE, MonsterScene::SCALE);
+    auto fine_a = FineCurve(a, scale), fine_b = FineCurve(b, scale);
+    return std::max(Deviation(fine_a, fine_b), Deviation(fine_b, fine_a));
+}
+
+}
+
+TEST(Morph, EndsDrawTheSourcePaths) {
+    // Splitting segments doesn't move the curve, so at either end the blend draws the
+    // path it came from.
+    Mouths mouths;
+    gfx::Path blended;
+    float weight = 0.0f;
+    mouths.morph.Evaluate({ &weight, 1 }, blended);
+    CHECK(CurveDistance(blended, mouths.sad) < 0.01);
+    weight = 1.0f;
+    mouths.morph.Evaluate({ &weight, 1 }, blended);
+    CHECK(CurveDistance(blended, mouths.smile) < 0.01);
+}
+
+TEST(Morph, BlendsLinesLinearly) {
+    // Squares scale linearly from one size to the other.
+    auto small = Square(10.0f), large = Square(20.0f);
+    const gfx::Path* paths[] = { &small, &large };
+    gfx::PathMorph morph;
+    REQUIRE(morph.Build(paths));
+
+    for (float weight : { 0.0f, 0.25f, 0.5f, 1.0f, 1.5f }) {
+        for (auto level : SupportedLevels()) {
+            test::Scope scope(std::string(LevelName(level)) + " at " + std::to_string(weight));
+            std::vector<gfx::Point> points(morph.PointCount());
+            morph.Evaluate({ &weight, 1 }, points, level);
+            double worst = 0.0;
+            for (auto point : points) {
+                auto distance = std::max(std::abs(point.x), std::abs(point.y));
+                worst = std::max(worst, std::abs(distance - (10.0 + 10.0 * weight)));
+            }
+            CHECK_NEAR(worst, 0.0, FMA_TOLERANCE);
+        }
+    }
+}
+
+TEST(Morph, MatchesSegmentCounts) {
+    // A square against an octagon: the square's sides are halved to make 8 segments,
+    // each closed figure getting its closing segment explicitly.
+    auto square = Square(10.0f), octagon = Polygon(8, 14.0f);
+    const gfx::Path* paths[] = { &square, &octagon };
+    gfx::PathMorph morph;
+    REQUIRE(morph.Build(paths));
+    CHECK_EQ(morph.Shape().Verbs().size(), 8u);
+    CHECK_EQ(morph.PointCount(), 1u + 8u * 3u);
+
+    gfx::Path blended;
+    float weight = 1.0f;
+    morph.Evaluate({ &weight, 1 }, blended);
+    CHECK(CurveDistance(blended, octagon) < 0.01);
+    weight = 0.0f;
+    morph.Evaluate({ &weight, 1 }, blended);
+    CHECK(CurveDistance(blended, square) < 0.01);
+}
+
+TEST(Morph, RejectsPathsWithDifferentFigures) {
+    auto closed = Square(10.0f);
+    gfx::Path open;
+    open.BeginFigure({ 0.0f, 0.0f }, gfx::FigureBegin::Filled);
+    open.AddLine({ 1.0f, 1.0f });
+    open.EndFigure(gfx::FigureEnd::Open);
+    auto two = Square(10.0f);
+    two.BeginFigure({ 0.0f, 0.0f }, gfx::FigureBegin::Filled);
+    two.AddLine({ 1.0f, 1.0f });
+    two.EndFigure(gfx::FigureEnd::Closed);
+
+    gfx::PathMorph morph;
+    const gfx::Path* open_and_closed[] = { &closed, &open };
+    CHECK(!morph.Build(open_and_closed));
+    const gfx::Path* one_and_two[] = { &closed, &two };
+    CHECK(!morph.Build(one_and_two));
+}
+
+TEST(Morph, BlendShapesAddTheirOffsets) {
+    // Three targets: every blend is the base plus each target's weighted offset, which
+    // for polygons with as many corners is exact per point.
+    auto base = Polygon(6, 10.0f), wide = Polygon(6, 10.0f), tall = Polygon(6, 10.0f), large = Polygon(6, 30.0f);
+    for (auto& point : wide.MutablePoints()) {
+        point.x *= 2.0f;
+    }
+    for (auto& point : tall.MutablePoints()) {
+        point.y *= 3.0f;
+    }
+    const gfx::Path* paths[] = { &base, &wide, &tall, &large };
+    gfx::PathMorph morph;
+    REQUIRE(morph.Build(paths));
+    REQUIRE_EQ(morph.TargetCount(), 3u);
+
+    auto shape = morph.Shape().Points();
+    std::vector<gfx::Point> points(morph.PointCount());
+    for (auto level : SupportedLevels()) {
+        test::Scope scope(LevelName(level));
+        float weights[] = { 0.5f, 0.25f, 0.125f };
+        morph.Evaluate(weights, points, level);
+        double worst = 0.0;
+        for (std::size_t i = 0; i < points.size(); i++) {
+            // Each target scales the base's points in its own way.
+            double x = shape[i].x * (1.0 + 0.5 * 1.0 + 0.125 * 2.0);
+            double y = shape[i].y * (1.0 + 0.25 * 2.0 + 0.125 * 2.0);
+            worst = std::max({ worst, std::abs(points[i].x - x), std::abs(points[i].y - y) });
+        }
+        CHECK_NEAR(worst, 0.0, FMA_TOLERANCE * 10.0);
+    }
+}
+
+TEST(Morph, LevelsMatchScalar) {
+    Mouths mouths;
+    std::vector<gfx::Point> reference(mouths.morph.PointCount()), points(reference.size());
+    for (float weight : { 0.0f, 0.1f, 0.5f, 0.9f, 1.0f }) {
+        mouths.morph.Evaluate({ &weight, 1 }, reference, gfx::SimdLevel::Scalar);
+        for (auto level : SupportedLevels()) {
+            test::Scope scope(std::string(LevelName(level)) + " at " + std::to_string(weight));
+            mouths.morph.Evaluate({ &weight, 1 }, points, level);
+            double worst = 0.0;
+            for (std::size_t i = 0; i < points.size(); i++) {
+                worst = std::max({ worst, (double)std::abs(points[i].x - reference[i].x),
+                    (double)std::abs(points[i].y - reference[i].y) });
+            }
+            // SSE2 does the same operations as scalar and has to match exactly.
+            CHECK_NEAR(worst, 0.0, level == gfx::SimdLevel::Avx2 ? FMA_TOLERANCE : 0.0);
+        }
+    }
+}
+
+TEST(Morph, BatchMatchesSingleBlends) {
+    Mouths mouths;
+    auto point_count = mouths.morph.PointCount();
+    std::vector<float> weights;
+    for (int i = 0; i < 101; i++) {
+        weights.push_back(i / 100.0f);
+    }
+    std::vector<gfx::Point> batch(weights.size() * point_count), single(point_count);
+    mouths.morph.EvaluateBatch(weights, batch);
+    for (std::size_t i = 0; i < weights.size(); i++) {
+        mouths.morph.Evaluate({ &weights[i], 1 }, single);
+        for (std::size_t p = 0; p < point_count; p++) {
+            REQUIRE_EQ(batch[i * point_count + p].x, single[p].x);
+            REQUIRE_EQ(batch[i * point_count + p].y, single[p].y);
+        }
+    }
+}
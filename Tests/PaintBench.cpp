@@ -0,0 +1,106 @@
+#include "Bench.h"
+#include "MonsterScene.h"
+#include "Paint.h"
+#include "TestScene.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Pixels per second shading a 1920x1080 target with the body's radial gradient at every
+// level the CPU runs, fully covered and with antialiased coverage, and with the gradient
+// evaluated per pixel from the stops as it was before the LUT.
+BENCHMARK(RadialFillRate) {
+    constexpr int WIDTH = 1920, HEIGHT = 1080;
+    TestTarget target(WIDTH, HEIGHT);
+    gfx::GradientLut lut(MonsterScene::rad_stops_data);
+    auto transformation = MonsterScene::DefaultTransformation((float)WIDTH, (float)HEIGHT);
+    auto paint = gfx::Paint::RadialGradient({ 0.0f, 0.0f }, 100.0f, 100.0f, lut, transformation);
+
+    std::vector<std::uint8_t> full(WIDTH, 255), partial(WIDTH);
+    for (int i = 0; i < WIDTH; i++) {
+        partial[i] = (std::uint8_t)(i * 37 % 256);
+    }
+
+    auto report = [&](const char* path, const char* coverage, double seconds) {
+        std::printf("%-14s %-9s %12.1f\n", path, coverage,
+            seconds > 0.0 ? (double)WIDTH * HEIGHT / seconds * 1e-6 : 0.0);
+    };
+
+    std::printf("%-14s %-9s %12s\n", "path", "coverage", "Mpixels/s");
+    report("per pixel", "full", bench::Measure([&] {
+        for (int y = 0; y < HEIGHT; y++) {
+            auto* row = target.surface.Row(y);
+            for (int x = 0; x < WIDTH; x++) {
+                auto u = (x + 0.5f) * paint.unit.m11 + (y + 0.5f) * paint.unit.m21 + paint.unit.dx;
+                auto v = (x + 0.5f) * paint.unit.m12 + (y + 0.5f) * paint.unit.m22 + paint.unit.dy;
+                auto color = gfx::PackPremultiplied(
+                    gfx::EvaluateGradient(MonsterScene::rad_stops_data, std::sqrt(u * u + v * v)));
+                std::memcpy(row + x * 4, &color, 4);
+            }
+        }
+        bench::KeepAlive(target.pixels);
+    }));
+
+    std::pair<gfx::SimdLevel, const char*> levels[] = {
+        { gfx::SimdLevel::Scalar, "scalar" }, { gfx::SimdLevel::Sse2, "SSE2" }, { gfx::SimdLevel::Avx2, "AVX2" }
+    };
+    for (auto [level, name] : levels) {
+        if (level > gfx::DetectSimdLevel()) {
+            continue;
+        }
+        for (const auto* coverage : { &full, &partial }) {
+            report(name, coverage == &full ? "full" : "partial", bench::Measure([&] {
+                for (int y = 0; y < HEIGHT; y++) {
+                    gfx::ShadeSpan(target.surface, paint, 0, y, WIDTH, coverage->data(), level);
+                }
+                bench::KeepAlive(target.pixels);
+            }));
+        }
+    }
+}
+
+// Target bytes per second through each blending kernel at every level the CPU runs,
+// with antialiased coverage over a 1920x1080 target, in both blend spaces.
+BENCHMARK(BlendKernels) {
+    constexpr int WIDTH = 1920, HEIGHT = 1080;
+    TestTarget target(WIDTH, HEIGHT);
+    gfx::FillSurface(target.surface, { 0.8f, 0.76f, 0.89f, 1.0f });
+    gfx::GradientLut lut(MonsterScene::rad_stops_data);
+    auto transformation = MonsterScene::DefaultTransformation((float)WIDTH, (float)HEIGHT);
+
+    std::vector<std::uint8_t> coverage(WIDTH);
+    for (int i = 0; i < WIDTH; i++) {
+        coverage[i] = (std::uint8_t)(i * 37 % 256);
+    }
+
+    std::pair<const char*, gfx::Paint> kernels[] = {
+        { "solid", gfx::Paint::Solid({ 0.2f, 0.7f, 0.4f, 1.0f }) },
+        { "solid 60%", gfx::Paint::Solid({ 0.2f, 0.7f, 0.4f, 0.6f }) },
+        { "radial", gfx::Paint::RadialGradient({ 0.0f, 0.0f }, 100.0f, 100.0f, lut, transformation) },
+    };
+    std::pair<gfx::SimdLevel, const char*> levels[] = {
+        { gfx::SimdLevel::Scalar, "scalar" }, { gfx::SimdLevel::Sse2, "SSE2" }, { gfx::SimdLevel::Avx2, "AVX2" }
+    };
+
+    std::printf("%-10s %-7s %-7s %8s\n", "kernel", "space", "path", "GB/s");
+    for (auto space : { gfx::BlendSpace::Stored, gfx::BlendSpace::Linear }) {
+        for (auto [kernel, paint] : kernels) {
+            paint.space = space;
+            for (auto [level, name] : levels) {
+                if (level > gfx::DetectSimdLevel()) {
+                    continue;
+                }
+                auto seconds = bench::Measure([&] {
+                    for (int y = 0; y < HEIGHT; y++) {
+                        gfx::ShadeSpan(target.surface, paint, 0, y, WIDTH, coverage.data(), level);
+                    }
+                    bench::KeepAlive(target.pixels);
+                });
+                std::printf("%-10s %-7s %-7s %8.2f\n", kernel, space == gfx::BlendSpace::Linear ? "linear" : "stored",
+                    name, seconds > 0.0 ? (double)WIDTH * HEIGHT * 4 / seconds * 1e-9 : 0.0);
+            }
+        }
+    }
+}
@@ -0,0 +1,338 @@
+#include "MonsterScene.h"
+#include "Paint.h"
+#include "Test.h"
+#include "TestScene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* LevelName(gfx::SimdLevel level) {
+    switch (level) {
+    case gfx::SimdLevel::Avx2:
+        return "AVX2";
+    case gfx::SimdLevel::Sse2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+std::vector<gfx::SimdLevel> SupportedLevels() {
+    std::vector<gfx::SimdLevel> levels = { gfx::SimdLevel::Scalar };
+    if (GFX_SIMD_X86) {
+        levels.push_back(gfx::SimdLevel::Sse2);
+    }
+    if (gfx::DetectSimdLevel() == gfx::SimdLevel::Avx2) {
+        levels.push_back(gfx::SimdLevel::Avx2);
+    }
+    return levels;
+}
+
+std::uint32_t PixelAt(const gfx::Surface& surface, int x, int y) {
+    std::uint32_t pixel;
+    std::memcpy(&pixel, surface.Row(y) + x * 4, 4);
+    return pixel;
+}
+
+int ChannelDifference(std::uint32_t a, std::uint32_t b) {
+    int worst = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        worst = std::max(worst, std::abs((int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff)));
+    }
+    return worst;
+}
+
+// How many 8-bit steps a channel may be off: the LUT holds the gradient at SIZE
+// positions and a pixel takes the nearest, up to half a step from its own, where the
+// steepest stretch between stops changes by at most this much. Plus one for rounding.
+int LutTolerance(std::span<const gfx::GradientStop> stops) {
+    double steepest = 0.0;
+    for (std::size_t i = 1; i < stops.size(); i++) {
+        auto range = stops[i].position - stops[i - 1].position;
+        const auto &from = stops[i - 1].color, &to = stops[i].color;
+        auto change = std::max({ std::abs(to.r - from.r), std::abs(to.g - from.g), std::abs(to.b - from.b),
+            std::abs(to.a - from.a) });
+        steepest = std::max(steepest, range > 0.0f ? change / range : 0.0);
+    }
+    return 1 + (int)std::ceil(steepest * 255.0 * 0.5 / (gfx::GradientLut::SIZE - 1));
+}
+
+struct TestGradient {
+    const char* name;
+    std::span<const gfx::GradientStop> stops;
+    gfx::Point center;
+    float radius_x, radius_y;
+};
+
+const TestGradient TEST_GRADIENTS[] = {
+    { "body", MonsterScene::rad_stops_data, { 0.0f, 0.0f }, 100.0f, 100.0f },
+    { "eye", MonsterScene::eye_stops_data, { -24.0f, -30.0f }, 14.0f, 9.0f },
+};
+
+// Shades every row of a transparent target fully covered with a radial gradient and
+// checks each pixel against the gradient evaluated at the pixel center's exact distance
+// from the gradient's center, in units of its radii, worked out in double.
+void CheckAgainstAnalytic(const TestGradient& gradient, const gfx::Matrix3x2& transformation,
+    gfx::BlendSpace space) {
+    constexpr int WIDTH = 160, HEIGHT = 120;
+    gfx::GradientLut lut(gradient.stops);
+    auto paint = gfx::Paint::RadialGradient(gradient.center, gradient.radius_x, gradient.radius_y, lut, transformation);
+    paint.space = space;
+
+    const auto& m = transformation;
+    double determinant = (double)m.m11 * m.m22 - (double)m.m12 * m.m21;
+    std::vector<std::uint8_t> coverage(WIDTH, 255);
+    // Linear space also encodes through a table of 4096 steps, which may round one
+    // further way.
+    auto tolerance = LutTolerance(gradient.stops) + (space == gfx::BlendSpace::Linear ? 1 : 0);
+
+    for (auto level : SupportedLevels()) {
+        test::Scope scope(std::string(gradient.name) + ", " + LevelName(level) +
+            (space == gfx::BlendSpace::Linear ? ", linear" : ", stored"));
+        TestTarget target(WIDTH, HEIGHT);
+        for (int y = 0; y < HEIGHT; y++) {
+            gfx::ShadeSpan(target.surface, paint, 0, y, WIDTH, coverage.data(), level);
+        }
+
+        int worst = 0;
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                double px = x + 0.5 - m.dx, py = y + 0.5 - m.dy;
+                double local_x = (px * m.m22 - py * m.m21) / determinant;
+                double local_y = (py * m.m11 - px * m.m12) / determinant;
+                double u = (local_x - gradient.center.x) / gradient.radius_x;
+                double v = (local_y - gradient.center.y) / gradient.radius_y;
+                auto color = gfx::EvaluateGradient(gradient.stops, (float)std::sqrt(u * u + v * v));
+                auto expected = gfx::PackPremultiplied(color, space);
+                worst = std::max(worst, ChannelDifference(PixelAt(target.surface, x, y), expected));
+            }
+        }
+        CHECK(worst <= tolerance);
+    }
+}
+
+// Shades spans of every length around the vector widths, starting at every alignment,
+// over a backdrop that isn't empty, with coverage from nothing to full, and checks every
+// level leaves the same bytes as the scalar one.
+void CheckLevelsMatchScalar(const gfx::Paint& paint) {
+    constexpr int WIDTH = 96, HEIGHT = 64;
+    std::vector<std::uint8_t> coverage(WIDTH);
+    for (std::size_t i = 0; i < coverage.size(); i++) {
+        coverage[i] = (std::uint8_t)(i * 37 % 256);
+    }
+    coverage[5] = 0;
+    coverage[6] = 255;
+
+    auto shade = [&](const gfx::Surface& surface, gfx::SimdLevel level) {
+        for (int y = 0; y < HEIGHT; y++) {
+            gfx::ShadeSpan(surface, paint, y % 9, y, WIDTH - y % 9 - y % 7, coverage.data(), level);
+        }
+    };
+
+    TestTarget backdrop(WIDTH, HEIGHT);
+    gfx::FillSurface(backdrop.surface, { 0.8f, 0.76f, 0.89f, 0.5f }, paint.space);
+    TestTarget reference = backdrop;
+    reference.surface.pixels = reference.pixels.data();
+    shade(reference.surface, gfx::SimdLevel::Scalar);
+
+    for (auto level : SupportedLevels()) {
+        test::Scope scope(LevelName(level));
+        TestTarget target = backdrop;
+        target.surface.pixels = target.pixels.data();
+        shade(target.surface, level);
+        CHECK(target.pixels == reference.pixels);
+    }
+}
+
+// Solid colors, some translucent, blended with coverage from none to full over random
+// backdrops, each pixel checked against expected(color, coverage, backdrop).
+template <class Expected>
+void CheckSolidBlend(gfx::BlendSpace space, int tolerance, Expected expected) {
+    constexpr int WIDTH = 256;
+    std::mt19937 random(6);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (auto level : SupportedLevels()) {
+        test::Scope scope(LevelName(level));
+        int worst = 0;
+        for (int trial = 0; trial < 64; trial++) {
+            gfx::Color color = { unit(random), unit(random), unit(random), trial % 4 == 0 ? 1.0f : unit(random) };
+            auto paint = gfx::Paint::Solid(color);
+            paint.space = space;
+
+            // Premultiplied backdrop pixels, coverage 0 to 255 along the row.
+            TestTarget target(WIDTH, 1);
+            std::vector<std::uint8_t> coverage(WIDTH);
+            for (int x = 0; x < WIDTH; x++) {
+                auto alpha = byte(random);
+                auto* pixel = target.pixels.data() + x * 4;
+                for (int channel = 0; channel < 3; channel++) {
+                    pixel[channel] = (std::uint8_t)(byte(random) * alpha / 255);
+                }
+                pixel[3] = (std::uint8_t)alpha;
+                coverage[x] = (std::uint8_t)x;
+            }
+            auto backdrop = target.pixels;
+
+            gfx::ShadeSpan(target.surface, paint, 0, 0, WIDTH, coverage.data(), level);
+            for (int x = 0; x < WIDTH; x++) {
+                std::uint32_t before;
+                std::memcpy(&before, backdrop.data() + x * 4, 4);
+                worst = std::max(worst, ChannelDifference(PixelAt(target.surface, x, 0),
+                    expected(color, coverage[x], before)));
+            }
+        }
+        CHECK(worst <= tolerance);
+    }
+}
+
+std::uint32_t Pack(const double (&channels)[4]) {
+    std::uint32_t pixel = 0;
+    for (int channel = 0; channel < 4; channel++) {
+        pixel |= (std::uint32_t)std::lround(std::clamp(channels[channel], 0.0, 1.0) * 255.0) << (channel * 8);
+    }
+    return pixel;
+}
+
+double Byte(std::uint32_t pixel, int channel) {
+    return ((pixel >> (channel * 8)) & 0xff) / 255.0;
+}
+
+}
+
+TEST(Paint, RadialGradientMatchesAnalytic) {
+    auto transformation = MonsterScene::DefaultTransformation(160.0f, 120.0f);
+    for (const auto& gradient : TEST_GRADIENTS) {
+        CheckAgainstAnalytic(gradient, transformation, gfx::BlendSpace::Stored);
+    }
+}
+
+TEST(Paint, RadialGradientMatchesAnalyticWhenRotatedAndSkewed) {
+    gfx::Matrix3x2 skew = { 1.0f, 0.2f, -0.3f, 0.9f, 0.0f, 0.0f };
+    auto transformation =
+        gfx::Matrix3x2::Rotation(33.0f) * skew * MonsterScene::DefaultTransformation(160.0f, 120.0f);
+    for (const auto& gradient : TEST_GRADIENTS) {
+        CheckAgainstAnalytic(gradient, transformation, gfx::BlendSpace::Stored);
+    }
+}
+
+TEST(Paint, LutHoldsTheGradientAtItsPositions) {
+    for (const auto& gradient : TEST_GRADIENTS) {
+        test::Scope scope(gradient.name);
+        gfx::GradientLut lut(gradient.stops);
+        for (int i = 0; i < gfx::GradientLut::SIZE; i++) {
+            auto position = (float)i / (gfx::GradientLut::SIZE - 1);
+            REQUIRE_EQ(gfx::GradientLut::Index(position), i);
+            REQUIRE_EQ(lut.Sample(position), gfx::PackPremultiplied(gfx::EvaluateGradient(gradient.stops, position)));
+        }
+        // Outside [0, 1] it clamps like the stops.
+        CHECK_EQ(lut.Sample(-3.0f), lut.Sample(0.0f));
+        CHECK_EQ(lut.Sample(7.0f), lut.Sample(1.0f));
+    }
+}
+
+TEST(Paint, RadialLevelsMatchScalarUnderPartialCoverage) {
+    gfx::GradientLut lut(MonsterScene::eye_stops_data);
+    auto transformation = MonsterScene::DefaultTransformation(96.0f, 64.0f);
+    auto paint = gfx::Paint::RadialGradient(MonsterScene::left_eye.center, 12.0f, 12.0f, lut, transformation);
+    CheckLevelsMatchScalar(paint);
+}
+
+TEST(Paint, SolidBlendMatchesSourceOver) {
+    // Premultiplied source-over in double: src * coverage + dst * (1 - alpha * coverage).
+    // Packing the color, the coverage multiply and the inverse multiply each round to
+    // bytes, so a channel may be two steps off.
+    CheckSolidBlend(gfx::BlendSpace::Stored, 2, [](const gfx::Color& color, std::uint8_t coverage, std::uint32_t dst) {
+        double weight = coverage / 255.0, a = std::clamp((double)color.a, 0.0, 1.0);
+        double src[4] = { color.b * a, color.g * a, color.r * a, a };
+        double result[4];
+        for (int channel = 0; channel < 4; channel++) {
+            result[channel] = src[channel] * weight + Byte(dst, channel) * (1.0 - a * weight);
+        }
+        return Pack(result);
+    });
+}
+
+TEST(Paint, LinearBlendMatchesSourceOverInLinearLight) {
+    // The same in linear light, with the exact transfer functions instead of the
+    // tables: the encoding table's 4096 steps round at most a step further.
+    CheckSolidBlend(gfx::BlendSpace::Linear, 1, [](const gfx::Color& color, std::uint8_t coverage, std::uint32_t dst) {
+        double weight = coverage / 255.0, a = std::clamp((double)color.a, 0.0, 1.0);
+        double src[3] = { gfx::SrgbToLinear(color.b) * a, gfx::SrgbToLinear(color.g) * a, gfx::SrgbToLinear(color.r) * a };
+        double result[4];
+        for (int channel = 0; channel < 3; channel++) {
+            auto linear = src[channel] * weight + gfx::SrgbToLinear((float)Byte(dst, channel)) * (1.0 - a * weight);
+            result[channel] = gfx::LinearToSrgb((float)std::min(linear, 1.0));
+        }
+        result[3] = a * weight + Byte(dst, 3) * (1.0 - a * weight);
+        return Pack(result);
+    });
+}
+
+TEST(Paint, LinearBlendLeavesUntouchedPixelsUnchanged) {
+    // A fully transparent color decodes every backdrop pixel and encodes it again, which
+    // has to give back every byte value.
+    TestTarget target(256, 1);
+    std::vector<std::uint8_t> coverage(256, 255);
+    for (int x = 0; x < 256; x++) {
+        auto* pixel = target.pixels.data() + x * 4;
+        pixel[0] = pixel[1] = pixel[2] = (std::uint8_t)x;
+        pixel[3] = 255;
+    }
+    auto backdrop = target.pixels;
+    auto paint = gfx::Paint::Solid({ 1.0f, 0.5f, 0.0f, 0.0f });
+    paint.space = gfx::BlendSpace::Linear;
+    for (auto level : SupportedLevels()) {
+        test::Scope scope(LevelName(level));
+        gfx::ShadeSpan(target.surface, paint, 0, 0, 256, coverage.data(), level);
+        CHECK(target.pixels == backdrop);
+    }
+}
+
+TEST(Paint, LinearBlendKeepsEdgesBright) {
+    // White over black at half coverage: half the light, which sRGB encodes as 188, not
+    // the 128 that blending the encoded values gives.
+    std::uint8_t half = 128;
+    for (auto [space, expected] : { std::pair{ gfx::BlendSpace::Stored, 128 }, std::pair{ gfx::BlendSpace::Linear, 188 } }) {
+        TestTarget target(1, 1);
+        gfx::FillSurface(target.surface, { 0.0f, 0.0f, 0.0f, 1.0f }, space);
+        auto paint = gfx::Paint::Solid({ 1.0f, 1.0f, 1.0f, 1.0f });
+        paint.space = space;
+        gfx::ShadeSpan(target.surface, paint, 0, 0, 1, &half);
+        CHECK_EQ((int)target.pixels[1], expected);
+    }
+}
+
+TEST(Paint, LinearRadialGradientMatchesAnalytic) {
+    auto transformation = MonsterScene::DefaultTransformation(160.0f, 120.0f);
+    for (const auto& gradient : TEST_GRADIENTS) {
+        CheckAgainstAnalytic(gradient, transformation, gfx::BlendSpace::Linear);
+    }
+}
+
+TEST(Paint, SolidLevelsMatchScalarUnderPartialCoverage) {
+    for (auto space : { gfx::BlendSpace::Stored, gfx::BlendSpace::Linear }) {
+        for (float alpha : { 1.0f, 0.6f, 0.0f }) {
+            test::Scope scope(std::string(space == gfx::BlendSpace::Linear ? "linear" : "stored") + ", alpha " +
+                std::to_string(alpha));
+            auto paint = gfx::Paint::Solid({ 0.2f, 0.7f, 0.4f, alpha });
+            paint.space = space;
+            CheckLevelsMatchScalar(paint);
+        }
+    }
+}
+
+TEST(Paint, LinearRadialLevelsMatchScalarUnderPartialCoverage) {
+    gfx::GradientLut lut(MonsterScene::eye_stops_data);
+    auto transformation = MonsterScene::DefaultTransformation(96.0f, 64.0f);
+    auto paint = gfx::Paint::RadialGradient(MonsterScene::left_eye.center, 12.0f, 12.0f, lut, transformation);
+    paint.space = gfx::BlendSpace::Linear;
+    CheckLevelsMatchScalar(paint);
+}
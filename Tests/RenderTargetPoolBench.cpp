@@ -0,0 +1,86 @@
+#include "Bench.h"
+#include "CpuRenderer.h"
+#include "RenderTargetPool.h"
+#include "TestScene.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+struct ResizeFrame {
+    std::uint32_t width, height;
+    bool resizing;
+};
+
+// A window corner dragged from 800x600 out to 1920x1080 and back in to 1000x700 at
+// 120 frames a second, wobbling a little as a hand does, then let go for half a second.
+std::vector<ResizeFrame> ResizeScript(int steps) {
+    std::vector<ResizeFrame> frames;
+    auto drag = [&](float from_width, float from_height, float to_width, float to_height) {
+        for (int i = 0; i <= steps; i++) {
+            auto t = (float)i / steps;
+            auto wobble = 6.0f * std::sin(i * 0.7f);
+            frames.push_back({ (std::uint32_t)(from_width + (to_width - from_width) * t + wobble),
+                (std::uint32_t)(from_height + (to_height - from_height) * t + wobble / 2.0f), true });
+        }
+    };
+    drag(800.0f, 600.0f, 1920.0f, 1080.0f);
+    drag(1920.0f, 1080.0f, 1000.0f, 700.0f);
+    for (int i = 0; i < 60; i++) {
+        frames.push_back({ 1000, 700, false });
+    }
+    return frames;
+}
+
+}
+
+// Frames of the scene through a scripted resize storm, with the target allocated at
+// exactly the window's size whenever it changes, against allocated as the window's swap
+// chain is, by a TargetSizer. Frame times include allocating the target, and the
+// renderer's layer, which is always pooled, is counted separately.
+BENCHMARK(ResizeStorm) {
+    using Clock = std::chrono::steady_clock;
+    auto script = ResizeScript(bench::Quick() ? 10 : 240);
+
+    std::printf("%-8s %7s %13s %12s %11s %11s\n", "target", "frames", "target allocs", "layer allocs", "mean ms",
+        "worst ms");
+    for (bool sized : { false, true }) {
+        CpuRenderer renderer;
+        TargetSizer sizer;
+        std::vector<std::uint8_t> pixels;
+        std::uint32_t allocated_width = 0, allocated_height = 0;
+        std::uint64_t allocations = 0;
+        std::vector<double> milliseconds;
+
+        auto frame_time = std::chrono::nanoseconds(1'000'000'000 / 120);
+        auto now = std::chrono::nanoseconds(0);
+        for (std::size_t i = 0; i < script.size(); i++) {
+            const auto& frame = script[i];
+            auto begin = Clock::now();
+            auto reallocate = sized ? sizer.Update(frame.width, frame.height, frame.resizing, now)
+                : frame.width != allocated_width || frame.height != allocated_height;
+            if (reallocate) {
+                allocated_width = sized ? sizer.AllocatedWidth() : frame.width;
+                allocated_height = sized ? sizer.AllocatedHeight() : frame.height;
+                pixels = std::vector<std::uint8_t>((std::size_t)allocated_width * allocated_height * 4);
+                allocations++;
+            }
+            renderer.SetTarget({ pixels.data(), (int)frame.width, (int)frame.height, (int)allocated_width * 4 });
+            renderer.Render(TestScene((int)frame.width, (int)frame.height, (int)i));
+            bench::KeepAlive(pixels);
+            milliseconds.push_back(std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+            now += frame_time;
+        }
+
+        auto mean = 0.0;
+        for (auto ms : milliseconds) {
+            mean += ms / milliseconds.size();
+        }
+        std::printf("%-8s %7zu %13llu %12llu %11.3f %11.3f\n", sized ? "sized" : "exact", script.size(),
+            (unsigned long long)allocations, (unsigned long long)renderer.LayerAllocations(), mean,
+            *std::max_element(milliseconds.begin(), milliseconds.end()));
+    }
+}
@@ -0,0 +1,159 @@
+#include "RenderTargetPool.h"
+#include "Test.h"
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// Move-only like the targets the pool holds, and numbered in the order they were
+// created, so a test can tell which one it got back.
+struct FakeTarget {
+    std::unique_ptr<int> id;
+    TargetKey key;
+};
+
+struct FakeTargets {
+    int created = 0;
+
+    FakeTarget operator()(const TargetKey& key) {
+        return { std::make_unique<int>(++created), key };
+    }
+};
+
+}
+
+TEST(RenderTargetPool, SizeClassesAreAtMostAQuarterLarger) {
+    CHECK_EQ(SizeClass(1), 64u);
+    CHECK_EQ(SizeClass(64), 64u);
+    CHECK_EQ(SizeClass(65), 80u);
+    CHECK_EQ(SizeClass(1024), 1024u);
+    CHECK_EQ(SizeClass(1025), 1280u);
+    CHECK_EQ(SizeClass(1080), 1280u);
+    CHECK_EQ(SizeClass(1920), 2048u);
+    CHECK_EQ(SizeClass(2561), 3072u);
+
+    // Never smaller, never more than a quarter larger past the smallest class, a class of
+    // its own, and growing with the size.
+    std::uint32_t previous = 0;
+    for (std::uint32_t size = 1; size <= 20000; size++) {
+        test::Scope scope("size " + std::to_string(size));
+        auto size_class = SizeClass(size);
+        REQUIRE(size_class >= size && size_class >= previous);
+        REQUIRE(size <= 64 || size_class <= size + size / 4);
+        REQUIRE_EQ(SizeClass(size_class), size_class);
+        previous = size_class;
+    }
+}
+
+TEST(RenderTargetPool, ReusesIdleTargetsOfTheSameKey) {
+    RenderTargetPool<FakeTarget> pool;
+    FakeTargets create;
+
+    auto key = TargetKey::ForSize(1000, 700);
+    auto first = pool.Acquire(key, create);
+    CHECK_EQ(*first.id, 1);
+    pool.Release(key, std::move(first));
+
+    // A few pixels either way is the same class, and gets the same target back.
+    auto again = pool.Acquire(TargetKey::ForSize(1010, 690), create);
+    CHECK_EQ(*again.id, 1);
+    CHECK_EQ(pool.Allocations(), 1u);
+
+    // Another format never shares.
+    auto other_format = pool.Acquire(TargetKey::ForSize(1000, 700, 1), create);
+    CHECK_EQ(*other_format.id, 2);
+    CHECK_EQ(pool.Allocations(), 2u);
+
+    // Of two idle targets of one key, the newest comes back first.
+    pool.Release(key, std::move(again));
+    pool.Release(key, create(key));
+    CHECK_EQ(*pool.Acquire(key, create).id, 3);
+    CHECK_EQ(*pool.Acquire(key, create).id, 1);
+    CHECK_EQ(pool.Allocations(), 2u);
+}
+
+TEST(RenderTargetPool, DropsTheOldestIdleTargetsPastTheLimit) {
+    RenderTargetPool<FakeTarget> pool;
+    FakeTargets create;
+
+    auto size = [](std::size_t i) { return TargetKey::ForSize(256 * (std::uint32_t)(i + 1), 256); };
+    for (std::size_t i = 0; i <= RenderTargetPool<FakeTarget>::MAX_IDLE; i++) {
+        pool.Release(size(i), create(size(i)));
+    }
+
+    CHECK(pool.Acquire(size(0), create).id);
+    CHECK_EQ(create.created, (int)RenderTargetPool<FakeTarget>::MAX_IDLE + 2);
+    for (std::size_t i = 1; i <= RenderTargetPool<FakeTarget>::MAX_IDLE; i++) {
+        test::Scope scope("target " + std::to_string(i));
+        CHECK_EQ(*pool.Acquire(size(i), create).id, (int)i + 1);
+    }
+    CHECK_EQ(pool.Allocations(), 1u);
+
+    pool.Release(size(0), create(size(0)));
+    pool.Clear();
+    pool.Acquire(size(0), create);
+    CHECK_EQ(pool.Allocations(), 2u);
+}
+
+TEST(RenderTargetPool, SizerGrowsOncePerClassWhileResizing) {
+    TargetSizer sizer;
+    TargetSizer::Duration now = 1s;
+    CHECK(sizer.Update(800, 600, false, now));
+    CHECK_EQ(sizer.AllocatedWidth(), SizeClass(800));
+    CHECK_EQ(sizer.AllocatedHeight(), SizeClass(600));
+
+    // Dragging the corner out a pixel at a time reallocates once per class crossed.
+    std::set<std::uint32_t> width_classes = { SizeClass(800) };
+    auto reallocations = 0;
+    for (std::uint32_t width = 801; width <= 1700; width++) {
+        now += 8ms;
+        reallocations += sizer.Update(width, 600, true, now);
+        width_classes.insert(SizeClass(width));
+        REQUIRE(sizer.AllocatedWidth() >= width);
+    }
+    CHECK_EQ(reallocations, (int)width_classes.size() - 1);
+
+    // Back in, and out again short of the largest, keeps what was allocated.
+    for (std::uint32_t width = 1700; width >= 900; width -= 3) {
+        now += 8ms;
+        REQUIRE(!sizer.Update(width, 600, true, now));
+    }
+    for (std::uint32_t width = 900; width <= 1600; width += 5) {
+        now += 8ms;
+        REQUIRE(!sizer.Update(width, 600, true, now));
+    }
+    CHECK_EQ(sizer.AllocatedWidth(), SizeClass(1700));
+    CHECK(!sizer.Settling());
+}
+
+TEST(RenderTargetPool, SizerShrinksOnlyOnceTheSizeSettles) {
+    TargetSizer sizer;
+    TargetSizer::Duration now = 1s;
+    sizer.Update(1900, 1000, false, now);
+    CHECK(!sizer.Update(700, 500, true, now));
+
+    // The drag ended; the smaller size has to hold for SETTLE.
+    now += 10ms;
+    CHECK(!sizer.Update(700, 500, false, now));
+    CHECK(sizer.Settling());
+    CHECK(!sizer.Update(700, 500, false, now + TargetSizer::SETTLE - 1ms));
+
+    // Another size starts the wait over.
+    now += 100ms;
+    CHECK(!sizer.Update(600, 500, false, now));
+    CHECK(!sizer.Update(600, 500, false, now + TargetSizer::SETTLE - 1ms));
+    CHECK(sizer.Update(600, 500, false, now + TargetSizer::SETTLE));
+    CHECK_EQ(sizer.AllocatedWidth(), SizeClass(600));
+    CHECK_EQ(sizer.AllocatedHeight(), SizeClass(500));
+    CHECK(!sizer.Settling());
+
+    // Growing never waits, and sizes past the largest texture get exactly what they ask.
+    CHECK(sizer.Update(16000, 500, false, now + 1s));
+    CHECK_EQ(sizer.AllocatedWidth(), TargetSizer::MAX_SIZE);
+    CHECK(sizer.Update(17000, 500, false, now + 1s));
+    CHECK_EQ(sizer.AllocatedWidth(), 17000u);
+}
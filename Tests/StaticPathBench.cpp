@@ -0,0 +1,42 @@
+#include "Bench.h"
+#include "MonsterHitTest.h"
+#include "MonsterScene.h"
+#include <cstdio>
+
+// What startup spends on the monster's shapes: parsing their path data and flattening
+// them for the hit tester at runtime, against copying the baked arrays into paths.
+BENCHMARK(BakedShapes) {
+    struct Shape {
+        std::string_view data;
+        gfx::FigureBegin begin;
+    };
+    const Shape shapes[] = {
+        { MonsterScene::monster_path_data, gfx::FigureBegin::Filled },
+        { MonsterScene::nose_path_data, gfx::FigureBegin::Filled },
+        { MonsterScene::smile_path_data, gfx::FigureBegin::Hollow },
+        { MonsterScene::sad_path_data, gfx::FigureBegin::Hollow },
+    };
+
+    gfx::Path paths[4];
+    gfx::FlattenedPath flattened;
+    auto runtime = bench::Measure([&] {
+        for (int i = 0; i < 4; i++) {
+            paths[i].Clear();
+            gfx::ParseSvgPath(shapes[i].data, paths[i], shapes[i].begin);
+            flattened.Clear();
+            gfx::FlattenPathAdaptive(paths[i], gfx::Matrix3x2::Identity(), MonsterHitTester::TOLERANCE, flattened);
+        }
+        bench::KeepAlive(flattened);
+    });
+    auto baked = bench::Measure([&] {
+        MonsterScene::monster_shape.CopyTo(paths[0]);
+        MonsterScene::nose_shape.CopyTo(paths[1]);
+        MonsterScene::smile_shape.CopyTo(paths[2]);
+        MonsterScene::sad_shape.CopyTo(paths[3]);
+        bench::KeepAlive(paths);
+    });
+
+    std::printf("%-28s %10s\n", "shapes", "us");
+    std::printf("%-28s %10.2f\n", "parsed and flattened", runtime * 1e6);
+    std::printf("%-28s %10.2f\n", "copied from baked arrays", baked * 1e6);
+}
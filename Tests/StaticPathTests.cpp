@@ -0,0 +1,164 @@
+#include "FlatteningCache.h"
+#include "MonsterHitTest.h"
+#include "MonsterScene.h"
+#include "StaticPath.h"
+#include "Test.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <string>
+
+namespace {
+
+using gfx::FlatteningCache;
+
+// Where a shape goes through sin or cos, as arcs do, the constexpr versions may round
+// one unit in the last place away from <cmath>; see ConstexprMath.h. Everything else,
+// point counts included, has to match exactly.
+constexpr std::int64_t MAX_ULPS = 1;
+
+// Units in the last place between two floats of the same sign, or a lot for different
+// signs other than zeros.
+std::int64_t UlpDistance(float a, float b) {
+    std::int32_t x, y;
+    std::memcpy(&x, &a, 4);
+    std::memcpy(&y, &b, 4);
+    if ((x < 0) != (y < 0)) {
+        return a == b ? 0 : INT32_MAX;
+    }
+    return std::abs((std::int64_t)x - y);
+}
+
+std::int64_t MaxUlpDistance(std::span<const gfx::Point> a, std::span<const gfx::Point> b) {
+    std::int64_t worst = 0;
+    for (std::size_t i = 0; i < std::min(a.size(), b.size()); i++) {
+        worst = std::max({ worst, UlpDistance(a[i].x, b[i].x), UlpDistance(a[i].y, b[i].y) });
+    }
+    return worst;
+}
+
+// Path data parsed at runtime, rather than replayed from the baked shapes as
+// MonsterScene::CreateMonster and the others do.
+gfx::Path Parse(std::string_view data, gfx::FigureBegin begin = gfx::FigureBegin::Filled) {
+    gfx::Path path;
+    gfx::ParseSvgPath(data, path, begin);
+    return path;
+}
+
+// Checks a shape baked at compile time against parsing its path data at runtime.
+template <const auto& shape>
+void CheckBakedPath(std::string_view data, gfx::FigureBegin begin) {
+    auto parsed = Parse(data, begin);
+
+    REQUIRE_EQ(shape.points.size(), parsed.Points().size());
+    REQUIRE_EQ(shape.verbs.size(), parsed.Verbs().size());
+    REQUIRE_EQ(shape.figures.size(), parsed.Figures().size());
+    CHECK(MaxUlpDistance(shape.points, parsed.Points()) <= MAX_ULPS);
+    for (std::size_t i = 0; i < shape.verbs.size(); i++) {
+        REQUIRE(shape.verbs[i] == parsed.Verbs()[i]);
+    }
+    for (std::size_t i = 0; i < shape.figures.size(); i++) {
+        const auto &a = shape.figures[i], &b = parsed.Figures()[i];
+        REQUIRE(a.first_point == b.first_point && a.first_verb == b.first_verb && a.verb_count == b.verb_count &&
+            a.filled == b.filled && a.closed == b.closed);
+    }
+}
+
+// Checks a flattening baked at compile time against flattening the same path at
+// runtime, with the tolerance worked out at runtime too.
+void CheckBakedFlattening(gfx::FlatPathView baked, const gfx::Path& path, float tolerance) {
+    gfx::FlattenedPath flattened;
+    gfx::FlattenPathAdaptive(path, gfx::Matrix3x2::Identity(), tolerance, flattened);
+
+    REQUIRE_EQ(baked.points.size(), flattened.points.size());
+    REQUIRE_EQ(baked.figures.size(), flattened.figures.size());
+    CHECK(MaxUlpDistance(baked.points, flattened.points) <= MAX_ULPS);
+    for (std::size_t i = 0; i < baked.figures.size(); i++) {
+        const auto &a = baked.figures[i], &b = flattened.figures[i];
+        REQUIRE(a.first_point == b.first_point && a.point_count == b.point_count && a.closed == b.closed);
+    }
+}
+
+template <const auto& shape, float tolerance>
+constexpr auto baked = gfx::BakeFlattened<shape, tolerance>();
+
+// The levels CpuRenderer bakes, and the hit tester's tolerance.
+template <const auto& shape>
+void CheckBakedFlattenings(const gfx::Path& path) {
+    constexpr float LEVEL_4 = FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(4);
+    constexpr float LEVEL_5 = FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(5);
+    constexpr float LEVEL_6 = FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(6);
+
+    // The runtime tolerances, from std::exp2 rather than the constexpr series.
+    volatile int level = 4;
+    {
+        test::Scope scope("level 4");
+        CheckBakedFlattening(baked<shape, LEVEL_4>.View(), path,
+            FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(level));
+    }
+    level = 5;
+    {
+        test::Scope scope("level 5");
+        CheckBakedFlattening(baked<shape, LEVEL_5>.View(), path,
+            FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(level));
+    }
+    level = 6;
+    {
+        test::Scope scope("level 6");
+        CheckBakedFlattening(baked<shape, LEVEL_6>.View(), path,
+            FlatteningCache::TOLERANCE / FlatteningCache::LevelScale(level));
+    }
+    {
+        test::Scope scope("hit testing");
+        CheckBakedFlattening(baked<shape, MonsterHitTester::TOLERANCE>.View(), path, MonsterHitTester::TOLERANCE);
+    }
+}
+
+}
+
+TEST(StaticPath, BakedPathsMatchRuntimeParsing) {
+    CheckBakedPath<MonsterScene::monster_shape>(MonsterScene::monster_path_data, gfx::FigureBegin::Filled);
+    CheckBakedPath<MonsterScene::nose_shape>(MonsterScene::nose_path_data, gfx::FigureBegin::Filled);
+    CheckBakedPath<MonsterScene::smile_shape>(MonsterScene::smile_path_data, gfx::FigureBegin::Hollow);
+    CheckBakedPath<MonsterScene::sad_shape>(MonsterScene::sad_path_data, gfx::FigureBegin::Hollow);
+}
+
+TEST(StaticPath, BakedFlatteningsMatchRuntimeFlattening) {
+    {
+        test::Scope scope("monster");
+        CheckBakedFlattenings<MonsterScene::monster_shape>(Parse(MonsterScene::monster_path_data));
+    }
+    {
+        test::Scope scope("nose");
+        CheckBakedFlattenings<MonsterScene::nose_shape>(Parse(MonsterScene::nose_path_data));
+    }
+    {
+        test::Scope scope("smile");
+        CheckBakedFlattenings<MonsterScene::smile_shape>(Parse(MonsterScene::smile_path_data, gfx::FigureBegin::Hollow));
+    }
+    {
+        test::Scope scope("sad");
+        CheckBakedFlattenings<MonsterScene::sad_shape>(Parse(MonsterScene::sad_path_data, gfx::FigureBegin::Hollow));
+    }
+}
+
+TEST(StaticPath, BakedBoundsMatchRuntimeBounds) {
+    auto monster = Parse(MonsterScene::monster_path_data);
+    auto bounds = monster.ControlBounds();
+    const auto& baked_bounds = MonsterScene::monster_shape.control_bounds;
+    CHECK_EQ(baked_bounds.left, bounds.left);
+    CHECK_EQ(baked_bounds.top, bounds.top);
+    CHECK_EQ(baked_bounds.right, bounds.right);
+    CHECK_EQ(baked_bounds.bottom, bounds.bottom);
+
+    gfx::FlattenedPath flattened;
+    gfx::FlattenPathAdaptive(monster, gfx::Matrix3x2::Identity(), MonsterHitTester::TOLERANCE, flattened);
+    auto flat_bounds = flattened.Bounds();
+    const auto& baked_flat = baked<MonsterScene::monster_shape, MonsterHitTester::TOLERANCE>.bounds;
+    CHECK_EQ(baked_flat.left, flat_bounds.left);
+    CHECK_EQ(baked_flat.top, flat_bounds.top);
+    CHECK_EQ(baked_flat.right, flat_bounds.right);
+    CHECK_EQ(baked_flat.bottom, flat_bounds.bottom);
+}
@@ -0,0 +1,71 @@
+#include "Bench.h"
+#include "FlatteningCache.h"
+#include "MonsterScene.h"
+#include "Stroke.h"
+#include <cstdio>
+
+// Outlines of the monster's body, nose and mouths, flattened as the renderer flattens
+// them at a range of scales: segments stroked per second for each join, and the time
+// for a StrokeCache that already holds the outline, which leaves only turning it to
+// the transformation.
+BENCHMARK(StrokePaths) {
+    gfx::Path paths[4];
+    MonsterScene::CreateMonster(paths[0]);
+    MonsterScene::CreateNose(paths[1]);
+    MonsterScene::CreateSmile(paths[2]);
+    MonsterScene::CreateSad(paths[3]);
+
+    const struct {
+        const char* name;
+        gfx::LineJoin join;
+        gfx::LineCap cap;
+    } styles[] = {
+        { "miter", gfx::LineJoin::Miter, gfx::LineCap::Flat },
+        { "bevel", gfx::LineJoin::Bevel, gfx::LineCap::Square },
+        { "round", gfx::LineJoin::Round, gfx::LineCap::Round },
+    };
+
+    std::printf("%6s %-6s %9s %15s %11s %12s %10s\n", "scale", "join", "segments", "outline points", "stroke us",
+        "Msegments/s", "cached us");
+    for (float scale : { 0.5f, 1.0f, 4.0f, 16.0f }) {
+        auto transformation = gfx::Matrix3x2::Scale(scale, scale) * gfx::Matrix3x2::Translation(960.0f, 540.0f);
+        auto level = gfx::FlatteningCache::LevelOfDetail(scale);
+        auto tolerance = gfx::FlatteningCache::TOLERANCE / gfx::FlatteningCache::LevelScale(level);
+
+        gfx::FlatteningCache flattening_cache;
+        std::size_t segments = 0;
+        for (const auto& path : paths) {
+            for (const auto& figure : flattening_cache.Get(path, transformation).figures) {
+                segments += figure.closed ? figure.point_count : figure.point_count - 1;
+            }
+        }
+
+        for (const auto& style : styles) {
+            gfx::StrokeStyle stroke = { .width = 3.0f, .join = style.join, .cap = style.cap };
+            gfx::FlattenedPath outline;
+            gfx::FrameArena arena;
+            auto stroke_seconds = bench::Measure([&] {
+                outline.Clear();
+                for (const auto& path : paths) {
+                    gfx::StrokePath(flattening_cache.Get(path, transformation), stroke, tolerance, outline, &arena);
+                }
+                arena.Reset();
+                bench::KeepAlive(outline);
+            });
+
+            gfx::StrokeCache stroke_cache;
+            gfx::FlattenedPath turned;
+            auto cached_seconds = bench::Measure([&] {
+                for (const auto& path : paths) {
+                    gfx::TransformPath(transformation, stroke_cache.Get(path, transformation, stroke, flattening_cache),
+                        turned);
+                    bench::KeepAlive(turned);
+                }
+            });
+
+            std::printf("%6.1f %-6s %9zu %15zu %11.2f %12.1f %10.2f\n", scale, style.name, segments,
+                outline.points.size(), stroke_seconds * 1e6,
+                stroke_seconds > 0.0 ? segments / stroke_seconds * 1e-6 : 0.0, cached_seconds * 1e6);
+        }
+    }
+}
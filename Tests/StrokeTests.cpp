@@ -0,0 +1,319 @@
+#include "MonsterScene.h"
+#include "Stroke.h"
+#include "Test.h"
+#include "TestGeometry.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+using gfx::LineCap;
+using gfx::LineJoin;
+using gfx::Point;
+
+constexpr LineJoin JOINS[] = { LineJoin::Miter, LineJoin::Bevel, LineJoin::Round, LineJoin::MiterOrBevel };
+constexpr LineCap CAPS[] = { LineCap::Flat, LineCap::Square, LineCap::Round };
+
+const char* JoinName(LineJoin join) {
+    switch (join) {
+    case LineJoin::Miter: return "miter";
+    case LineJoin::Bevel: return "bevel";
+    case LineJoin::Round: return "round";
+    case LineJoin::MiterOrBevel: return "miter or bevel";
+    }
+    return "";
+}
+
+const char* CapName(LineCap cap) {
+    switch (cap) {
+    case LineCap::Flat: return "flat";
+    case LineCap::Square: return "square";
+    case LineCap::Round: return "round";
+    }
+    return "";
+}
+
+struct Vector {
+    double x, y;
+};
+
+Vector Between(Point a, Point b) { return { (double)b.x - a.x, (double)b.y - a.y }; }
+double Dot(Vector a, Vector b) { return a.x * b.x + a.y * b.y; }
+double Cross(Vector a, Vector b) { return a.x * b.y - a.y * b.x; }
+double Length(Vector v) { return std::hypot(v.x, v.y); }
+Vector Unit(Vector v) { return { v.x / Length(v), v.y / Length(v) }; }
+
+// Whether p is in the stroke of one figure, half_width wide, worked out from the
+// figure rather than from an outline: every segment a rectangle, and every join and
+// cap the shape it is named for. A miter is where the rectangles of the two segments
+// would overlap if both went on past the joint, cut square to the bisector at
+// miter_limit half widths; a bevel is the same, cut where the two outer corners meet.
+// Paths that double back aren't covered.
+bool ReferenceContains(const std::vector<Point>& figure, bool closed, const gfx::StrokeStyle& style,
+    double half_width, Point p) {
+    // A point repeated is drawn once.
+    std::vector<Point> points;
+    for (auto q : figure) {
+        if (points.empty() || q.x != points.back().x || q.y != points.back().y) {
+            points.push_back(q);
+        }
+    }
+    auto count = points.size();
+    if (count == 1) {
+        auto w = Between(points[0], p);
+        return (style.cap == LineCap::Round && Length(w) <= half_width) ||
+            (style.cap == LineCap::Square && std::max(std::abs(w.x), std::abs(w.y)) <= half_width);
+    }
+
+    auto segments = closed ? count : count - 1;
+    for (std::size_t i = 0; i < segments; i++) {
+        auto a = points[i], b = points[(i + 1) % count];
+        auto d = Unit(Between(a, b));
+        auto w = Between(a, p);
+        auto along = Dot(w, d), across = std::abs(Cross(d, w));
+        double first = 0.0, last = Length(Between(a, b));
+        if (!closed && style.cap == LineCap::Square) {
+            first -= i == 0 ? half_width : 0.0;
+            last += i == segments - 1 ? half_width : 0.0;
+        }
+        if (across <= half_width && along >= first && along <= last) {
+            return true;
+        }
+    }
+
+    if (!closed && style.cap == LineCap::Round &&
+        (Length(Between(points[0], p)) <= half_width || Length(Between(points[count - 1], p)) <= half_width)) {
+        return true;
+    }
+
+    auto first_join = closed ? 0 : 1;
+    auto last_join = closed ? count : count - 1;
+    for (auto i = (std::size_t)first_join; i < last_join; i++) {
+        auto a = points[(i + count - 1) % count], b = points[i], c = points[(i + 1) % count];
+        auto w = Between(b, p);
+        if (style.join == LineJoin::Round) {
+            if (Length(w) <= half_width) {
+                return true;
+            }
+            continue;
+        }
+
+        auto d1 = Unit(Between(a, b)), d2 = Unit(Between(b, c));
+        if (Dot(w, d1) < 0.0 || Dot(w, d2) > 0.0 || std::abs(Cross(d1, w)) > half_width ||
+            std::abs(Cross(d2, w)) > half_width) {
+            continue;
+        }
+        auto turn = Dot(d1, d2);
+        if (turn >= 1.0 - 1e-9) {
+            continue;
+        }
+        auto bisector = Unit({ d1.x - d2.x, d1.y - d2.y });
+        // Cosine of half the turn: the miter reaches half_width over it from the joint.
+        auto cos_half = std::sqrt((1.0 + turn) / 2.0);
+        auto bevel = half_width * cos_half;
+        auto cut = std::numeric_limits<double>::infinity();
+        if (style.join == LineJoin::Miter) {
+            cut = style.miter_limit * half_width;
+        }
+        else if (style.join == LineJoin::Bevel || 1.0 / cos_half > style.miter_limit) {
+            cut = bevel;
+        }
+        if (Dot(w, bisector) <= cut) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct Figure {
+    std::vector<Point> points;
+    bool closed = false;
+};
+
+gfx::FlattenedPath ToPath(const std::vector<Figure>& figures) {
+    gfx::FlattenedPath path;
+    for (const auto& figure : figures) {
+        gfx::FlatFigure flat;
+        flat.first_point = (std::uint32_t)path.points.size();
+        flat.point_count = (std::uint32_t)figure.points.size();
+        flat.filled = false;
+        flat.closed = figure.closed;
+        path.points.insert(path.points.end(), figure.points.begin(), figure.points.end());
+        path.figures.push_back(flat);
+    }
+    return path;
+}
+
+// Strokes figures and compares the outline's nonzero fill with the reference at points
+// on a grid over it. Round parts may fall short by tolerance, so points closer than that
+// to the edge of the reference aren't decided and are skipped.
+void CheckAgainstReference(const std::vector<Figure>& figures, const gfx::StrokeStyle& style, float tolerance,
+    float spacing) {
+    gfx::FlattenedPath outline;
+    gfx::StrokePath(ToPath(figures), style, tolerance, outline);
+    REQUIRE(!outline.figures.empty());
+
+    auto half_width = style.width * 0.5;
+    auto slack = tolerance + 0.01;
+    auto contains = [&](double width, Point p) {
+        for (const auto& figure : figures) {
+            if (ReferenceContains(figure.points, figure.closed, style, width, p)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto bounds = outline.Bounds();
+    auto margin = style.width;
+    int inside = 0, outside = 0, mismatches = 0;
+    // Off the grid the figures are drawn on, so no point sits exactly on an edge.
+    for (auto y = bounds.top - margin + 0.37f * spacing; y < bounds.bottom + margin; y += spacing) {
+        for (auto x = bounds.left - margin + 0.61f * spacing; x < bounds.right + margin; x += spacing) {
+            Point p = { x, y };
+            auto filled = WindingContains(outline, p);
+            if (contains(half_width - slack, p)) {
+                inside++;
+                mismatches += !filled;
+            }
+            else if (!contains(half_width + slack, p)) {
+                outside++;
+                mismatches += filled;
+            }
+        }
+    }
+    CHECK(inside > 0);
+    CHECK(outside > 0);
+    CHECK_EQ(mismatches, 0);
+}
+
+// An open zigzag with a sharp turn at (140, 20), about 27 degrees, whose miter is 4.3
+// half widths long, and gentler ones elsewhere.
+const std::vector<Figure> ZIGZAG = {
+    { { { 20.0f, 30.0f }, { 140.0f, 20.0f }, { 40.0f, 70.0f }, { 130.0f, 120.0f }, { 60.0f, 150.0f } }, false },
+};
+
+// A closed triangle with the same sharp turn, and a quadrilateral with right angles.
+const std::vector<Figure> CLOSED = {
+    { { { 20.0f, 30.0f }, { 140.0f, 20.0f }, { 40.0f, 70.0f } }, true },
+    { { { 60.0f, 100.0f }, { 140.0f, 100.0f }, { 140.0f, 160.0f }, { 60.0f, 160.0f } }, true },
+};
+
+// The polygons of an outline, leaving out joins of segments that are straight to within
+// rounding. Whether those get a sliver of a join depends on the last bit of the points.
+std::vector<std::vector<Point>> WithoutSlivers(const gfx::FlattenedPath& outline) {
+    std::vector<std::vector<Point>> polygons;
+    for (const auto& figure : outline.figures) {
+        auto points = std::span(outline.points).subspan(figure.first_point, figure.point_count);
+        auto area = 0.0;
+        for (std::size_t i = 0; i < points.size(); i++) {
+            area += Cross({ points[i].x, points[i].y }, { points[(i + 1) % points.size()].x,
+                points[(i + 1) % points.size()].y });
+        }
+        if (std::abs(area) / 2.0 >= 0.01) {
+            polygons.emplace_back(points.begin(), points.end());
+        }
+    }
+    return polygons;
+}
+
+}
+
+TEST(Stroke, JoinsAndCapsMatchTheReference) {
+    for (auto join : JOINS) {
+        for (auto cap : CAPS) {
+            // The sharp turn's miter fits within a limit of 10 but not of 3.
+            for (float limit : { 3.0f, 10.0f }) {
+                test::Scope scope(std::string(JoinName(join)) + " joins, " + CapName(cap) + " caps, miter limit " +
+                    std::to_string(limit));
+                CheckAgainstReference(ZIGZAG, { .width = 12.0f, .join = join, .cap = cap, .miter_limit = limit },
+                    0.1f, 0.7f);
+            }
+        }
+    }
+}
+
+TEST(Stroke, ClosedFiguresJoinAllAround) {
+    for (auto join : JOINS) {
+        test::Scope scope(std::string(JoinName(join)) + " joins");
+        // Caps never apply to closed figures.
+        CheckAgainstReference(CLOSED, { .width = 10.0f, .join = join, .cap = LineCap::Round, .miter_limit = 3.0f },
+            0.1f, 0.5f);
+    }
+}
+
+TEST(Stroke, FiguresThatNeverMoveAreDots) {
+    for (auto cap : { LineCap::Square, LineCap::Round }) {
+        test::Scope scope(std::string(CapName(cap)) + " caps");
+        CheckAgainstReference({ { { { 10.0f, 10.0f } }, false }, { { { 40.0f, 25.0f }, { 40.0f, 25.0f } }, false } },
+            { .width = 14.0f, .cap = cap }, 0.1f, 0.25f);
+    }
+
+    gfx::FlattenedPath outline;
+    gfx::StrokePath(ToPath({ { { { 10.0f, 10.0f } }, false } }), {}, 0.1f, outline);
+    CHECK(outline.figures.empty());
+}
+
+TEST(Stroke, HairlinesStayOnePixelWideAtAnyScale) {
+    // Stroked as CpuRenderer strokes hairlines: after transforming, so the width is in
+    // pixels however far the path is scaled.
+    const Figure figure = { { { 0.0f, 0.0f }, { 2.5f, 0.5f }, { 1.0f, 2.0f }, { 3.0f, 3.5f } }, false };
+    for (float scale : { 1.0f, 4.0f, 25.0f }) {
+        for (auto join : { LineJoin::Miter, LineJoin::Round }) {
+            test::Scope scope(std::string(JoinName(join)) + " joins at scale " + std::to_string(scale));
+            auto transformation = gfx::Matrix3x2::Rotation(30.0f) * gfx::Matrix3x2::Scale(scale, scale);
+            Figure transformed = { {}, false };
+            for (auto p : figure.points) {
+                transformed.points.push_back(transformation.TransformPoint(p));
+            }
+            CheckAgainstReference({ transformed },
+                { .width = 1.0f, .join = join, .cap = LineCap::Round, .hairline = true }, 0.02f, 0.1f);
+        }
+    }
+}
+
+TEST(Stroke, CachedOutlinesTurnedMatchFreshStrokes) {
+    gfx::FlatteningCache flattening_cache;
+    gfx::StrokeCache cache;
+    const gfx::StrokeStyle styles[] = {
+        { .width = 3.0f, .join = LineJoin::Round, .cap = LineCap::Round },
+        { .width = 2.0f, .join = LineJoin::Miter, .cap = LineCap::Square, .miter_limit = 4.0f },
+    };
+    gfx::Path monster, smile;
+    MonsterScene::monster_shape.CopyTo(monster);
+    MonsterScene::smile_shape.CopyTo(smile);
+    for (const auto* path : { &monster, &smile }) {
+        for (const auto& style : styles) {
+            for (float angle : { 0.0f, 17.0f, 90.0f, -140.0f }) {
+                test::Scope scope("angle " + std::to_string(angle));
+                auto transformation = gfx::Matrix3x2::Rotation(angle) * gfx::Matrix3x2::Translation(300.0f, 200.0f);
+                gfx::FlattenedPath cached;
+                gfx::TransformPath(transformation, cache.Get(*path, transformation, style, flattening_cache), cached);
+
+                // The same polyline turned first and stroked in place.
+                auto level = gfx::FlatteningCache::LevelOfDetail(transformation.MaxScale());
+                gfx::FlattenedPath turned, fresh;
+                gfx::TransformPath(transformation, flattening_cache.Get(*path, transformation), turned);
+                gfx::StrokePath(turned, style,
+                    gfx::FlatteningCache::TOLERANCE / gfx::FlatteningCache::LevelScale(level), fresh);
+
+                auto a = WithoutSlivers(cached), b = WithoutSlivers(fresh);
+                REQUIRE_EQ(a.size(), b.size());
+                auto worst = 0.0f;
+                for (std::size_t i = 0; i < a.size(); i++) {
+                    REQUIRE_EQ(a[i].size(), b[i].size());
+                    for (std::size_t j = 0; j < a[i].size(); j++) {
+                        worst = std::max({ worst, std::abs(a[i][j].x - b[i][j].x), std::abs(a[i][j].y - b[i][j].y) });
+                    }
+                }
+                CHECK(worst <= 1e-3f);
+            }
+        }
+    }
+    // Turning reuses the outline: one per path and style.
+    CHECK_EQ(cache.Size(), (std::size_t)4);
+}
@@ -0,0 +1,62 @@
+#include "Bench.h"
+#include "SvgPath.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+
+// Counts calls, so the parse can't be optimized away and costs next to nothing itself.
+class CountingSink : public gfx::PathSink {
+public:
+    std::size_t count = 0;
+
+    void BeginFigure(gfx::Point, gfx::FigureBegin) override { count++; }
+    void AddLine(gfx::Point) override { count++; }
+    void AddBezier(gfx::Point, gfx::Point, gfx::Point) override { count++; }
+    void AddQuadraticBezier(gfx::Point, gfx::Point) override { count++; }
+    void AddArc(const gfx::ArcSegment&) override { count++; }
+    void EndFigure(gfx::FigureEnd) override { count++; }
+};
+
+// Figures of 40 cubics with two decimals, like path data exported from a drawing tool.
+std::string Corpus(std::size_t size) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> coordinate(-500.0f, 500.0f);
+    std::string corpus;
+    char buffer[96];
+    while (corpus.size() < size) {
+        corpus += "M0 0";
+        for (int i = 0; i < 40; i++) {
+            std::snprintf(buffer, sizeof(buffer), " C%.2f %.2f %.2f %.2f %.2f %.2f", coordinate(random),
+                coordinate(random), coordinate(random), coordinate(random), coordinate(random), coordinate(random));
+            corpus += buffer;
+        }
+        corpus += " Z\n";
+    }
+    return corpus;
+}
+
+}
+
+// Parse throughput over bulk path data, and for a path as short as the monster's.
+BENCHMARK(ParseSvgPath) {
+    std::printf("%12s %10s %12s\n", "bytes", "MB/s", "calls/s");
+    for (std::size_t size : { 200u, 64u * 1024u, 16u * 1024u * 1024u }) {
+        auto corpus = bench::Quick() ? Corpus(std::min<std::size_t>(size, 64 * 1024)) : Corpus(size);
+        CountingSink sink;
+        bool ok = true;
+        auto seconds = bench::Measure([&] {
+            sink.count = 0;
+            ok = gfx::ParseSvgPath(corpus, sink) && ok;
+            bench::KeepAlive(sink.count);
+        });
+        if (!ok) {
+            std::printf("%12zu failed to parse\n", corpus.size());
+            continue;
+        }
+        std::printf("%12zu %10.0f %12.3g\n", corpus.size(), seconds > 0.0 ? corpus.size() / seconds * 1e-6 : 0.0,
+            seconds > 0.0 ? sink.count / seconds : 0.0);
+    }
+}
@@ -0,0 +1,186 @@
+#include "SvgPath.h"
+#include "Test.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+// Writes down every call as a command letter and its numbers, the same way for every
+// test, so the expected output reads like normalized path data.
+class RecordingSink : public gfx::PathSink {
+public:
+    std::string calls;
+
+    void BeginFigure(gfx::Point start, gfx::FigureBegin begin) override {
+        Add(begin == gfx::FigureBegin::Hollow ? "m" : "M", { start.x, start.y });
+    }
+    void AddLine(gfx::Point point) override { Add("L", { point.x, point.y }); }
+    void AddBezier(gfx::Point control1, gfx::Point control2, gfx::Point end) override {
+        Add("C", { control1.x, control1.y, control2.x, control2.y, end.x, end.y });
+    }
+    void AddQuadraticBezier(gfx::Point control, gfx::Point end) override {
+        Add("Q", { control.x, control.y, end.x, end.y });
+    }
+    void AddArc(const gfx::ArcSegment& arc) override {
+        Add("A", { arc.radius_x, arc.radius_y, arc.rotation_angle, (float)(arc.arc_size == gfx::ArcSize::Large),
+            (float)(arc.sweep_direction == gfx::SweepDirection::Clockwise), arc.point.x, arc.point.y });
+    }
+    void EndFigure(gfx::FigureEnd end) override { Add(end == gfx::FigureEnd::Closed ? "Z" : "E", {}); }
+
+private:
+    void Add(const char* command, std::initializer_list<float> numbers) {
+        if (!calls.empty()) {
+            calls += ' ';
+        }
+        calls += command;
+        char buffer[32];
+        auto separator = "";
+        for (auto number : numbers) {
+            std::snprintf(buffer, sizeof(buffer), "%s%g", separator, number);
+            calls += buffer;
+            separator = ",";
+        }
+    }
+};
+
+struct Parsed {
+    bool ok;
+    std::string calls;
+};
+
+Parsed Parse(std::string_view data, gfx::FigureBegin begin = gfx::FigureBegin::Filled) {
+    RecordingSink sink;
+    auto ok = gfx::ParseSvgPath(data, sink, begin);
+    return { ok, sink.calls };
+}
+
+// data in quotes, for the scope. Appended piece by piece, since GCC 12 warns about
+// "\"" + std::string(data) with -Wrestrict, wrongly.
+std::string Quoted(std::string_view data) {
+    std::string quoted = "\"";
+    quoted.append(data);
+    quoted.push_back('"');
+    return quoted;
+}
+
+void CheckParses(std::string_view data, const char* expected) {
+    test::Scope scope(Quoted(data));
+    auto parsed = Parse(data);
+    CHECK(parsed.ok);
+    CHECK_EQ(parsed.calls, std::string(expected));
+}
+
+void CheckFails(std::string_view data, const char* expected) {
+    test::Scope scope(Quoted(data));
+    auto parsed = Parse(data);
+    CHECK(!parsed.ok);
+    CHECK_EQ(parsed.calls, std::string(expected));
+}
+
+// With a constexpr sink, ParseSvgPath runs in a constant expression as StaticPath needs.
+class CountingSink : public gfx::PathSink {
+public:
+    int count = 0;
+
+    constexpr ~CountingSink() override {}
+
+    constexpr void BeginFigure(gfx::Point, gfx::FigureBegin) override { count++; }
+    constexpr void AddLine(gfx::Point) override { count++; }
+    constexpr void AddBezier(gfx::Point, gfx::Point, gfx::Point) override { count++; }
+    constexpr void AddQuadraticBezier(gfx::Point, gfx::Point) override { count++; }
+    constexpr void AddArc(const gfx::ArcSegment&) override { count++; }
+    constexpr void EndFigure(gfx::FigureEnd) override { count++; }
+};
+
+constexpr int CountCalls(std::string_view data) {
+    CountingSink sink;
+    return gfx::ParseSvgPath(data, sink) ? sink.count : -1;
+}
+
+static_assert(CountCalls("M0 0 L1 1 C1 2 3 4 5 6 Z") == 4);
+static_assert(CountCalls("M0 0 X") == -1);
+
+}
+
+TEST(SvgPath, LinesAbsoluteAndRelative) {
+    CheckParses("M10,10 L20,20", "M10,10 L20,20 E");
+    CheckParses("M10,10 l5-5h3v-1 H0 V0z", "M10,10 L15,5 L18,5 L18,4 L0,4 L0,0 Z");
+    CheckParses("m1 1 l1 1 1 1", "M1,1 L2,2 L3,3 E");
+}
+
+TEST(SvgPath, ImplicitLinetosAfterMoveto) {
+    CheckParses("M10,10 20,20 30,10", "M10,10 L20,20 L30,10 E");
+    CheckParses("m10,10 20,20 30,10", "M10,10 L30,30 L60,40 E");
+}
+
+TEST(SvgPath, Cubics) {
+    CheckParses("M0 0 C1 2 3 4 5 6", "M0,0 C1,2,3,4,5,6 E");
+    CheckParses("m1 1 c1 1 2 2 3 3", "M1,1 C2,2,3,3,4,4 E");
+    // S reflects the previous control point, or uses the current point after anything
+    // but a cubic.
+    CheckParses("m1 1 c1 1 2 2 3 3 s4 4 5 5", "M1,1 C2,2,3,3,4,4 C5,5,8,8,9,9 E");
+    CheckParses("M0 0 L10 0 S20 10 30 0", "M0,0 L10,0 C10,0,20,10,30,0 E");
+}
+
+TEST(SvgPath, Quadratics) {
+    CheckParses("M0 0 Q10 0 10 10", "M0,0 Q10,0,10,10 E");
+    // T reflects the previous control point the same way S does.
+    CheckParses("M0 0 Q10 0 10 10 T20 20 t10 0", "M0,0 Q10,0,10,10 Q10,20,20,20 Q30,20,30,20 E");
+    CheckParses("M0 0 T10 10", "M0,0 Q0,0,10,10 E");
+}
+
+TEST(SvgPath, Arcs) {
+    CheckParses("M0,0 A5 5 30 1 1 10 10", "M0,0 A5,5,30,1,1,10,10 E");
+    CheckParses("M1,1 a5 5 0 0 0 10 10", "M1,1 A5,5,0,0,0,11,11 E");
+    // Flags need no separator after them.
+    CheckParses("M0,0a5 5 0 0110 10", "M0,0 A5,5,0,0,1,10,10 E");
+    // A zero radius is a straight line.
+    CheckParses("M+1 +2 a0 5 0 1 1 3 3", "M1,2 L4,5 E");
+}
+
+TEST(SvgPath, Numbers) {
+    CheckParses("M1e1-2e-1.5.5", "M10,-0.2 L0.5,0.5 E");
+    CheckParses("M 1.5E+1 , -.25", "M15,-0.25 E");
+    CheckParses("  \t\r\nM0 0\n", "M0,0 E");
+}
+
+TEST(SvgPath, ClosePathStartsTheNextFigureAtTheFirstPoint) {
+    CheckParses("M0 0 L10 10 Z L5 5", "M0,0 L10,10 Z M0,0 L5,5 E");
+    CheckParses("M5 5 l10 0 z m1 1 l1 0", "M5,5 L15,5 Z M6,6 L7,6 E");
+    CheckParses("M0 0 L1 1 M5 5 L6 6", "M0,0 L1,1 E M5,5 L6,6 E");
+}
+
+TEST(SvgPath, FigureBeginComesFromTheCaller) {
+    RecordingSink sink;
+    CHECK(gfx::ParseSvgPath("M1 2 L3 4", sink, gfx::FigureBegin::Hollow));
+    CHECK_EQ(sink.calls, std::string("m1,2 L3,4 E"));
+}
+
+TEST(SvgPath, ErrorsKeepTheFiguresParsedSoFar) {
+    CheckFails("M0 0 L10 10 X 5 5", "M0,0 L10,10 E");
+    CheckFails("M0 0 L10", "M0,0 E");
+    CheckFails("M0 0 L10 10 Z 5 5", "M0,0 L10,10 Z");
+    CheckFails("M0,0 A5 5 0 2 0 10 10", "M0,0 E");
+    // Path data has to start with a moveto.
+    CheckFails("L0 0", "");
+    CheckFails("0 0", "");
+    CheckParses("", "");
+}
+
+TEST(SvgPath, LoadsFiles) {
+    auto filename = std::filesystem::temp_directory_path() / "MonsterTests.svgpath";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "M0,0 L10,10 Z";
+    }
+    RecordingSink sink;
+    CHECK(gfx::LoadSvgPath(filename, sink));
+    CHECK_EQ(sink.calls, std::string("M0,0 L10,10 Z"));
+    std::filesystem::remove(filename);
+
+    RecordingSink missing;
+    CHECK(!gfx::LoadSvgPath(filename, missing));
+    CHECK(missing.calls.empty());
+}
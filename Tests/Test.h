@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cmath>
+#include <concepts>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// A small test runner, so the tests need nothing beyond the standard library on any
+// platform. TEST(Suite, Name) { ... } defines a test; CHECK* record a failure and go
+// on, REQUIRE* end the test. MonsterTests runs every test, or those of the suites
+// named on its command line.
+namespace test {
+
+using Function = void (*)();
+
+struct Registration {
+    Registration(const char* suite, const char* name, Function function);
+};
+
+// Thrown by REQUIRE to end the test.
+struct Stop {};
+
+void Fail(const char* file, int line, const std::string& message);
+
+// Printed along with every failure while it lives, like the loop variable of a
+// check inside a loop.
+class Scope {
+public:
+    explicit Scope(std::string text);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+template <class T>
+std::string Describe(const T& value) {
+    if constexpr (requires(std::ostream& stream) { stream << value; }) {
+        std::ostringstream stream;
+        stream << value;
+        return stream.str();
+    }
+    else {
+        return "(value)";
+    }
+}
+
+template <class A, class B>
+bool CheckEqual(const A& a, const B& b, const char* a_text, const char* b_text, const char* file, int line) {
+    if (a == b) {
+        return true;
+    }
+    Fail(file, line, std::string(a_text) + " == " + b_text + ": " + Describe(a) + " vs " + Describe(b));
+    return false;
+}
+
+inline bool CheckNear(double a, double b, double tolerance, const char* a_text, const char* b_text, const char* file,
+    int line) {
+    if (std::abs(a - b) <= tolerance) {
+        return true;
+    }
+    Fail(file, line, std::string(a_text) + " ~ " + b_text + ": " + Describe(a) + " vs " + Describe(b) +
+        ", more than " + Describe(tolerance) + " apart");
+    return false;
+}
+
+}
+
+#define TEST(suite, name) \
+    static void suite##_##name(); \
+    static const test::Registration suite##_##name##_registration(#suite, #name, &suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition) \
+    ((condition) ? true : (test::Fail(__FILE__, __LINE__, #condition), false))
+#define CHECK_EQ(a, b) test::CheckEqual((a), (b), #a, #b, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b, tolerance) test::CheckNear((a), (b), (tolerance), #a, #b, __FILE__, __LINE__)
+
+#define REQUIRE(condition) \
+    do { if (!CHECK(condition)) throw test::Stop(); } while (false)
+#define REQUIRE_EQ(a, b) \
+    do { if (!CHECK_EQ(a, b)) throw test::Stop(); } while (false)
+#define REQUIRE_NEAR(a, b, tolerance) \
+    do { if (!CHECK_NEAR(a, b, tolerance)) throw test::Stop(); } while (false)
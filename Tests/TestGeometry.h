@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Geometry.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// How far the polyline strays from the curve at most: the largest distance from a point
+// of the curve flattened very finely to the nearest segment of polyline. Figures match
+// one to one.
+inline double Deviation(gfx::FlatPathView curve, gfx::FlatPathView polyline) {
+    double worst = 0.0;
+    for (std::size_t f = 0; f < curve.figures.size(); f++) {
+        const auto& curve_figure = curve.figures[f];
+        const auto& figure = polyline.figures[f];
+        auto points = polyline.points.subspan(figure.first_point, figure.point_count);
+
+        for (auto q : curve.points.subspan(curve_figure.first_point, curve_figure.point_count)) {
+            auto nearest = 1e30;
+            auto segments = figure.closed ? points.size() : points.size() - 1;
+            for (std::size_t i = 0; i < segments; i++) {
+                auto a = points[i], b = points[(i + 1) % points.size()];
+                double vx = b.x - a.x, vy = b.y - a.y, wx = q.x - a.x, wy = q.y - a.y;
+                auto length_squared = vx * vx + vy * vy;
+                auto t = length_squared > 0.0 ? std::clamp((vx * wx + vy * wy) / length_squared, 0.0, 1.0) : 0.0;
+                nearest = std::min(nearest, std::hypot(wx - t * vx, wy - t * vy));
+            }
+            worst = std::max(worst, nearest);
+        }
+    }
+    return worst;
+}
+
+// The reference polylines are measured against: the curve in 256 steps per cubic.
+inline gfx::FlattenedPath FineCurve(const gfx::Path& path, const gfx::Matrix3x2& transformation) {
+    gfx::FlattenedPath fine;
+    gfx::FlattenPath(path, transformation, 256, fine);
+    return fine;
+}
+
+// Nonzero winding of p over every edge of path, the way a single FillContainsPoint
+// call walks them all. Same crossing rule as PathHitTester, with nothing skipped.
+inline bool WindingContains(gfx::FlatPathView path, gfx::Point p) {
+    auto winding = 0;
+    for (const auto& figure : path.figures) {
+        if (!figure.filled || figure.point_count < 2) {
+            continue;
+        }
+        auto points = path.points.subspan(figure.first_point, figure.point_count);
+        for (std::size_t i = 0; i < points.size(); i++) {
+            auto a = points[i], b = points[(i + 1) % points.size()];
+            if (a.y == b.y) {
+                continue;
+            }
+            auto direction = 1;
+            if (a.y > b.y) {
+                std::swap(a, b);
+                direction = -1;
+            }
+            if (p.y >= a.y && p.y < b.y && a.x + (p.y - a.y) * ((b.x - a.x) / (b.y - a.y)) > p.x) {
+                winding += direction;
+            }
+        }
+    }
+    return winding != 0;
+}
@@ -0,0 +1,76 @@
+#include "Test.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCase {
+    std::string suite, name;
+    test::Function function;
+};
+
+std::vector<TestCase>& TestCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+std::vector<std::string> scopes;
+int failures = 0;
+
+}
+
+namespace test {
+
+Registration::Registration(const char* suite, const char* name, Function function) {
+    TestCases().push_back({ suite, name, function });
+}
+
+void Fail(const char* file, int line, const std::string& message) {
+    std::printf("%s(%d): failed: %s\n", file, line, message.c_str());
+    for (const auto& scope : scopes) {
+        std::printf("    with %s\n", scope.c_str());
+    }
+    failures++;
+}
+
+Scope::Scope(std::string text) {
+    scopes.push_back(std::move(text));
+}
+
+Scope::~Scope() {
+    scopes.pop_back();
+}
+
+}
+
+// MonsterTests [Suite...] runs the tests of the suites given, or all of them. Fails if a
+// test fails or none ran.
+int main(int argc, char** argv) {
+    std::vector<std::string> suites(argv + 1, argv + argc);
+    int ran = 0, failed = 0;
+    for (const auto& test : TestCases()) {
+        if (!suites.empty() && std::find(suites.begin(), suites.end(), test.suite) == suites.end()) {
+            continue;
+        }
+
+        std::printf("%s.%s\n", test.suite.c_str(), test.name.c_str());
+        std::fflush(stdout);
+        auto failures_before = failures;
+        try {
+            test.function();
+        }
+        catch (const test::Stop&) {
+        }
+        scopes.clear();
+        ran++;
+        if (failures > failures_before) {
+            std::printf("%s.%s FAILED\n", test.suite.c_str(), test.name.c_str());
+            failed++;
+        }
+    }
+
+    std::printf("%d tests ran, %d failed.\n", ran, failed);
+    return ran > 0 && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Crowd.h"
+#include "MonsterScene.h"
+#include "Paint.h"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// A BGRA8 buffer to render into, owning its pixels.
+struct TestTarget {
+    std::vector<std::uint8_t> pixels;
+    gfx::Surface surface;
+
+    TestTarget(int width, int height)
+        : pixels((std::size_t)width * height * 4), surface{ pixels.data(), width, height, width * 4 } {}
+};
+
+// Frame frame of the monster centered in a target of the given size, swaying, with its
+// eyes following a cursor circling it and the mouth going back and forth between sad and
+// smiling, so consecutive frames differ in every moving part.
+inline SceneState TestScene(int width, int height, int frame) {
+    auto transformation = MonsterScene::DefaultTransformation((float)width, (float)height);
+    auto angle = frame * 0.05f;
+    gfx::Point mouse = { width / 2.0f + 300.0f * std::cos(angle), height / 2.0f + 200.0f * std::sin(angle) };
+    auto scene = MonsterScene::CreateScene(transformation, MonsterScene::SwayAngle(frame / 60.0), mouse, false);
+    scene.smile = (frame / 30) % 2 ? 1.0f : (frame % 30) / 30.0f;
+    return scene;
+}
+
+// count small monsters scattered over a target of the given size, as the window's crowd
+// mode places them, seeded so every run is the same.
+inline Crowd TestCrowd(std::size_t count, int width, int height) {
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    Crowd crowd;
+    for (std::size_t i = 0; i < count; i++) {
+        crowd.Add({ unit(random) * width, unit(random) * height }, 0.03f + 0.05f * unit(random), 2.0f * unit(random),
+            unit(random) < 0.5f ? Expression::Sad : Expression::Smile);
+    }
+    return crowd;
+}
@@ -0,0 +1,89 @@
+#include "Bench.h"
+#include "TestScene.h"
+#include "TripleBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Snapshot {
+    std::chrono::steady_clock::time_point published;
+    SceneState scene;
+    Crowd crowd;
+    std::uint64_t crowd_generation = 0;
+};
+
+}
+
+// Publishing a snapshot with crowds of several sizes, copying the whole crowd every
+// time against only its animation once the buffer holds the crowd as the window does,
+// and how long a published snapshot waits until a render thread polling for it picks
+// it up.
+BENCHMARK(SnapshotHandoff) {
+    using Clock = std::chrono::steady_clock;
+
+    std::printf("%8s %16s %16s %18s %18s\n", "crowd", "full copy us", "animation us", "median latency us",
+        "99% latency us");
+    for (std::size_t count : { 0u, 1000u, 10000u, 100000u }) {
+        auto crowd = TestCrowd(count, 1920, 1080);
+        crowd.Update(0.0, { 960.0f, 540.0f });
+        TripleBuffer<Snapshot> buffer;
+
+        auto full_copy = bench::Measure([&] {
+            auto& snapshot = buffer.Back();
+            snapshot.scene = TestScene(1920, 1080, 0);
+            snapshot.crowd = crowd;
+            snapshot.published = Clock::now();
+            buffer.Publish();
+        });
+        auto animation = bench::Measure([&] {
+            auto& snapshot = buffer.Back();
+            snapshot.scene = TestScene(1920, 1080, 0);
+            if (snapshot.crowd_generation != 1) {
+                snapshot.crowd = crowd;
+                snapshot.crowd_generation = 1;
+            }
+            else {
+                snapshot.crowd.CopyAnimation(crowd);
+            }
+            snapshot.published = Clock::now();
+            buffer.Publish();
+        });
+
+        // The writer publishes at about 1 kHz, as a busy UI thread would, while the
+        // reader polls.
+        auto snapshots = bench::Quick() ? 10 : 500;
+        std::atomic<bool> done = false;
+        std::vector<double> latencies;
+        std::thread reader([&] {
+            while (!done) {
+                if (buffer.Read()) {
+                    auto latency = Clock::now() - buffer.Front().published;
+                    latencies.push_back(std::chrono::duration<double, std::micro>(latency).count());
+                }
+            }
+        });
+        for (int i = 0; i < snapshots; i++) {
+            auto& snapshot = buffer.Back();
+            snapshot.crowd = crowd;
+            snapshot.published = Clock::now();
+            buffer.Publish();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        done = true;
+        reader.join();
+
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p) {
+            auto i = std::min(latencies.size() - 1, (std::size_t)(p * latencies.size()));
+            return latencies.empty() ? 0.0 : latencies[i];
+        };
+        std::printf("%8zu %16.2f %16.2f %18.2f %18.2f\n", count, full_copy * 1e6, animation * 1e6, percentile(0.5),
+            percentile(0.99));
+    }
+}
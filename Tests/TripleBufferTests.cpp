@@ -0,0 +1,158 @@
+#include "Crowd.h"
+#include "FrameScheduler.h"
+#include "MonsterScene.h"
+#include "Test.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace {
+
+// The portable part of the window's SceneSnapshot: plain fields, a scene, and a crowd
+// whose vectors reallocate as it grows and shrinks between snapshots. The writer derives
+// every field from the sequence number, so the reader can tell a snapshot that mixes
+// two of them apart.
+struct Snapshot {
+    std::uint64_t sequence = 0;
+    unsigned width = 0, height = 0;
+    SceneState scene;
+    Crowd crowd;
+    FrameMode frame_mode = FrameMode::VSync;
+    bool animating = false;
+};
+
+// Every so often the writer lets the reader run halfway through a snapshot, so the
+// reader gets to look while a slot is half written even on a single core.
+void Write(Snapshot& snapshot, Crowd& crowd, std::uint64_t sequence) {
+    auto value = (float)sequence;
+    crowd.Clear();
+    for (std::uint64_t i = 0; i < sequence % 37 + 1; i++) {
+        crowd.Add({ value, (float)i }, 0.05f, value, sequence % 2 ? Expression::Smile : Expression::Sad);
+    }
+
+    snapshot.sequence = sequence;
+    snapshot.width = (unsigned)(sequence % 4000) + 1;
+    snapshot.height = (unsigned)(sequence % 3000) + 1;
+    snapshot.scene.transformation = gfx::Matrix3x2::Translation(value, -value);
+    snapshot.scene.angle = value;
+    snapshot.scene.left_ball = { { value, 1.0f }, 8.0f, 8.0f };
+    snapshot.scene.right_ball = { { -value, 1.0f }, 8.0f, 8.0f };
+    snapshot.scene.smile = (float)(sequence % 101) / 100.0f;
+    if (sequence % 16 == 0) {
+        std::this_thread::yield();
+    }
+    snapshot.crowd = crowd;
+    snapshot.frame_mode = (FrameMode)(sequence % (std::uint64_t)FrameMode::Count);
+    snapshot.animating = sequence % 3 == 0;
+}
+
+// Whether every field of snapshot came from the same Write.
+bool Consistent(const Snapshot& snapshot) {
+    auto sequence = snapshot.sequence;
+    auto value = (float)sequence;
+    const auto& scene = snapshot.scene;
+    const auto& crowd = snapshot.crowd;
+
+    bool consistent = snapshot.width == sequence % 4000 + 1 && snapshot.height == sequence % 3000 + 1 &&
+        scene.transformation.dx == value && scene.transformation.dy == -value && scene.angle == value &&
+        scene.left_ball.center.x == value && scene.right_ball.center.x == -value &&
+        scene.smile == (float)(sequence % 101) / 100.0f &&
+        snapshot.frame_mode == (FrameMode)(sequence % (std::uint64_t)FrameMode::Count) &&
+        snapshot.animating == (sequence % 3 == 0) && crowd.Size() == sequence % 37 + 1 &&
+        crowd.position_y.size() == crowd.Size() && crowd.phase.size() == crowd.Size() &&
+        crowd.expression.size() == crowd.Size();
+    for (std::size_t i = 0; consistent && i < crowd.Size(); i++) {
+        consistent = crowd.position_x[i] == value && crowd.position_y[i] == (float)i && crowd.phase[i] == value &&
+            crowd.expression[i] == (sequence % 2 ? Expression::Smile : Expression::Sad);
+    }
+    return consistent;
+}
+
+}
+
+TEST(TripleBuffer, ReadTakesTheLatestPublishedValue) {
+    TripleBuffer<int> buffer;
+    CHECK(!buffer.Read());
+    CHECK_EQ(buffer.Front(), 0);
+
+    buffer.Back() = 1;
+    buffer.Publish();
+    CHECK(buffer.Read());
+    CHECK_EQ(buffer.Front(), 1);
+    // Nothing new: Front() stays.
+    CHECK(!buffer.Read());
+    CHECK_EQ(buffer.Front(), 1);
+
+    // Values published in between reads are skipped.
+    for (int value = 2; value <= 5; value++) {
+        buffer.Back() = value;
+        buffer.Publish();
+        CHECK(&buffer.Back() != &buffer.Front());
+    }
+    CHECK(buffer.Read());
+    CHECK_EQ(buffer.Front(), 5);
+    CHECK(!buffer.Read());
+}
+
+TEST(TripleBuffer, WriterAndReaderNeverShareASlot) {
+    TripleBuffer<int> buffer;
+    for (int step = 0; step < 64; step++) {
+        // Any interleaving of the two sides, chosen by the bits of step.
+        if (step & 1) {
+            buffer.Publish();
+        }
+        if (step & 2) {
+            buffer.Read();
+        }
+        if (step & 4) {
+            buffer.Publish();
+            buffer.Publish();
+        }
+        REQUIRE(&buffer.Back() != &buffer.Front());
+    }
+}
+
+TEST(TripleBuffer, SnapshotsDoNotTearUnderStress) {
+    // The UI thread publishes as fast as it can while the render thread reads as fast as
+    // it can. Every snapshot the reader gets has to be whole, newer than the last one,
+    // and the last one published has to arrive.
+    constexpr std::uint64_t SNAPSHOTS = 200000;
+
+    TripleBuffer<Snapshot> buffer;
+    std::atomic<bool> done = false;
+    std::thread writer([&] {
+        Crowd crowd;
+        for (std::uint64_t sequence = 1; sequence <= SNAPSHOTS; sequence++) {
+            Write(buffer.Back(), crowd, sequence);
+            buffer.Publish();
+        }
+        done = true;
+    });
+
+    std::uint64_t reads = 0, torn = 0, out_of_order = 0, last = 0;
+    while (last < SNAPSHOTS) {
+        auto finished = done.load();
+        if (!buffer.Read()) {
+            // Nothing new after the writer finished means the last snapshot was lost.
+            if (finished) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        const auto& snapshot = buffer.Front();
+        reads++;
+        torn += !Consistent(snapshot);
+        out_of_order += snapshot.sequence <= last;
+        last = snapshot.sequence;
+    }
+    writer.join();
+
+    test::Scope scope(std::to_string(reads) + " reads");
+    CHECK(reads > 1000);
+    CHECK_EQ(torn, 0u);
+    CHECK_EQ(out_of_order, 0u);
+    CHECK_EQ(last, SNAPSHOTS);
+}